@@ -59,3 +59,31 @@ typedef enum {
 	DISPATCH_RESULT_TIMEOUT = 4,
 } DispatchResult;
 
+/* Whether @file_name in a script directory can be a script, rather than a
+ * hidden file, a backup or a package management file. Shared by the
+ * dispatcher and NetworkManager, which skips calling the dispatcher for
+ * directories without scripts. */
+static inline gboolean
+nm_dispatcher_script_name_is_valid (const char *file_name)
+{
+	static const char *bad_suffixes[] = {
+		"~",
+		".rpmsave",
+		".rpmorig",
+		".rpmnew",
+		".swp",
+	};
+	char *tmp;
+	guint i;
+
+	if (file_name[0] == '.')
+		return FALSE;
+	for (i = 0; i < G_N_ELEMENTS (bad_suffixes); i++) {
+		if (g_str_has_suffix (file_name, bad_suffixes[i]))
+			return FALSE;
+	}
+	tmp = g_strrstr (file_name, ".dpkg-");
+	if (tmp && !strchr (&tmp[1], '.'))
+		return FALSE;
+	return TRUE;
+}
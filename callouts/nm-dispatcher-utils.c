@@ -542,3 +542,202 @@ nm_dispatcher_utils_construct_envp (const char *action,
 	return envp;
 }
 
+
+/*****************************************************************************/
+
+/**
+ * nm_dispatcher_utils_get_queue_key:
+ * @envp: (allow-none): the environment of the request
+ * @iface: (allow-none): the interface name of the request
+ *
+ * Requests are ordered per device. VPN requests carry the interface of
+ * the tunnel in @iface, but DEVICE_IFACE of the underlying device, so they
+ * are ordered together with the requests of that device. Hostname and
+ * connectivity changes have no device and are ordered among themselves.
+ *
+ * Returns: the key of the queue for the request.
+ */
+const char *
+nm_dispatcher_utils_get_queue_key (char **envp, const char *iface)
+{
+	const char *device_iface;
+
+	device_iface = envp ? g_environ_getenv (envp, "DEVICE_IFACE") : NULL;
+	if (device_iface && device_iface[0])
+		return device_iface;
+	return iface ?: "";
+}
+
+typedef struct {
+	char *key;
+	GQueue items;
+	gboolean running;
+} Queue;
+
+struct _NMDispatcherQueues {
+	GHashTable *queues;
+	GQueue queues_ready;
+	guint max_parallel;
+	guint num_running;
+	NMDispatcherQueuesStartFunc start_func;
+	gpointer user_data;
+};
+
+static void
+_queue_free (gpointer data)
+{
+	Queue *q = data;
+
+	g_queue_clear (&q->items);
+	g_free (q->key);
+	g_slice_free (Queue, q);
+}
+
+/**
+ * nm_dispatcher_queues_new:
+ * @max_parallel: the maximum number of queues running at the same time
+ * @start_func: starts an item
+ * @user_data: user data for @start_func
+ *
+ * Items added with the same key run one after another, in the order they
+ * were added. Items with different keys run in parallel, for up to
+ * @max_parallel keys at the same time.
+ *
+ * @start_func returns %TRUE if the item is still running. Then the next
+ * item of its queue only starts after nm_dispatcher_queues_done(). With
+ * %FALSE, the item completed right away.
+ *
+ * Returns: the new queues. Free them with nm_dispatcher_queues_free().
+ */
+NMDispatcherQueues *
+nm_dispatcher_queues_new (guint max_parallel,
+                          NMDispatcherQueuesStartFunc start_func,
+                          gpointer user_data)
+{
+	NMDispatcherQueues *queues;
+
+	g_return_val_if_fail (max_parallel > 0, NULL);
+	g_return_val_if_fail (start_func, NULL);
+
+	queues = g_slice_new0 (NMDispatcherQueues);
+	queues->queues = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, _queue_free);
+	g_queue_init (&queues->queues_ready);
+	queues->max_parallel = max_parallel;
+	queues->start_func = start_func;
+	queues->user_data = user_data;
+	return queues;
+}
+
+void
+nm_dispatcher_queues_free (NMDispatcherQueues *queues)
+{
+	if (!queues)
+		return;
+
+	g_queue_clear (&queues->queues_ready);
+	g_hash_table_destroy (queues->queues);
+	g_slice_free (NMDispatcherQueues, queues);
+}
+
+/* Starts the next items of @q, until one of them keeps running. If there
+ * are no more items, @q is released along with its slot. */
+static void
+_queue_run (NMDispatcherQueues *queues, Queue *q)
+{
+	gpointer item;
+
+	nm_assert (q->running);
+
+	while ((item = g_queue_pop_head (&q->items))) {
+		if (queues->start_func (item, queues->user_data))
+			return;
+	}
+
+	queues->num_running--;
+	g_hash_table_remove (queues->queues, q->key);
+}
+
+/* Starts ready queues while less than @max_parallel are running. */
+static void
+_queues_start (NMDispatcherQueues *queues)
+{
+	Queue *q;
+
+	while (queues->num_running < queues->max_parallel) {
+		q = g_queue_pop_head (&queues->queues_ready);
+		if (!q)
+			return;
+
+		q->running = TRUE;
+		queues->num_running++;
+		_queue_run (queues, q);
+	}
+}
+
+/**
+ * nm_dispatcher_queues_add:
+ * @queues: the queues
+ * @key: the key of the queue for @item
+ * @item: the item
+ *
+ * Appends @item to the queue for @key. It starts right away, if the queue
+ * has no other items and there is a free slot.
+ */
+void
+nm_dispatcher_queues_add (NMDispatcherQueues *queues, const char *key, gpointer item)
+{
+	Queue *q;
+
+	g_return_if_fail (queues);
+	g_return_if_fail (key);
+	g_return_if_fail (item);
+
+	q = g_hash_table_lookup (queues->queues, key);
+	if (!q) {
+		q = g_slice_new0 (Queue);
+		q->key = g_strdup (key);
+		g_queue_init (&q->items);
+		g_hash_table_insert (queues->queues, q->key, q);
+		g_queue_push_tail (&queues->queues_ready, q);
+	}
+	g_queue_push_tail (&q->items, item);
+
+	_queues_start (queues);
+}
+
+/**
+ * nm_dispatcher_queues_done:
+ * @queues: the queues
+ * @key: the key of the queue
+ *
+ * Tells that the running item of the queue for @key completed, after
+ * @start_func returned %TRUE for it. Starts the next items.
+ */
+void
+nm_dispatcher_queues_done (NMDispatcherQueues *queues, const char *key)
+{
+	Queue *q;
+
+	g_return_if_fail (queues);
+	g_return_if_fail (key);
+
+	q = g_hash_table_lookup (queues->queues, key);
+	g_return_if_fail (q && q->running);
+
+	_queue_run (queues, q);
+	_queues_start (queues);
+}
+
+/**
+ * nm_dispatcher_queues_is_idle:
+ * @queues: the queues
+ *
+ * Returns: whether no queue is running or waiting.
+ */
+gboolean
+nm_dispatcher_queues_is_idle (NMDispatcherQueues *queues)
+{
+	g_return_val_if_fail (queues, TRUE);
+
+	return g_hash_table_size (queues->queues) == 0;
+}
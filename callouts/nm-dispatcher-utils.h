@@ -41,5 +41,20 @@ nm_dispatcher_utils_construct_envp (const char *action,
                                     char **out_iface,
                                     const char **out_error_message);
 
+const char *nm_dispatcher_utils_get_queue_key (char **envp, const char *iface);
+
+typedef struct _NMDispatcherQueues NMDispatcherQueues;
+
+typedef gboolean (*NMDispatcherQueuesStartFunc) (gpointer item, gpointer user_data);
+
+NMDispatcherQueues *nm_dispatcher_queues_new (guint max_parallel,
+                                              NMDispatcherQueuesStartFunc start_func,
+                                              gpointer user_data);
+void nm_dispatcher_queues_free (NMDispatcherQueues *queues);
+
+void nm_dispatcher_queues_add (NMDispatcherQueues *queues, const char *key, gpointer item);
+void nm_dispatcher_queues_done (NMDispatcherQueues *queues, const char *key);
+gboolean nm_dispatcher_queues_is_idle (NMDispatcherQueues *queues);
+
 #endif  /* __NETWORKMANAGER_DISPATCHER_UTILS_H__ */
 
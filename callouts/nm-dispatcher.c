@@ -43,6 +43,7 @@ static gboolean debug = FALSE;
 static gboolean persist = FALSE;
 static guint quit_id;
 static guint request_id_counter = 0;
+static gint max_parallel = 16;
 
 typedef struct Request Request;
 
@@ -52,8 +53,10 @@ typedef struct {
 	/* Private data */
 	NMDBusDispatcher *dbus_dispatcher;
 
-	Request *current_request;
-	GQueue *requests_waiting;
+	/* requests with "wait" scripts are ordered per device, see
+	 * nm_dispatcher_utils_get_queue_key(). Up to @max_parallel devices
+	 * run scripts at the same time. */
+	NMDispatcherQueues *queues;
 	gint num_requests_pending;
 } Handler;
 
@@ -89,10 +92,12 @@ handle_action (NMDBusDispatcher *dbus_dispatcher,
                gboolean request_debug,
                gpointer user_data);
 
+static gboolean request_start (gpointer item, gpointer user_data);
+
 static void
 handler_init (Handler *h)
 {
-	h->requests_waiting = g_queue_new ();
+	h->queues = nm_dispatcher_queues_new (max_parallel, request_start, h);
 	h->dbus_dispatcher = nmdbus_dispatcher_skeleton_new ();
 	g_signal_connect (h->dbus_dispatcher, "handle-action",
 	                  G_CALLBACK (handle_action), h);
@@ -104,6 +109,7 @@ handler_class_init (HandlerClass *h_class)
 }
 
 static gboolean dispatch_one_script (Request *request);
+static void complete_request (Request *request);
 
 typedef struct {
 	Request *request;
@@ -121,6 +127,13 @@ typedef struct {
 struct Request {
 	Handler *handler;
 
+	/* the key of the queue for requests with "wait" scripts. */
+	char *queue_key;
+
+	/* the request is the running one of its queue. It stays running
+	 * until all its scripts, including "no-wait" ones, completed. */
+	gboolean started;
+
 	guint request_id;
 
 	GDBusMethodInvocation *context;
@@ -202,6 +215,7 @@ request_free (Request *request)
 	g_assert_cmpuint (request->num_scripts_done, ==, request->scripts->len);
 	g_assert_cmpuint (request->num_scripts_nowait, ==, 0);
 
+	g_free (request->queue_key);
 	g_free (request->action);
 	g_free (request->iface);
 	g_strfreev (request->envp);
@@ -227,44 +241,32 @@ quit_timeout_reschedule (void)
 }
 
 /**
- * next_request:
- *
- * @h: the handler
- * @request: (allow-none): the request to set as next. If %NULL, dequeue the next
- * waiting request. Otherwise, try to set the given request.
+ * request_start:
+ * @item: a request of a queue
+ * @user_data: the handler
  *
- * Sets the currently active request (@current_request). The current request
- * is a request that has at least on "wait" script, because requests that only
- * consist of "no-wait" scripts are handled right away and not enqueued to
- * @requests_waiting nor set as @current_request.
+ * Starts the "wait" scripts of the request, once all previous requests
+ * of its queue completed.
  *
- * Returns: %TRUE, if there was currently not request in process and it set
- * a new request as current.
+ * Returns: %TRUE if the request is still running, %FALSE if it completed.
  */
 static gboolean
-next_request (Handler *h, Request *request)
+request_start (gpointer item, gpointer user_data)
 {
-	if (request) {
-		if (h->current_request) {
-			g_queue_push_tail (h->requests_waiting, request);
-			return FALSE;
-		}
-	} else {
-		/* when calling next_request() without explicit @request, we always
-		 * forcefully clear @current_request. That one is certainly
-		 * handled already. */
-		h->current_request = NULL;
-
-		request = g_queue_pop_head (h->requests_waiting);
-		if (!request)
-			return FALSE;
-	}
+	Request *request = item;
 
 	_LOG_R_I (request, "start running ordered scripts...");
 
-	h->current_request = request;
+	request->started = TRUE;
 
-	return TRUE;
+	if (dispatch_one_script (request))
+		return TRUE;
+
+	/* Complete the request. It has no more scripts to run, neither
+	 * "wait" ones, nor pending "no-wait" ones (otherwise
+	 * dispatch_one_script() would have returned TRUE). */
+	complete_request (request);
+	return FALSE;
 }
 
 /**
@@ -305,85 +307,39 @@ complete_request (Request *request)
 
 	_LOG_R_D (request, "completed (%u scripts)", request->scripts->len);
 
-	if (handler->current_request == request)
-		handler->current_request = NULL;
-
 	request_free (request);
 
 	g_assert_cmpuint (handler->num_requests_pending, >, 0);
-	if (--handler->num_requests_pending <= 0) {
-		nm_assert (!handler->current_request && !g_queue_peek_head (handler->requests_waiting));
+	if (--handler->num_requests_pending <= 0)
 		quit_timeout_reschedule ();
-	}
 }
 
 static void
 complete_script (ScriptInfo *script)
 {
-	Handler *handler;
-	Request *request;
-	gboolean wait = script->wait;
-
-	request = script->request;
+	Request *request = script->request;
+	NMDispatcherQueues *queues;
+	gs_free char *queue_key = NULL;
 
-	if (wait) {
-		/* for "wait" scripts, try to schedule the next blocking script.
-		 * If that is successful, return (as we must wait for its completion). */
-		if (dispatch_one_script (request))
-			return;
+	if (!request->started) {
+		/* a "no-wait" script of a request that either has no "wait"
+		 * scripts, or still waits in its queue. Complete the request,
+		 * if this was its last script. */
+		complete_request (request);
+		return;
 	}
 
-	handler = request->handler;
-
-	nm_assert (!wait || handler->current_request == request);
+	/* try to schedule the next "wait" script. That only happens
+	 * once all "no-wait" scripts completed. If a script is still
+	 * running, return (as we must wait for its completion). */
+	if (dispatch_one_script (request))
+		return;
 
-	/* Try to complete the request. @request will be possibly free'd,
-	 * making @script and @request a dangling pointer. */
+	/* @request completed, continue with the next request of the queue. */
+	queues = request->handler->queues;
+	queue_key = g_steal_pointer (&request->queue_key);
 	complete_request (request);
-
-	if (!wait) {
-		/* this was a "no-wait" script. We either completed the request,
-		 * or there is nothing to do. Especially, there is no need to
-		 * queue the next_request() -- because no-wait scripts don't block
-		 * requests. However, if this was the last "no-wait" script and
-		 * there are "wait" scripts ready to run, launch them.
-		 */
-		if (   handler->current_request == request
-		    && handler->current_request->num_scripts_nowait == 0) {
-
-			if (dispatch_one_script (handler->current_request))
-				return;
-
-			complete_request (handler->current_request);
-		} else
-			return;
-	} else {
-		/* if the script is a "wait" script, we already tried above to
-		 * dispatch the next script. As we didn't do that, it means we
-		 * just completed the last script of @request and we can continue
-		 * with the next request...
-		 *
-		 * Also, it cannot be that there is another request currently being
-		 * processed because only requests with "wait" scripts can become
-		 * @current_request. As there can only be one "wait" script running
-		 * at any time, it means complete_request() above completed @request. */
-		nm_assert (!handler->current_request);
-	}
-
-	while (next_request (handler, NULL)) {
-		request = handler->current_request;
-
-		if (dispatch_one_script (request))
-			return;
-
-		/* Try to complete the request. It will be either completed
-		 * now, or when all pending "no-wait" scripts return. */
-		complete_request (request);
-
-		/* We can immediately start next_request(), because our current
-		 * @request has obviously no more "wait" scripts either.
-		 * Repeat... */
-	}
+	nm_dispatcher_queues_done (queues, queue_key);
 }
 
 static void
@@ -495,33 +451,6 @@ check_permissions (struct stat *s, const char **out_error_msg)
 	return TRUE;
 }
 
-static gboolean
-check_filename (const char *file_name)
-{
-	static const char *bad_suffixes[] = {
-		"~",
-		".rpmsave",
-		".rpmorig",
-		".rpmnew",
-		".swp",
-	};
-	char *tmp;
-	guint i;
-
-	/* File must not be a backup file, package management file, or start with '.' */
-
-	if (file_name[0] == '.')
-		return FALSE;
-	for (i = 0; i < G_N_ELEMENTS (bad_suffixes); i++) {
-		if (g_str_has_suffix (file_name, bad_suffixes[i]))
-			return FALSE;
-	}
-	tmp = g_strrstr (file_name, ".dpkg-");
-	if (tmp && !strchr (&tmp[1], '.'))
-		return FALSE;
-	return TRUE;
-}
-
 #define SCRIPT_TIMEOUT 600  /* 10 minutes */
 
 static gboolean
@@ -608,7 +537,7 @@ find_scripts (const char *str_action)
 		int err;
 		const char *err_msg = NULL;
 
-		if (!check_filename (filename))
+		if (!nm_dispatcher_script_name_is_valid (filename))
 			continue;
 
 		path = g_build_filename (dirname, filename, NULL);
@@ -762,35 +691,19 @@ handle_action (NMDBusDispatcher *dbus_dispatcher,
 	}
 
 	if (num_nowait < request->scripts->len) {
-		/* The request has at least one wait script.
-		 * Try next_request() to schedule the request for
-		 * execution. This either enqueues the request or
-		 * sets it as h->current_request. */
-		if (next_request (h, request)) {
-			/* @request is now @current_request. Go ahead and
-			 * schedule the first wait script. */
-			if (!dispatch_one_script (request)) {
-				/* If that fails, we might be already finished with the
-				 * request. Try complete_request(). */
-				complete_request (request);
-
-				if (next_request (h, NULL)) {
-					/* As @request was successfully scheduled as next_request(), there is no
-					 * other request in queue that can be scheduled afterwards. Assert against
-					 * that, but call next_request() to clear current_request. */
-					g_assert_not_reached ();
-				}
-			}
-		}
+		/* The request has at least one wait script. Enqueue it
+		 * behind the other requests for the same device. It
+		 * starts right away, if there are none and there is a
+		 * free slot. */
+		request->queue_key = g_strdup (nm_dispatcher_utils_get_queue_key (request->envp, request->iface));
+		nm_dispatcher_queues_add (h->queues, request->queue_key, request);
 	} else {
 		/* The request contains only no-wait scripts. Try to complete
 		 * the request right away (we might have failed to schedule any
 		 * of the scripts). It will be either completed now, or later
 		 * when the pending scripts return.
-		 * We don't enqueue it to h->requests_waiting.
-		 * There is no need to handle next_request(), because @request is
-		 * not the current request anyway and does not interfere with requests
-		 * that have any "wait" scripts. */
+		 * We don't enqueue it to a queue, because it does not
+		 * interfere with requests that have any "wait" scripts. */
 		complete_request (request);
 	}
 
@@ -901,6 +814,7 @@ main (int argc, char **argv)
 	GOptionEntry entries[] = {
 		{ "debug", 0, 0, G_OPTION_ARG_NONE, &debug, "Output to console rather than syslog", NULL },
 		{ "persist", 0, 0, G_OPTION_ARG_NONE, &persist, "Don't quit after a short timeout", NULL },
+		{ "max-parallel", 0, 0, G_OPTION_ARG_INT, &max_parallel, "Maximum number of interfaces to run scripts for at the same time (default: 16)", "N" },
 		{ NULL }
 	};
 
@@ -916,6 +830,11 @@ main (int argc, char **argv)
 
 	g_option_context_free (opt_ctx);
 
+	if (max_parallel < 1) {
+		g_warning ("Invalid value for --max-parallel: %d", max_parallel);
+		return 1;
+	}
+
 	nm_g_type_init ();
 
 	g_unix_signal_add (SIGTERM, signal_handler, GINT_TO_POINTER (SIGTERM));
@@ -966,7 +885,7 @@ main (int argc, char **argv)
 
 	g_main_loop_run (loop);
 
-	g_queue_free (handler->requests_waiting);
+	nm_dispatcher_queues_free (handler->queues);
 	g_object_unref (handler);
 
 	if (!debug)
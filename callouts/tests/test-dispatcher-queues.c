@@ -0,0 +1,226 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ *
+ */
+
+#include "nm-default.h"
+
+#include <string.h>
+
+#include "nm-dispatcher-utils.h"
+
+#include "nm-utils/nm-test-utils.h"
+
+/*******************************************/
+
+typedef struct {
+	NMDispatcherQueues *queues;
+	GString *started;
+} TestData;
+
+/* records the started items. Items whose name starts with '!' complete
+ * right away, the others keep running until nm_dispatcher_queues_done(). */
+static gboolean
+_start_func (gpointer item, gpointer user_data)
+{
+	TestData *data = user_data;
+	const char *name = item;
+
+	if (data->started->len)
+		g_string_append_c (data->started, ' ');
+	g_string_append (data->started, name);
+	return name[0] != '!';
+}
+
+static void
+_test_data_init (TestData *data, guint max_parallel)
+{
+	data->queues = nm_dispatcher_queues_new (max_parallel, _start_func, data);
+	data->started = g_string_new (NULL);
+}
+
+static void
+_test_data_clear (TestData *data)
+{
+	g_assert (nm_dispatcher_queues_is_idle (data->queues));
+	nm_dispatcher_queues_free (data->queues);
+	g_string_free (data->started, TRUE);
+}
+
+#define _assert_started(data, expected) \
+	G_STMT_START { \
+		g_assert_cmpstr ((data)->started->str, ==, (expected)); \
+		g_string_truncate ((data)->started, 0); \
+	} G_STMT_END
+
+/*******************************************/
+
+static void
+test_queues_ordering (void)
+{
+	TestData data;
+
+	_test_data_init (&data, 16);
+
+	/* requests for the same interface run one after another. */
+	nm_dispatcher_queues_add (data.queues, "eth0", "eth0-1");
+	nm_dispatcher_queues_add (data.queues, "eth0", "eth0-2");
+	nm_dispatcher_queues_add (data.queues, "eth0", "eth0-3");
+	_assert_started (&data, "eth0-1");
+
+	nm_dispatcher_queues_done (data.queues, "eth0");
+	_assert_started (&data, "eth0-2");
+
+	nm_dispatcher_queues_add (data.queues, "eth0", "eth0-4");
+	_assert_started (&data, "");
+
+	nm_dispatcher_queues_done (data.queues, "eth0");
+	_assert_started (&data, "eth0-3");
+	nm_dispatcher_queues_done (data.queues, "eth0");
+	_assert_started (&data, "eth0-4");
+	nm_dispatcher_queues_done (data.queues, "eth0");
+	_assert_started (&data, "");
+
+	/* requests that complete right away don't hold up the queue. */
+	nm_dispatcher_queues_add (data.queues, "eth0", "eth0-5");
+	nm_dispatcher_queues_add (data.queues, "eth0", "!eth0-6");
+	nm_dispatcher_queues_add (data.queues, "eth0", "!eth0-7");
+	nm_dispatcher_queues_add (data.queues, "eth0", "eth0-8");
+	_assert_started (&data, "eth0-5");
+	nm_dispatcher_queues_done (data.queues, "eth0");
+	_assert_started (&data, "!eth0-6 !eth0-7 eth0-8");
+	nm_dispatcher_queues_done (data.queues, "eth0");
+
+	nm_dispatcher_queues_add (data.queues, "eth0", "!eth0-9");
+	_assert_started (&data, "!eth0-9");
+
+	_test_data_clear (&data);
+}
+
+static void
+test_queues_parallel (void)
+{
+	TestData data;
+
+	_test_data_init (&data, 16);
+
+	/* different interfaces don't wait for each other. */
+	nm_dispatcher_queues_add (data.queues, "eth0", "eth0-1");
+	nm_dispatcher_queues_add (data.queues, "eth1", "eth1-1");
+	nm_dispatcher_queues_add (data.queues, "eth0", "eth0-2");
+	nm_dispatcher_queues_add (data.queues, "eth2", "eth2-1");
+	_assert_started (&data, "eth0-1 eth1-1 eth2-1");
+
+	nm_dispatcher_queues_done (data.queues, "eth1");
+	_assert_started (&data, "");
+	nm_dispatcher_queues_done (data.queues, "eth0");
+	_assert_started (&data, "eth0-2");
+	nm_dispatcher_queues_done (data.queues, "eth2");
+	nm_dispatcher_queues_done (data.queues, "eth0");
+	_assert_started (&data, "");
+
+	_test_data_clear (&data);
+}
+
+static void
+test_queues_max_parallel (void)
+{
+	TestData data;
+
+	_test_data_init (&data, 2);
+
+	/* only two interfaces run at the same time, the others wait
+	 * in the order they came in. */
+	nm_dispatcher_queues_add (data.queues, "eth0", "eth0-1");
+	nm_dispatcher_queues_add (data.queues, "eth1", "eth1-1");
+	nm_dispatcher_queues_add (data.queues, "eth2", "eth2-1");
+	nm_dispatcher_queues_add (data.queues, "eth3", "eth3-1");
+	nm_dispatcher_queues_add (data.queues, "eth0", "eth0-2");
+	_assert_started (&data, "eth0-1 eth1-1");
+
+	/* a running interface keeps its slot until its queue is empty. */
+	nm_dispatcher_queues_done (data.queues, "eth0");
+	_assert_started (&data, "eth0-2");
+
+	nm_dispatcher_queues_done (data.queues, "eth1");
+	_assert_started (&data, "eth2-1");
+
+	nm_dispatcher_queues_add (data.queues, "eth4", "!eth4-1");
+	_assert_started (&data, "");
+	nm_dispatcher_queues_done (data.queues, "eth0");
+	_assert_started (&data, "eth3-1");
+	nm_dispatcher_queues_done (data.queues, "eth2");
+	_assert_started (&data, "!eth4-1");
+
+	/* a queue that completed right away freed its slot again. */
+	nm_dispatcher_queues_add (data.queues, "eth5", "eth5-1");
+	_assert_started (&data, "eth5-1");
+
+	nm_dispatcher_queues_done (data.queues, "eth3");
+	nm_dispatcher_queues_done (data.queues, "eth5");
+	_assert_started (&data, "");
+
+	_test_data_clear (&data);
+}
+
+static void
+test_queue_key (void)
+{
+	char *envp_up[] = {
+		"CONNECTION_UUID=355653c0-34d3-4777-ad25-f9a498b7ef8e",
+		"DEVICE_IFACE=wlan0",
+		"DEVICE_IP_IFACE=wlan0",
+		NULL,
+	};
+	char *envp_vpn_up[] = {
+		"CONNECTION_UUID=355653c0-34d3-4777-ad25-f9a498b7ef8e",
+		"DEVICE_IFACE=wlan0",
+		"DEVICE_IP_IFACE=tun0",
+		"VPN_IP_IFACE=tun0",
+		NULL,
+	};
+	char *envp_hostname[] = {
+		"PATH=/usr/bin",
+		NULL,
+	};
+
+	/* VPN requests are ordered with the requests of their device. */
+	g_assert_cmpstr (nm_dispatcher_utils_get_queue_key (envp_up, "wlan0"), ==, "wlan0");
+	g_assert_cmpstr (nm_dispatcher_utils_get_queue_key (envp_vpn_up, "tun0"), ==, "wlan0");
+
+	g_assert_cmpstr (nm_dispatcher_utils_get_queue_key (envp_hostname, NULL), ==, "");
+	g_assert_cmpstr (nm_dispatcher_utils_get_queue_key (NULL, NULL), ==, "");
+	g_assert_cmpstr (nm_dispatcher_utils_get_queue_key (NULL, "eth0"), ==, "eth0");
+}
+
+/*******************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init (&argc, &argv, TRUE);
+
+	g_test_add_func ("/dispatcher/queues/ordering", test_queues_ordering);
+	g_test_add_func ("/dispatcher/queues/parallel", test_queues_parallel);
+	g_test_add_func ("/dispatcher/queues/max_parallel", test_queues_max_parallel);
+	g_test_add_func ("/dispatcher/queues/key", test_queue_key);
+
+	return g_test_run ();
+}
@@ -123,6 +123,8 @@ NMConnection *_nm_simple_connection_new_from_dbus (GVariant      *dict,
 
 guint32 _nm_setting_get_setting_priority (NMSetting *setting);
 
+void _nm_setting_ensure_all_registered (void);
+
 gboolean _nm_setting_get_property (NMSetting *setting, const char *name, GValue *value);
 
 guint _nm_utils_hwaddr_length (const char *asc);
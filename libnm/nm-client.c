@@ -36,6 +36,7 @@
 #include "nm-remote-connection.h"
 #include "nm-object-cache.h"
 #include "nm-dbus-helpers.h"
+#include "nm-object-private.h"
 
 void _nm_device_wifi_set_wireless_enabled (NMDeviceWifi *device, gboolean enabled);
 
@@ -52,6 +53,7 @@ G_DEFINE_TYPE_WITH_CODE (NMClient, nm_client, G_TYPE_OBJECT,
 typedef struct {
 	NMManager *manager;
 	NMRemoteSettings *settings;
+	gboolean prefetch_started;
 } NMClientPrivate;
 
 enum {
@@ -1813,6 +1815,17 @@ init_sync (GInitable *initable, GCancellable *cancellable, GError **error)
 {
 	NMClient *client = NM_CLIENT (initable);
 	NMClientPrivate *priv = NM_CLIENT_GET_PRIVATE (client);
+	GDBusConnection *connection;
+
+	/* Load the properties of all objects at once, instead of letting each
+	 * object fetch its own. */
+	connection = _nm_dbus_new_connection (cancellable, error);
+	if (!connection)
+		return FALSE;
+	priv->prefetch_started = _nm_object_prefetch_start (connection);
+	g_object_unref (connection);
+	if (priv->prefetch_started)
+		_nm_object_prefetch_load (cancellable);
 
 	if (!g_initable_init (G_INITABLE (priv->manager), cancellable, error))
 		return FALSE;
@@ -1867,12 +1880,60 @@ init_async_inited_settings (GObject *object, GAsyncResult *result, gpointer user
 		init_async_complete (init_data);
 }
 
+static void
+init_async_init_objects (NMClientInitData *init_data)
+{
+	NMClientPrivate *priv = NM_CLIENT_GET_PRIVATE (init_data->client);
+
+	g_async_initable_init_async (G_ASYNC_INITABLE (priv->manager),
+	                             G_PRIORITY_DEFAULT, init_data->cancellable,
+	                             init_async_inited_manager, init_data);
+	g_async_initable_init_async (G_ASYNC_INITABLE (priv->settings),
+	                             G_PRIORITY_DEFAULT, init_data->cancellable,
+	                             init_async_inited_settings, init_data);
+}
+
+static void
+init_async_prefetched (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+	NMClientInitData *init_data = user_data;
+
+	_nm_object_prefetch_load_finish (result);
+	init_async_init_objects (init_data);
+}
+
+static void
+init_async_got_bus (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+	NMClientInitData *init_data = user_data;
+	NMClientPrivate *priv = NM_CLIENT_GET_PRIVATE (init_data->client);
+	GDBusConnection *connection;
+	GError *error = NULL;
+
+	connection = _nm_dbus_new_connection_finish (result, &error);
+	if (!connection) {
+		g_simple_async_result_take_error (init_data->result, error);
+		init_async_complete (init_data);
+		return;
+	}
+
+	/* Load the properties of all objects at once, instead of letting each
+	 * object fetch its own. */
+	priv->prefetch_started = _nm_object_prefetch_start (connection);
+	g_object_unref (connection);
+	if (priv->prefetch_started) {
+		_nm_object_prefetch_load_async (init_data->cancellable, init_async_prefetched, init_data);
+		return;
+	}
+
+	init_async_init_objects (init_data);
+}
+
 static void
 init_async (GAsyncInitable *initable, int io_priority,
             GCancellable *cancellable, GAsyncReadyCallback callback,
             gpointer user_data)
 {
-	NMClientPrivate *priv = NM_CLIENT_GET_PRIVATE (initable);
 	NMClientInitData *init_data;
 
 	init_data = g_slice_new0 (NMClientInitData);
@@ -1882,12 +1943,7 @@ init_async (GAsyncInitable *initable, int io_priority,
 	                                               user_data, init_async);
 	g_simple_async_result_set_op_res_gboolean (init_data->result, TRUE);
 
-	g_async_initable_init_async (G_ASYNC_INITABLE (priv->manager),
-	                             G_PRIORITY_DEFAULT, init_data->cancellable,
-	                             init_async_inited_manager, init_data);
-	g_async_initable_init_async (G_ASYNC_INITABLE (priv->settings),
-	                             G_PRIORITY_DEFAULT, init_data->cancellable,
-	                             init_async_inited_settings, init_data);
+	_nm_dbus_new_connection_async (init_data->cancellable, init_async_got_bus, init_data);
 }
 
 static gboolean
@@ -1915,6 +1971,11 @@ dispose (GObject *object)
 		g_clear_object (&priv->settings);
 	}
 
+	if (priv->prefetch_started) {
+		priv->prefetch_started = FALSE;
+		_nm_object_prefetch_stop ();
+	}
+
 	G_OBJECT_CLASS (nm_client_parent_class)->dispose (object);
 }
 
@@ -48,6 +48,14 @@ gboolean _nm_object_reload_properties_finish (NMObject *object,
                                               GAsyncResult *result,
                                               GError **error);
 
+gboolean _nm_object_prefetch_start         (GDBusConnection *connection);
+void     _nm_object_prefetch_stop          (void);
+void     _nm_object_prefetch_load          (GCancellable *cancellable);
+void     _nm_object_prefetch_load_async    (GCancellable *cancellable,
+                                            GAsyncReadyCallback callback,
+                                            gpointer user_data);
+void     _nm_object_prefetch_load_finish   (GAsyncResult *result);
+
 void _nm_object_queue_notify (NMObject *object, const char *property);
 
 void _nm_object_suppress_property_updates (NMObject *object, gboolean suppress);
@@ -371,6 +371,461 @@ _nm_object_register_type_func (GType base_type,
 	                     type_data);
 }
 
+/*****************************************************************************/
+
+/* Prefetched properties.
+ *
+ * Instead of calling GetAll() for every interface of every object, NMClient
+ * fetches the properties of all objects with one GetManagedObjects() call on
+ * the daemon's object manager. The result is kept here by object path and
+ * interface until the NMObject for that path is initialized and takes it.
+ *
+ * Until then, InterfacesAdded/InterfacesRemoved and PropertiesChanged signals
+ * are applied to the stored properties. A signal that is dispatched shortly
+ * after an object took its properties might have been received before the
+ * object's own proxies subscribed to it. Such signals are applied to the
+ * object directly, until the next idle. */
+
+#define DBUS_INTERFACE_OBJECT_MANAGER "org.freedesktop.DBus.ObjectManager"
+
+/* The daemon exports its GDBusObjectManagerServer at the parent of NM_DBUS_PATH. */
+#define NM_DBUS_OBJECT_MANAGER_PATH   "/org/freedesktop"
+
+typedef struct {
+	GDBusConnection *connection;
+	guint refcount;
+
+	/* path -> (interface -> (property name -> GVariant)). The property names
+	 * are normalized with wincaps_to_dash(), as the daemon's PropertiesChanged
+	 * signals don't use the same spelling as GetManagedObjects(). */
+	GHashTable *objects;
+
+	/* paths of objects that took their properties since the last idle. */
+	GHashTable *taken;
+	guint taken_idle_id;
+
+	guint properties_changed_id;
+	guint interfaces_added_id;
+	guint interfaces_removed_id;
+	guint name_owner_changed_id;
+} NMObjectPrefetch;
+
+static NMObjectPrefetch *prefetch;
+
+static void process_properties_changed (NMObject *self, GVariant *properties, gboolean synchronously);
+static char *wincaps_to_dash (const char *caps);
+
+static void
+_prefetch_props_update (GHashTable *props, GVariant *dict)
+{
+	GVariantIter iter;
+	const char *name;
+	GVariant *value;
+
+	g_variant_iter_init (&iter, dict);
+	while (g_variant_iter_next (&iter, "{&sv}", &name, &value))
+		g_hash_table_insert (props, wincaps_to_dash (name), value);
+}
+
+static void
+_prefetch_add_object (const char *path, GVariant *interfaces)
+{
+	GHashTable *ifaces, *props;
+	GVariantIter iter;
+	const char *interface;
+	GVariant *dict;
+
+	ifaces = g_hash_table_lookup (prefetch->objects, path);
+	if (!ifaces) {
+		ifaces = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_unref);
+		g_hash_table_insert (prefetch->objects, g_strdup (path), ifaces);
+	}
+
+	g_variant_iter_init (&iter, interfaces);
+	while (g_variant_iter_next (&iter, "{&s@a{sv}}", &interface, &dict)) {
+		props = g_hash_table_lookup (ifaces, interface);
+		if (!props) {
+			props = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_variant_unref);
+			g_hash_table_insert (ifaces, g_strdup (interface), props);
+		}
+		_prefetch_props_update (props, dict);
+		g_variant_unref (dict);
+	}
+}
+
+static gboolean
+_prefetch_taken_clear (gpointer user_data)
+{
+	prefetch->taken_idle_id = 0;
+	g_hash_table_remove_all (prefetch->taken);
+	return G_SOURCE_REMOVE;
+}
+
+/* Returns the prefetched properties of @interface as a{sv} and forgets about them,
+ * or %NULL if there are none. */
+static GVariant *
+_prefetch_take (NMObject *object, const char *interface)
+{
+	NMObjectPrivate *priv = NM_OBJECT_GET_PRIVATE (object);
+	GHashTable *ifaces, *props;
+	GVariantBuilder builder;
+	GHashTableIter iter;
+	const char *name;
+	GVariant *value;
+
+	if (   !prefetch
+	    || prefetch->connection != priv->connection)
+		return NULL;
+
+	ifaces = g_hash_table_lookup (prefetch->objects, priv->path);
+	if (!ifaces)
+		return NULL;
+	props = g_hash_table_lookup (ifaces, interface);
+	if (!props)
+		return NULL;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+	g_hash_table_iter_init (&iter, props);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &name, (gpointer *) &value))
+		g_variant_builder_add (&builder, "{sv}", name, value);
+
+	g_hash_table_remove (ifaces, interface);
+	if (!g_hash_table_size (ifaces))
+		g_hash_table_remove (prefetch->objects, priv->path);
+
+	g_hash_table_add (prefetch->taken, g_strdup (priv->path));
+	if (!prefetch->taken_idle_id)
+		prefetch->taken_idle_id = g_idle_add (_prefetch_taken_clear, NULL);
+
+	return g_variant_ref_sink (g_variant_builder_end (&builder));
+}
+
+/* Returns a reference to the prefetched value of a single property, or %NULL. */
+static GVariant *
+_prefetch_peek (GDBusConnection *connection,
+                const char *path,
+                const char *interface,
+                const char *property)
+{
+	GHashTable *ifaces, *props;
+	GVariant *value;
+	gs_free char *name = NULL;
+
+	if (   !prefetch
+	    || prefetch->connection != connection)
+		return NULL;
+
+	ifaces = g_hash_table_lookup (prefetch->objects, path);
+	if (!ifaces)
+		return NULL;
+	props = g_hash_table_lookup (ifaces, interface);
+	if (!props)
+		return NULL;
+	name = wincaps_to_dash (property);
+	value = g_hash_table_lookup (props, name);
+	return value ? g_variant_ref (value) : NULL;
+}
+
+static void
+_prefetch_properties_changed (GDBusConnection *connection,
+                              const char *sender_name,
+                              const char *object_path,
+                              const char *interface_name,
+                              const char *signal_name,
+                              GVariant *parameters,
+                              gpointer user_data)
+{
+	gs_unref_variant GVariant *dict = NULL;
+	const char *interface;
+	GHashTable *ifaces, *props = NULL;
+	NMObject *object;
+
+	if (!prefetch)
+		return;
+
+	/* The daemon emits both org.freedesktop.DBus.Properties.PropertiesChanged and
+	 * the PropertiesChanged signal of the interface itself. Accept both, applying
+	 * the same change twice is harmless. */
+	if (!strcmp (interface_name, DBUS_INTERFACE_PROPERTIES)) {
+		if (!g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(sa{sv}as)")))
+			return;
+		g_variant_get (parameters, "(&s@a{sv}as)", &interface, &dict, NULL);
+	} else {
+		if (!g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(a{sv})")))
+			return;
+		interface = interface_name;
+		g_variant_get (parameters, "(@a{sv})", &dict);
+	}
+
+	ifaces = g_hash_table_lookup (prefetch->objects, object_path);
+	if (ifaces)
+		props = g_hash_table_lookup (ifaces, interface);
+	if (props) {
+		_prefetch_props_update (props, dict);
+		return;
+	}
+
+	if (!g_hash_table_contains (prefetch->taken, object_path))
+		return;
+
+	object = _nm_object_cache_get (object_path);
+	if (object) {
+		process_properties_changed (object, dict, FALSE);
+		g_object_unref (object);
+	}
+}
+
+static void
+_prefetch_interfaces_added (GDBusConnection *connection,
+                            const char *sender_name,
+                            const char *object_path,
+                            const char *interface_name,
+                            const char *signal_name,
+                            GVariant *parameters,
+                            gpointer user_data)
+{
+	gs_unref_variant GVariant *interfaces = NULL;
+	const char *path;
+	NMObject *object;
+
+	if (   !prefetch
+	    || !g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(oa{sa{sv}})")))
+		return;
+
+	g_variant_get (parameters, "(&o@a{sa{sv}})", &path, &interfaces);
+
+	/* an existing object reloads its properties itself. */
+	object = _nm_object_cache_get (path);
+	if (object) {
+		g_object_unref (object);
+		return;
+	}
+
+	_prefetch_add_object (path, interfaces);
+}
+
+static void
+_prefetch_interfaces_removed (GDBusConnection *connection,
+                              const char *sender_name,
+                              const char *object_path,
+                              const char *interface_name,
+                              const char *signal_name,
+                              GVariant *parameters,
+                              gpointer user_data)
+{
+	const char **interfaces;
+	const char *path;
+	GHashTable *ifaces;
+	guint i;
+
+	if (   !prefetch
+	    || !g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(oas)")))
+		return;
+
+	g_variant_get (parameters, "(&o^a&s)", &path, &interfaces);
+
+	ifaces = g_hash_table_lookup (prefetch->objects, path);
+	if (ifaces) {
+		for (i = 0; interfaces[i]; i++)
+			g_hash_table_remove (ifaces, interfaces[i]);
+		if (!g_hash_table_size (ifaces))
+			g_hash_table_remove (prefetch->objects, path);
+	}
+	g_free (interfaces);
+}
+
+static void
+_prefetch_name_owner_changed (GDBusConnection *connection,
+                              const char *sender_name,
+                              const char *object_path,
+                              const char *interface_name,
+                              const char *signal_name,
+                              GVariant *parameters,
+                              gpointer user_data)
+{
+	/* the properties of a previous daemon instance are useless. */
+	if (prefetch)
+		g_hash_table_remove_all (prefetch->objects);
+}
+
+/**
+ * _nm_object_prefetch_start:
+ * @connection: the #GDBusConnection to the daemon
+ *
+ * Starts tracking prefetched properties for objects on @connection. A
+ * successful call must be paired with _nm_object_prefetch_stop().
+ *
+ * Returns: %TRUE if prefetching was started. It is not supported for
+ *   a second connection at the same time.
+ */
+gboolean
+_nm_object_prefetch_start (GDBusConnection *connection)
+{
+	const char *name;
+
+	g_return_val_if_fail (G_IS_DBUS_CONNECTION (connection), FALSE);
+
+	if (prefetch) {
+		if (prefetch->connection != connection)
+			return FALSE;
+		prefetch->refcount++;
+		return TRUE;
+	}
+
+	name = _nm_dbus_is_connection_private (connection) ? NULL : NM_DBUS_SERVICE;
+
+	prefetch = g_slice_new0 (NMObjectPrefetch);
+	prefetch->connection = g_object_ref (connection);
+	prefetch->refcount = 1;
+	prefetch->objects = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_unref);
+	prefetch->taken = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	/* Subscribe before calling GetManagedObjects(), so that no change
+	 * after the reply goes unnoticed. */
+	prefetch->properties_changed_id =
+	    g_dbus_connection_signal_subscribe (connection, name, NULL, "PropertiesChanged",
+	                                        NULL, NULL, G_DBUS_SIGNAL_FLAGS_NONE,
+	                                        _prefetch_properties_changed, NULL, NULL);
+	prefetch->interfaces_added_id =
+	    g_dbus_connection_signal_subscribe (connection, name, DBUS_INTERFACE_OBJECT_MANAGER, "InterfacesAdded",
+	                                        NM_DBUS_OBJECT_MANAGER_PATH, NULL, G_DBUS_SIGNAL_FLAGS_NONE,
+	                                        _prefetch_interfaces_added, NULL, NULL);
+	prefetch->interfaces_removed_id =
+	    g_dbus_connection_signal_subscribe (connection, name, DBUS_INTERFACE_OBJECT_MANAGER, "InterfacesRemoved",
+	                                        NM_DBUS_OBJECT_MANAGER_PATH, NULL, G_DBUS_SIGNAL_FLAGS_NONE,
+	                                        _prefetch_interfaces_removed, NULL, NULL);
+	if (name) {
+		prefetch->name_owner_changed_id =
+		    g_dbus_connection_signal_subscribe (connection, DBUS_SERVICE_DBUS, DBUS_INTERFACE_DBUS, "NameOwnerChanged",
+		                                        DBUS_PATH_DBUS, NM_DBUS_SERVICE, G_DBUS_SIGNAL_FLAGS_NONE,
+		                                        _prefetch_name_owner_changed, NULL, NULL);
+	}
+
+	return TRUE;
+}
+
+void
+_nm_object_prefetch_stop (void)
+{
+	g_return_if_fail (prefetch);
+
+	if (--prefetch->refcount > 0)
+		return;
+
+	g_dbus_connection_signal_unsubscribe (prefetch->connection, prefetch->properties_changed_id);
+	g_dbus_connection_signal_unsubscribe (prefetch->connection, prefetch->interfaces_added_id);
+	g_dbus_connection_signal_unsubscribe (prefetch->connection, prefetch->interfaces_removed_id);
+	if (prefetch->name_owner_changed_id)
+		g_dbus_connection_signal_unsubscribe (prefetch->connection, prefetch->name_owner_changed_id);
+	nm_clear_g_source (&prefetch->taken_idle_id);
+	g_hash_table_unref (prefetch->objects);
+	g_hash_table_unref (prefetch->taken);
+	g_object_unref (prefetch->connection);
+	g_slice_free (NMObjectPrefetch, prefetch);
+	prefetch = NULL;
+}
+
+static void
+_prefetch_add_managed_objects (GVariant *ret)
+{
+	GVariantIter *iter;
+	const char *path;
+	GVariant *interfaces;
+
+	g_variant_get (ret, "(a{oa{sa{sv}}})", &iter);
+	while (g_variant_iter_next (iter, "{&o@a{sa{sv}}}", &path, &interfaces)) {
+		_prefetch_add_object (path, interfaces);
+		g_variant_unref (interfaces);
+	}
+	g_variant_iter_free (iter);
+}
+
+/**
+ * _nm_object_prefetch_load:
+ * @cancellable: a #GCancellable
+ *
+ * Fetches the properties of all objects with a single GetManagedObjects()
+ * call. Errors are not fatal, objects then fetch their properties themselves.
+ */
+void
+_nm_object_prefetch_load (GCancellable *cancellable)
+{
+	GVariant *ret;
+	GError *error = NULL;
+
+	g_return_if_fail (prefetch);
+
+	ret = g_dbus_connection_call_sync (prefetch->connection,
+	                                   _nm_dbus_is_connection_private (prefetch->connection) ? NULL : NM_DBUS_SERVICE,
+	                                   NM_DBUS_OBJECT_MANAGER_PATH,
+	                                   DBUS_INTERFACE_OBJECT_MANAGER,
+	                                   "GetManagedObjects",
+	                                   NULL,
+	                                   G_VARIANT_TYPE ("(a{oa{sa{sv}}})"),
+	                                   G_DBUS_CALL_FLAGS_NO_AUTO_START, -1,
+	                                   cancellable, &error);
+	if (!ret) {
+		dbgmsg ("%s: GetManagedObjects failed: %s", __func__, error->message);
+		g_error_free (error);
+		return;
+	}
+
+	_prefetch_add_managed_objects (ret);
+	g_variant_unref (ret);
+}
+
+static void
+prefetch_load_cb (GObject *source, GAsyncResult *result, gpointer user_data)
+{
+	GSimpleAsyncResult *simple = user_data;
+	GVariant *ret;
+	GError *error = NULL;
+
+	ret = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source), result, &error);
+	if (!ret) {
+		dbgmsg ("%s: GetManagedObjects failed: %s", __func__, error->message);
+		g_error_free (error);
+	} else {
+		/* prefetching might have been stopped meanwhile. */
+		if (prefetch && prefetch->connection == G_DBUS_CONNECTION (source))
+			_prefetch_add_managed_objects (ret);
+		g_variant_unref (ret);
+	}
+
+	g_simple_async_result_complete (simple);
+	g_object_unref (simple);
+}
+
+void
+_nm_object_prefetch_load_async (GCancellable *cancellable,
+                                GAsyncReadyCallback callback,
+                                gpointer user_data)
+{
+	GSimpleAsyncResult *simple;
+
+	g_return_if_fail (prefetch);
+
+	simple = g_simple_async_result_new (NULL, callback, user_data, _nm_object_prefetch_load_async);
+	g_dbus_connection_call (prefetch->connection,
+	                        _nm_dbus_is_connection_private (prefetch->connection) ? NULL : NM_DBUS_SERVICE,
+	                        NM_DBUS_OBJECT_MANAGER_PATH,
+	                        DBUS_INTERFACE_OBJECT_MANAGER,
+	                        "GetManagedObjects",
+	                        NULL,
+	                        G_VARIANT_TYPE ("(a{oa{sa{sv}}})"),
+	                        G_DBUS_CALL_FLAGS_NO_AUTO_START, -1,
+	                        cancellable,
+	                        prefetch_load_cb, simple);
+}
+
+void
+_nm_object_prefetch_load_finish (GAsyncResult *result)
+{
+	g_return_if_fail (g_simple_async_result_is_valid (result, NULL, _nm_object_prefetch_load_async));
+}
+
+/*****************************************************************************/
+
 static GObject *
 _nm_object_create (GType type, GDBusConnection *connection, const char *path)
 {
@@ -383,6 +838,13 @@ _nm_object_create (GType type, GDBusConnection *connection, const char *path)
 		GDBusProxy *proxy;
 		GVariant *ret, *value;
 
+		value = _prefetch_peek (connection, path, type_data->interface, type_data->property);
+		if (value) {
+			type = type_data->type_func (value);
+			g_variant_unref (value);
+			goto create;
+		}
+
 		proxy = _nm_dbus_new_proxy_for_connection (connection, path,
 		                                           DBUS_INTERFACE_PROPERTIES,
 		                                           NULL, &error);
@@ -413,6 +875,7 @@ _nm_object_create (GType type, GDBusConnection *connection, const char *path)
 		g_variant_unref (ret);
 	}
 
+create:
 	if (type == G_TYPE_INVALID) {
 		dbgmsg ("Could not create object for %s: unknown object type", path);
 		return NULL;
@@ -613,6 +1076,18 @@ _nm_object_create_async (GType type, GDBusConnection *connection, const char *pa
 
 	async_data->type_data = g_hash_table_lookup (type_funcs, GSIZE_TO_POINTER (type));
 	if (async_data->type_data) {
+		GVariant *value;
+
+		value = _prefetch_peek (connection, path,
+		                        async_data->type_data->interface,
+		                        async_data->type_data->property);
+		if (value) {
+			type = async_data->type_data->type_func (value);
+			g_variant_unref (value);
+			create_async_got_type (async_data, type);
+			return;
+		}
+
 		_nm_dbus_new_proxy_for_connection_async (connection, path,
 		                                         DBUS_INTERFACE_PROPERTIES,
 		                                         NULL,
@@ -1260,6 +1735,13 @@ _nm_object_reload_properties (NMObject *object, GError **error)
 
 	g_hash_table_iter_init (&iter, priv->proxies);
 	while (g_hash_table_iter_next (&iter, (gpointer *) &interface, (gpointer *) &proxy)) {
+		props = _prefetch_take (object, interface);
+		if (props) {
+			process_properties_changed (object, props, TRUE);
+			g_variant_unref (props);
+			continue;
+		}
+
 		ret = _nm_dbus_proxy_call_sync (priv->properties_proxy,
 		                                "GetAll",
 		                                g_variant_new ("(s)", interface),
@@ -1427,6 +1909,28 @@ reload_got_properties (GObject *proxy,
 		reload_complete (object, FALSE);
 }
 
+typedef struct {
+	NMObject *object;
+	guint n_prefetched;
+} ReloadPrefetchedData;
+
+static gboolean
+reload_prefetched_cb (gpointer user_data)
+{
+	ReloadPrefetchedData *data = user_data;
+	NMObjectPrivate *priv = NM_OBJECT_GET_PRIVATE (data->object);
+
+	nm_assert (priv->reload_remaining >= data->n_prefetched);
+
+	priv->reload_remaining -= data->n_prefetched;
+	if (priv->reload_remaining == 0)
+		reload_complete (data->object, FALSE);
+
+	g_object_unref (data->object);
+	g_slice_free (ReloadPrefetchedData, data);
+	return G_SOURCE_REMOVE;
+}
+
 void
 _nm_object_reload_properties_async (NMObject *object,
                                     GCancellable *cancellable,
@@ -1438,6 +1942,8 @@ _nm_object_reload_properties_async (NMObject *object,
 	GHashTableIter iter;
 	const char *interface;
 	GDBusProxy *proxy;
+	GVariant *props;
+	guint n_prefetched = 0;
 
 	simple = g_simple_async_result_new (G_OBJECT (object), callback,
 	                                    user_data, _nm_object_reload_properties_async);
@@ -1460,6 +1966,17 @@ _nm_object_reload_properties_async (NMObject *object,
 	g_hash_table_iter_init (&iter, priv->proxies);
 	while (g_hash_table_iter_next (&iter, (gpointer *) &interface, (gpointer *) &proxy)) {
 		priv->reload_remaining++;
+
+		/* Apply prefetched properties right away, so that later changes
+		 * cannot be overwritten by them. Only the completion is deferred. */
+		props = _prefetch_take (object, interface);
+		if (props) {
+			process_properties_changed (object, props, FALSE);
+			g_variant_unref (props);
+			n_prefetched++;
+			continue;
+		}
+
 		g_dbus_proxy_call (priv->properties_proxy,
 		                   "GetAll",
 		                   g_variant_new ("(s)", interface),
@@ -1467,6 +1984,15 @@ _nm_object_reload_properties_async (NMObject *object,
 		                   cancellable,
 		                   reload_got_properties, object);
 	}
+
+	if (n_prefetched) {
+		ReloadPrefetchedData *data;
+
+		data = g_slice_new (ReloadPrefetchedData);
+		data->object = g_object_ref (object);
+		data->n_prefetched = n_prefetched;
+		g_idle_add_full (G_PRIORITY_DEFAULT, reload_prefetched_cb, data, NULL);
+	}
 }
 
 gboolean
@@ -16,15 +16,25 @@
 
 #include "nm-default.h"
 
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
 #include <netinet/in.h>
+#include <netinet/if_ether.h>
+#include <netpacket/packet.h>
+#include <linux/filter.h>
+#include <sys/socket.h>
 #include <sys/types.h>
-#include <sys/wait.h>
 
 #include "nm-arping-manager.h"
 #include "nm-platform.h"
 #include "nm-utils.h"
 #include "NetworkManagerUtils.h"
 
+/* number of probes sent during DAD, evenly spread over the first half
+ * of the timeout. */
+#define PROBE_NUM 3
+
 typedef enum {
 	STATE_INIT,
 	STATE_PROBING,
@@ -36,17 +46,22 @@ typedef struct {
 	int            ifindex;
 	State          state;
 	GHashTable    *addresses;
-	guint          completed;
+	guint          duplicates;
 	guint          timer;
 	guint          round2_id;
+
+	guint8         hwaddr[ETH_ALEN];
+	int            fd;
+	GIOChannel    *channel;
+	guint          channel_id;
+	guint          probe_id;
+	guint          probes_sent;
+	guint          probe_interval;
 } NMArpingManagerPrivate;
 
 typedef struct {
 	in_addr_t address;
-	GPid pid;
-	guint watch;
 	gboolean duplicate;
-	NMArpingManager *manager;
 } AddressInfo;
 
 enum {
@@ -100,41 +115,272 @@ nm_arping_manager_add_address (NMArpingManager *self, in_addr_t address)
 
 	info = g_slice_new0 (AddressInfo);
 	info->address = address;
-	info->manager = self;
 
 	g_hash_table_insert (priv->addresses, GUINT_TO_POINTER (address), info);
 
 	return TRUE;
 }
 
+/*****************************************************************************/
+
+static void
+_socket_close (NMArpingManager *self)
+{
+	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
+
+	nm_clear_g_source (&priv->channel_id);
+	g_clear_pointer (&priv->channel, g_io_channel_unref);
+	if (priv->fd >= 0) {
+		close (priv->fd);
+		priv->fd = -1;
+	}
+}
+
+static gboolean _receive_cb (GIOChannel *channel, GIOCondition condition, gpointer user_data);
+
+/* Opens a packet socket on the interface. With @receive, ARP packets
+ * from other hosts are received and matched against the addresses. */
+static gboolean
+_socket_open (NMArpingManager *self, gboolean receive, GError **error)
+{
+	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
+	gconstpointer hwaddr;
+	size_t hwaddr_len = 0;
+	struct sockaddr_ll sll = {
+		.sll_family = AF_PACKET,
+		.sll_protocol = htons (ETH_P_ARP),
+		.sll_ifindex = priv->ifindex,
+	};
+	int fd, errsv;
+
+	nm_assert (priv->fd < 0);
+
+	hwaddr = nm_platform_link_get_address (NM_PLATFORM_GET, priv->ifindex, &hwaddr_len);
+	if (!hwaddr) {
+		/* The device was probably just removed. */
+		g_set_error (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
+		             "can't find the hardware address for ifindex %d", priv->ifindex);
+		return FALSE;
+	}
+	if (hwaddr_len != ETH_ALEN) {
+		g_set_error (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
+		             "unsupported hardware address length %u for ifindex %d",
+		             (guint) hwaddr_len, priv->ifindex);
+		return FALSE;
+	}
+	memcpy (priv->hwaddr, hwaddr, ETH_ALEN);
+
+	fd = socket (PF_PACKET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, receive ? htons (ETH_P_ARP) : 0);
+	if (fd < 0) {
+		errsv = errno;
+		g_set_error (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
+		             "can't open packet socket: %s", g_strerror (errsv));
+		return FALSE;
+	}
+
+	if (receive) {
+		guint32 hw_hi;
+		guint16 hw_lo;
+
+		memcpy (&hw_hi, &priv->hwaddr[0], 4);
+		memcpy (&hw_lo, &priv->hwaddr[4], 2);
+
+		{
+			/* Let the kernel drop everything but well-formed Ethernet/IPv4
+			 * requests and replies sent by other hosts. Matching the addresses
+			 * is done in user space, with a single lookup for all of them. */
+			struct sock_filter filter[] = {
+				BPF_STMT (BPF_LD + BPF_W + BPF_LEN, 0),
+				BPF_JUMP (BPF_JMP + BPF_JGE + BPF_K, sizeof (struct ether_arp), 1, 0),
+				BPF_STMT (BPF_RET + BPF_K, 0),
+				BPF_STMT (BPF_LD + BPF_H + BPF_ABS, offsetof (struct ether_arp, ea_hdr.ar_hrd)),
+				BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, ARPHRD_ETHER, 1, 0),
+				BPF_STMT (BPF_RET + BPF_K, 0),
+				BPF_STMT (BPF_LD + BPF_H + BPF_ABS, offsetof (struct ether_arp, ea_hdr.ar_pro)),
+				BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, ETHERTYPE_IP, 1, 0),
+				BPF_STMT (BPF_RET + BPF_K, 0),
+				BPF_STMT (BPF_LD + BPF_B + BPF_ABS, offsetof (struct ether_arp, ea_hdr.ar_hln)),
+				BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, ETH_ALEN, 1, 0),
+				BPF_STMT (BPF_RET + BPF_K, 0),
+				BPF_STMT (BPF_LD + BPF_B + BPF_ABS, offsetof (struct ether_arp, ea_hdr.ar_pln)),
+				BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, sizeof (in_addr_t), 1, 0),
+				BPF_STMT (BPF_RET + BPF_K, 0),
+				BPF_STMT (BPF_LD + BPF_H + BPF_ABS, offsetof (struct ether_arp, ea_hdr.ar_op)),
+				BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, ARPOP_REQUEST, 2, 0),
+				BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, ARPOP_REPLY, 1, 0),
+				BPF_STMT (BPF_RET + BPF_K, 0),
+				/* accept if the sender hardware address differs from ours */
+				BPF_STMT (BPF_LD + BPF_W + BPF_ABS, offsetof (struct ether_arp, arp_sha)),
+				BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, ntohl (hw_hi), 0, 2),
+				BPF_STMT (BPF_LD + BPF_H + BPF_ABS, offsetof (struct ether_arp, arp_sha) + 4),
+				BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, ntohs (hw_lo), 1, 0),
+				BPF_STMT (BPF_RET + BPF_K, sizeof (struct ether_arp)),
+				BPF_STMT (BPF_RET + BPF_K, 0),
+			};
+			struct sock_fprog fprog = {
+				.len = G_N_ELEMENTS (filter),
+				.filter = filter,
+			};
+
+			if (setsockopt (fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof (fprog)) < 0) {
+				errsv = errno;
+				close (fd);
+				g_set_error (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
+				             "can't attach socket filter: %s", g_strerror (errsv));
+				return FALSE;
+			}
+		}
+
+		if (bind (fd, (struct sockaddr *) &sll, sizeof (sll)) < 0) {
+			errsv = errno;
+			close (fd);
+			g_set_error (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
+			             "can't bind packet socket: %s", g_strerror (errsv));
+			return FALSE;
+		}
+	}
+
+	priv->fd = fd;
+	if (receive) {
+		priv->channel = g_io_channel_unix_new (fd);
+		priv->channel_id = g_io_add_watch (priv->channel, G_IO_IN, _receive_cb, self);
+	}
+	return TRUE;
+}
+
+static gboolean
+_send_arp (NMArpingManager *self, guint16 op, in_addr_t spa, in_addr_t tpa)
+{
+	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
+	struct sockaddr_ll sll = {
+		.sll_family = AF_PACKET,
+		.sll_protocol = htons (ETH_P_ARP),
+		.sll_ifindex = priv->ifindex,
+		.sll_halen = ETH_ALEN,
+		.sll_addr = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff },
+	};
+	struct ether_arp arp = {
+		.ea_hdr.ar_hrd = htons (ARPHRD_ETHER),
+		.ea_hdr.ar_pro = htons (ETHERTYPE_IP),
+		.ea_hdr.ar_hln = ETH_ALEN,
+		.ea_hdr.ar_pln = sizeof (in_addr_t),
+		.ea_hdr.ar_op = htons (op),
+	};
+
+	memcpy (arp.arp_sha, priv->hwaddr, ETH_ALEN);
+	memcpy (arp.arp_spa, &spa, sizeof (spa));
+	memcpy (arp.arp_tpa, &tpa, sizeof (tpa));
+
+	if (sendto (priv->fd, &arp, sizeof (arp), 0, (struct sockaddr *) &sll, sizeof (sll)) < 0) {
+		int errsv = errno;
+
+		_LOGD ("could not send ARP %s for address %s: %s",
+		       op == ARPOP_REQUEST ? "request" : "reply",
+		       nm_utils_inet4_ntop (tpa, NULL),
+		       g_strerror (errsv));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/*****************************************************************************/
+
 static void
-arping_watch_cb (GPid pid, gint status, gpointer user_data)
+_probe_done (NMArpingManager *self)
+{
+	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
+
+	nm_clear_g_source (&priv->timer);
+	nm_clear_g_source (&priv->probe_id);
+	_socket_close (self);
+
+	priv->state = STATE_PROBE_DONE;
+	g_signal_emit (self, signals[PROBE_TERMINATED], 0);
+}
+
+static gboolean
+_receive_cb (GIOChannel *channel, GIOCondition condition, gpointer user_data)
 {
-	AddressInfo *info = user_data;
-	NMArpingManager *self = info->manager;
+	NMArpingManager *self = user_data;
 	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
-	const char *addr;
-
-	info->pid = 0;
-	info->watch = 0;
-	addr = nm_utils_inet4_ntop (info->address, NULL);
-
-	if (WIFEXITED (status)) {
-		if (WEXITSTATUS (status) != 0) {
-			_LOGD ("%s already used in the %s network",
-			       addr, nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex));
-			info->duplicate = TRUE;
-		} else
-			_LOGD ("DAD succeeded for %s", addr);
-	} else {
-		_LOGD ("stopped unexpectedly with status %d for %s", status, addr);
+	struct ether_arp arp;
+	struct sockaddr_ll sll;
+	socklen_t sll_len;
+	AddressInfo *info;
+	in_addr_t spa, tpa;
+	ssize_t n;
+
+	for (;;) {
+		sll_len = sizeof (sll);
+		n = recvfrom (priv->fd, &arp, sizeof (arp), 0, (struct sockaddr *) &sll, &sll_len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		/* packets from other interfaces might have been queued before
+		 * the socket was bound. */
+		if (   n < (ssize_t) sizeof (arp)
+		    || sll.sll_ifindex != priv->ifindex)
+			continue;
+
+		memcpy (&spa, arp.arp_spa, sizeof (spa));
+		memcpy (&tpa, arp.arp_tpa, sizeof (tpa));
+
+		/* Somebody uses the address if it is the sender address of any
+		 * packet, or if somebody else is probing for it (RFC 5227, 2.1.1). */
+		if (spa)
+			info = g_hash_table_lookup (priv->addresses, GUINT_TO_POINTER (spa));
+		else if (ntohs (arp.ea_hdr.ar_op) == ARPOP_REQUEST)
+			info = g_hash_table_lookup (priv->addresses, GUINT_TO_POINTER (tpa));
+		else
+			info = NULL;
+
+		if (!info || info->duplicate)
+			continue;
+
+		if (_LOGD_ENABLED ()) {
+			gs_free char *hwaddr = nm_utils_hwaddr_ntoa (arp.arp_sha, ETH_ALEN);
+
+			_LOGD ("%s already used in the %s network by %s",
+			       nm_utils_inet4_ntop (info->address, NULL),
+			       nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex),
+			       hwaddr);
+		}
+		info->duplicate = TRUE;
+		priv->duplicates++;
+	}
+
+	if (priv->duplicates == g_hash_table_size (priv->addresses)) {
+		/* no need to wait any longer. */
+		priv->channel_id = 0;
+		_probe_done (self);
+		return G_SOURCE_REMOVE;
 	}
 
-	if (++priv->completed == g_hash_table_size (priv->addresses)) {
-		priv->state = STATE_PROBE_DONE;
-		nm_clear_g_source (&priv->timer);
-		g_signal_emit (self, signals[PROBE_TERMINATED], 0);
+	return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+_probe_send_cb (gpointer user_data)
+{
+	NMArpingManager *self = user_data;
+	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
+	GHashTableIter iter;
+	AddressInfo *info;
+
+	priv->probe_id = 0;
+
+	g_hash_table_iter_init (&iter, priv->addresses);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info)) {
+		if (!info->duplicate)
+			_send_arp (self, ARPOP_REQUEST, 0, info->address);
 	}
+
+	if (++priv->probes_sent < PROBE_NUM)
+		priv->probe_id = g_timeout_add (priv->probe_interval, _probe_send_cb, self);
+
+	return G_SOURCE_REMOVE;
 }
 
 static gboolean
@@ -149,19 +395,11 @@ arping_timeout_cb (gpointer user_data)
 
 	g_hash_table_iter_init (&iter, priv->addresses);
 	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info)) {
-		nm_clear_g_source (&info->watch);
-		if (info->pid) {
-			_LOGD ("DAD timed out for %s",
-			       nm_utils_inet4_ntop (info->address, NULL));
-			nm_utils_kill_child_async (info->pid, SIGTERM, LOGD_IP4,
-			                           "arping", 1000, NULL, NULL);
-			info->pid = 0;
-		}
+		if (!info->duplicate)
+			_LOGD ("DAD succeeded for %s", nm_utils_inet4_ntop (info->address, NULL));
 	}
 
-	priv->state = STATE_PROBE_DONE;
-	g_signal_emit (self, signals[PROBE_TERMINATED], 0);
-
+	_probe_done (self);
 	return G_SOURCE_REMOVE;
 }
 
@@ -179,11 +417,7 @@ arping_timeout_cb (gpointer user_data)
 gboolean
 nm_arping_manager_start_probe (NMArpingManager *self, guint timeout, GError **error)
 {
-	const char *argv[] = { NULL, "-D", "-q", "-I", NULL, "-c", NULL, "-w", NULL, NULL, NULL };
 	NMArpingManagerPrivate *priv;
-	GHashTableIter iter;
-	AddressInfo *info;
-	gs_free char *timeout_str = NULL;
 
 	g_return_val_if_fail (NM_IS_ARPING_MANAGER (self), FALSE);
 	g_return_val_if_fail (!error || !*error, FALSE);
@@ -192,44 +426,16 @@ nm_arping_manager_start_probe (NMArpingManager *self, guint timeout, GError **er
 	priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
 	g_return_val_if_fail (priv->state == STATE_INIT, FALSE);
 
-	argv[4] = nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex);
-	if (!argv[4]) {
-		/* The device was probably just removed. */
-		g_set_error (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
-		             "can't find a name for ifindex %d", priv->ifindex);
-		return FALSE;
-	}
-
-	priv->completed = 0;
-
-	argv[0] = nm_utils_find_helper ("arping", NULL, NULL);
-	if (!argv[0]) {
-		g_set_error_literal (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
-		                     "arping could not be found");
+	if (!_socket_open (self, TRUE, error))
 		return FALSE;
-	}
-
-	timeout_str = g_strdup_printf ("%u", timeout / 1000 + 2);
-	argv[6] = timeout_str;
-	argv[8] = timeout_str;
-
-	g_hash_table_iter_init (&iter, priv->addresses);
 
-	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info)) {
-		gs_free char *tmp_str = NULL;
-		gboolean success;
-
-		argv[9] = nm_utils_inet4_ntop (info->address, NULL);
-		_LOGD ("run %s", (tmp_str = g_strjoinv (" ", (char **) argv)));
+	_LOGD ("probe %u addresses with a timeout of %u ms",
+	       g_hash_table_size (priv->addresses), timeout);
 
-		success = g_spawn_async (NULL, (char **) argv, NULL,
-		                         G_SPAWN_STDOUT_TO_DEV_NULL |
-		                         G_SPAWN_STDERR_TO_DEV_NULL |
-		                         G_SPAWN_DO_NOT_REAP_CHILD,
-		                         NULL, NULL, &info->pid, NULL);
-
-		info->watch = g_child_watch_add (info->pid, arping_watch_cb, info);
-	}
+	priv->duplicates = 0;
+	priv->probes_sent = 0;
+	priv->probe_interval = MAX (timeout / (2 * (PROBE_NUM - 1)), 1u);
+	_probe_send_cb (self);
 
 	priv->timer = g_timeout_add (timeout, arping_timeout_cb, self);
 	priv->state = STATE_PROBING;
@@ -253,6 +459,8 @@ nm_arping_manager_reset (NMArpingManager *self)
 
 	nm_clear_g_source (&priv->timer);
 	nm_clear_g_source (&priv->round2_id);
+	nm_clear_g_source (&priv->probe_id);
+	_socket_close (self);
 	g_hash_table_remove_all (priv->addresses);
 
 	priv->state = STATE_INIT;
@@ -301,49 +509,28 @@ nm_arping_manager_check_address (NMArpingManager *self, in_addr_t address)
 }
 
 static void
-send_announcements (NMArpingManager *self, const char *mode_arg)
+send_announcements (NMArpingManager *self, guint16 op)
 {
 	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
-	const char *argv[] = { NULL, mode_arg, "-q", "-I", NULL, "-c", "1", NULL, NULL };
-	int ip_arg = G_N_ELEMENTS (argv) - 2;
 	GError *error = NULL;
 	GHashTableIter iter;
 	AddressInfo *info;
 
-	argv[4] = nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex);
-	if (!argv[4]) {
-		/* The device was probably just removed. */
-		_LOGW ("can't find a name for ifindex %d", priv->ifindex);
-		return;
-	}
-
-	argv[0] = nm_utils_find_helper ("arping", NULL, NULL);
-	if (!argv[0]) {
-		_LOGW ("arping could not be found; no ARPs will be sent");
+	if (priv->fd < 0 && !_socket_open (self, FALSE, &error)) {
+		_LOGW ("no ARPs will be sent: %s", error->message);
+		g_clear_error (&error);
 		return;
 	}
 
 	g_hash_table_iter_init (&iter, priv->addresses);
-
 	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info)) {
-		gs_free char *tmp_str = NULL;
-		gboolean success;
-
 		if (info->duplicate)
 			continue;
 
-		argv[ip_arg] = nm_utils_inet4_ntop (info->address, NULL);
-		_LOGD ("run %s", (tmp_str = g_strjoinv (" ", (char **) argv)));
-
-		success = g_spawn_async (NULL, (char **) argv, NULL,
-		                         G_SPAWN_STDOUT_TO_DEV_NULL |
-		                         G_SPAWN_STDERR_TO_DEV_NULL,
-		                         NULL, NULL, NULL, &error);
-		if (!success) {
-			_LOGW ("could not send ARP for address %s: %s", argv[ip_arg],
-			       error->message);
-			g_clear_error (&error);
-		}
+		_LOGD ("announce %s with an ARP %s",
+		       nm_utils_inet4_ntop (info->address, NULL),
+		       op == ARPOP_REQUEST ? "request" : "reply");
+		_send_arp (self, op, info->address, info->address);
 	}
 }
 
@@ -353,7 +540,8 @@ arp_announce_round2 (gpointer self)
 	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
 
 	priv->round2_id = 0;
-	send_announcements (self, "-U");
+	send_announcements (self, ARPOP_REQUEST);
+	_socket_close (self);
 	priv->state = STATE_INIT;
 	g_hash_table_remove_all (priv->addresses);
 
@@ -374,7 +562,9 @@ nm_arping_manager_announce_addresses (NMArpingManager *self)
 	g_return_if_fail (   priv->state == STATE_INIT
 	                  || priv->state == STATE_PROBE_DONE);
 
-	send_announcements (self, "-A");
+	/* like "arping -A" followed by "arping -U" two seconds later:
+	 * first gratuitous ARP replies, then gratuitous ARP requests. */
+	send_announcements (self, ARPOP_REPLY);
 	nm_clear_g_source (&priv->round2_id);
 	priv->round2_id = g_timeout_add_seconds (2, arp_announce_round2, self);
 	priv->state = STATE_ANNOUNCING;
@@ -385,13 +575,6 @@ destroy_address_info (gpointer data)
 {
 	AddressInfo *info = (AddressInfo *) data;
 
-	nm_clear_g_source (&info->watch);
-
-	if (info->pid) {
-		nm_utils_kill_child_async (info->pid, SIGTERM, LOGD_IP4, "arping",
-		                           1000, NULL, NULL);
-	}
-
 	g_slice_free (AddressInfo, info);
 }
 
@@ -403,6 +586,8 @@ dispose (GObject *object)
 
 	nm_clear_g_source (&priv->timer);
 	nm_clear_g_source (&priv->round2_id);
+	nm_clear_g_source (&priv->probe_id);
+	_socket_close (self);
 	g_clear_pointer (&priv->addresses, g_hash_table_destroy);
 
 	G_OBJECT_CLASS (nm_arping_manager_parent_class)->dispose (object);
@@ -416,6 +601,7 @@ nm_arping_manager_init (NMArpingManager *self)
 	priv->addresses = g_hash_table_new_full (g_direct_hash, g_direct_equal,
 	                                         NULL, destroy_address_info);
 	priv->state = STATE_INIT;
+	priv->fd = -1;
 }
 
 NMArpingManager *
@@ -3043,6 +3043,59 @@ can_auto_connect (NMDevice *self,
 	return nm_device_check_connection_available (self, connection, NM_DEVICE_CHECK_CON_AVAILABLE_NONE, NULL);
 }
 
+/* The permanent MAC address is only compared for realized devices, like
+ * the device classes do in check_connection_compatible(). */
+static const char *
+_candidate_hwaddr (NMDevice *self)
+{
+	return nm_device_is_real (self)
+	       ? nm_device_get_permanent_hw_address (self, FALSE)
+	       : NULL;
+}
+
+/* Quickly reject settings connections that are locked to the interface
+ * name or MAC address of another device, before doing the full
+ * check_connection_compatible(). */
+static gboolean
+connection_is_candidate (NMDevice *self, NMConnection *connection)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+
+	if (   !priv->settings
+	    || !NM_IS_SETTINGS_CONNECTION (connection))
+		return TRUE;
+
+	return nm_settings_is_candidate_connection (priv->settings,
+	                                            NM_SETTINGS_CONNECTION (connection),
+	                                            nm_device_get_iface (self),
+	                                            _candidate_hwaddr (self));
+}
+
+/**
+ * nm_device_get_candidate_connections:
+ * @self: an #NMDevice
+ * @out_len: (out): (allow-none): returns the number of returned
+ *   connections.
+ *
+ * Returns: (transfer-container): the settings connections that are not
+ *   locked to another device, in the order suitable for auto-connecting.
+ *   The array is %NULL terminated, free it with g_free().
+ */
+NMSettingsConnection **
+nm_device_get_candidate_connections (NMDevice *self, guint *out_len)
+{
+	NMDevicePrivate *priv;
+
+	g_return_val_if_fail (NM_IS_DEVICE (self), NULL);
+
+	priv = NM_DEVICE_GET_PRIVATE (self);
+
+	return nm_settings_get_candidate_connections (priv->settings,
+	                                              nm_device_get_iface (self),
+	                                              _candidate_hwaddr (self),
+	                                              out_len);
+}
+
 /**
  * nm_device_can_auto_connect:
  * @self: an #NMDevice
@@ -3069,6 +3122,9 @@ nm_device_can_auto_connect (NMDevice *self,
 	g_return_val_if_fail (NM_IS_CONNECTION (connection), FALSE);
 	g_return_val_if_fail (specific_object && !*specific_object, FALSE);
 
+	if (!connection_is_candidate (self, connection))
+		return FALSE;
+
 	if (nm_device_autoconnect_allowed (self))
 		return NM_DEVICE_GET_CLASS (self)->can_auto_connect (self, connection, specific_object);
 	return FALSE;
@@ -3330,6 +3386,9 @@ nm_device_check_connection_compatible (NMDevice *self, NMConnection *connection)
 	g_return_val_if_fail (NM_IS_DEVICE (self), FALSE);
 	g_return_val_if_fail (NM_IS_CONNECTION (connection), FALSE);
 
+	if (!connection_is_candidate (self, connection))
+		return FALSE;
+
 	return NM_DEVICE_GET_CLASS (self)->check_connection_compatible (self, connection);
 }
 
@@ -4455,18 +4514,21 @@ _device_get_default_route_from_platform (NMDevice *self, int addr_family, NMPlat
 {
 	gboolean success = FALSE;
 	int ifindex = nm_device_get_ip_ifindex (self);
-	GArray *routes;
+	NMPlatformSnapshot *snapshot;
+	const GArray *routes;
 
 	if (addr_family == AF_INET)
-		routes = nm_platform_ip4_route_get_all (NM_PLATFORM_GET, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT);
+		snapshot = nm_platform_ip4_route_get_snapshot (NM_PLATFORM_GET, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT);
 	else
-		routes = nm_platform_ip6_route_get_all (NM_PLATFORM_GET, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT);
+		snapshot = nm_platform_ip6_route_get_snapshot (NM_PLATFORM_GET, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT);
 
-	if (routes) {
+	if (snapshot) {
 		guint route_metric = G_MAXUINT32, m;
 		const NMPlatformIPRoute *route = NULL, *r;
 		guint i;
 
+		routes = nm_platform_snapshot_get_array (snapshot);
+
 		/* if there are several default routes, find the one with the best metric */
 		for (i = 0; i < routes->len; i++) {
 			if (addr_family == AF_INET) {
@@ -4489,7 +4551,7 @@ _device_get_default_route_from_platform (NMDevice *self, int addr_family, NMPlat
 				*((NMPlatformIP6Route *) out_route) = *((NMPlatformIP6Route *) route);
 			success = TRUE;
 		}
-		g_array_free (routes, TRUE);
+		nm_platform_snapshot_unref (snapshot);
 	}
 	return success;
 }
@@ -10905,7 +10967,7 @@ nm_device_spawn_iface_helper (NMDevice *self)
 
 		g_ptr_array_add (argv, NULL);
 
-		if (nm_logging_enabled (LOGL_DEBUG, LOGD_DEVICE)) {
+		if (nm_logging_backend_enabled (LOGL_DEBUG, LOGD_DEVICE)) {
 			char *tmp;
 
 			tmp = g_strjoinv (" ", (char **) argv->pdata);
@@ -411,6 +411,9 @@ gboolean nm_device_can_auto_connect (NMDevice *self,
                                      NMConnection *connection,
                                      char **specific_object);
 
+NMSettingsConnection **nm_device_get_candidate_connections (NMDevice *self,
+                                                            guint *out_len);
+
 gboolean nm_device_complete_connection (NMDevice *device,
                                         NMConnection *connection,
                                         const char *specific_object,
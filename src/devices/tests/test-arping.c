@@ -20,6 +20,10 @@
 
 #include "nm-default.h"
 
+#include <netinet/if_ether.h>
+#include <netpacket/packet.h>
+#include <sys/socket.h>
+
 #include "nm-arping-manager.h"
 #include "test-common.h"
 
@@ -67,11 +71,6 @@ test_arping_common (test_fixture *fixture, TestInfo *info)
 	GMainLoop *loop;
 	int i;
 
-	if (!nm_utils_find_helper ("arping", NULL, NULL)) {
-		g_test_skip ("arping binary is missing");
-		return;
-	}
-
 	manager = nm_arping_manager_new (fixture->ifindex0);
 	g_assert (manager != NULL);
 
@@ -118,6 +117,83 @@ test_arping_2 (test_fixture *fixture, gconstpointer user_data)
 	test_arping_common (fixture, &info);
 }
 
+static void
+test_arping_many (test_fixture *fixture, gconstpointer user_data)
+{
+	gs_unref_object NMArpingManager *manager = NULL;
+	GMainLoop *loop;
+	guint i;
+
+	/* all addresses are probed over a single socket. */
+	manager = nm_arping_manager_new (fixture->ifindex0);
+	for (i = 1; i <= 64; i++)
+		g_assert (nm_arping_manager_add_address (manager, htonl (0x0a000000 + i)));
+
+	nmtstp_ip4_address_add (NULL, FALSE, fixture->ifindex1, htonl (0x0a000000 + 5),
+	                        24, 0, 3600, 1800, 0, NULL);
+	nmtstp_ip4_address_add (NULL, FALSE, fixture->ifindex1, htonl (0x0a000000 + 33),
+	                        24, 0, 3600, 1800, 0, NULL);
+
+	loop = g_main_loop_new (NULL, FALSE);
+	g_signal_connect (manager, NM_ARPING_MANAGER_PROBE_TERMINATED,
+	                  G_CALLBACK (arping_manager_probe_terminated), loop);
+	g_assert (nm_arping_manager_start_probe (manager, 100, NULL));
+	g_assert (nmtst_main_loop_run (loop, 1000));
+
+	for (i = 1; i <= 64; i++) {
+		g_assert_cmpint (nm_arping_manager_check_address (manager, htonl (0x0a000000 + i)),
+		                 ==,
+		                 i != 5 && i != 33);
+	}
+
+	g_main_loop_unref (loop);
+}
+
+static void
+test_arping_announce (test_fixture *fixture, gconstpointer user_data)
+{
+	gs_unref_object NMArpingManager *manager = NULL;
+	struct sockaddr_ll sll = {
+		.sll_family = AF_PACKET,
+		.sll_protocol = htons (ETH_P_ARP),
+		.sll_ifindex = fixture->ifindex1,
+	};
+	struct timeval tv = { .tv_usec = 500000 };
+	struct ether_arp arp;
+	gboolean seen1 = FALSE, seen2 = FALSE;
+	in_addr_t spa, tpa;
+	int fd;
+
+	/* capture what arrives at the peer. */
+	fd = socket (PF_PACKET, SOCK_DGRAM | SOCK_CLOEXEC, htons (ETH_P_ARP));
+	g_assert_cmpint (fd, >=, 0);
+	g_assert_cmpint (bind (fd, (struct sockaddr *) &sll, sizeof (sll)), ==, 0);
+	g_assert_cmpint (setsockopt (fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof (tv)), ==, 0);
+
+	manager = nm_arping_manager_new (fixture->ifindex0);
+	g_assert (nm_arping_manager_add_address (manager, ADDR1));
+	g_assert (nm_arping_manager_add_address (manager, ADDR2));
+	nm_arping_manager_announce_addresses (manager);
+
+	while (!seen1 || !seen2) {
+		g_assert_cmpint (recv (fd, &arp, sizeof (arp), 0), ==, sizeof (arp));
+
+		/* the first round are gratuitous ARP replies. */
+		g_assert_cmpint (ntohs (arp.ea_hdr.ar_op), ==, ARPOP_REPLY);
+		memcpy (&spa, arp.arp_spa, sizeof (spa));
+		memcpy (&tpa, arp.arp_tpa, sizeof (tpa));
+		g_assert_cmpint (spa, ==, tpa);
+		if (spa == ADDR1)
+			seen1 = TRUE;
+		else if (spa == ADDR2)
+			seen2 = TRUE;
+		else
+			g_assert_not_reached ();
+	}
+
+	close (fd);
+}
+
 static void
 fixture_teardown (test_fixture *fixture, gconstpointer user_data)
 {
@@ -136,4 +212,6 @@ _nmtstp_setup_tests (void)
 {
 	g_test_add ("/arping/1", test_fixture, NULL, fixture_setup, test_arping_1, fixture_teardown);
 	g_test_add ("/arping/2", test_fixture, NULL, fixture_setup, test_arping_2, fixture_teardown);
+	g_test_add ("/arping/many", test_fixture, NULL, fixture_setup, test_arping_many, fixture_teardown);
+	g_test_add ("/arping/announce", test_fixture, NULL, fixture_setup, test_arping_announce, fixture_teardown);
 }
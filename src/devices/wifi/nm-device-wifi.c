@@ -1421,7 +1421,7 @@ request_wireless_scan (NMDeviceWifi *self, GVariant *scan_options)
 		if (!ssids)
 			ssids = build_hidden_probe_list (self);
 
-		if (nm_logging_enabled (LOGL_DEBUG, LOGD_WIFI_SCAN)) {
+		if (nm_logging_backend_enabled (LOGL_DEBUG, LOGD_WIFI_SCAN)) {
 			if (ssids) {
 				const GByteArray *ssid;
 				guint i;
@@ -1560,7 +1560,7 @@ schedule_ap_list_dump (NMDeviceWifi *self)
 {
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 
-	if (!nm_logging_enabled (LOGL_DEBUG, LOGD_WIFI_SCAN))
+	if (!nm_logging_backend_enabled (LOGL_DEBUG, LOGD_WIFI_SCAN))
 		return;
 	nm_clear_g_source (&priv->ap_dump_id);
 	priv->ap_dump_id = g_timeout_add_seconds (1, ap_list_dump, self);
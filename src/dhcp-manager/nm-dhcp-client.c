@@ -620,43 +620,6 @@ nm_dhcp_client_stop (NMDhcpClient *self, gboolean release)
 
 /********************************************/
 
-static char *
-bytearray_variant_to_string (NMDhcpClient *self, GVariant *value, const char *key)
-{
-	const guint8 *array;
-	gsize length;
-	GString *str;
-	int i;
-	unsigned char c;
-	char *converted = NULL;
-
-	g_return_val_if_fail (value != NULL, NULL);
-
-	array = g_variant_get_fixed_array (value, &length, 1);
-
-	/* Since the DHCP options come through environment variables, they should
-	 * already be UTF-8 safe, but just make sure.
-	 */
-	str = g_string_sized_new (length);
-	for (i = 0; i < length; i++) {
-		c = array[i];
-
-		/* Convert NULLs to spaces and non-ASCII characters to ? */
-		if (c == '\0')
-			c = ' ';
-		else if (c > 127)
-			c = '?';
-		str = g_string_append_c (str, c);
-	}
-	str = g_string_append_c (str, '\0');
-
-	converted = str->str;
-	if (!g_utf8_validate (converted, -1, NULL))
-		_LOGW ("option '%s' couldn't be converted to UTF-8", key);
-	g_string_free (str, FALSE);
-	return converted;
-}
-
 #define OLD_TAG "old_"
 #define NEW_TAG "new_"
 
@@ -664,9 +627,8 @@ static void
 maybe_add_option (NMDhcpClient *self,
                   GHashTable *hash,
                   const char *key,
-                  GVariant *value)
+                  const char *value)
 {
-	char *str_value = NULL;
 	const char **p;
 	static const char *ignored_keys[] = {
 		"interface",
@@ -676,8 +638,6 @@ maybe_add_option (NMDhcpClient *self,
 		NULL
 	};
 
-	g_return_if_fail (g_variant_is_of_type (value, G_VARIANT_TYPE_BYTESTRING));
-
 	if (g_str_has_prefix (key, OLD_TAG))
 		return;
 
@@ -692,16 +652,14 @@ maybe_add_option (NMDhcpClient *self,
 	if (!key[0])
 		return;
 
-	str_value = bytearray_variant_to_string (self, value, key);
-	if (str_value)
-		g_hash_table_insert (hash, g_strdup (key), str_value);
+	g_hash_table_insert (hash, g_strdup (key), g_strdup (value));
 }
 
 gboolean
 nm_dhcp_client_handle_event (gpointer unused,
                              const char *iface,
                              gint pid,
-                             GVariant *options,
+                             GHashTable *options,
                              const char *reason,
                              NMDhcpClient *self)
 {
@@ -714,7 +672,7 @@ nm_dhcp_client_handle_event (gpointer unused,
 	g_return_val_if_fail (NM_IS_DHCP_CLIENT (self), FALSE);
 	g_return_val_if_fail (iface != NULL, FALSE);
 	g_return_val_if_fail (pid > 0, FALSE);
-	g_return_val_if_fail (g_variant_is_of_type (options, G_VARIANT_TYPE_VARDICT), FALSE);
+	g_return_val_if_fail (options != NULL, FALSE);
 	g_return_val_if_fail (reason != NULL, FALSE);
 
 	priv = NM_DHCP_CLIENT_GET_PRIVATE (self);
@@ -730,17 +688,14 @@ nm_dhcp_client_handle_event (gpointer unused,
 	       reason, state_to_string (new_state));
 
 	if (new_state == NM_DHCP_STATE_BOUND) {
-		GVariantIter iter;
-		const char *name;
-		GVariant *value;
+		GHashTableIter iter;
+		const char *name, *value;
 
 		/* Copy options */
 		str_options = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
-		g_variant_iter_init (&iter, options);
-		while (g_variant_iter_next (&iter, "{&sv}", &name, &value)) {
+		g_hash_table_iter_init (&iter, options);
+		while (g_hash_table_iter_next (&iter, (gpointer *) &name, (gpointer *) &value))
 			maybe_add_option (self, str_options, name, value);
-			g_variant_unref (value);
-		}
 
 		/* Create the IP config */
 		g_warn_if_fail (g_hash_table_size (str_options));
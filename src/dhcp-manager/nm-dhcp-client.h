@@ -166,7 +166,7 @@ void nm_dhcp_client_set_state (NMDhcpClient *self,
 gboolean nm_dhcp_client_handle_event (gpointer unused,
                                       const char *iface,
                                       gint pid,
-                                      GVariant *options,
+                                      GHashTable *options, /* str:str hash */
                                       const char *reason,
                                       NMDhcpClient *self);
 
@@ -0,0 +1,42 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2016 Red Hat, Inc.
+ */
+
+#ifndef __NM_DHCP_HELPER_API_H__
+#define __NM_DHCP_HELPER_API_H__
+
+/* Protocol between nm-dhcp-helper and NMDhcpListener.
+ *
+ * For each lease event the helper connects to a SOCK_SEQPACKET unix
+ * socket at NM_DHCP_HELPER_SOCKET_PATH and sends a single message. The
+ * message starts with NM_DHCP_HELPER_MSG_MAGIC (including the trailing
+ * '\0') followed by the environment variables of the DHCP client as
+ * "NAME=VALUE" entries, each terminated by '\0'. Values are passed
+ * verbatim, without any guarantee about the character encoding.
+ *
+ * When the socket cannot be reached, the helper falls back to emitting
+ * the "Event" signal on the private D-Bus socket NM_DHCP_HELPER_DBUS_PATH.
+ */
+
+#define NM_DHCP_HELPER_SOCKET_PATH      NMRUNDIR "/private-dhcp-event"
+#define NM_DHCP_HELPER_DBUS_PATH        NMRUNDIR "/private-dhcp"
+#define NM_DHCP_HELPER_DBUS_IFACE       "org.freedesktop.nm_dhcp_client"
+
+#define NM_DHCP_HELPER_MSG_MAGIC        "NMDHCP1"
+#define NM_DHCP_HELPER_MSG_MAX_SIZE     (64 * 1024)
+
+#endif /* __NM_DHCP_HELPER_API_H__ */
@@ -24,10 +24,102 @@
 #include <stdlib.h>
 #include <string.h>
 #include <signal.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
-#define NM_DHCP_CLIENT_DBUS_IFACE   "org.freedesktop.nm_dhcp_client"
+#include "nm-dhcp-helper-api.h"
 
-static const char * ignore[] = {"PATH", "SHLVL", "_", "PWD", "dhc_dbus", NULL};
+/* The daemon ignores the "old_" options of the previous lease, so don't
+ * bother sending them. */
+static const char * ignore[] = {"PATH", "SHLVL", "_", "PWD", "dhc_dbus", "old_", NULL};
+
+static gboolean
+ignore_variable (const char *name, gsize name_len)
+{
+	const char **p;
+
+	/* Ignore non-DCHP-related environment variables */
+	for (p = ignore; *p; p++) {
+		gsize len = strlen (*p);
+
+		if (name_len >= len && strncmp (name, *p, len) == 0)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static GString *
+build_message (void)
+{
+	GString *msg;
+	char **item;
+
+	msg = g_string_sized_new (4096);
+	g_string_append_len (msg, NM_DHCP_HELPER_MSG_MAGIC, sizeof (NM_DHCP_HELPER_MSG_MAGIC));
+
+	for (item = environ; *item; item++) {
+		const char *eq = strchr (*item, '=');
+
+		if (!eq || eq == *item)
+			continue;
+		if (ignore_variable (*item, eq - *item))
+			continue;
+
+		g_string_append_len (msg, *item, strlen (*item) + 1);
+	}
+
+	return msg;
+}
+
+/* Returns: 1 on success, 0 if the daemon doesn't listen on the socket
+ * and the D-Bus fallback should be used, -1 on failure. */
+static int
+send_message (GError **error)
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	GString *msg;
+	int fd, errsv;
+	int r = -1;
+
+	G_STATIC_ASSERT (sizeof (NM_DHCP_HELPER_SOCKET_PATH) <= sizeof (addr.sun_path));
+	memcpy (addr.sun_path, NM_DHCP_HELPER_SOCKET_PATH, sizeof (NM_DHCP_HELPER_SOCKET_PATH));
+
+	fd = socket (AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		errsv = errno;
+		g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv),
+		             "could not create socket: %s", g_strerror (errsv));
+		return -1;
+	}
+
+	if (connect (fd, (struct sockaddr *) &addr, sizeof (addr)) != 0) {
+		errsv = errno;
+		if (errsv == ENOENT || errsv == ECONNREFUSED)
+			r = 0;
+		else {
+			g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv),
+			             "could not connect to %s: %s", NM_DHCP_HELPER_SOCKET_PATH, g_strerror (errsv));
+		}
+		close (fd);
+		return r;
+	}
+
+	msg = build_message ();
+	if (msg->len > NM_DHCP_HELPER_MSG_MAX_SIZE) {
+		g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+		             "message of %zu bytes is too large", (size_t) msg->len);
+	} else if (send (fd, msg->str, msg->len, MSG_NOSIGNAL) != (ssize_t) msg->len) {
+		errsv = errno;
+		g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv),
+		             "could not send message: %s", g_strerror (errsv));
+	} else
+		r = 1;
+
+	g_string_free (msg, TRUE);
+	close (fd);
+	return r;
+}
 
 static GVariant *
 build_signal_parameters (void)
@@ -39,7 +131,7 @@ build_signal_parameters (void)
 
 	/* List environment and format for dbus dict */
 	for (item = environ; *item; item++) {
-		char *name, *val, **p;
+		char *name, *val;
 
 		/* Split on the = */
 		name = g_strdup (*item);
@@ -48,11 +140,8 @@ build_signal_parameters (void)
 			goto next;
 		*val++ = '\0';
 
-		/* Ignore non-DCHP-related environment variables */
-		for (p = (char **) ignore; *p; p++) {
-			if (strncmp (name, *p, strlen (*p)) == 0)
-				goto next;
-		}
+		if (ignore_variable (name, strlen (name)))
+			goto next;
 
 		/* Value passed as a byte array rather than a string, because there are
 		 * no character encoding guarantees with DHCP, and D-Bus requires
@@ -94,10 +183,23 @@ main (int argc, char *argv[])
 {
 	GDBusConnection *connection;
 	GError *error = NULL;
+	int r;
 
 	nm_g_type_init ();
 
-	connection = g_dbus_connection_new_for_address_sync ("unix:path=" NMRUNDIR "/private-dhcp",
+	r = send_message (&error);
+	if (r > 0)
+		return 0;
+	if (r < 0) {
+		g_printerr ("Error: could not send DHCP event to NetworkManager: %s\n",
+		            error->message);
+		g_error_free (error);
+		fatal_error ();
+	}
+
+	/* Fall back to D-Bus if NetworkManager doesn't listen on the socket,
+	 * e.g. because an older version of the daemon is still running. */
+	connection = g_dbus_connection_new_for_address_sync ("unix:path=" NM_DHCP_HELPER_DBUS_PATH,
 	                                                     G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT,
 	                                                     NULL, NULL, &error);
 	if (!connection) {
@@ -111,7 +213,7 @@ main (int argc, char *argv[])
 	if (!g_dbus_connection_emit_signal (connection,
 	                                    NULL,
 	                                    "/",
-	                                    NM_DHCP_CLIENT_DBUS_IFACE,
+	                                    NM_DHCP_HELPER_DBUS_IFACE,
 	                                    "Event",
 	                                    build_signal_parameters (),
 	                                    &error)) {
@@ -20,6 +20,8 @@
 #include "nm-default.h"
 
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <sys/wait.h>
 #include <signal.h>
 #include <string.h>
@@ -28,12 +30,12 @@
 #include <unistd.h>
 
 #include "nm-dhcp-listener.h"
+#include "nm-dhcp-helper-api.h"
+#include "nm-dhcp-utils.h"
 #include "nm-core-internal.h"
 #include "nm-bus-manager.h"
 #include "NetworkManagerUtils.h"
 
-#define NM_DHCP_CLIENT_DBUS_IFACE "org.freedesktop.nm_dhcp_client"
-#define PRIV_SOCK_PATH            NMRUNDIR "/private-dhcp"
 #define PRIV_SOCK_TAG             "dhcp"
 
 typedef struct {
@@ -41,8 +43,20 @@ typedef struct {
 	gulong              new_conn_id;
 	gulong              dis_conn_id;
 	GHashTable *        signal_handlers;
+
+	int                 sock_fd;
+	GIOChannel *        sock_channel;
+	guint               sock_id;
+	GSList *            clients;
 } NMDhcpListenerPrivate;
 
+typedef struct {
+	NMDhcpListener *    self;
+	int                 fd;
+	GIOChannel *        channel;
+	guint               id;
+} Client;
+
 #define NM_DHCP_LISTENER_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NM_TYPE_DHCP_LISTENER, NMDhcpListenerPrivate))
 
 G_DEFINE_TYPE (NMDhcpListener, nm_dhcp_listener, G_TYPE_OBJECT)
@@ -55,74 +69,30 @@ static guint signals[LAST_SIGNAL] = { 0 };
 
 /***************************************************/
 
-static char *
-get_option (GVariant *options, const char *key)
-{
-	GVariant *value;
-	const guchar *bytes, *s;
-	gsize len;
-	char *converted, *d;
-
-	if (!g_variant_lookup (options, key, "@ay", &value))
-		return NULL;
-
-	bytes = g_variant_get_fixed_array (value, &len, 1);
-
-	/* Since the DHCP options come through environment variables, they should
-	 * already be UTF-8 safe, but just make sure.
-	 */
-	converted = g_malloc (len + 1);
-	for (s = bytes, d = converted; s < bytes + len; s++, d++) {
-		/* Convert NULLs to spaces and non-ASCII characters to ? */
-		if (*s == '\0')
-			*d = ' ';
-		else if (*s > 127)
-			*d = '?';
-		else
-			*d = *s;
-	}
-	*d = '\0';
-	g_variant_unref (value);
-
-	return converted;
-}
-
+/* Takes ownership of @options */
 static void
-handle_event (GDBusConnection  *connection,
-              const char       *sender_name,
-              const char       *object_path,
-              const char       *interface_name,
-              const char       *signal_name,
-              GVariant         *parameters,
-              gpointer          user_data)
+handle_event (NMDhcpListener *self, GHashTable *options)
 {
-	NMDhcpListener *self = NM_DHCP_LISTENER (user_data);
-	char *iface = NULL;
-	char *pid_str = NULL;
-	char *reason = NULL;
+	const char *iface;
+	const char *pid_str;
+	const char *reason;
 	gint pid;
 	gboolean handled = FALSE;
-	GVariant *options;
 
-	if (!g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(a{sv})")))
-		return;
-
-	g_variant_get (parameters, "(@a{sv})", &options);
-
-	iface = get_option (options, "interface");
+	iface = g_hash_table_lookup (options, "interface");
 	if (iface == NULL) {
 		nm_log_warn (LOGD_DHCP, "dhcp-event: didn't have associated interface.");
 		goto out;
 	}
 
-	pid_str = get_option (options, "pid");
+	pid_str = g_hash_table_lookup (options, "pid");
 	pid = _nm_utils_ascii_str_to_int64 (pid_str, 10, 0, G_MAXINT32, -1);
 	if (pid == -1) {
 		nm_log_warn (LOGD_DHCP, "dhcp-event: couldn't convert PID '%s' to an integer", pid_str ? pid_str : "(null)");
 		goto out;
 	}
 
-	reason = get_option (options, "reason");
+	reason = g_hash_table_lookup (options, "reason");
 	if (reason == NULL) {
 		nm_log_warn (LOGD_DHCP, "dhcp-event: (pid %d) DHCP event didn't have a reason", pid);
 		goto out;
@@ -138,10 +108,194 @@ handle_event (GDBusConnection  *connection,
 	}
 
 out:
-	g_free (iface);
-	g_free (pid_str);
-	g_free (reason);
-	g_variant_unref (options);
+	g_hash_table_unref (options);
+}
+
+/***************************************************/
+
+static void
+client_free (Client *client)
+{
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (client->self);
+
+	priv->clients = g_slist_remove (priv->clients, client);
+	nm_clear_g_source (&client->id);
+	g_io_channel_unref (client->channel);
+	close (client->fd);
+	g_slice_free (Client, client);
+}
+
+static gboolean
+client_read_cb (GIOChannel *channel, GIOCondition condition, gpointer user_data)
+{
+	Client *client = user_data;
+	static guint8 buf[NM_DHCP_HELPER_MSG_MAX_SIZE];
+	struct iovec iov = { .iov_base = buf, .iov_len = sizeof (buf) };
+	struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1 };
+	GHashTable *options;
+	ssize_t len;
+	int errsv;
+
+	len = recvmsg (client->fd, &msg, MSG_DONTWAIT);
+	if (len < 0) {
+		errsv = errno;
+		if (errsv == EAGAIN || errsv == EINTR)
+			return G_SOURCE_CONTINUE;
+		nm_log_warn (LOGD_DHCP, "dhcp-event: failed to receive message: %s", strerror (errsv));
+		goto out;
+	}
+
+	/* the helper closed the connection without sending anything. */
+	if (len == 0)
+		goto out;
+
+	if (msg.msg_flags & MSG_TRUNC) {
+		nm_log_warn (LOGD_DHCP, "dhcp-event: message exceeds %d bytes", NM_DHCP_HELPER_MSG_MAX_SIZE);
+		goto out;
+	}
+
+	options = nm_dhcp_utils_parse_helper_message (buf, len);
+	if (!options) {
+		nm_log_warn (LOGD_DHCP, "dhcp-event: malformed message of %zd bytes", len);
+		goto out;
+	}
+
+	handle_event (client->self, options);
+
+out:
+	/* Each helper sends exactly one message per connection. */
+	client->id = 0;
+	client_free (client);
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+sock_accept_cb (GIOChannel *channel, GIOCondition condition, gpointer user_data)
+{
+	NMDhcpListener *self = user_data;
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+	struct ucred cred;
+	socklen_t cred_len = sizeof (cred);
+	Client *client;
+	int fd;
+
+	fd = accept4 (priv->sock_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+	if (fd < 0)
+		return G_SOURCE_CONTINUE;
+
+	/* Only accept lease events from DHCP clients running as root, like
+	 * the private D-Bus server does. */
+	if (   getsockopt (fd, SOL_SOCKET, SO_PEERCRED, &cred, &cred_len) != 0
+	    || cred.uid != 0) {
+		nm_log_warn (LOGD_DHCP, "dhcp-event: rejecting connection from unprivileged process");
+		close (fd);
+		return G_SOURCE_CONTINUE;
+	}
+
+	client = g_slice_new0 (Client);
+	client->self = self;
+	client->fd = fd;
+	client->channel = g_io_channel_unix_new (fd);
+	client->id = g_io_add_watch (client->channel, G_IO_IN | G_IO_ERR | G_IO_HUP, client_read_cb, client);
+	priv->clients = g_slist_prepend (priv->clients, client);
+	return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+sock_open (NMDhcpListener *self)
+{
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	int fd, errsv;
+
+	G_STATIC_ASSERT (sizeof (NM_DHCP_HELPER_SOCKET_PATH) <= sizeof (addr.sun_path));
+	memcpy (addr.sun_path, NM_DHCP_HELPER_SOCKET_PATH, sizeof (NM_DHCP_HELPER_SOCKET_PATH));
+
+	fd = socket (AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		errsv = errno;
+		goto fail;
+	}
+
+	/* remove a stale socket of a previous instance */
+	unlink (NM_DHCP_HELPER_SOCKET_PATH);
+
+	if (   bind (fd, (struct sockaddr *) &addr, sizeof (addr)) != 0
+	    || chmod (NM_DHCP_HELPER_SOCKET_PATH, 0600) != 0
+	    || listen (fd, SOMAXCONN) != 0) {
+		errsv = errno;
+		close (fd);
+		goto fail;
+	}
+
+	priv->sock_fd = fd;
+	priv->sock_channel = g_io_channel_unix_new (fd);
+	priv->sock_id = g_io_add_watch (priv->sock_channel, G_IO_IN, sock_accept_cb, self);
+	return TRUE;
+
+fail:
+	nm_log_warn (LOGD_DHCP, "dhcp-listener: failed to listen on %s: %s",
+	             NM_DHCP_HELPER_SOCKET_PATH, strerror (errsv));
+	return FALSE;
+}
+
+static void
+sock_close (NMDhcpListener *self)
+{
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+
+	while (priv->clients)
+		client_free (priv->clients->data);
+
+	if (priv->sock_fd >= 0) {
+		nm_clear_g_source (&priv->sock_id);
+		g_clear_pointer (&priv->sock_channel, g_io_channel_unref);
+		close (priv->sock_fd);
+		priv->sock_fd = -1;
+		unlink (NM_DHCP_HELPER_SOCKET_PATH);
+	}
+}
+
+/***************************************************/
+
+static void
+dbus_event_cb (GDBusConnection  *connection,
+               const char       *sender_name,
+               const char       *object_path,
+               const char       *interface_name,
+               const char       *signal_name,
+               GVariant         *parameters,
+               gpointer          user_data)
+{
+	NMDhcpListener *self = NM_DHCP_LISTENER (user_data);
+	GHashTable *options;
+	GVariantIter *iter;
+	const char *name;
+	GVariant *value;
+
+	if (!g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(a{sv})")))
+		return;
+
+	options = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+	/* Values are passed as byte arrays, because there are no character
+	 * encoding guarantees with DHCP. */
+	g_variant_get (parameters, "(a{sv})", &iter);
+	while (g_variant_iter_next (iter, "{&sv}", &name, &value)) {
+		if (g_variant_is_of_type (value, G_VARIANT_TYPE_BYTESTRING)) {
+			const guint8 *bytes;
+			gsize len;
+
+			bytes = g_variant_get_fixed_array (value, &len, 1);
+			g_hash_table_insert (options,
+			                     g_strdup (name),
+			                     nm_dhcp_utils_option_to_string (bytes, len));
+		}
+		g_variant_unref (value);
+	}
+	g_variant_iter_free (iter);
+
+	handle_event (self, options);
 }
 
 static void
@@ -155,12 +309,12 @@ new_connection_cb (NMBusManager *mgr,
 
 	id = g_dbus_connection_signal_subscribe (connection,
 	                                         NULL,
-	                                         NM_DHCP_CLIENT_DBUS_IFACE,
+	                                         NM_DHCP_HELPER_DBUS_IFACE,
 	                                         "Event",
 	                                         NULL,
 	                                         NULL,
 	                                         G_DBUS_SIGNAL_FLAGS_NONE,
-	                                         handle_event, self, NULL);
+	                                         dbus_event_cb, self, NULL);
 	g_hash_table_insert (priv->signal_handlers, connection, GUINT_TO_POINTER (id));
 }
 
@@ -191,10 +345,15 @@ nm_dhcp_listener_init (NMDhcpListener *self)
 	/* Maps GDBusConnection :: GDBusProxy */
 	priv->signal_handlers = g_hash_table_new (NULL, NULL);
 
+	/* The socket our DHCP clients will return lease info on */
+	priv->sock_fd = -1;
+	sock_open (self);
+
 	priv->dbus_mgr = nm_bus_manager_get ();
 
-	/* Register the socket our DHCP clients will return lease info on */
-	nm_bus_manager_private_server_register (priv->dbus_mgr, PRIV_SOCK_PATH, PRIV_SOCK_TAG);
+	/* Also listen on the private D-Bus socket, which is used by the
+	 * helper when it cannot reach the socket above. */
+	nm_bus_manager_private_server_register (priv->dbus_mgr, NM_DHCP_HELPER_DBUS_PATH, PRIV_SOCK_TAG);
 	priv->new_conn_id = g_signal_connect (priv->dbus_mgr,
 	                                      NM_BUS_MANAGER_PRIVATE_CONNECTION_NEW "::" PRIV_SOCK_TAG,
 	                                      G_CALLBACK (new_connection_cb),
@@ -216,6 +375,8 @@ dispose (GObject *object)
 
 	g_clear_pointer (&priv->signal_handlers, g_hash_table_destroy);
 
+	sock_close (NM_DHCP_LISTENER (object));
+
 	G_OBJECT_CLASS (nm_dhcp_listener_parent_class)->dispose (object);
 }
 
@@ -240,6 +401,6 @@ nm_dhcp_listener_class_init (NMDhcpListenerClass *listener_class)
 		              4,
 		              G_TYPE_STRING,      /* iface */
 		              G_TYPE_INT,         /* pid */
-		              G_TYPE_VARIANT,     /* options */
+		              G_TYPE_HASH_TABLE,  /* options (str:str hash) */
 		              G_TYPE_STRING);     /* reason */
 }
@@ -51,6 +51,7 @@ typedef struct {
 	char *lease_file;
 
 	guint request_count;
+	guint start_id;
 
 	gboolean privacy;
 	gboolean info_only;
@@ -549,6 +550,63 @@ get_arp_type (const GByteArray *hwaddr)
 		return ARPHRD_NONE;
 }
 
+/* When many interfaces start DHCP at once, like hundreds of VLANs or
+ * macvlans coming up together, space out the starts of the clients to
+ * not flood the link and the server with DISCOVERs. About
+ * NM_DHCP_SYSTEMD_START_BURST clients start immediately, further ones are
+ * delayed by NM_DHCP_SYSTEMD_START_SPACING_MSEC each. Once that would
+ * exceed NM_DHCP_SYSTEMD_START_DELAY_MAX_MSEC, the remaining clients start
+ * at a random time within that period.
+ *
+ * @next_start_ms tracks the next free start slot, @now is the current
+ * monotonic timestamp in milliseconds. Returns the delay in milliseconds. */
+guint
+_nm_dhcp_systemd_start_delay_get (gint64 *next_start_ms, gint64 now)
+{
+	gint64 slot;
+
+	slot = MAX (*next_start_ms, now - NM_DHCP_SYSTEMD_START_BURST * NM_DHCP_SYSTEMD_START_SPACING_MSEC);
+	if (slot <= now + NM_DHCP_SYSTEMD_START_DELAY_MAX_MSEC) {
+		*next_start_ms = slot + NM_DHCP_SYSTEMD_START_SPACING_MSEC;
+		return slot > now ? slot - now : 0;
+	}
+
+	/* all slots are taken. Don't start the remaining clients together
+	 * at the end of the period, but spread them over it. */
+	return g_random_int_range (NM_DHCP_SYSTEMD_START_SPACING_MSEC,
+	                           NM_DHCP_SYSTEMD_START_DELAY_MAX_MSEC + 1);
+}
+
+static guint
+_start_delay_get (void)
+{
+	static gint64 next_start_ms = 0;
+
+	return _nm_dhcp_systemd_start_delay_get (&next_start_ms,
+	                                         nm_utils_get_monotonic_timestamp_ms ());
+}
+
+static gboolean
+ip4_start_delayed_cb (gpointer user_data)
+{
+	NMDhcpSystemd *self = user_data;
+	NMDhcpSystemdPrivate *priv = NM_DHCP_SYSTEMD_GET_PRIVATE (self);
+	int r;
+
+	priv->start_id = 0;
+
+	r = sd_dhcp_client_start (priv->client4);
+	if (r < 0) {
+		_LOGW ("failed to start client (%d)", r);
+		nm_dhcp_client_set_state (NM_DHCP_CLIENT (self), NM_DHCP_STATE_FAIL, NULL, NULL);
+		return G_SOURCE_REMOVE;
+	}
+
+	/* the timeout only counts from the actual start. */
+	nm_dhcp_client_start_timeout (NM_DHCP_CLIENT (self));
+	return G_SOURCE_REMOVE;
+}
+
 static gboolean
 ip4_start (NMDhcpClient *client, const char *dhcp_anycast_addr, const char *last_ip4_address)
 {
@@ -565,6 +623,7 @@ ip4_start (NMDhcpClient *client, const char *dhcp_anycast_addr, const char *last
 	int r, i;
 	gboolean success = FALSE;
 	guint16 arp_type;
+	guint delay;
 
 	g_assert (priv->client4 == NULL);
 	g_assert (priv->client6 == NULL);
@@ -694,14 +753,19 @@ ip4_start (NMDhcpClient *client, const char *dhcp_anycast_addr, const char *last
 		}
 	}
 
-	r = sd_dhcp_client_start (priv->client4);
-	if (r < 0) {
-		_LOGW ("failed to start client (%d)", r);
-		goto error;
+	delay = _start_delay_get ();
+	if (delay) {
+		_LOGD ("delay start by %u ms", delay);
+		priv->start_id = g_timeout_add (delay, ip4_start_delayed_cb, self);
+	} else {
+		r = sd_dhcp_client_start (priv->client4);
+		if (r < 0) {
+			_LOGW ("failed to start client (%d)", r);
+			goto error;
+		}
+		nm_dhcp_client_start_timeout (client);
 	}
 
-	nm_dhcp_client_start_timeout (client);
-
 	success = TRUE;
 
 error:
@@ -981,6 +1045,8 @@ stop (NMDhcpClient *client, gboolean release, const GByteArray *duid)
 	       priv->client4 ? '4' : '6',
 	       priv->client4 ? (gpointer) priv->client4 : (gpointer) priv->client6);
 
+	nm_clear_g_source (&priv->start_id);
+
 	if (priv->client4) {
 		sd_dhcp_client_set_callback (priv->client4, NULL, NULL);
 		r = sd_dhcp_client_stop (priv->client4);
@@ -1006,6 +1072,7 @@ dispose (GObject *object)
 	NMDhcpSystemdPrivate *priv = NM_DHCP_SYSTEMD_GET_PRIVATE (object);
 
 	g_clear_pointer (&priv->lease_file, g_free);
+	nm_clear_g_source (&priv->start_id);
 
 	if (priv->client4) {
 		sd_dhcp_client_stop (priv->client4);
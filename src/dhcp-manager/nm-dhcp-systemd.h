@@ -38,5 +38,12 @@ typedef struct {
 
 GType nm_dhcp_systemd_get_type (void);
 
+/* exposed for testing */
+#define NM_DHCP_SYSTEMD_START_BURST             8
+#define NM_DHCP_SYSTEMD_START_SPACING_MSEC      25
+#define NM_DHCP_SYSTEMD_START_DELAY_MAX_MSEC    10000
+
+guint _nm_dhcp_systemd_start_delay_get (gint64 *next_start_ms, gint64 now);
+
 #endif /* NM_DHCP_SYSTEMD_H */
 
@@ -25,6 +25,7 @@
 #include <arpa/inet.h>
 
 #include "nm-dhcp-utils.h"
+#include "nm-dhcp-helper-api.h"
 #include "nm-utils.h"
 #include "NetworkManagerUtils.h"
 #include "nm-platform.h"
@@ -737,3 +738,74 @@ nm_dhcp_utils_client_id_string_to_bytes (const char *client_id)
 	return bytes;
 }
 
+/**
+ * nm_dhcp_utils_option_to_string:
+ * @value: the raw value of an option as passed by the DHCP client
+ * @len: the length of @value
+ *
+ * Since the DHCP options come through environment variables, they should
+ * already be UTF-8 safe, but just make sure.
+ *
+ * Returns: a newly allocated ASCII string with NULs converted to spaces
+ * and non-ASCII characters converted to '?'.
+ */
+char *
+nm_dhcp_utils_option_to_string (const guint8 *value, gsize len)
+{
+	char *converted;
+	gsize i;
+
+	converted = g_malloc (len + 1);
+	for (i = 0; i < len; i++) {
+		if (value[i] == '\0')
+			converted[i] = ' ';
+		else if (value[i] > 127)
+			converted[i] = '?';
+		else
+			converted[i] = value[i];
+	}
+	converted[len] = '\0';
+	return converted;
+}
+
+/**
+ * nm_dhcp_utils_parse_helper_message:
+ * @buf: a message as received from nm-dhcp-helper
+ * @len: the length of @buf
+ *
+ * Parses a lease event sent by nm-dhcp-helper, see nm-dhcp-helper-api.h
+ * for the format.
+ *
+ * Returns: a (char *) -> (char *) hash table of the options with their
+ * values converted by nm_dhcp_utils_option_to_string(), or %NULL if the
+ * message is malformed.
+ */
+GHashTable *
+nm_dhcp_utils_parse_helper_message (const guint8 *buf, gsize len)
+{
+	GHashTable *options;
+	const guint8 *end = buf + len;
+	const guint8 *entry, *eq, *nul;
+
+	if (   len < sizeof (NM_DHCP_HELPER_MSG_MAGIC)
+	    || memcmp (buf, NM_DHCP_HELPER_MSG_MAGIC, sizeof (NM_DHCP_HELPER_MSG_MAGIC)) != 0)
+		return NULL;
+
+	options = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	for (entry = buf + sizeof (NM_DHCP_HELPER_MSG_MAGIC); entry < end; entry = nul + 1) {
+		nul = memchr (entry, '\0', end - entry);
+		if (!nul)
+			goto fail;
+		eq = memchr (entry, '=', nul - entry);
+		if (!eq || eq == entry)
+			goto fail;
+		g_hash_table_insert (options,
+		                     g_strndup ((const char *) entry, eq - entry),
+		                     nm_dhcp_utils_option_to_string (eq + 1, nul - (eq + 1)));
+	}
+	return options;
+
+fail:
+	g_hash_table_unref (options);
+	return NULL;
+}
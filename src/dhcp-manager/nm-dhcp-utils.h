@@ -41,5 +41,9 @@ char *       nm_dhcp_utils_duid_to_string          (const GByteArray *duid);
 
 GBytes *     nm_dhcp_utils_client_id_string_to_bytes (const char *client_id);
 
+char *       nm_dhcp_utils_option_to_string        (const guint8 *value, gsize len);
+
+GHashTable * nm_dhcp_utils_parse_helper_message    (const guint8 *buf, gsize len);
+
 #endif /* __NETWORKMANAGER_DHCP_UTILS_H__ */
 
@@ -0,0 +1,372 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <netinet/if_ether.h>
+#include <sys/socket.h>
+
+#include "nm-dhcp-systemd.h"
+#include "nm-ip4-config.h"
+#include "nm-sd.h"
+#include "test-common.h"
+
+#define IFACE_VETH0     "nm-test-veth0"
+#define IFACE_VETH1     "nm-test-veth1"
+#define IFACE_MACVLAN   "nm-test-mv%u"
+
+#define NUM_CLIENTS     16
+
+#define SERVER_ADDR     "192.168.234.1"
+#define SERVER_PREFIX   24
+#define CLIENT_ADDR(i)  (htonl (0xc0a8ea0a + (i)))   /* 192.168.234.10 + i */
+
+/*****************************************************************************/
+
+/* A stand-in DHCP server, listening on the peer of the veth pair. It
+ * hands out an address to each client hardware address. */
+
+#define BOOTREQUEST     1
+#define BOOTREPLY       2
+#define DHCP_MAGIC      0x63825363
+
+#define DHCPDISCOVER    1
+#define DHCPOFFER       2
+#define DHCPREQUEST     3
+#define DHCPACK         5
+
+typedef struct {
+	guint8 op;
+	guint8 htype;
+	guint8 hlen;
+	guint8 hops;
+	guint32 xid;
+	guint16 secs;
+	guint16 flags;
+	guint32 ciaddr;
+	guint32 yiaddr;
+	guint32 siaddr;
+	guint32 giaddr;
+	guint8 chaddr[16];
+	guint8 sname[64];
+	guint8 file[128];
+	guint32 magic;
+	guint8 options[312];
+} __attribute__((packed)) DhcpMessage;
+
+typedef struct {
+	int fd;
+	GIOChannel *channel;
+	guint id;
+	GHashTable *clients;    /* chaddr string -> ServerClient */
+	guint num_discovers;
+	guint num_acks;
+} Server;
+
+typedef struct {
+	guint index;
+} ServerClient;
+
+static int
+_dhcp_message_get_type (const DhcpMessage *msg, gsize len)
+{
+	const guint8 *opt = msg->options;
+	const guint8 *end = ((const guint8 *) msg) + len;
+
+	while (opt < end && opt[0] != 255) {
+		if (opt[0] == 0) {
+			opt++;
+			continue;
+		}
+		if (opt + 2 > end || opt + 2 + opt[1] > end)
+			break;
+		if (opt[0] == 53 && opt[1] == 1)
+			return opt[2];
+		opt += 2 + opt[1];
+	}
+	return -1;
+}
+
+static guint8 *
+_dhcp_option_add (guint8 *opt, guint8 code, guint8 len, gconstpointer data)
+{
+	opt[0] = code;
+	opt[1] = len;
+	memcpy (&opt[2], data, len);
+	return opt + 2 + len;
+}
+
+static gboolean
+server_receive_cb (GIOChannel *channel, GIOCondition condition, gpointer user_data)
+{
+	Server *server = user_data;
+	struct sockaddr_in dst = {
+		.sin_family = AF_INET,
+		.sin_port = htons (68),
+		.sin_addr.s_addr = htonl (INADDR_BROADCAST),
+	};
+	DhcpMessage msg, reply;
+	ServerClient *client;
+	gs_free char *chaddr = NULL;
+	guint8 *opt;
+	guint32 u32;
+	guint8 u8;
+	ssize_t len;
+	int type;
+
+	len = recv (server->fd, &msg, sizeof (msg), MSG_DONTWAIT);
+	if (len < (ssize_t) G_STRUCT_OFFSET (DhcpMessage, options))
+		return G_SOURCE_CONTINUE;
+	if (   msg.op != BOOTREQUEST
+	    || msg.hlen != ETH_ALEN
+	    || ntohl (msg.magic) != DHCP_MAGIC)
+		return G_SOURCE_CONTINUE;
+
+	type = _dhcp_message_get_type (&msg, len);
+	if (!NM_IN_SET (type, DHCPDISCOVER, DHCPREQUEST))
+		return G_SOURCE_CONTINUE;
+
+	chaddr = nm_utils_hwaddr_ntoa (msg.chaddr, ETH_ALEN);
+	client = g_hash_table_lookup (server->clients, chaddr);
+	if (!client) {
+		client = g_slice_new0 (ServerClient);
+		client->index = g_hash_table_size (server->clients);
+		g_hash_table_insert (server->clients, g_strdup (chaddr), client);
+	}
+	if (type == DHCPDISCOVER)
+		server->num_discovers++;
+	else
+		server->num_acks++;
+
+	memset (&reply, 0, sizeof (reply));
+	reply.op = BOOTREPLY;
+	reply.htype = msg.htype;
+	reply.hlen = msg.hlen;
+	reply.xid = msg.xid;
+	reply.flags = msg.flags;
+	reply.yiaddr = CLIENT_ADDR (client->index);
+	memcpy (reply.chaddr, msg.chaddr, sizeof (reply.chaddr));
+	reply.magic = htonl (DHCP_MAGIC);
+
+	opt = reply.options;
+	u8 = type == DHCPDISCOVER ? DHCPOFFER : DHCPACK;
+	opt = _dhcp_option_add (opt, 53, 1, &u8);
+	inet_pton (AF_INET, SERVER_ADDR, &u32);
+	opt = _dhcp_option_add (opt, 54, 4, &u32);
+	opt = _dhcp_option_add (opt, 3, 4, &u32);
+	u32 = htonl (3600);
+	opt = _dhcp_option_add (opt, 51, 4, &u32);
+	u32 = nm_utils_ip4_prefix_to_netmask (SERVER_PREFIX);
+	opt = _dhcp_option_add (opt, 1, 4, &u32);
+	*opt++ = 255;
+
+	g_assert_cmpint (sendto (server->fd, &reply, opt - (guint8 *) &reply, 0,
+	                         (struct sockaddr *) &dst, sizeof (dst)), ==, opt - (guint8 *) &reply);
+	return G_SOURCE_CONTINUE;
+}
+
+static void
+server_client_free (gpointer data)
+{
+	g_slice_free (ServerClient, data);
+}
+
+static void
+server_start (Server *server, const char *iface)
+{
+	struct sockaddr_in addr = {
+		.sin_family = AF_INET,
+		.sin_port = htons (67),
+		.sin_addr.s_addr = htonl (INADDR_ANY),
+	};
+	int on = 1;
+
+	server->fd = socket (AF_INET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+	g_assert_cmpint (server->fd, >=, 0);
+	g_assert_cmpint (setsockopt (server->fd, SOL_SOCKET, SO_BINDTODEVICE, iface, strlen (iface) + 1), ==, 0);
+	g_assert_cmpint (setsockopt (server->fd, SOL_SOCKET, SO_BROADCAST, &on, sizeof (on)), ==, 0);
+	g_assert_cmpint (setsockopt (server->fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof (on)), ==, 0);
+	g_assert_cmpint (bind (server->fd, (struct sockaddr *) &addr, sizeof (addr)), ==, 0);
+
+	server->clients = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, server_client_free);
+	server->channel = g_io_channel_unix_new (server->fd);
+	server->id = g_io_add_watch (server->channel, G_IO_IN, server_receive_cb, server);
+}
+
+static void
+server_stop (Server *server)
+{
+	nm_clear_g_source (&server->id);
+	g_clear_pointer (&server->channel, g_io_channel_unref);
+	g_clear_pointer (&server->clients, g_hash_table_unref);
+	close (server->fd);
+}
+
+/*****************************************************************************/
+
+typedef struct {
+	int ifindex0;
+	int ifindex1;
+	int ifindex_mv[NUM_CLIENTS];
+} test_fixture;
+
+static void
+fixture_setup (test_fixture *fixture, gconstpointer user_data)
+{
+	guint i;
+
+	/* create veth pair, the DHCP server listens on the peer. */
+	nmtstp_run_command_check ("ip link add dev %s type veth peer name %s", IFACE_VETH0, IFACE_VETH1);
+	fixture->ifindex0 = nmtstp_assert_wait_for_link (NM_PLATFORM_GET, IFACE_VETH0, NM_LINK_TYPE_VETH, 100)->ifindex;
+	fixture->ifindex1 = nmtstp_assert_wait_for_link (NM_PLATFORM_GET, IFACE_VETH1, NM_LINK_TYPE_VETH, 100)->ifindex;
+	nmtstp_run_command_check ("ip addr add %s/%d dev %s", SERVER_ADDR, SERVER_PREFIX, IFACE_VETH1);
+
+	g_assert (nm_platform_link_set_up (NM_PLATFORM_GET, fixture->ifindex0, NULL));
+	g_assert (nm_platform_link_set_up (NM_PLATFORM_GET, fixture->ifindex1, NULL));
+
+	/* one macvlan per DHCP client on top of the other end. */
+	for (i = 0; i < NUM_CLIENTS; i++) {
+		char name[IFNAMSIZ];
+
+		nm_sprintf_buf (name, IFACE_MACVLAN, i);
+		nmtstp_run_command_check ("ip link add link %s name %s type macvlan mode bridge", IFACE_VETH0, name);
+		fixture->ifindex_mv[i] = nmtstp_assert_wait_for_link (NM_PLATFORM_GET, name, NM_LINK_TYPE_MACVLAN, 100)->ifindex;
+		g_assert (nm_platform_link_set_up (NM_PLATFORM_GET, fixture->ifindex_mv[i], NULL));
+	}
+}
+
+static void
+fixture_teardown (test_fixture *fixture, gconstpointer user_data)
+{
+	guint i;
+
+	for (i = 0; i < NUM_CLIENTS; i++)
+		nm_platform_link_delete (NM_PLATFORM_GET, fixture->ifindex_mv[i]);
+	nm_platform_link_delete (NM_PLATFORM_GET, fixture->ifindex0);
+	nm_platform_link_delete (NM_PLATFORM_GET, fixture->ifindex1);
+}
+
+/*****************************************************************************/
+
+typedef struct {
+	GMainLoop *loop;
+	guint num_bound;
+	guint num_failed;
+} TestInfo;
+
+static void
+client_state_changed (NMDhcpClient *client,
+                      NMDhcpState state,
+                      GObject *ip_config,
+                      GHashTable *options,
+                      const char *event_id,
+                      TestInfo *info)
+{
+	if (state == NM_DHCP_STATE_BOUND) {
+		g_assert (NM_IS_IP4_CONFIG (ip_config));
+		g_assert_cmpint (nm_ip4_config_get_num_addresses (NM_IP4_CONFIG (ip_config)), ==, 1);
+		info->num_bound++;
+	} else if (state != NM_DHCP_STATE_UNKNOWN)
+		info->num_failed++;
+
+	if (info->num_bound + info->num_failed == NUM_CLIENTS)
+		g_main_loop_quit (info->loop);
+}
+
+static void
+test_dhcp_systemd_many (test_fixture *fixture, gconstpointer user_data)
+{
+	NMDhcpClient *clients[NUM_CLIENTS];
+	gs_free char *uuid = nm_utils_uuid_generate ();
+	TestInfo info = { 0 };
+	Server server = { 0 };
+	guint sd_id;
+	guint i;
+
+	server_start (&server, IFACE_VETH1);
+	info.loop = g_main_loop_new (NULL, FALSE);
+	sd_id = nm_sd_event_attach_default ();
+
+	/* start all clients at once, like for many VLANs coming up together. */
+	for (i = 0; i < NUM_CLIENTS; i++) {
+		const NMPlatformLink *plink = nm_platform_link_get (NM_PLATFORM_GET, fixture->ifindex_mv[i]);
+		gconstpointer hwaddr_data;
+		size_t hwaddr_len = 0;
+		GByteArray *hwaddr;
+
+		g_assert (plink);
+		hwaddr_data = nm_platform_link_get_address (NM_PLATFORM_GET, plink->ifindex, &hwaddr_len);
+		g_assert (hwaddr_data && hwaddr_len == ETH_ALEN);
+		hwaddr = g_byte_array_sized_new (hwaddr_len);
+		g_byte_array_append (hwaddr, hwaddr_data, hwaddr_len);
+
+		clients[i] = g_object_new (NM_TYPE_DHCP_SYSTEMD,
+		                           NM_DHCP_CLIENT_INTERFACE, plink->name,
+		                           NM_DHCP_CLIENT_IFINDEX, plink->ifindex,
+		                           NM_DHCP_CLIENT_HWADDR, hwaddr,
+		                           NM_DHCP_CLIENT_IPV6, FALSE,
+		                           NM_DHCP_CLIENT_UUID, uuid,
+		                           NM_DHCP_CLIENT_PRIORITY, 0,
+		                           NM_DHCP_CLIENT_TIMEOUT, 30,
+		                           NULL);
+		g_byte_array_unref (hwaddr);
+		g_signal_connect (clients[i], NM_DHCP_CLIENT_SIGNAL_STATE_CHANGED,
+		                  G_CALLBACK (client_state_changed), &info);
+		g_assert (nm_dhcp_client_start_ip4 (clients[i], NULL, NULL, NULL, NULL, NULL));
+	}
+
+	g_assert (nmtst_main_loop_run (info.loop, 10000));
+
+	g_assert_cmpint (info.num_failed, ==, 0);
+	g_assert_cmpint (info.num_bound, ==, NUM_CLIENTS);
+	g_assert_cmpint (g_hash_table_size (server.clients), ==, NUM_CLIENTS);
+	g_assert_cmpint (server.num_discovers, >=, NUM_CLIENTS);
+	g_assert_cmpint (server.num_acks, >=, NUM_CLIENTS);
+
+	for (i = 0; i < NUM_CLIENTS; i++) {
+		gs_free char *lease_file = NULL;
+
+		lease_file = g_strdup_printf (NMSTATEDIR "/internal-%s-%s.lease",
+		                              uuid, nm_dhcp_client_get_iface (clients[i]));
+		nm_dhcp_client_stop (clients[i], FALSE);
+		g_object_unref (clients[i]);
+		unlink (lease_file);
+	}
+
+	nm_clear_g_source (&sd_id);
+	g_main_loop_unref (info.loop);
+	server_stop (&server);
+}
+
+/*****************************************************************************/
+
+void
+_nmtstp_init_tests (int *argc, char ***argv)
+{
+	nmtst_init_with_logging (argc, argv, NULL, "ALL");
+}
+
+void
+_nmtstp_setup_tests (void)
+{
+	g_test_add ("/dhcp/systemd/many", test_fixture, NULL, fixture_setup, test_dhcp_systemd_many, fixture_teardown);
+}
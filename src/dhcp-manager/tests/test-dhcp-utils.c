@@ -26,6 +26,8 @@
 #include "nm-utils.h"
 
 #include "nm-dhcp-utils.h"
+#include "nm-dhcp-helper-api.h"
+#include "nm-dhcp-systemd.h"
 #include "nm-platform.h"
 
 #include "nm-test-utils-core.h"
@@ -715,6 +717,93 @@ test_client_id_from_string (void)
 	COMPARE_ID (endcolon, TRUE, endcolon, strlen (endcolon));
 }
 
+#define PARSE_HELPER_MESSAGE(msg) \
+	nm_dhcp_utils_parse_helper_message ((const guint8 *) (msg), sizeof (msg) - 1)
+
+static void
+test_parse_helper_message (void)
+{
+	GHashTable *options;
+
+	options = PARSE_HELPER_MESSAGE (NM_DHCP_HELPER_MSG_MAGIC "\0"
+	                                "interface=eth0\0"
+	                                "pid=1234\0"
+	                                "reason=BOUND\0"
+	                                "new_ip_address=192.168.1.5\0"
+	                                "new_domain_name=foo\xc3" "bar\0"
+	                                "empty=\0"
+	                                "new_x=a=b\0");
+	g_assert (options);
+	g_assert_cmpint (g_hash_table_size (options), ==, 7);
+	g_assert_cmpstr (g_hash_table_lookup (options, "interface"), ==, "eth0");
+	g_assert_cmpstr (g_hash_table_lookup (options, "pid"), ==, "1234");
+	g_assert_cmpstr (g_hash_table_lookup (options, "reason"), ==, "BOUND");
+	g_assert_cmpstr (g_hash_table_lookup (options, "new_ip_address"), ==, "192.168.1.5");
+	g_assert_cmpstr (g_hash_table_lookup (options, "new_domain_name"), ==, "foo?bar");
+	g_assert_cmpstr (g_hash_table_lookup (options, "empty"), ==, "");
+	g_assert_cmpstr (g_hash_table_lookup (options, "new_x"), ==, "a=b");
+	g_hash_table_unref (options);
+
+	/* just the magic */
+	options = PARSE_HELPER_MESSAGE (NM_DHCP_HELPER_MSG_MAGIC "\0");
+	g_assert (options);
+	g_assert_cmpint (g_hash_table_size (options), ==, 0);
+	g_hash_table_unref (options);
+
+	/* wrong or truncated magic */
+	g_assert (!PARSE_HELPER_MESSAGE ("NMDHCP0\0a=b\0"));
+	g_assert (!PARSE_HELPER_MESSAGE ("NMD"));
+
+	/* unterminated entry */
+	g_assert (!PARSE_HELPER_MESSAGE (NM_DHCP_HELPER_MSG_MAGIC "\0" "a=b"));
+
+	/* entries without name or '=' */
+	g_assert (!PARSE_HELPER_MESSAGE (NM_DHCP_HELPER_MSG_MAGIC "\0" "=b\0"));
+	g_assert (!PARSE_HELPER_MESSAGE (NM_DHCP_HELPER_MSG_MAGIC "\0" "ab\0"));
+}
+
+static void
+test_systemd_start_delay (void)
+{
+	const gint64 now = 1000000;
+	gint64 next_start_ms = 0;
+	guint i, n, delay;
+
+	/* a burst of clients starts immediately, ... */
+	for (i = 0; i <= NM_DHCP_SYSTEMD_START_BURST; i++)
+		g_assert_cmpint (_nm_dhcp_systemd_start_delay_get (&next_start_ms, now), ==, 0);
+
+	/* ... further ones are spaced out, ... */
+	n = NM_DHCP_SYSTEMD_START_DELAY_MAX_MSEC / NM_DHCP_SYSTEMD_START_SPACING_MSEC;
+	for (i = 1; i <= n; i++) {
+		g_assert_cmpint (_nm_dhcp_systemd_start_delay_get (&next_start_ms, now),
+		                 ==,
+		                 i * NM_DHCP_SYSTEMD_START_SPACING_MSEC);
+	}
+
+	/* ... and once all slots are taken, spread over the whole period. */
+	for (i = 0; i < 100; i++) {
+		delay = _nm_dhcp_systemd_start_delay_get (&next_start_ms, now);
+		g_assert_cmpint (delay, >=, NM_DHCP_SYSTEMD_START_SPACING_MSEC);
+		g_assert_cmpint (delay, <=, NM_DHCP_SYSTEMD_START_DELAY_MAX_MSEC);
+	}
+
+	/* later, the slots are free again. */
+	g_assert_cmpint (_nm_dhcp_systemd_start_delay_get (&next_start_ms,
+	                                                   now + NM_DHCP_SYSTEMD_START_DELAY_MAX_MSEC + NM_DHCP_SYSTEMD_START_SPACING_MSEC),
+	                 ==,
+	                 0);
+
+	/* clients starting one by one are not delayed. */
+	next_start_ms = 0;
+	for (i = 0; i < 100; i++) {
+		g_assert_cmpint (_nm_dhcp_systemd_start_delay_get (&next_start_ms,
+		                                                   now + i * NM_DHCP_SYSTEMD_START_SPACING_MSEC),
+		                 ==,
+		                 0);
+	}
+}
+
 NMTST_DEFINE ();
 
 int main (int argc, char **argv)
@@ -741,7 +830,9 @@ int main (int argc, char **argv)
 	g_test_add_func ("/dhcp/ip4-missing-prefix-8", test_ip4_missing_prefix_8);
 	g_test_add_func ("/dhcp/ip4-prefix-classless", test_ip4_prefix_classless);
 	g_test_add_func ("/dhcp/client-id-from-string", test_client_id_from_string);
+	g_test_add_func ("/dhcp/parse-helper-message", test_parse_helper_message);
 	g_test_add_func ("/dhcp/vendor-option-metered", test_vendor_option_metered);
+	g_test_add_func ("/dhcp/systemd-start-delay", test_systemd_start_delay);
 
 	return g_test_run ();
 }
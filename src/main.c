@@ -127,6 +127,7 @@ nm_main_config_reload (int signal)
 		break;
 	case SIGUSR2:
 		reload_flags = NM_CONFIG_CHANGE_CAUSE_SIGUSR2;
+		nm_logging_recorder_dump_to_log ();
 		break;
 	default:
 		g_return_if_reached ();
@@ -323,6 +324,16 @@ main (int argc, char *argv[])
 		}
 	}
 
+	if (!nm_logging_recorder_setup (nm_config_data_get_value_cached (NM_CONFIG_GET_DATA_ORIG,
+	                                                                 NM_CONFIG_KEYFILE_GROUP_LOGGING,
+	                                                                 NM_CONFIG_KEYFILE_KEY_LOGGING_RECORDER,
+	                                                                 NM_CONFIG_GET_VALUE_STRIP | NM_CONFIG_GET_VALUE_NO_EMPTY),
+	                                &error)) {
+		fprintf (stderr, _("Error in configuration file: %s.\n"),
+		         error->message);
+		exit (1);
+	}
+
 	if (global_opt.become_daemon && !nm_config_get_is_debug (config)) {
 		if (daemon (0, 0) < 0) {
 			int saved_errno;
@@ -346,6 +357,12 @@ main (int argc, char *argv[])
 	                                                              NM_CONFIG_KEYFILE_KEY_LOGGING_BACKEND,
 	                                                              NM_CONFIG_GET_VALUE_STRIP | NM_CONFIG_GET_VALUE_NO_EMPTY));
 
+	if (nm_config_data_get_value_boolean (NM_CONFIG_GET_DATA_ORIG,
+	                                      NM_CONFIG_KEYFILE_GROUP_LOGGING,
+	                                      NM_CONFIG_KEYFILE_KEY_LOGGING_ASYNC,
+	                                      FALSE))
+		nm_logging_async_start ();
+
 	nm_log_info (LOGD_CORE, "NetworkManager (version " NM_DIST_VERSION ") is starting...");
 
 	nm_log_info (LOGD_CORE, "Read config: %s", nm_config_data_get_config_description (nm_config_get_data (config)));
@@ -425,5 +442,7 @@ done:
 
 	nm_clear_g_source (&sd_id);
 
+	nm_logging_async_stop ();
+
 	exit (success ? 0 : 1);
 }
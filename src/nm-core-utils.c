@@ -2137,7 +2137,7 @@ monotonic_timestamp_get (struct timespec *tp)
 	monotonic_timestamp_offset_sec = (- ((gint64) tp->tv_sec)) + 1;
 	monotonic_timestamp_clock_mode = clock_mode;
 
-	if (nm_logging_enabled (LOGL_DEBUG, LOGD_CORE)) {
+	if (nm_logging_backend_enabled (LOGL_DEBUG, LOGD_CORE)) {
 		time_t now = time (NULL);
 		struct tm tm;
 		char s[255];
@@ -3657,3 +3657,55 @@ nm_utils_get_reverse_dns_domains_ip6 (const struct in6_addr *ip, guint8 plen, GP
 
 #undef N_SHIFT
 }
+
+/*****************************************************************************/
+
+#define PARALLEL_MIN_ITEMS   16
+#define PARALLEL_MAX_THREADS 16
+
+/**
+ * nm_utils_parallel_for_each:
+ * @items: the items to process. They must not be %NULL.
+ * @len: the number of @items
+ * @func: called for each item with @user_data, possibly from another thread
+ * @user_data: data for @func
+ *
+ * Calls @func for each item on a pool of worker threads and returns
+ * once all calls completed. @func must be thread-safe; in particular it
+ * must not touch the platform or other main-loop objects. For few
+ * items, or if no thread can be created, @func is called on the
+ * calling thread.
+ */
+void
+nm_utils_parallel_for_each (gpointer *items,
+                            guint len,
+                            GFunc func,
+                            gpointer user_data)
+{
+	GThreadPool *pool = NULL;
+	long n_threads;
+	guint i;
+
+	g_return_if_fail (items || !len);
+	g_return_if_fail (func);
+
+	if (len >= PARALLEL_MIN_ITEMS) {
+		n_threads = sysconf (_SC_NPROCESSORS_ONLN);
+		n_threads = CLAMP (n_threads, 2, PARALLEL_MAX_THREADS);
+		pool = g_thread_pool_new (func, user_data, MIN (n_threads, len), TRUE, NULL);
+	}
+
+	if (!pool) {
+		for (i = 0; i < len; i++)
+			func (items[i], user_data);
+		return;
+	}
+
+	for (i = 0; i < len; i++) {
+		nm_assert (items[i]);
+		g_thread_pool_push (pool, items[i], NULL);
+	}
+
+	/* wait for all items */
+	g_thread_pool_free (pool, FALSE, TRUE);
+}
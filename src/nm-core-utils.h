@@ -429,4 +429,9 @@ const char *nm_utils_dnsmasq_status_to_string (int status, char *dest, gsize siz
 void nm_utils_get_reverse_dns_domains_ip4 (guint32 ip, guint8 plen, GPtrArray *domains);
 void nm_utils_get_reverse_dns_domains_ip6 (const struct in6_addr *ip, guint8 plen, GPtrArray *domains);
 
+void nm_utils_parallel_for_each (gpointer *items,
+                                 guint len,
+                                 GFunc func,
+                                 gpointer user_data);
+
 #endif /* __NM_CORE_UTILS_H__ */
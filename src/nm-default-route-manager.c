@@ -180,7 +180,7 @@ typedef struct {
 static const VTableIP vtable_ip4, vtable_ip6;
 
 static NMPlatformIPRoute *
-_vt_route_index (const VTableIP *vtable, GArray *routes, guint index)
+_vt_route_index (const VTableIP *vtable, const GArray *routes, guint index)
 {
 	if (vtable->vt->is_ip4)
 		return (NMPlatformIPRoute *) &g_array_index (routes, NMPlatformIP4Route, index);
@@ -189,7 +189,7 @@ _vt_route_index (const VTableIP *vtable, GArray *routes, guint index)
 }
 
 static gboolean
-_vt_routes_has_entry (const VTableIP *vtable, GArray *routes, const Entry *entry)
+_vt_routes_has_entry (const VTableIP *vtable, const GArray *routes, const Entry *entry)
 {
 	guint i;
 	NMPlatformIPXRoute route = entry->route;
@@ -318,12 +318,14 @@ _platform_route_sync_flush (const VTableIP *vtable, NMDefaultRouteManager *self,
 {
 	NMDefaultRouteManagerPrivate *priv = NM_DEFAULT_ROUTE_MANAGER_GET_PRIVATE (self);
 	GPtrArray *entries = vtable->get_entries (priv);
-	GArray *routes;
+	NMPlatformSnapshot *snapshot;
+	const GArray *routes;
 	guint i, j;
 	gboolean changed = FALSE;
 
 	/* prune all other default routes from this device. */
-	routes = vtable->vt->route_get_all (priv->platform, 0, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT);
+	snapshot = vtable->vt->route_get_snapshot (priv->platform, 0, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT);
+	routes = nm_platform_snapshot_get_array (snapshot);
 
 	for (i = 0; i < routes->len; i++) {
 		const NMPlatformIPRoute *route;
@@ -359,7 +361,7 @@ _platform_route_sync_flush (const VTableIP *vtable, NMDefaultRouteManager *self,
 			changed = TRUE;
 		}
 	}
-	g_array_free (routes, TRUE);
+	nm_platform_snapshot_unref (snapshot);
 	return changed;
 }
 
@@ -406,7 +408,7 @@ _sort_entries_cmp (gconstpointer a, gconstpointer b, gpointer user_data)
 }
 
 static GHashTable *
-_get_assumed_interface_metrics (const VTableIP *vtable, NMDefaultRouteManager *self, GArray *routes)
+_get_assumed_interface_metrics (const VTableIP *vtable, NMDefaultRouteManager *self, const GArray *routes)
 {
 	NMDefaultRouteManagerPrivate *priv = NM_DEFAULT_ROUTE_MANAGER_GET_PRIVATE (self);
 	GPtrArray *entries;
@@ -491,7 +493,8 @@ _resync_all (const VTableIP *vtable, NMDefaultRouteManager *self, const Entry *c
 	GPtrArray *entries;
 	GArray *changed_metrics = g_array_new (FALSE, FALSE, sizeof (guint32));
 	GHashTable *assumed_metrics;
-	GArray *routes;
+	NMPlatformSnapshot *snapshot;
+	const GArray *routes;
 	gboolean changed = FALSE;
 	int ifindex_to_flush = 0;
 
@@ -509,7 +512,8 @@ _resync_all (const VTableIP *vtable, NMDefaultRouteManager *self, const Entry *c
 
 	entries = vtable->get_entries (priv);
 
-	routes = vtable->vt->route_get_all (priv->platform, 0, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT);
+	snapshot = vtable->vt->route_get_snapshot (priv->platform, 0, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT);
+	routes = nm_platform_snapshot_get_array (snapshot);
 
 	assumed_metrics = _get_assumed_interface_metrics (vtable, self, routes);
 
@@ -608,7 +612,7 @@ _resync_all (const VTableIP *vtable, NMDefaultRouteManager *self, const Entry *c
 		last_metric = expected_metric;
 	}
 
-	g_array_free (routes, TRUE);
+	nm_platform_snapshot_unref (snapshot);
 
 	g_array_sort (changed_metrics, _sort_metrics_ascending_fcn);
 	last_metric = -1;
@@ -23,6 +23,7 @@
 
 #include <string.h>
 #include <errno.h>
+#include <sys/stat.h>
 
 #include "nm-dispatcher.h"
 #include "nm-dispatcher-api.h"
@@ -649,7 +650,7 @@ _dispatcher_call (DispatcherAction action,
 		                                               &vpn_proxy_props,
 		                                               &vpn_ip4_props,
 		                                               &vpn_ip6_props,
-		                                               nm_logging_enabled (LOGL_DEBUG, LOGD_DISPATCH)),
+		                                               nm_logging_backend_enabled (LOGL_DEBUG, LOGD_DISPATCH)),
 		                                G_VARIANT_TYPE ("(a(sus))"),
 		                                G_DBUS_CALL_FLAGS_NONE, CALL_TIMEOUT,
 		                                NULL, &error);
@@ -687,7 +688,7 @@ _dispatcher_call (DispatcherAction action,
 		                                  &vpn_proxy_props,
 		                                  &vpn_ip4_props,
 		                                  &vpn_ip6_props,
-		                                  nm_logging_enabled (LOGL_DEBUG, LOGD_DISPATCH)),
+		                                  nm_logging_backend_enabled (LOGL_DEBUG, LOGD_DISPATCH)),
 		                   G_DBUS_CALL_FLAGS_NONE, CALL_TIMEOUT,
 		                   NULL, dispatcher_done_cb, info);
 		success = TRUE;
@@ -865,6 +866,31 @@ nm_dispatcher_call_cancel (guint call_id)
 	}
 }
 
+/* Applies the file name filter of the dispatcher service and mirrors the
+ * checks of find_scripts() in callouts/nm-dispatcher.c, so that a directory
+ * only containing subdirectories (like "no-wait.d"), backup files or
+ * non-executable files is not considered to have scripts. The daemon runs
+ * as root, so we don't check ownership here and leave it to the dispatcher
+ * to reject such scripts. */
+static gboolean
+_script_is_candidate (const char *dirname, const char *file_name)
+{
+	gs_free char *path = NULL;
+	struct stat st;
+
+	if (!nm_dispatcher_script_name_is_valid (file_name))
+		return FALSE;
+
+	path = g_build_filename (dirname, file_name, NULL);
+
+	/* follow symlinks, scripts in "no-wait.d" are linked from the
+	 * default directory. */
+	if (stat (path, &st) != 0)
+		return FALSE;
+	return    S_ISREG (st.st_mode)
+	       && (st.st_mode & S_IXUSR);
+}
+
 static void
 dispatcher_dir_changed (GFileMonitor *monitor,
                         GFile *file,
@@ -873,7 +899,6 @@ dispatcher_dir_changed (GFileMonitor *monitor,
                         Monitor *item)
 {
 	const char *name;
-	char *full_name;
 	GDir *dir;
 	GError *error = NULL;
 
@@ -885,9 +910,9 @@ dispatcher_dir_changed (GFileMonitor *monitor,
 		errno = 0;
 		while (!item->has_scripts
 		    && (name = g_dir_read_name (dir))) {
-			full_name = g_build_filename (item->dir, name, NULL);
-			item->has_scripts = g_file_test (full_name, G_FILE_TEST_IS_EXECUTABLE);
-			g_free (full_name);
+			item->has_scripts = _script_is_candidate (item->dir, name);
+			/* _script_is_candidate() may clobber errno with a failed stat(). */
+			errno = 0;
 		}
 		errsv = errno;
 		g_dir_close (dir);
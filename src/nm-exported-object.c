@@ -44,12 +44,15 @@ typedef struct {
 	NMBusManager *bus_mgr;
 	char *path;
 
+	/* D-Bus property name -> GParamSpec. The values are only read when
+	 * the notification is emitted. */
 	GHashTable *pending_notifies;
 
 	InterfaceData *interfaces;
 	guint num_interfaces;
 
-	guint notify_idle_id;
+	/* link in notify_queue. The data is set while the object is queued. */
+	GList notify_link;
 
 #ifdef _ASSERT_NO_EARLY_EXPORT
 	bool _constructed:1;
@@ -58,6 +61,8 @@ typedef struct {
 
 #define NM_EXPORTED_OBJECT_GET_PRIVATE(o) (G_TYPE_INSTANCE_GET_PRIVATE ((o), NM_TYPE_EXPORTED_OBJECT, NMExportedObjectPrivate))
 
+static gboolean _notify_dequeue (NMExportedObjectPrivate *priv);
+
 typedef struct {
 	GHashTable *properties;
 	GSList *skeleton_types;
@@ -699,7 +704,7 @@ nm_exported_object_unexport (NMExportedObject *self)
 
 	g_clear_pointer (&priv->path, g_free);
 
-	if (nm_clear_g_source (&priv->notify_idle_id)) {
+	if (_notify_dequeue (priv)) {
 		/* We had a notification queued. Since we removed all interfaces,
 		 * the notification is obsolete and must be cleaned up. */
 		g_hash_table_remove_all (priv->pending_notifies);
@@ -768,7 +773,7 @@ nm_exported_object_class_set_quitting (void)
 
 typedef struct {
 	const char *property_name;
-	GVariant *variant;
+	GParamSpec *pspec;
 } PendingNotifiesItem;
 
 static int
@@ -778,8 +783,26 @@ _sort_pending_notifies (gconstpointer a, gconstpointer b, gpointer       user_da
 	               ((const PendingNotifiesItem *) b)->property_name);
 }
 
-static gboolean
-idle_emit_properties_changed (gpointer self)
+static const GVariantType *
+_find_property_type (NMExportedObjectPrivate *priv, const char *dbus_property_name)
+{
+	guint i, j;
+
+	for (i = 0; i < priv->num_interfaces; i++) {
+		GDBusInterfaceSkeleton *skel = priv->interfaces[i].interface;
+		GDBusInterfaceInfo *iinfo;
+
+		iinfo = g_dbus_interface_skeleton_get_info (skel);
+		for (j = 0; iinfo->properties[j]; j++) {
+			if (nm_streq (iinfo->properties[j]->name, dbus_property_name))
+				return G_VARIANT_TYPE (iinfo->properties[j]->signature);
+		}
+	}
+	return NULL;
+}
+
+static void
+emit_properties_changed (NMExportedObject *self)
 {
 	NMExportedObjectPrivate *priv = NM_EXPORTED_OBJECT_GET_PRIVATE (self);
 	gs_unref_variant GVariant *variant = NULL;
@@ -789,25 +812,39 @@ idle_emit_properties_changed (gpointer self)
 	guint i, n;
 	PendingNotifiesItem *values;
 
-	priv->notify_idle_id = 0;
-
-
 	n = g_hash_table_size (priv->pending_notifies);
-	g_return_val_if_fail (n > 0, FALSE);
+	g_return_if_fail (n > 0);
 
 	values = g_alloca (sizeof (values[0]) * n);
 
 	i = 0;
 	g_hash_table_iter_init (&hash_iter, priv->pending_notifies);
-	while (g_hash_table_iter_next (&hash_iter, (gpointer) &values[i].property_name, (gpointer) &values[i].variant))
+	while (g_hash_table_iter_next (&hash_iter, (gpointer) &values[i].property_name, (gpointer) &values[i].pspec))
 		i++;
 	nm_assert (i == n);
 
 	g_qsort_with_data (values, n, sizeof (values[0]), _sort_pending_notifies, NULL);
 
+	/* Only now read and serialize the values. If a property changed several
+	 * times since it was queued, only the last value is sent. */
 	g_variant_builder_init (&notifies, G_VARIANT_TYPE_VARDICT);
-	for (i = 0; i < n; i++)
-		g_variant_builder_add (&notifies, "{sv}", values[i].property_name, values[i].variant);
+	for (i = 0; i < n; i++) {
+		const GVariantType *vtype;
+		GValue value = G_VALUE_INIT;
+
+		vtype = _find_property_type (priv, values[i].property_name);
+		if (!vtype) {
+			g_warn_if_reached ();
+			continue;
+		}
+
+		g_value_init (&value, values[i].pspec->value_type);
+		g_object_get_property (G_OBJECT (self), values[i].pspec->name, &value);
+		g_variant_builder_add (&notifies, "{sv}",
+		                       values[i].property_name,
+		                       g_dbus_gvalue_to_gvariant (&value, vtype));
+		g_value_unset (&value);
+	}
 	variant = g_variant_ref_sink (g_variant_builder_end (&notifies));
 
 	g_hash_table_remove_all (priv->pending_notifies);
@@ -818,9 +855,9 @@ idle_emit_properties_changed (gpointer self)
 			break;
 		}
 	}
-	g_return_val_if_fail (ifdata, FALSE);
+	g_return_if_fail (ifdata);
 
-	if (nm_logging_enabled (LOGL_DEBUG, LOGD_DBUS_PROPS)) {
+	if (nm_logging_backend_enabled (LOGL_DEBUG, LOGD_DBUS_PROPS)) {
 		gs_free char *notification = g_variant_print (variant, TRUE);
 
 		nm_log_dbg (LOGD_DBUS_PROPS, "PropertiesChanged %s %p: %s",
@@ -828,7 +865,67 @@ idle_emit_properties_changed (gpointer self)
 	}
 
 	g_signal_emit (ifdata->interface, ifdata->property_changed_signal_id, 0, variant);
-	return FALSE;
+}
+
+/*****************************************************************************/
+
+/* Objects with pending property notifications. Instead of one idle source
+ * per object, all of them are flushed together from a single idle handler. */
+static GQueue notify_queue = G_QUEUE_INIT;
+static guint notify_flush_id;
+
+static gboolean
+notify_flush (gpointer user_data)
+{
+	NMExportedObject *self;
+	NMExportedObjectPrivate *priv;
+	GList *link;
+	guint n;
+
+	notify_flush_id = 0;
+
+	/* Objects that get queued while we emit are left for the next round. */
+	for (n = notify_queue.length; n > 0; n--) {
+		link = g_queue_pop_head_link (&notify_queue);
+		if (!link)
+			break;
+
+		self = g_object_ref (link->data);
+		link->data = NULL;
+
+		priv = NM_EXPORTED_OBJECT_GET_PRIVATE (self);
+		if (g_hash_table_size (priv->pending_notifies) > 0)
+			emit_properties_changed (self);
+		g_object_unref (self);
+	}
+
+	if (notify_queue.length > 0)
+		notify_flush_id = g_idle_add (notify_flush, NULL);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+_notify_queue (NMExportedObject *self, NMExportedObjectPrivate *priv)
+{
+	if (priv->notify_link.data)
+		return;
+
+	priv->notify_link.data = self;
+	g_queue_push_tail_link (&notify_queue, &priv->notify_link);
+
+	if (!notify_flush_id)
+		notify_flush_id = g_idle_add (notify_flush, NULL);
+}
+
+static gboolean
+_notify_dequeue (NMExportedObjectPrivate *priv)
+{
+	if (!priv->notify_link.data)
+		return FALSE;
+
+	g_queue_unlink (&notify_queue, &priv->notify_link);
+	priv->notify_link.data = NULL;
+	return TRUE;
 }
 
 static void
@@ -838,9 +935,6 @@ nm_exported_object_notify (GObject *object, GParamSpec *pspec)
 	NMExportedObjectClassInfo *classinfo;
 	GType type;
 	const char *dbus_property_name = NULL;
-	GValue value = G_VALUE_INIT;
-	const GVariantType *vtype;
-	guint i, j;
 
 	if (priv->num_interfaces == 0)
 		return;
@@ -860,33 +954,13 @@ nm_exported_object_notify (GObject *object, GParamSpec *pspec)
 		return;
 	}
 
-	for (i = 0; i < priv->num_interfaces; i++) {
-		GDBusInterfaceSkeleton *skel = priv->interfaces[i].interface;
-		GDBusInterfaceInfo *iinfo;
-
-		iinfo = g_dbus_interface_skeleton_get_info (skel);
-		for (j = 0; iinfo->properties[j]; j++) {
-			if (nm_streq (iinfo->properties[j]->name, dbus_property_name)) {
-				vtype = G_VARIANT_TYPE (iinfo->properties[j]->signature);
-				goto vtype_found;
-			}
-		}
-	}
-	g_return_if_reached ();
-
-vtype_found:
-	g_value_init (&value, pspec->value_type);
-	g_object_get_property (G_OBJECT (object), pspec->name, &value);
-
 	/* @dbus_property_name is inside classinfo and never freed, thus we don't clone it.
 	 * Also, we do a pointer, not string comparison. */
 	g_hash_table_insert (priv->pending_notifies,
 	                     (gpointer) dbus_property_name,
-	                     g_dbus_gvalue_to_gvariant (&value, vtype));
-	g_value_unset (&value);
+	                     pspec);
 
-	if (!priv->notify_idle_id)
-		priv->notify_idle_id = g_idle_add (idle_emit_properties_changed, object);
+	_notify_queue ((NMExportedObject *) object, priv);
 }
 
 /*****************************************************************************/
@@ -896,10 +970,7 @@ nm_exported_object_init (NMExportedObject *self)
 {
 	NMExportedObjectPrivate *priv = NM_EXPORTED_OBJECT_GET_PRIVATE (self);
 
-	priv->pending_notifies = g_hash_table_new_full (g_direct_hash,
-	                                                g_direct_equal,
-	                                                NULL,
-	                                                (GDestroyNotify) g_variant_unref);
+	priv->pending_notifies = g_hash_table_new (g_direct_hash, g_direct_equal);
 }
 
 static void
@@ -936,7 +1007,7 @@ nm_exported_object_dispose (GObject *object)
 		g_clear_pointer (&priv->path, g_free);
 
 	g_clear_pointer (&priv->pending_notifies, g_hash_table_destroy);
-	nm_clear_g_source (&priv->notify_idle_id);
+	_notify_dequeue (priv);
 
 	G_OBJECT_CLASS (nm_exported_object_parent_class)->dispose (object);
 }
@@ -31,6 +31,7 @@
 #include "nm-platform-utils.h"
 #include "NetworkManagerUtils.h"
 #include "nm-route-manager.h"
+#include "nm-prefix-trie.h"
 #include "nm-core-internal.h"
 
 #include "nmdbus-ip4-config.h"
@@ -41,6 +42,9 @@ typedef struct {
 	gboolean has_gateway;
 	GArray *addresses;
 	GArray *routes;
+	/* index of @routes for nm_ip4_config_get_direct_route_for_host(),
+	 * created on demand. The values are the route indexes plus one. */
+	NMPrefixTrie *routes_lpm;
 	GArray *nameservers;
 	GPtrArray *domains;
 	GPtrArray *searches;
@@ -1591,6 +1595,12 @@ nm_ip4_config_address_exists (const NMIP4Config *config,
 
 /******************************************************************/
 
+static void
+_routes_lpm_clear (NMIP4ConfigPrivate *priv)
+{
+	g_clear_pointer (&priv->routes_lpm, nm_prefix_trie_free);
+}
+
 void
 nm_ip4_config_reset_routes (NMIP4Config *config)
 {
@@ -1598,6 +1608,7 @@ nm_ip4_config_reset_routes (NMIP4Config *config)
 
 	if (priv->routes->len != 0) {
 		g_array_set_size (priv->routes, 0);
+		_routes_lpm_clear (priv);
 		_notify (config, PROP_ROUTE_DATA);
 		_notify (config, PROP_ROUTES);
 	}
@@ -1641,6 +1652,8 @@ nm_ip4_config_add_route (NMIP4Config *config, const NMPlatformIP4Route *new)
 
 	g_array_append_val (priv->routes, *new);
 	g_array_index (priv->routes, NMPlatformIP4Route, priv->routes->len - 1).ifindex = priv->ifindex;
+	if (priv->routes_lpm)
+		nm_prefix_trie_add (priv->routes_lpm, &new->network, new->plen, GUINT_TO_POINTER (priv->routes->len));
 NOTIFY:
 	_notify (config, PROP_ROUTE_DATA);
 	_notify (config, PROP_ROUTES);
@@ -1654,6 +1667,7 @@ nm_ip4_config_del_route (NMIP4Config *config, guint i)
 	g_return_if_fail (i < priv->routes->len);
 
 	g_array_remove_index (priv->routes, i);
+	_routes_lpm_clear (priv);
 	_notify (config, PROP_ROUTE_DATA);
 	_notify (config, PROP_ROUTES);
 }
@@ -1674,34 +1688,53 @@ nm_ip4_config_get_route (const NMIP4Config *config, guint i)
 	return &g_array_index (priv->routes, NMPlatformIP4Route, i);
 }
 
-const NMPlatformIP4Route *
-nm_ip4_config_get_direct_route_for_host (const NMIP4Config *config, guint32 host)
+typedef struct {
+	const GArray *routes;
+	const NMPlatformIP4Route *best_route;
+} DirectRouteData;
+
+static gboolean
+_direct_route_for_host_cb (guint8 plen, void *const* values, guint len, gpointer user_data)
 {
-	const NMIP4ConfigPrivate *priv = NM_IP4_CONFIG_GET_PRIVATE (config);
+	DirectRouteData *data = user_data;
 	guint i;
-	NMPlatformIP4Route *best_route = NULL;
 
-	g_return_val_if_fail (host, NULL);
-
-	for (i = 0; i < priv->routes->len; i++) {
-		NMPlatformIP4Route *item = &g_array_index (priv->routes, NMPlatformIP4Route, i);
+	for (i = 0; i < len; i++) {
+		const NMPlatformIP4Route *item = &g_array_index (data->routes, NMPlatformIP4Route, GPOINTER_TO_UINT (values[i]) - 1);
 
 		if (item->gateway != 0)
 			continue;
 
-		if (best_route && best_route->plen > item->plen)
+		if (data->best_route && data->best_route->metric <= item->metric)
 			continue;
 
-		if (nm_utils_ip4_address_clear_host_address (host, item->plen) != nm_utils_ip4_address_clear_host_address (item->network, item->plen))
-			continue;
+		data->best_route = item;
+	}
+	return !!data->best_route;
+}
 
-		if (best_route && best_route->metric <= item->metric)
-			continue;
+const NMPlatformIP4Route *
+nm_ip4_config_get_direct_route_for_host (const NMIP4Config *config, guint32 host)
+{
+	/* @routes_lpm is only a lookup cache, building it doesn't change @config. */
+	NMIP4ConfigPrivate *priv = (NMIP4ConfigPrivate *) NM_IP4_CONFIG_GET_PRIVATE (config);
+	DirectRouteData data = { 0 };
+	guint i;
+
+	g_return_val_if_fail (host, NULL);
 
-		best_route = item;
+	if (!priv->routes_lpm) {
+		priv->routes_lpm = nm_prefix_trie_new (AF_INET);
+		for (i = 0; i < priv->routes->len; i++) {
+			const NMPlatformIP4Route *item = &g_array_index (priv->routes, NMPlatformIP4Route, i);
+
+			nm_prefix_trie_add (priv->routes_lpm, &item->network, item->plen, GUINT_TO_POINTER (i + 1));
+		}
 	}
 
-	return best_route;
+	data.routes = priv->routes;
+	nm_prefix_trie_lookup_lpm (priv->routes_lpm, &host, 32, _direct_route_for_host_cb, &data);
+	return data.best_route;
 }
 
 /******************************************************************/
@@ -2288,6 +2321,7 @@ finalize (GObject *object)
 
 	g_array_unref (priv->addresses);
 	g_array_unref (priv->routes);
+	_routes_lpm_clear (priv);
 	g_array_unref (priv->nameservers);
 	g_ptr_array_unref (priv->domains);
 	g_ptr_array_unref (priv->searches);
@@ -30,6 +30,7 @@
 #include "nm-platform.h"
 #include "nm-platform-utils.h"
 #include "nm-route-manager.h"
+#include "nm-prefix-trie.h"
 #include "nm-core-internal.h"
 #include "NetworkManagerUtils.h"
 
@@ -40,6 +41,9 @@ typedef struct {
 	struct in6_addr gateway;
 	GArray *addresses;
 	GArray *routes;
+	/* index of @routes for nm_ip6_config_get_direct_route_for_host(),
+	 * created on demand. The values are the route indexes plus one. */
+	NMPrefixTrie *routes_lpm;
 	GArray *nameservers;
 	GPtrArray *domains;
 	GPtrArray *searches;
@@ -1464,6 +1468,12 @@ nm_ip6_config_has_any_dad_pending (const NMIP6Config *self,
 
 /******************************************************************/
 
+static void
+_routes_lpm_clear (NMIP6ConfigPrivate *priv)
+{
+	g_clear_pointer (&priv->routes_lpm, nm_prefix_trie_free);
+}
+
 void
 nm_ip6_config_reset_routes (NMIP6Config *config)
 {
@@ -1471,6 +1481,7 @@ nm_ip6_config_reset_routes (NMIP6Config *config)
 
 	if (priv->routes->len != 0) {
 		g_array_set_size (priv->routes, 0);
+		_routes_lpm_clear (priv);
 		_notify (config, PROP_ROUTE_DATA);
 		_notify (config, PROP_ROUTES);
 	}
@@ -1514,6 +1525,8 @@ nm_ip6_config_add_route (NMIP6Config *config, const NMPlatformIP6Route *new)
 
 	g_array_append_val (priv->routes, *new);
 	g_array_index (priv->routes, NMPlatformIP6Route, priv->routes->len - 1).ifindex = priv->ifindex;
+	if (priv->routes_lpm)
+		nm_prefix_trie_add (priv->routes_lpm, &new->network, new->plen, GUINT_TO_POINTER (priv->routes->len));
 NOTIFY:
 	_notify (config, PROP_ROUTE_DATA);
 	_notify (config, PROP_ROUTES);
@@ -1527,6 +1540,7 @@ nm_ip6_config_del_route (NMIP6Config *config, guint i)
 	g_return_if_fail (i < priv->routes->len);
 
 	g_array_remove_index (priv->routes, i);
+	_routes_lpm_clear (priv);
 	_notify (config, PROP_ROUTE_DATA);
 	_notify (config, PROP_ROUTES);
 }
@@ -1547,35 +1561,54 @@ nm_ip6_config_get_route (const NMIP6Config *config, guint i)
 	return &g_array_index (priv->routes, NMPlatformIP6Route, i);
 }
 
-const NMPlatformIP6Route *
-nm_ip6_config_get_direct_route_for_host (const NMIP6Config *config, const struct in6_addr *host)
+typedef struct {
+	const GArray *routes;
+	const NMPlatformIP6Route *best_route;
+} DirectRouteData;
+
+static gboolean
+_direct_route_for_host_cb (guint8 plen, void *const* values, guint len, gpointer user_data)
 {
-	const NMIP6ConfigPrivate *priv = NM_IP6_CONFIG_GET_PRIVATE (config);
+	DirectRouteData *data = user_data;
 	guint i;
-	NMPlatformIP6Route *best_route = NULL;
 
-	g_return_val_if_fail (host && !IN6_IS_ADDR_UNSPECIFIED (host), NULL);
-
-	for (i = 0; i < priv->routes->len; i++) {
-		NMPlatformIP6Route *item = &g_array_index (priv->routes, NMPlatformIP6Route, i);
+	for (i = 0; i < len; i++) {
+		const NMPlatformIP6Route *item = &g_array_index (data->routes, NMPlatformIP6Route, GPOINTER_TO_UINT (values[i]) - 1);
 
 		if (!IN6_IS_ADDR_UNSPECIFIED (&item->gateway))
 			continue;
 
-		if (best_route && best_route->plen > item->plen)
+		if (data->best_route &&
+		    nm_utils_ip6_route_metric_normalize (data->best_route->metric) <= nm_utils_ip6_route_metric_normalize (item->metric))
 			continue;
 
-		if (!nm_utils_ip6_address_same_prefix (host, &item->network, item->plen))
-			continue;
+		data->best_route = item;
+	}
+	return !!data->best_route;
+}
 
-		if (best_route &&
-		    nm_utils_ip6_route_metric_normalize (best_route->metric) <= nm_utils_ip6_route_metric_normalize (item->metric))
-			continue;
+const NMPlatformIP6Route *
+nm_ip6_config_get_direct_route_for_host (const NMIP6Config *config, const struct in6_addr *host)
+{
+	/* @routes_lpm is only a lookup cache, building it doesn't change @config. */
+	NMIP6ConfigPrivate *priv = (NMIP6ConfigPrivate *) NM_IP6_CONFIG_GET_PRIVATE (config);
+	DirectRouteData data = { 0 };
+	guint i;
+
+	g_return_val_if_fail (host && !IN6_IS_ADDR_UNSPECIFIED (host), NULL);
 
-		best_route = item;
+	if (!priv->routes_lpm) {
+		priv->routes_lpm = nm_prefix_trie_new (AF_INET6);
+		for (i = 0; i < priv->routes->len; i++) {
+			const NMPlatformIP6Route *item = &g_array_index (priv->routes, NMPlatformIP6Route, i);
+
+			nm_prefix_trie_add (priv->routes_lpm, &item->network, item->plen, GUINT_TO_POINTER (i + 1));
+		}
 	}
 
-	return best_route;
+	data.routes = priv->routes;
+	nm_prefix_trie_lookup_lpm (priv->routes_lpm, host, 128, _direct_route_for_host_cb, &data);
+	return data.best_route;
 }
 
 const NMPlatformIP6Address *
@@ -2015,6 +2048,7 @@ finalize (GObject *object)
 
 	g_array_unref (priv->addresses);
 	g_array_unref (priv->routes);
+	_routes_lpm_clear (priv);
 	g_array_unref (priv->nameservers);
 	g_ptr_array_unref (priv->domains);
 	g_ptr_array_unref (priv->searches);
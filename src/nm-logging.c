@@ -107,11 +107,9 @@ typedef struct {
 	LogFormatFlags log_format_level;
 } LogLevelDesc;
 
+/* the domains for which _nm_log_impl() must be called. That is the union
+ * of global.backend_state and global.recorder_domains. */
 NMLogDomain _nm_logging_enabled_state[_LOGL_N_REAL] = {
-	/* nm_logging_setup ("INFO", LOGD_DEFAULT_STRING, NULL, NULL);
-	 *
-	 * Note: LOGD_VPN_PLUGIN is special and must be disabled for
-	 * DEBUG and TRACE levels. */
 	[LOGL_INFO] = LOGD_DEFAULT,
 	[LOGL_WARN] = LOGD_DEFAULT,
 	[LOGL_ERR]  = LOGD_DEFAULT,
@@ -119,6 +117,8 @@ NMLogDomain _nm_logging_enabled_state[_LOGL_N_REAL] = {
 
 static struct {
 	NMLogLevel log_level;
+	NMLogDomain backend_state[_LOGL_N_REAL];
+	NMLogDomain recorder_domains;
 	LogFormatFlags log_format_flags;
 	bool uses_syslog:1;
 	enum {
@@ -136,6 +136,13 @@ static struct {
 } global = {
 	/* nm_logging_setup ("INFO", LOGD_DEFAULT_STRING, NULL, NULL); */
 	.log_level = LOGL_INFO,
+	.backend_state = {
+		/* Note: LOGD_VPN_PLUGIN is special and must be disabled for
+		 * DEBUG and TRACE levels. */
+		[LOGL_INFO] = LOGD_DEFAULT,
+		[LOGL_WARN] = LOGD_DEFAULT,
+		[LOGL_ERR]  = LOGD_DEFAULT,
+	},
 	.log_backend = LOG_BACKEND_GLIB,
 	.log_format_flags = _LOG_FORMAT_FLAG_DEFAULT,
 	.level_desc = {
@@ -206,6 +213,57 @@ static char *_domains_to_string (gboolean include_level_override);
 
 /************************************************************************/
 
+static gboolean
+match_log_domain (const char *name,
+                  NMLogDomain *out_bits,
+                  NMLogDomain *out_protect)
+{
+	const LogDesc *diter;
+
+	/* LOGD_VPN_PLUGIN is protected, that is, when setting ALL or DEFAULT,
+	 * it does not enable the verbose levels DEBUG and TRACE, because that
+	 * may expose sensitive data. */
+	*out_protect = LOGD_NONE;
+
+	/* Check for combined domains */
+	if (!g_ascii_strcasecmp (name, LOGD_ALL_STRING)) {
+		*out_bits = LOGD_ALL;
+		*out_protect = LOGD_VPN_PLUGIN;
+	} else if (!g_ascii_strcasecmp (name, LOGD_DEFAULT_STRING)) {
+		*out_bits = LOGD_DEFAULT;
+		*out_protect = LOGD_VPN_PLUGIN;
+	} else if (!g_ascii_strcasecmp (name, LOGD_DHCP_STRING))
+		*out_bits = LOGD_DHCP;
+	else if (!g_ascii_strcasecmp (name, LOGD_IP_STRING))
+		*out_bits = LOGD_IP;
+
+	/* Check for compatibility domains */
+	else if (!g_ascii_strcasecmp (name, "HW"))
+		*out_bits = LOGD_PLATFORM;
+	else if (!g_ascii_strcasecmp (name, "WIMAX"))
+		*out_bits = LOGD_NONE;
+
+	else {
+		for (diter = &global.domain_desc[0]; diter->name; diter++) {
+			if (!g_ascii_strcasecmp (diter->name, name)) {
+				*out_bits = diter->num;
+				return TRUE;
+			}
+		}
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static void
+_enabled_state_update (void)
+{
+	int i;
+
+	for (i = 0; i < G_N_ELEMENTS (_nm_logging_enabled_state); i++)
+		_nm_logging_enabled_state[i] = global.backend_state[i] | global.recorder_domains;
+}
+
 static gboolean
 match_log_level (const char  *level,
                  NMLogLevel  *out_level,
@@ -256,22 +314,17 @@ nm_logging_setup (const char  *level,
 		if (new_log_level == _LOGL_KEEP) {
 			new_log_level = global.log_level;
 			for (i = 0; i < G_N_ELEMENTS (new_logging); i++)
-				new_logging[i] = _nm_logging_enabled_state[i];
+				new_logging[i] = global.backend_state[i];
 		}
 	}
 
 	tmp = g_strsplit_set (domains, ", ", 0);
 	for (iter = tmp; iter && *iter; iter++) {
-		const LogDesc *diter;
 		NMLogLevel domain_log_level;
 		NMLogDomain bits;
+		NMLogDomain protect;
 		char *p;
 
-		/* LOGD_VPN_PLUGIN is protected, that is, when setting ALL or DEFAULT,
-		 * it does not enable the verbose levels DEBUG and TRACE, because that
-		 * may expose sensitive data. */
-		NMLogDomain protect = LOGD_NONE;
-
 		if (!strlen (*iter))
 			continue;
 
@@ -285,53 +338,26 @@ nm_logging_setup (const char  *level,
 		} else
 			domain_log_level = new_log_level;
 
-		bits = 0;
-
-		/* Check for combined domains */
-		if (!g_ascii_strcasecmp (*iter, LOGD_ALL_STRING)) {
-			bits = LOGD_ALL;
-			protect = LOGD_VPN_PLUGIN;
-		} else if (!g_ascii_strcasecmp (*iter, LOGD_DEFAULT_STRING)) {
-			bits = LOGD_DEFAULT;
-			protect = LOGD_VPN_PLUGIN;
-		} else if (!g_ascii_strcasecmp (*iter, LOGD_DHCP_STRING))
-			bits = LOGD_DHCP;
-		else if (!g_ascii_strcasecmp (*iter, LOGD_IP_STRING))
-			bits = LOGD_IP;
-
-		/* Check for compatibility domains */
-		else if (!g_ascii_strcasecmp (*iter, "HW"))
-			bits = LOGD_PLATFORM;
-		else if (!g_ascii_strcasecmp (*iter, "WIMAX"))
-			continue;
-
-		else {
-			for (diter = &global.domain_desc[0]; diter->name; diter++) {
-				if (!g_ascii_strcasecmp (diter->name, *iter)) {
-					bits = diter->num;
-					break;
-				}
+		if (!match_log_domain (*iter, &bits, &protect)) {
+			if (!bad_domains) {
+				g_set_error (error, NM_MANAGER_ERROR, NM_MANAGER_ERROR_UNKNOWN_LOG_DOMAIN,
+				             _("Unknown log domain '%s'"), *iter);
+				return FALSE;
 			}
 
-			if (!bits) {
-				if (!bad_domains) {
-					g_set_error (error, NM_MANAGER_ERROR, NM_MANAGER_ERROR_UNKNOWN_LOG_DOMAIN,
-					             _("Unknown log domain '%s'"), *iter);
-					return FALSE;
-				}
-
-				if (unrecognized)
-					g_string_append (unrecognized, ", ");
-				else
-					unrecognized = g_string_new (NULL);
-				g_string_append (unrecognized, *iter);
-				continue;
-			}
+			if (unrecognized)
+				g_string_append (unrecognized, ", ");
+			else
+				unrecognized = g_string_new (NULL);
+			g_string_append (unrecognized, *iter);
+			continue;
 		}
+		if (!bits)
+			continue;
 
 		if (domain_log_level == _LOGL_KEEP) {
 			for (i = 0; i < G_N_ELEMENTS (new_logging); i++)
-				new_logging[i] = (new_logging[i] & ~bits) | (_nm_logging_enabled_state[i] & bits);
+				new_logging[i] = (new_logging[i] & ~bits) | (global.backend_state[i] & bits);
 		} else {
 			for (i = 0; i < G_N_ELEMENTS (new_logging); i++) {
 				if (i < domain_log_level)
@@ -353,7 +379,8 @@ nm_logging_setup (const char  *level,
 
 	global.log_level = new_log_level;
 	for (i = 0; i < G_N_ELEMENTS (new_logging); i++)
-		_nm_logging_enabled_state[i] = new_logging[i];
+		global.backend_state[i] = new_logging[i];
+	_enabled_state_update ();
 
 	if (   had_platform_debug
 	    && _nm_logging_clear_platform_logging_cache
@@ -418,7 +445,7 @@ _domains_to_string (gboolean include_level_override)
 	str = g_string_sized_new (75);
 	for (diter = &global.domain_desc[0]; diter->name; diter++) {
 		/* If it's set for any lower level, it will also be set for LOGL_ERR */
-		if (!(diter->num & _nm_logging_enabled_state[LOGL_ERR]))
+		if (!(diter->num & global.backend_state[LOGL_ERR]))
 			continue;
 
 		if (str->len)
@@ -430,15 +457,15 @@ _domains_to_string (gboolean include_level_override)
 
 		/* Check if it's logging at a lower level than the default. */
 		for (i = 0; i < global.log_level; i++) {
-			if (diter->num & _nm_logging_enabled_state[i]) {
+			if (diter->num & global.backend_state[i]) {
 				g_string_append_printf (str, ":%s", global.level_desc[i].name);
 				break;
 			}
 		}
 		/* Check if it's logging at a higher level than the default. */
-		if (!(diter->num & _nm_logging_enabled_state[global.log_level])) {
+		if (!(diter->num & global.backend_state[global.log_level])) {
 			for (i = global.log_level + 1; i < G_N_ELEMENTS (_nm_logging_enabled_state); i++) {
-				if (diter->num & _nm_logging_enabled_state[i]) {
+				if (diter->num & global.backend_state[i]) {
 					g_string_append_printf (str, ":%s", global.level_desc[i].name);
 					break;
 				}
@@ -471,6 +498,26 @@ nm_logging_all_domains_to_string (void)
 	return str->str;
 }
 
+/**
+ * nm_logging_backend_enabled:
+ * @level: the logging level
+ * @domain: the logging domain(s)
+ *
+ * Unlike nm_logging_enabled(), this ignores the flight recorder and only
+ * tells whether messages are passed on to the backend. Use it to decide
+ * about side effects beyond formatting a message, like running a helper
+ * in debug mode or doing extra work only for debugging.
+ *
+ * Returns: whether messages of @level in @domain are logged.
+ **/
+gboolean
+nm_logging_backend_enabled (NMLogLevel level, NMLogDomain domain)
+{
+	g_return_val_if_fail (((guint) level) < G_N_ELEMENTS (global.backend_state), FALSE);
+
+	return NM_FLAGS_ANY (global.backend_state[level], domain);
+}
+
 /**
  * nm_logging_get_level:
  * @domain: find the lowest enabled logging level for the
@@ -487,7 +534,7 @@ nm_logging_get_level (NMLogDomain domain)
 
 	G_STATIC_ASSERT (LOGL_TRACE == 0);
 	while (   sl > LOGL_TRACE
-	       && nm_logging_enabled (sl - 1, domain))
+	       && NM_FLAGS_ANY (global.backend_state[sl - 1], domain))
 		sl--;
 	return sl;
 }
@@ -519,43 +566,33 @@ _iovec_set_string (struct iovec *iov, gboolean *iov_free, int i, const char *str
 #define _iovec_set_literal_string(iov, iov_free, i, str) _iovec_set_string ((iov), (iov_free), (i), (""str""), NM_STRLEN (str))
 #endif
 
-void
-_nm_log_impl (const char *file,
-              guint line,
-              const char *func,
-              NMLogLevel level,
-              NMLogDomain domain,
-              int error,
-              const char *fmt,
-              ...)
+/* _log_write:
+ * @tv: (allow-none): the time of the message. If %NULL, the current time.
+ * @now_ns: the monotonic timestamp of the message, or 0 for the current time.
+ *
+ * Formats and writes the message @msg to the logging backend. */
+static void
+_log_write (const char *file,
+            guint line,
+            const char *func,
+            NMLogLevel level,
+            NMLogDomain domain,
+            int error,
+            const GTimeVal *tv,
+            gint64 now_ns,
+            const char *msg)
 {
-	va_list args;
-	char *msg;
 	char *fullmsg;
 	char s_buf_timestamp[64];
 	char s_buf_location[1024];
-	GTimeVal tv;
-
-	if ((guint) level >= G_N_ELEMENTS (_nm_logging_enabled_state))
-		g_return_if_reached ();
-
-	if (!(_nm_logging_enabled_state[level] & domain))
-		return;
-
-	/* Make sure that %m maps to the specified error */
-	if (error != 0) {
-		if (error < 0)
-			error = -error;
-		errno = error;
-	}
-
-	va_start (args, fmt);
-	msg = g_strdup_vprintf (fmt, args);
-	va_end (args);
+	GTimeVal tv_now;
 
 	if (NM_FLAGS_ANY (global.log_format_flags, global.level_desc[level].log_format_level & _LOG_FORMAT_FLAG_TIMESTAMP)) {
-		g_get_current_time (&tv);
-		nm_sprintf_buf (s_buf_timestamp, " [%ld.%04ld]", tv.tv_sec, (tv.tv_usec + 50) / 100);
+		if (!tv) {
+			g_get_current_time (&tv_now);
+			tv = &tv_now;
+		}
+		nm_sprintf_buf (s_buf_timestamp, " [%ld.%04ld]", tv->tv_sec, (tv->tv_usec + 50) / 100);
 	} else
 		s_buf_timestamp[0] = '\0';
 
@@ -610,7 +647,7 @@ _nm_log_impl (const char *file,
 			struct iovec iov[_NUM_FIELDS];
 			gboolean iov_free[_NUM_FIELDS];
 
-			now = nm_utils_get_monotonic_timestamp_ns ();
+			now = now_ns ?: nm_utils_get_monotonic_timestamp_ns ();
 			boottime = nm_utils_monotonic_timestamp_as_boottime (now, 1);
 
 			_iovec_set_format (iov, iov_free, i_field++, "PRIORITY=%d", global.level_desc[level].syslog_level);
@@ -628,7 +665,7 @@ _nm_log_impl (const char *file,
 				const char *s_domain_1 = NULL;
 				GString *s_domain_all = NULL;
 				NMLogDomain dom_all = domain;
-				NMLogDomain dom = dom_all & _nm_logging_enabled_state[level];
+				NMLogDomain dom = dom_all & global.backend_state[level];
 
 				for (diter = &global.domain_desc[0]; diter->name; diter++) {
 					if (!NM_FLAGS_HAS (dom_all, diter->num))
@@ -700,7 +737,640 @@ _nm_log_impl (const char *file,
 		g_free (fullmsg);
 		break;
 	}
+}
+
+/************************************************************************/
+
+/* With asynchronous logging, _nm_log_impl() only formats the message into
+ * a slot of a preallocated ring and a writer thread passes it on to the
+ * backend. That way, a slow syslog or journald never blocks the caller.
+ *
+ * The ring is a bounded multi-producer queue: each slot has a sequence
+ * number telling whether it is free for the producer at a position or
+ * filled for the consumer. Producers never block; if the ring is full,
+ * the message is dropped and counted. The consumer side is serialized
+ * by a mutex, so that the ring can be flushed from outside the writer
+ * thread too. */
+
+#define ASYNC_RING_SIZE      1024
+#define ASYNC_MSG_LEN        480
+
+typedef struct {
+	volatile gint sequence;
+	NMLogLevel level;
+	NMLogDomain domain;
+	int error;
+	const char *file;
+	guint line;
+	const char *func;
+	GTimeVal tv;
+	gint64 now_ns;
+
+	/* messages that don't fit into @msg are allocated. */
+	char *msg_heap;
+	char msg[ASYNC_MSG_LEN];
+} AsyncSlot;
+
+struct _NMLogAsyncRing {
+	AsyncSlot *slots;
+	guint mask;
+	volatile gint enqueue_pos;
+	guint dequeue_pos;
+	volatile gint dropped;
+};
+
+static struct {
+	NMLogAsyncRing *ring;
+	volatile gint running;
+	volatile gint writer_sleeping;
+	GMutex consumer_lock;
+	GMutex wakeup_lock;
+	GCond wakeup_cond;
+	GThread *thread;
+} async;
+
+NMLogAsyncRing *
+_nm_logging_async_ring_new (guint size)
+{
+	NMLogAsyncRing *ring;
+	guint i;
+
+	g_return_val_if_fail (size > 0 && (size & (size - 1)) == 0, NULL);
+
+	ring = g_slice_new0 (NMLogAsyncRing);
+	ring->mask = size - 1;
+	ring->slots = g_new0 (AsyncSlot, size);
+	for (i = 0; i < size; i++)
+		ring->slots[i].sequence = i;
+	return ring;
+}
+
+void
+_nm_logging_async_ring_free (NMLogAsyncRing *ring)
+{
+	guint i;
+
+	for (i = 0; i <= ring->mask; i++)
+		g_free (ring->slots[i].msg_heap);
+	g_free (ring->slots);
+	g_slice_free (NMLogAsyncRing, ring);
+}
+
+/* Claims the slot at the next enqueue position, or returns %NULL if the
+ * ring is full. The slot must be handed to the consumer with
+ * _ring_publish(). */
+static AsyncSlot *
+_ring_reserve (NMLogAsyncRing *ring, guint *out_pos)
+{
+	AsyncSlot *slot;
+	guint pos;
+	gint diff;
+
+	pos = (guint) g_atomic_int_get (&ring->enqueue_pos);
+	for (;;) {
+		slot = &ring->slots[pos & ring->mask];
+		diff = (gint) ((guint) g_atomic_int_get (&slot->sequence) - pos);
+		if (diff == 0) {
+			if (g_atomic_int_compare_and_exchange (&ring->enqueue_pos, (gint) pos, (gint) (pos + 1)))
+				break;
+		} else if (diff < 0) {
+			/* full */
+			g_atomic_int_inc (&ring->dropped);
+			return NULL;
+		}
+		pos = (guint) g_atomic_int_get (&ring->enqueue_pos);
+	}
+
+	*out_pos = pos;
+	return slot;
+}
+
+static void
+_ring_publish (AsyncSlot *slot, guint pos)
+{
+	g_atomic_int_set (&slot->sequence, (gint) (pos + 1));
+}
+
+/* Returns the oldest filled slot, or %NULL. Consumers must be serialized. */
+static AsyncSlot *
+_ring_peek (NMLogAsyncRing *ring)
+{
+	AsyncSlot *slot = &ring->slots[ring->dequeue_pos & ring->mask];
+
+	if ((guint) g_atomic_int_get (&slot->sequence) != ring->dequeue_pos + 1)
+		return NULL;
+	return slot;
+}
+
+static void
+_ring_release (NMLogAsyncRing *ring, AsyncSlot *slot)
+{
+	g_clear_pointer (&slot->msg_heap, g_free);
+
+	/* hand the slot back to the producers */
+	g_atomic_int_set (&slot->sequence, (gint) (ring->dequeue_pos + ring->mask + 1));
+	ring->dequeue_pos++;
+}
+
+static guint
+_ring_take_dropped (NMLogAsyncRing *ring)
+{
+	gint dropped;
+
+	do {
+		dropped = g_atomic_int_get (&ring->dropped);
+	} while (dropped && !g_atomic_int_compare_and_exchange (&ring->dropped, dropped, 0));
+	return dropped;
+}
+
+gboolean
+_nm_logging_async_ring_push (NMLogAsyncRing *ring, const char *msg)
+{
+	AsyncSlot *slot;
+	guint pos;
+
+	slot = _ring_reserve (ring, &pos);
+	if (!slot)
+		return FALSE;
+	if (g_strlcpy (slot->msg, msg, sizeof (slot->msg)) >= sizeof (slot->msg))
+		slot->msg_heap = g_strdup (msg);
+	_ring_publish (slot, pos);
+	return TRUE;
+}
+
+char *
+_nm_logging_async_ring_pop (NMLogAsyncRing *ring)
+{
+	AsyncSlot *slot;
+	char *msg;
+
+	slot = _ring_peek (ring);
+	if (!slot)
+		return NULL;
+	msg = g_strdup (slot->msg_heap ?: slot->msg);
+	_ring_release (ring, slot);
+	return msg;
+}
+
+guint
+_nm_logging_async_ring_take_dropped (NMLogAsyncRing *ring)
+{
+	return _ring_take_dropped (ring);
+}
+
+static void
+_async_log (const char *file,
+            guint line,
+            const char *func,
+            NMLogLevel level,
+            NMLogDomain domain,
+            int error,
+            const char *fmt,
+            va_list args)
+{
+	AsyncSlot *slot;
+	va_list args_copy;
+	guint pos;
+	int errsv = errno;
+
+	slot = _ring_reserve (async.ring, &pos);
+	if (!slot)
+		return;
+
+	slot->level = level;
+	slot->domain = domain;
+	slot->error = error;
+	slot->file = file;
+	slot->line = line;
+	slot->func = func;
+	g_get_current_time (&slot->tv);
+	slot->now_ns = nm_utils_get_monotonic_timestamp_ns ();
+
+	va_copy (args_copy, args);
+	errno = errsv;
+	if (g_vsnprintf (slot->msg, sizeof (slot->msg), fmt, args) >= (gint) sizeof (slot->msg)) {
+		errno = errsv;
+		slot->msg_heap = g_strdup_vprintf (fmt, args_copy);
+	}
+	va_end (args_copy);
+
+	_ring_publish (slot, pos);
+
+	/* The writer sets writer_sleeping before it checks for pending slots
+	 * and then waits without a timeout, so either it sees our slot or we
+	 * see that it sleeps. */
+	if (g_atomic_int_get (&async.writer_sleeping)) {
+		g_mutex_lock (&async.wakeup_lock);
+		g_cond_signal (&async.wakeup_cond);
+		g_mutex_unlock (&async.wakeup_lock);
+	}
+}
+
+/* must be called with the consumer_lock held. */
+static void
+_async_drain (void)
+{
+	AsyncSlot *slot;
+	guint dropped;
+
+	while ((slot = _ring_peek (async.ring))) {
+		_log_write (slot->file, slot->line, slot->func,
+		            slot->level, slot->domain, slot->error,
+		            &slot->tv, slot->now_ns,
+		            slot->msg_heap ?: slot->msg);
+		_ring_release (async.ring, slot);
+	}
+
+	dropped = _ring_take_dropped (async.ring);
+	if (dropped) {
+		gs_free char *msg = g_strdup_printf ("logging: dropped %u messages", dropped);
+
+		_log_write (NULL, 0, NULL, LOGL_WARN, LOGD_CORE, 0, NULL, 0, msg);
+	}
+}
+
+static void
+_async_flush (void)
+{
+	g_mutex_lock (&async.consumer_lock);
+	_async_drain ();
+	g_mutex_unlock (&async.consumer_lock);
+}
 
+static gpointer
+_async_writer_thread (gpointer user_data)
+{
+	while (g_atomic_int_get (&async.running)) {
+		_async_flush ();
+
+		g_mutex_lock (&async.wakeup_lock);
+		g_atomic_int_set (&async.writer_sleeping, 1);
+		while (   !_ring_peek (async.ring)
+		       && g_atomic_int_get (&async.running))
+			g_cond_wait (&async.wakeup_cond, &async.wakeup_lock);
+		g_atomic_int_set (&async.writer_sleeping, 0);
+		g_mutex_unlock (&async.wakeup_lock);
+	}
+
+	_async_flush ();
+	return NULL;
+}
+
+/**
+ * nm_logging_async_start:
+ *
+ * Switches to asynchronous logging, where messages are written by a
+ * separate thread. Must be called after nm_logging_syslog_openlog().
+ * With the glib backend, logging stays synchronous.
+ */
+void
+nm_logging_async_start (void)
+{
+	if (g_atomic_int_get (&async.running))
+		return;
+
+	/* with the glib backend, messages go to the g_log() handlers, which
+	 * are not prepared to be called from another thread. That is the
+	 * case with --debug, just keep logging synchronously. */
+	if (global.log_backend == LOG_BACKEND_GLIB)
+		return;
+
+	if (!async.ring)
+		async.ring = _nm_logging_async_ring_new (ASYNC_RING_SIZE);
+
+	/* the first call logs a message. Don't let that happen in _async_log(). */
+	nm_utils_get_monotonic_timestamp_ns ();
+
+	g_atomic_int_set (&async.running, 1);
+	async.thread = g_thread_new ("nm-logging", _async_writer_thread, NULL);
+}
+
+/**
+ * nm_logging_async_stop:
+ *
+ * Writes all pending messages and switches back to synchronous logging.
+ */
+void
+nm_logging_async_stop (void)
+{
+	if (!g_atomic_int_get (&async.running))
+		return;
+
+	g_atomic_int_set (&async.running, 0);
+
+	g_mutex_lock (&async.wakeup_lock);
+	g_cond_signal (&async.wakeup_cond);
+	g_mutex_unlock (&async.wakeup_lock);
+
+	g_thread_join (async.thread);
+	async.thread = NULL;
+
+	/* messages queued by callers that saw logging still running. The
+	 * slots stay allocated, for the same reason. */
+	_async_flush ();
+}
+
+/************************************************************************/
+
+/* The flight recorder keeps the most recent messages of some domains in
+ * memory, at all levels, regardless of what is passed on to the backend.
+ * Nothing is written out until requested via nm_logging_recorder_dump().
+ * That allows to run at a quiet level and still get the context of a
+ * failure afterwards.
+ *
+ * Each domain has its own ring, so that a chatty domain doesn't push out
+ * the messages of the others. The rings are allocated when the domain
+ * gets recorded for the first time. */
+
+#define RECORDER_RING_SIZE 128
+#define RECORDER_MSG_LEN   224
+
+typedef struct {
+	guint64 seq;
+	gint64 timestamp_ns;
+	NMLogLevel level;
+	guint domain_idx;
+	const char *func;
+	char msg[RECORDER_MSG_LEN];
+} RecorderRecord;
+
+typedef struct {
+	guint next;
+	guint len;
+	RecorderRecord records[RECORDER_RING_SIZE];
+} RecorderRing;
+
+static struct {
+	GMutex lock;
+	guint64 seq;
+	RecorderRing *rings[64];
+} recorder;
+
+static guint
+_recorder_domain_idx (NMLogDomain domain)
+{
+	guint i = 0;
+
+	nm_assert (domain);
+
+	while (!(domain & (1LL << i)))
+		i++;
+	return i;
+}
+
+static void
+_recorder_add (NMLogDomain domain,
+               NMLogLevel level,
+               const char *func,
+               const char *fmt,
+               va_list args)
+{
+	RecorderRing *ring;
+	RecorderRecord *record;
+	gint64 now;
+	guint idx;
+	int errsv = errno;
+
+	/* the first call might log. Do it before taking the lock. */
+	now = nm_utils_get_monotonic_timestamp_ns ();
+
+	idx = _recorder_domain_idx (domain);
+
+	g_mutex_lock (&recorder.lock);
+
+	ring = recorder.rings[idx];
+	if (!ring) {
+		/* the recorder was disabled in the meantime. */
+		goto out;
+	}
+
+	record = &ring->records[ring->next];
+	ring->next = (ring->next + 1) % RECORDER_RING_SIZE;
+	ring->len = MIN (ring->len + 1, RECORDER_RING_SIZE);
+
+	record->seq = recorder.seq++;
+	record->timestamp_ns = now;
+	record->level = level;
+	record->domain_idx = idx;
+	record->func = func;
+	errno = errsv;
+	g_vsnprintf (record->msg, sizeof (record->msg), fmt, args);
+
+out:
+	g_mutex_unlock (&recorder.lock);
+	errno = errsv;
+}
+
+/**
+ * nm_logging_recorder_setup:
+ * @domains: the domains to record, in the same form as for
+ *   nm_logging_setup() but without levels. %NULL, "" or "NONE" disable
+ *   the recorder.
+ * @error: on return, the error.
+ *
+ * Returns: %TRUE if @domains was valid and the recorder was set up.
+ */
+gboolean
+nm_logging_recorder_setup (const char *domains,
+                           GError **error)
+{
+	gs_strfreev char **tmp = NULL;
+	NMLogDomain new_domains = LOGD_NONE;
+	NMLogDomain bits, protect;
+	char **iter;
+	guint i;
+
+	g_return_val_if_fail (!error || !*error, FALSE);
+
+	tmp = g_strsplit_set (domains ?: "", ", ", 0);
+	for (iter = tmp; *iter; iter++) {
+		if (!**iter || !g_ascii_strcasecmp (*iter, "NONE"))
+			continue;
+		if (!match_log_domain (*iter, &bits, &protect)) {
+			g_set_error (error, NM_MANAGER_ERROR, NM_MANAGER_ERROR_UNKNOWN_LOG_DOMAIN,
+			             _("Unknown log domain '%s'"), *iter);
+			return FALSE;
+		}
+		/* the recorder records all levels, so the protected domains
+		 * are only recorded when requested explicitly. */
+		new_domains |= (bits & ~protect);
+	}
+
+	g_mutex_lock (&recorder.lock);
+	for (i = 0; i < G_N_ELEMENTS (recorder.rings); i++) {
+		if (new_domains & (1LL << i)) {
+			if (!recorder.rings[i]) {
+				recorder.rings[i] = g_new (RecorderRing, 1);
+				recorder.rings[i]->next = 0;
+				recorder.rings[i]->len = 0;
+			}
+		} else
+			g_clear_pointer (&recorder.rings[i], g_free);
+	}
+	g_mutex_unlock (&recorder.lock);
+
+	global.recorder_domains = new_domains;
+	_enabled_state_update ();
+	return TRUE;
+}
+
+static const char *
+_domain_to_name (guint domain_idx)
+{
+	const LogDesc *diter;
+
+	for (diter = &global.domain_desc[0]; diter->name; diter++) {
+		if (diter->num == (1LL << domain_idx))
+			return diter->name;
+	}
+	return "???";
+}
+
+static int
+_recorder_record_cmp (gconstpointer a, gconstpointer b)
+{
+	const RecorderRecord *r_a = *((const RecorderRecord **) a);
+	const RecorderRecord *r_b = *((const RecorderRecord **) b);
+
+	return r_a->seq < r_b->seq ? -1 : (r_a->seq > r_b->seq);
+}
+
+/**
+ * nm_logging_recorder_dump:
+ *
+ * Returns: (transfer full): the recorded messages of all domains, oldest
+ *   first. The recorder is not cleared.
+ */
+char **
+nm_logging_recorder_dump (void)
+{
+	gs_unref_ptrarray GPtrArray *records = NULL;
+	GPtrArray *lines;
+	const RecorderRing *ring;
+	const RecorderRecord *record;
+	guint i, j;
+
+	records = g_ptr_array_new ();
+
+	g_mutex_lock (&recorder.lock);
+
+	for (i = 0; i < G_N_ELEMENTS (recorder.rings); i++) {
+		ring = recorder.rings[i];
+		if (!ring)
+			continue;
+		for (j = 0; j < ring->len; j++)
+			g_ptr_array_add (records, (gpointer) &ring->records[j]);
+	}
+	g_ptr_array_sort (records, _recorder_record_cmp);
+
+	lines = g_ptr_array_new_full (records->len + 1, g_free);
+	for (i = 0; i < records->len; i++) {
+		record = records->pdata[i];
+		g_ptr_array_add (lines,
+		                 g_strdup_printf ("%-7s [%"G_GINT64_FORMAT".%06d] %s:%s%s%s %s",
+		                                  global.level_desc[record->level].level_str,
+		                                  record->timestamp_ns / NM_UTILS_NS_PER_SECOND,
+		                                  (int) ((record->timestamp_ns % NM_UTILS_NS_PER_SECOND) / 1000),
+		                                  _domain_to_name (record->domain_idx),
+		                                  record->func ? " " : "",
+		                                  record->func ?: "",
+		                                  record->func ? "():" : "",
+		                                  record->msg));
+	}
+
+	g_mutex_unlock (&recorder.lock);
+
+	g_ptr_array_add (lines, NULL);
+	return (char **) g_ptr_array_free (lines, FALSE);
+}
+
+/**
+ * nm_logging_recorder_dump_to_log:
+ *
+ * Writes the recorded messages to the logging backend.
+ */
+void
+nm_logging_recorder_dump_to_log (void)
+{
+	gs_strfreev char **lines = NULL;
+	char **iter;
+	gboolean async_running;
+
+	lines = nm_logging_recorder_dump ();
+
+	/* write the lines directly, so that they don't end up in
+	 * the recorder themselves. */
+	async_running = g_atomic_int_get (&async.running);
+	if (async_running) {
+		g_mutex_lock (&async.consumer_lock);
+		_async_drain ();
+	}
+
+	_log_write (NULL, 0, NULL, LOGL_INFO, LOGD_CORE, 0, NULL, 0,
+	            lines[0] ? "recorder: begin dump" : "recorder: nothing recorded");
+	for (iter = lines; *iter; iter++) {
+		gs_free char *msg = g_strdup_printf ("recorder: %s", *iter);
+
+		_log_write (NULL, 0, NULL, LOGL_INFO, LOGD_CORE, 0, NULL, 0, msg);
+	}
+	if (lines[0])
+		_log_write (NULL, 0, NULL, LOGL_INFO, LOGD_CORE, 0, NULL, 0, "recorder: end dump");
+
+	if (async_running)
+		g_mutex_unlock (&async.consumer_lock);
+}
+
+/************************************************************************/
+
+void
+_nm_log_impl (const char *file,
+              guint line,
+              const char *func,
+              NMLogLevel level,
+              NMLogDomain domain,
+              int error,
+              const char *fmt,
+              ...)
+{
+	va_list args;
+	char *msg;
+	NMLogDomain recorder_domain;
+
+	if ((guint) level >= G_N_ELEMENTS (_nm_logging_enabled_state))
+		g_return_if_reached ();
+
+	if (!(_nm_logging_enabled_state[level] & domain))
+		return;
+
+	/* Make sure that %m maps to the specified error */
+	if (error != 0) {
+		if (error < 0)
+			error = -error;
+		errno = error;
+	}
+
+	recorder_domain = domain & global.recorder_domains;
+	if (recorder_domain) {
+		va_start (args, fmt);
+		_recorder_add (recorder_domain, level, func, fmt, args);
+		va_end (args);
+	}
+
+	if (!(global.backend_state[level] & domain))
+		return;
+
+	if (g_atomic_int_get (&async.running)) {
+		va_start (args, fmt);
+		_async_log (file, line, func, level, domain, error, fmt, args);
+		va_end (args);
+		return;
+	}
+
+	va_start (args, fmt);
+	msg = g_strdup_vprintf (fmt, args);
+	va_end (args);
+
+	_log_write (file, line, func, level, domain, error, NULL, 0, msg);
 	g_free (msg);
 }
 
@@ -736,6 +1406,11 @@ nm_log_handler (const gchar *log_domain,
 		break;
 	}
 
+	/* keep the order with queued messages, and don't lose them if this
+	 * message is fatal. */
+	if (g_atomic_int_get (&async.running))
+		_async_flush ();
+
 	switch (global.log_backend) {
 #if SYSTEMD_JOURNAL
 	case LOG_BACKEND_JOURNAL:
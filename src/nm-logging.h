@@ -179,6 +179,8 @@ nm_logging_enabled (NMLogLevel level, NMLogDomain domain)
 	       && !!(_nm_logging_enabled_state[level] & domain);
 }
 
+gboolean nm_logging_backend_enabled (NMLogLevel level, NMLogDomain domain);
+
 NMLogLevel nm_logging_get_level (NMLogDomain domain);
 
 const char *nm_logging_all_levels_to_string (void);
@@ -191,6 +193,22 @@ gboolean nm_logging_setup (const char  *level,
 void     nm_logging_syslog_openlog (const char *logging_backend);
 gboolean nm_logging_syslog_enabled (void);
 
+gboolean nm_logging_recorder_setup (const char *domains,
+                                    GError **error);
+char   **nm_logging_recorder_dump (void);
+void     nm_logging_recorder_dump_to_log (void);
+
+void     nm_logging_async_start (void);
+void     nm_logging_async_stop (void);
+
+/* exposed for unit tests only. */
+typedef struct _NMLogAsyncRing NMLogAsyncRing;
+NMLogAsyncRing *_nm_logging_async_ring_new (guint size);
+void            _nm_logging_async_ring_free (NMLogAsyncRing *ring);
+gboolean        _nm_logging_async_ring_push (NMLogAsyncRing *ring, const char *msg);
+char           *_nm_logging_async_ring_pop (NMLogAsyncRing *ring);
+guint           _nm_logging_async_ring_take_dropped (NMLogAsyncRing *ring);
+
 /*****************************************************************************/
 
 /* This is the default definition of _NMLOG_ENABLED(). Special implementations
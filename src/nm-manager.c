@@ -433,11 +433,29 @@ nm_manager_get_activatable_connections (NMManager *manager)
 	GSList *all_connections = nm_settings_get_connections_sorted (priv->settings);
 	GSList *connections = NULL, *iter;
 	NMSettingsConnection *connection;
+	gs_unref_hashtable GHashTable *active = NULL;
+
+	/* Collect the active settings connections first instead of calling
+	 * find_ac_for_connection() for every connection. That would scan the
+	 * active connections once per connection. */
+	for (iter = priv->active_connections; iter; iter = iter->next) {
+		NMActiveConnection *ac = iter->data;
+
+		if (nm_active_connection_get_state (ac) >= NM_ACTIVE_CONNECTION_STATE_DEACTIVATED)
+			continue;
+		connection = nm_active_connection_get_settings_connection (ac);
+		if (!connection)
+			continue;
+		if (!active)
+			active = g_hash_table_new (NULL, NULL);
+		g_hash_table_add (active, connection);
+	}
 
 	for (iter = all_connections; iter; iter = iter->next) {
 		connection = iter->data;
 
-		if (!find_ac_for_connection (manager, NM_CONNECTION (connection)))
+		if (   !active
+		    || !g_hash_table_contains (active, connection))
 			connections = g_slist_prepend (connections, connection);
 	}
 
@@ -445,6 +463,17 @@ nm_manager_get_activatable_connections (NMManager *manager)
 	return g_slist_reverse (connections);
 }
 
+/* Whether @connection is not active yet, i.e. whether it is part of
+ * nm_manager_get_activatable_connections(). */
+gboolean
+nm_manager_connection_is_activatable (NMManager *manager, NMSettingsConnection *connection)
+{
+	g_return_val_if_fail (NM_IS_MANAGER (manager), FALSE);
+	g_return_val_if_fail (NM_IS_SETTINGS_CONNECTION (connection), FALSE);
+
+	return !find_ac_for_connection (manager, NM_CONNECTION (connection));
+}
+
 static NMActiveConnection *
 active_connection_get_by_path (NMManager *manager, const char *path)
 {
@@ -4506,6 +4535,36 @@ impl_manager_get_logging (NMManager *manager,
 	                                                      nm_logging_domains_to_string ()));
 }
 
+static void
+impl_manager_dump_logging (NMManager *self,
+                           GDBusMethodInvocation *context)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	gs_strfreev char **lines = NULL;
+	gulong caller_uid = G_MAXULONG;
+
+	if (!nm_bus_manager_get_caller_info (priv->dbus_mgr, context, NULL, &caller_uid, NULL)) {
+		g_dbus_method_invocation_return_error_literal (context,
+		                                               NM_MANAGER_ERROR,
+		                                               NM_MANAGER_ERROR_PERMISSION_DENIED,
+		                                               "Failed to get request UID.");
+		return;
+	}
+
+	/* like debug logging, the recorded messages may contain sensitive data. */
+	if (0 != caller_uid) {
+		g_dbus_method_invocation_return_error_literal (context,
+		                                               NM_MANAGER_ERROR,
+		                                               NM_MANAGER_ERROR_PERMISSION_DENIED,
+		                                               "Permission denied");
+		return;
+	}
+
+	lines = nm_logging_recorder_dump ();
+	g_dbus_method_invocation_return_value (context,
+	                                       g_variant_new ("(^as)", lines));
+}
+
 static void
 connectivity_check_done (GObject *object,
                          GAsyncResult *result,
@@ -4668,6 +4727,8 @@ nm_manager_stop (NMManager *self)
 		remove_device (self, NM_DEVICE (priv->devices->data), TRUE, TRUE);
 
 	_active_connection_cleanup (self);
+
+	nm_settings_connection_flush_state ();
 }
 
 static gboolean
@@ -5934,6 +5995,7 @@ nm_manager_class_init (NMManagerClass *manager_class)
 	                                        "GetPermissions", impl_manager_get_permissions,
 	                                        "SetLogging", impl_manager_set_logging,
 	                                        "GetLogging", impl_manager_get_logging,
+	                                        "DumpLogging", impl_manager_dump_logging,
 	                                        "CheckConnectivity", impl_manager_check_connectivity,
 	                                        "state", impl_manager_get_state,
 	                                        NULL);
@@ -40,6 +40,15 @@ typedef struct {
 		gpointer *values;
 	};
 	GHashTable *index;
+
+	/* Once there is more than one item, @values is a %NULL terminated array
+	 * of all @len items (in no particular order), with room for @alloc
+	 * pointers. @index maps each item to its position in @values plus one.
+	 * That way, the array can be returned by nm_multi_index_lookup() at any
+	 * time, while adding and removing an item is still O(1): removal
+	 * moves the last item into the freed slot. */
+	guint len;
+	guint alloc;
 } ValuesData;
 
 /******************************************************************************************/
@@ -67,10 +76,6 @@ _values_data_get_data (ValuesData *values_data,
                        void *const**out_data,
                        guint *out_len)
 {
-	guint i, len;
-	gpointer *values;
-	GHashTableIter iter;
-
 	nm_assert (values_data);
 
 	if (!values_data->index) {
@@ -79,24 +84,78 @@ _values_data_get_data (ValuesData *values_data,
 		return;
 	}
 
-	nm_assert (values_data->index && g_hash_table_size (values_data->index) > 0);
+	nm_assert (values_data->len > 0);
+	nm_assert (values_data->len == g_hash_table_size (values_data->index));
+	nm_assert (values_data->values[values_data->len] == NULL);
+
+	NM_SET_OUT (out_data, values_data->values);
+	NM_SET_OUT (out_len, values_data->len);
+}
 
-	if (!values_data->values) {
-		len = g_hash_table_size (values_data->index);
-		values = g_new (gpointer, len + 1);
+static gboolean
+_values_data_add (ValuesData *values_data, gconstpointer value)
+{
+	if (!values_data->index) {
+		gpointer value0 = values_data->value0;
 
-		g_hash_table_iter_init (&iter, values_data->index);
-		for (i = 0; g_hash_table_iter_next (&iter, &values[i], NULL); i++)
-			nm_assert (i < len);
-		nm_assert (i == len);
-		values[i] = NULL;
+		if (value0 == value)
+			return FALSE;
 
-		values_data->values = values;
-		NM_SET_OUT (out_len, len);
-	} else if (out_len)
-		NM_SET_OUT (out_len, g_hash_table_size (values_data->index));
+		values_data->alloc = 4;
+		values_data->values = g_new (gpointer, values_data->alloc);
+		values_data->values[0] = value0;
+		values_data->len = 1;
+		values_data->index = g_hash_table_new (NULL, NULL);
+		g_hash_table_insert (values_data->index, value0, GUINT_TO_POINTER (1));
+	} else {
+		if (g_hash_table_contains (values_data->index, value))
+			return FALSE;
 
-	NM_SET_OUT (out_data, values_data->values);
+		if (values_data->len + 2 > values_data->alloc) {
+			values_data->alloc *= 2;
+			values_data->values = g_renew (gpointer, values_data->values, values_data->alloc);
+		}
+	}
+
+	values_data->values[values_data->len++] = (gpointer) value;
+	values_data->values[values_data->len] = NULL;
+	g_hash_table_insert (values_data->index, (gpointer) value, GUINT_TO_POINTER (values_data->len));
+	return TRUE;
+}
+
+/* Returns: %FALSE if @value was not in @values_data. Otherwise, %TRUE
+ *   and @out_empty tells whether @values_data has no more values
+ *   and should be destroyed. */
+static gboolean
+_values_data_remove (ValuesData *values_data, gconstpointer value, gboolean *out_empty)
+{
+	guint pos;
+	gpointer last;
+
+	if (!values_data->index) {
+		if (values_data->value0 != value)
+			return FALSE;
+		*out_empty = TRUE;
+		return TRUE;
+	}
+
+	pos = GPOINTER_TO_UINT (g_hash_table_lookup (values_data->index, value));
+	if (!pos)
+		return FALSE;
+	g_hash_table_remove (values_data->index, value);
+
+	nm_assert (pos <= values_data->len);
+	nm_assert (values_data->values[pos - 1] == value);
+
+	last = values_data->values[--values_data->len];
+	values_data->values[values_data->len] = NULL;
+	if (last != value) {
+		values_data->values[pos - 1] = last;
+		g_hash_table_insert (values_data->index, last, GUINT_TO_POINTER (pos));
+	}
+
+	*out_empty = (values_data->len == 0);
+	return TRUE;
 }
 
 /******************************************************************************************/
@@ -250,15 +309,13 @@ nm_multi_index_id_iter_init (NMMultiIndexIdIter *iter,
 	g_return_if_fail (iter);
 	g_return_if_fail (id);
 
+	iter->_idx = 0;
 	values_data = g_hash_table_lookup (index->hash, id);
-	if (!values_data)
-		iter->_state = 2;
-	else if (values_data->index) {
-		iter->_state = 1;
-		g_hash_table_iter_init (&iter->_iter, values_data->index);
-	} else {
-		iter->_state = 0;
-		iter->_value = values_data->value0;
+	if (values_data)
+		_values_data_get_data (values_data, &iter->_values, &iter->_len);
+	else {
+		iter->_values = NULL;
+		iter->_len = 0;
 	}
 }
 
@@ -268,19 +325,10 @@ nm_multi_index_id_iter_next (NMMultiIndexIdIter *iter,
 {
 	g_return_val_if_fail (iter, FALSE);
 
-	switch (iter->_state) {
-	case 0:
-		iter->_state = 2;
-		NM_SET_OUT (out_value, iter->_value);
-		return TRUE;
-	case 1:
-		return g_hash_table_iter_next (&iter->_iter, out_value, NULL);
-	case 2:
-		iter->_state = 3;
+	if (iter->_idx >= iter->_len)
 		return FALSE;
-	default:
-		g_return_val_if_reached (FALSE);
-	}
+	NM_SET_OUT (out_value, iter->_values[iter->_idx++]);
+	return TRUE;
 }
 
 /******************************************************************************************/
@@ -313,21 +361,10 @@ _do_add (NMMultiIndex *index,
 		values_data->value0 = (gpointer) value;
 
 		g_hash_table_insert (index->hash, id_new, values_data);
-	} else {
-		if (!values_data->index) {
-			if (values_data->value0 == value)
-				return FALSE;
-			values_data->index = g_hash_table_new (NULL, NULL);
-			g_hash_table_replace (values_data->index, (gpointer) value, (gpointer) value);
-			g_hash_table_replace (values_data->index, values_data->value0, values_data->value0);
-			values_data->values = NULL;
-		} else {
-			if (!nm_g_hash_table_replace (values_data->index, (gpointer) value, (gpointer) value))
-				return FALSE;
-			g_clear_pointer (&values_data->values, g_free);
-		}
+		return TRUE;
 	}
-	return TRUE;
+
+	return _values_data_add (values_data, value);
 }
 
 static gboolean
@@ -336,24 +373,16 @@ _do_remove (NMMultiIndex *index,
             gconstpointer value)
 {
 	ValuesData *values_data;
+	gboolean empty;
 
 	values_data = g_hash_table_lookup (index->hash, id);
 	if (!values_data)
 		return FALSE;
 
-	if (values_data->index) {
-		if (!g_hash_table_remove (values_data->index, value))
-			return FALSE;
-		if (g_hash_table_size (values_data->index) == 0)
-			g_hash_table_remove (index->hash, id);
-		else
-			g_clear_pointer (&values_data->values, g_free);
-	} else {
-		if (values_data->value0 != value)
-			return FALSE;
+	if (!_values_data_remove (values_data, value, &empty))
+		return FALSE;
+	if (empty)
 		g_hash_table_remove (index->hash, id);
-	}
-
 	return TRUE;
 }
 
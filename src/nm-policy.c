@@ -676,9 +676,8 @@ auto_activate_device (gpointer user_data)
 	NMPolicyPrivate *priv;
 	NMSettingsConnection *best_connection;
 	char *specific_object = NULL;
-	GPtrArray *connections;
-	GSList *connection_list;
-	guint i;
+	gs_free NMSettingsConnection **connections = NULL;
+	guint i, len;
 
 	g_assert (data);
 	self = data->policy;
@@ -693,30 +692,30 @@ auto_activate_device (gpointer user_data)
 	if (nm_device_get_act_request (data->device))
 		goto out;
 
-	connection_list = nm_manager_get_activatable_connections (priv->manager);
-	if (!connection_list)
-		goto out;
-
-	connections = _nm_utils_copy_slist_to_array (connection_list, NULL, NULL);
-	g_slist_free (connection_list);
-
-	/* sort is stable (which is important at this point) so that connections
-	 * with same priority are still sorted by last-connected-timestamp. */
-	g_ptr_array_sort (connections, (GCompareFunc) nm_utils_cmp_connection_by_autoconnect_priority);
-
-	/* Find the first connection that should be auto-activated */
+	/* The candidates are sorted by autoconnect priority and last-connected
+	 * timestamp, and only include the connections that are not locked to
+	 * another device. Find the first connection that should be
+	 * auto-activated. */
+	connections = nm_device_get_candidate_connections (data->device, &len);
 	best_connection = NULL;
-	for (i = 0; i < connections->len; i++) {
-		NMSettingsConnection *candidate = NM_SETTINGS_CONNECTION (connections->pdata[i]);
+	for (i = 0; i < len; i++) {
+		NMSettingsConnection *candidate = connections[i];
 
 		if (!nm_settings_connection_can_autoconnect (candidate))
 			continue;
-		if (nm_device_can_auto_connect (data->device, (NMConnection *) candidate, &specific_object)) {
-			best_connection = candidate;
-			break;
+		if (!nm_device_can_auto_connect (data->device, (NMConnection *) candidate, &specific_object))
+			continue;
+
+		/* only the few compatible connections need the (more expensive)
+		 * check whether they are active already. */
+		if (!nm_manager_connection_is_activatable (priv->manager, candidate)) {
+			g_clear_pointer (&specific_object, g_free);
+			continue;
 		}
+
+		best_connection = candidate;
+		break;
 	}
-	g_ptr_array_free (connections, TRUE);
 
 	if (best_connection) {
 		GError *error = NULL;
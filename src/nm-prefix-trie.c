@@ -0,0 +1,381 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-prefix-trie.h"
+
+#include <string.h>
+#include <sys/socket.h>
+
+/* A path compressed binary trie (radix tree) of address prefixes. Each node
+ * stands for one prefix and carries the values that were added for exactly
+ * that prefix. Nodes without values only exist as branch points, so
+ * there are less than twice as many nodes as distinct prefixes.
+ *
+ * Looking up the prefixes that cover an address only walks down one
+ * path of the trie, which is at most as deep as the address has bits.
+ */
+
+typedef struct _Node Node;
+
+struct _Node {
+	Node *parent;
+	Node *child[2];
+
+	/* %NULL terminated array of @len values. */
+	gpointer *values;
+	guint len;
+
+	guint8 plen;
+
+	/* the prefix, with the host part cleared. */
+	guint8 prefix[16];
+};
+
+struct NMPrefixTrie {
+	Node *root;
+	guint num_values;
+	guint8 addr_bits;
+};
+
+/******************************************************************************************/
+
+static inline guint
+_get_bit (const guint8 *addr, guint8 idx)
+{
+	return (addr[idx / 8] >> (7 - (idx % 8))) & 1;
+}
+
+/* returns the number of leading bits that @a and @b have in common,
+ * but at most @max_plen. */
+static guint8
+_common_plen (const guint8 *a, const guint8 *b, guint8 max_plen)
+{
+	guint i;
+
+	for (i = 0; i * 8 < max_plen; i++) {
+		guint8 x = a[i] ^ b[i];
+
+		if (x) {
+			guint n = i * 8;
+
+			while (!(x & 0x80)) {
+				x <<= 1;
+				n++;
+			}
+			return MIN (n, max_plen);
+		}
+	}
+	return max_plen;
+}
+
+static Node *
+_node_new (const guint8 *key, guint8 plen, Node *parent)
+{
+	Node *node;
+
+	node = g_slice_new0 (Node);
+	node->parent = parent;
+	node->plen = plen;
+	memcpy (node->prefix, key, plen / 8);
+	if (plen % 8)
+		node->prefix[plen / 8] = key[plen / 8] & (0xFF << (8 - (plen % 8)));
+	return node;
+}
+
+static void
+_node_free (Node *node)
+{
+	if (!node)
+		return;
+	_node_free (node->child[0]);
+	_node_free (node->child[1]);
+	g_free (node->values);
+	g_slice_free (Node, node);
+}
+
+static Node **
+_node_get_slot (NMPrefixTrie *trie, Node *node)
+{
+	if (!node->parent)
+		return &trie->root;
+	return &node->parent->child[_get_bit (node->prefix, node->parent->plen)];
+}
+
+static Node *
+_node_find (const NMPrefixTrie *trie, const guint8 *key, guint8 plen)
+{
+	Node *node = trie->root;
+
+	while (node && node->plen <= plen) {
+		if (_common_plen (node->prefix, key, node->plen) < node->plen)
+			return NULL;
+		if (node->plen == plen)
+			return node;
+		node = node->child[_get_bit (key, node->plen)];
+	}
+	return NULL;
+}
+
+static gboolean
+_node_add_value (Node *node, gconstpointer value)
+{
+	guint i;
+
+	for (i = 0; i < node->len; i++) {
+		if (node->values[i] == value)
+			return FALSE;
+	}
+	node->values = g_renew (gpointer, node->values, node->len + 2);
+	node->values[node->len++] = (gpointer) value;
+	node->values[node->len] = NULL;
+	return TRUE;
+}
+
+static gboolean
+_node_remove_value (Node *node, gconstpointer value)
+{
+	guint i;
+
+	for (i = 0; i < node->len; i++) {
+		if (node->values[i] == value) {
+			/* preserve the order of the remaining values, including the
+			 * %NULL terminator. */
+			memmove (&node->values[i], &node->values[i + 1], (node->len - i) * sizeof (gpointer));
+			if (--node->len == 0)
+				g_clear_pointer (&node->values, g_free);
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/* drop the nodes without values that are no longer needed as
+ * branch points, starting at @node and walking upwards. */
+static void
+_node_compact (NMPrefixTrie *trie, Node *node)
+{
+	while (node && !node->len) {
+		Node *parent = node->parent;
+		Node *child;
+
+		if (node->child[0] && node->child[1])
+			return;
+
+		child = node->child[0] ? node->child[0] : node->child[1];
+		*_node_get_slot (trie, node) = child;
+		node->child[0] = NULL;
+		node->child[1] = NULL;
+		_node_free (node);
+
+		if (child) {
+			child->parent = parent;
+			return;
+		}
+
+		/* @parent lost one child. Maybe it can go too. */
+		node = parent;
+	}
+}
+
+/******************************************************************************************/
+
+gboolean
+nm_prefix_trie_add (NMPrefixTrie *trie,
+                    gconstpointer addr,
+                    guint8 plen,
+                    gconstpointer value)
+{
+	const guint8 *key = addr;
+	Node **p_node;
+	Node *node, *parent = NULL, *target;
+	guint8 cpl;
+
+	g_return_val_if_fail (trie, FALSE);
+	g_return_val_if_fail (addr, FALSE);
+	g_return_val_if_fail (plen <= trie->addr_bits, FALSE);
+	g_return_val_if_fail (value, FALSE);
+
+	p_node = &trie->root;
+	while ((node = *p_node)) {
+		cpl = _common_plen (node->prefix, key, MIN (node->plen, plen));
+		if (cpl < node->plen) {
+			Node *branch;
+
+			/* @node is not a prefix of @key. Insert a new node in between,
+			 * either for @key itself (if @key is a prefix of @node), or as
+			 * branch point for @node and a new node for @key. */
+			if (cpl == plen) {
+				branch = _node_new (key, plen, parent);
+				target = branch;
+			} else {
+				branch = _node_new (key, cpl, parent);
+				target = _node_new (key, plen, branch);
+				branch->child[_get_bit (key, cpl)] = target;
+			}
+			branch->child[_get_bit (node->prefix, cpl)] = node;
+			node->parent = branch;
+			*p_node = branch;
+			goto add_value;
+		}
+		if (node->plen == plen) {
+			target = node;
+			goto add_value;
+		}
+		parent = node;
+		p_node = &node->child[_get_bit (key, node->plen)];
+	}
+	target = _node_new (key, plen, parent);
+	*p_node = target;
+
+add_value:
+	if (!_node_add_value (target, value))
+		return FALSE;
+	trie->num_values++;
+	return TRUE;
+}
+
+gboolean
+nm_prefix_trie_remove (NMPrefixTrie *trie,
+                       gconstpointer addr,
+                       guint8 plen,
+                       gconstpointer value)
+{
+	Node *node;
+
+	g_return_val_if_fail (trie, FALSE);
+	g_return_val_if_fail (addr, FALSE);
+	g_return_val_if_fail (value, FALSE);
+
+	node = _node_find (trie, addr, plen);
+	if (!node)
+		return FALSE;
+	if (!_node_remove_value (node, value))
+		return FALSE;
+	trie->num_values--;
+	_node_compact (trie, node);
+	return TRUE;
+}
+
+gboolean
+nm_prefix_trie_contains (const NMPrefixTrie *trie,
+                         gconstpointer addr,
+                         guint8 plen,
+                         gconstpointer value)
+{
+	const Node *node;
+	guint i;
+
+	g_return_val_if_fail (trie, FALSE);
+	g_return_val_if_fail (addr, FALSE);
+
+	node = _node_find (trie, addr, plen);
+	if (node) {
+		for (i = 0; i < node->len; i++) {
+			if (node->values[i] == value)
+				return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+guint
+nm_prefix_trie_get_num_values (const NMPrefixTrie *trie)
+{
+	g_return_val_if_fail (trie, 0);
+
+	return trie->num_values;
+}
+
+/**
+ * nm_prefix_trie_lookup_lpm:
+ * @trie: the trie
+ * @addr: the address to look up
+ * @max_plen: only consider prefixes with at most @max_plen bits.
+ * @match_func: called for all prefixes that cover @addr, starting with
+ *   the longest one.
+ * @user_data: user data for @match_func
+ *
+ * Performs a longest-prefix-match lookup of @addr. The cost
+ * depends only on the address length, not on the number of
+ * values in @trie.
+ *
+ * Returns: %TRUE, if @match_func returned %TRUE for one prefix.
+ */
+gboolean
+nm_prefix_trie_lookup_lpm (const NMPrefixTrie *trie,
+                           gconstpointer addr,
+                           guint8 max_plen,
+                           NMPrefixTrieFuncMatch match_func,
+                           gpointer user_data)
+{
+	const guint8 *key = addr;
+	const Node *stack[129];
+	const Node *node;
+	guint n = 0;
+
+	g_return_val_if_fail (trie, FALSE);
+	g_return_val_if_fail (addr, FALSE);
+	g_return_val_if_fail (match_func, FALSE);
+
+	max_plen = MIN (max_plen, trie->addr_bits);
+
+	node = trie->root;
+	while (node && node->plen <= max_plen) {
+		if (_common_plen (node->prefix, key, node->plen) < node->plen)
+			break;
+		if (node->len)
+			stack[n++] = node;
+		if (node->plen == max_plen)
+			break;
+		node = node->child[_get_bit (key, node->plen)];
+	}
+
+	while (n > 0) {
+		node = stack[--n];
+		if (match_func (node->plen, node->values, node->len, user_data))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/******************************************************************************************/
+
+NMPrefixTrie *
+nm_prefix_trie_new (int addr_family)
+{
+	NMPrefixTrie *trie;
+
+	g_return_val_if_fail (NM_IN_SET (addr_family, AF_INET, AF_INET6), NULL);
+
+	trie = g_new0 (NMPrefixTrie, 1);
+	trie->addr_bits = addr_family == AF_INET ? 32 : 128;
+	return trie;
+}
+
+void
+nm_prefix_trie_free (NMPrefixTrie *trie)
+{
+	g_return_if_fail (trie);
+
+	_node_free (trie->root);
+	g_free (trie);
+}
@@ -0,0 +1,66 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#ifndef __NM_PREFIX_TRIE__
+#define __NM_PREFIX_TRIE__
+
+#include "nm-default.h"
+
+G_BEGIN_DECLS
+
+typedef struct NMPrefixTrie NMPrefixTrie;
+
+/* Called by nm_prefix_trie_lookup_lpm() for each prefix that covers
+ * the looked-up address, starting with the longest one.
+ * @values is a %NULL terminated array of @len values that were added
+ * for the prefix of length @plen.
+ * Return %TRUE to stop the lookup. */
+typedef gboolean (*NMPrefixTrieFuncMatch) (guint8 plen, void *const* values, guint len, gpointer user_data);
+
+NMPrefixTrie *nm_prefix_trie_new (int addr_family);
+
+void nm_prefix_trie_free (NMPrefixTrie *trie);
+
+gboolean nm_prefix_trie_add (NMPrefixTrie *trie,
+                             gconstpointer addr,
+                             guint8 plen,
+                             gconstpointer value);
+
+gboolean nm_prefix_trie_remove (NMPrefixTrie *trie,
+                                gconstpointer addr,
+                                guint8 plen,
+                                gconstpointer value);
+
+gboolean nm_prefix_trie_contains (const NMPrefixTrie *trie,
+                                  gconstpointer addr,
+                                  guint8 plen,
+                                  gconstpointer value);
+
+guint nm_prefix_trie_get_num_values (const NMPrefixTrie *trie);
+
+gboolean nm_prefix_trie_lookup_lpm (const NMPrefixTrie *trie,
+                                    gconstpointer addr,
+                                    guint8 max_plen,
+                                    NMPrefixTrieFuncMatch match_func,
+                                    gpointer user_data);
+
+G_END_DECLS
+
+#endif /* __NM_PREFIX_TRIE__ */
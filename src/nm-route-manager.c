@@ -51,6 +51,11 @@ typedef struct {
 	GArray *effective_metrics_reverse;
 } RouteEntries;
 
+typedef struct {
+	guint batch_idx;
+	const NMPlatformIPXRoute *route;
+} AddedRoute;
+
 typedef struct {
 	NMRouteManager *self;
 	gint64 scheduled_at_ns;
@@ -285,6 +290,56 @@ _route_index_create (const VTableIP *vtable, const GArray *routes)
 	return index;
 }
 
+/* Creates the index for @routes after routes were appended to it, without
+ * sorting all routes again.
+ *
+ * @kept contains the positions in @routes of the @n_kept previously indexed
+ * routes, in the order of the previous index. The routes after position
+ * @n_kept were appended. Only those get sorted, and the two sorted lists
+ * are merged. For routes that compare equal, the previously indexed ones come
+ * first, which gives the same result as the stable sort of _route_index_create(). */
+static RouteIndex *
+_route_index_create_merged (const VTableIP *vtable, const GArray *routes, const guint *kept, guint n_kept)
+{
+	RouteIndex *index;
+	guint len = routes->len;
+	guint first_added = n_kept;
+	guint i;
+	gssize i_added, i_kept, i_dst;
+
+	nm_assert (n_kept <= len);
+
+	index = g_malloc (sizeof (RouteIndex) + len * sizeof (NMPlatformIPXRoute *));
+	index->len = len;
+	index->entries[len] = NULL;
+
+	/* sort the added routes at the tail of the index... */
+	for (i = first_added; i < len; i++)
+		index->entries[i] = VTABLE_ROUTE_INDEX (vtable, routes, i);
+	g_qsort_with_data (&index->entries[first_added],
+	                   len - first_added,
+	                   sizeof (NMPlatformIPXRoute *),
+	                   (GCompareDataFunc) _route_index_create_sort,
+	                   (gpointer) vtable);
+
+	/* ... and merge them with the kept routes, from the back to the front. */
+	i_added = ((gssize) len) - 1;
+	i_kept = ((gssize) n_kept) - 1;
+	i_dst = ((gssize) len) - 1;
+	while (i_kept >= 0) {
+		const NMPlatformIPXRoute *r_kept = VTABLE_ROUTE_INDEX (vtable, routes, kept[i_kept]);
+
+		if (   i_added >= (gssize) first_added
+		    && vtable->route_id_cmp (r_kept, index->entries[i_added]) <= 0)
+			index->entries[i_dst--] = index->entries[i_added--];
+		else
+			index->entries[i_dst--] = (NMPlatformIPXRoute *) r_kept;
+	}
+	nm_assert (i_dst == i_added);
+
+	return index;
+}
+
 static int
 _vx_route_id_cmp_full (const NMPlatformIPXRoute *r1, const NMPlatformIPXRoute *r2, const VTableIP *vtable)
 {
@@ -437,7 +492,8 @@ static gboolean
 _vx_route_sync (const VTableIP *vtable, NMRouteManager *self, int ifindex, const GArray *known_routes, gboolean ignore_kernel_routes, gboolean full_sync)
 {
 	NMRouteManagerPrivate *priv = NM_ROUTE_MANAGER_GET_PRIVATE (self);
-	GArray *plat_routes;
+	NMPlatformSnapshot *plat_snapshot;
+	const GArray *plat_routes;
 	RouteEntries *ipx_routes;
 	RouteIndex *plat_routes_idx, *known_routes_idx;
 	gboolean success = TRUE;
@@ -450,14 +506,21 @@ _vx_route_sync (const VTableIP *vtable, NMRouteManager *self, int ifindex, const
 	gint64 *p_effective_metric = NULL;
 	gboolean ipx_routes_changed = FALSE;
 	gint64 *effective_metrics = NULL;
+	NMPlatformBatch *batch;
+	GArray *added_routes = NULL;
 
 	nm_platform_process_events (priv->platform);
 
+	/* all changes to platform are queued in @batch and sent to kernel together
+	 * at the end. The order of the operations is preserved. */
+	batch = nm_platform_batch_new (priv->platform);
+
 	ipx_routes = vtable->vt->is_ip4 ? &priv->ip4_routes : &priv->ip6_routes;
-	plat_routes = vtable->vt->route_get_all (priv->platform, ifindex,
-	                                         ignore_kernel_routes
-	                                             ? NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT
-	                                             : NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT | NM_PLATFORM_GET_ROUTE_FLAGS_WITH_RTPROT_KERNEL);
+	plat_snapshot = vtable->vt->route_get_snapshot (priv->platform, ifindex,
+	                                                ignore_kernel_routes
+	                                                    ? NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT
+	                                                    : NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT | NM_PLATFORM_GET_ROUTE_FLAGS_WITH_RTPROT_KERNEL);
+	plat_routes = nm_platform_snapshot_get_array (plat_snapshot);
 	plat_routes_idx = _route_index_create (vtable, plat_routes);
 	known_routes_idx = _route_index_create (vtable, known_routes);
 
@@ -576,14 +639,36 @@ _vx_route_sync (const VTableIP *vtable, NMRouteManager *self, int ifindex, const
 				 * in platform. Delete it. */
 				_LOGt (vtable->vt->addr_family, "%3d: platform rt-rm #%u - %s", ifindex, i_plat_routes,
 				       vtable->vt->route_to_string (cur_plat_route, NULL, 0));
-				vtable->vt->route_delete (priv->platform, ifindex, cur_plat_route);
+				vtable->vt->batch_route_delete (batch, ifindex, cur_plat_route);
 			}
 		}
 	}
 
 	/* Update @ipx_routes with the just learned changes. */
 	if (to_delete_indexes || to_add_routes) {
+		guint n_kept = 0;
+		gs_free guint *kept = NULL;
+
+		/* @ipx_routes contains the routes of all interfaces, so don't sort it
+		 * completely when only a few routes change. Remember the positions of the
+		 * routes that stay, in the order of the current index, and merge the added
+		 * routes into that below. */
+		kept = g_new (guint, ipx_routes->index->len);
+		for (i = 0, i_ipx_routes = 0; i_ipx_routes < ipx_routes->index->len; i_ipx_routes++) {
+			if (   to_delete_indexes
+			    && i < to_delete_indexes->len
+			    && g_array_index (to_delete_indexes, guint, i) == i_ipx_routes) {
+				i++;
+				continue;
+			}
+			kept[n_kept++] = _route_index_reverse_idx (vtable, ipx_routes->index, i_ipx_routes, ipx_routes->entries);
+		}
+
 		if (to_delete_indexes) {
+			gs_free guint *shifted = NULL;
+			guint n_old = ipx_routes->entries->len;
+			guint j;
+
 			for (i = 0; i < to_delete_indexes->len; i++) {
 				guint idx = g_array_index (to_delete_indexes, guint, i);
 
@@ -592,6 +677,18 @@ _vx_route_sync (const VTableIP *vtable, NMRouteManager *self, int ifindex, const
 				g_array_index (to_delete_indexes, guint, i) = _route_index_reverse_idx (vtable, ipx_routes->index, idx, ipx_routes->entries);
 			}
 			g_array_sort (to_delete_indexes, (GCompareFunc) _sort_indexes_cmp);
+
+			/* the kept routes move to the front by the number of deleted routes before them. */
+			shifted = g_new (guint, n_old);
+			for (i = 0, j = 0; i < n_old; i++) {
+				if (   j < to_delete_indexes->len
+				    && g_array_index (to_delete_indexes, guint, j) == i)
+					j++;
+				shifted[i] = i - j;
+			}
+			for (i = 0; i < n_kept; i++)
+				kept[i] = shifted[kept[i]];
+
 			nm_utils_array_remove_at_indexes (ipx_routes->entries, &g_array_index (to_delete_indexes, guint, 0), to_delete_indexes->len);
 			nm_utils_array_remove_at_indexes (ipx_routes->effective_metrics_reverse, &g_array_index (to_delete_indexes, guint, 0), to_delete_indexes->len);
 			g_array_unref (to_delete_indexes);
@@ -618,7 +715,7 @@ _vx_route_sync (const VTableIP *vtable, NMRouteManager *self, int ifindex, const
 			g_ptr_array_unref (to_add_routes);
 		}
 		g_free (ipx_routes->index);
-		ipx_routes->index = _route_index_create (vtable, ipx_routes->entries);
+		ipx_routes->index = _route_index_create_merged (vtable, ipx_routes->entries, kept, n_kept);
 		ipx_routes_changed = TRUE;
 		ASSERT_route_index_valid (vtable, ipx_routes->entries, ipx_routes->index, TRUE);
 	}
@@ -742,7 +839,7 @@ next:
 			if (   !cur_ipx_route
 			    || route_dest_cmp_result != 0
 			    || *p_effective_metric != cur_plat_route->rx.metric)
-				vtable->vt->route_delete (priv->platform, ifindex, cur_plat_route);
+				vtable->vt->batch_route_delete (batch, ifindex, cur_plat_route);
 
 			cur_plat_route = _get_next_plat_route (plat_routes_idx, FALSE, &i_plat_routes);
 		}
@@ -815,15 +912,15 @@ next:
 					gateway_routes = g_array_new (FALSE, FALSE, sizeof (guint));
 				g_array_append_val (gateway_routes, i_ipx_routes);
 			} else
-				vtable->vt->route_add (priv->platform, 0, cur_ipx_route, *p_effective_metric);
+				vtable->vt->batch_route_add (batch, 0, cur_ipx_route, *p_effective_metric);
 		}
 
 		if (gateway_routes) {
 			for (i = 0; i < gateway_routes->len; i++) {
 				i_ipx_routes = g_array_index (gateway_routes, guint, i);
-				vtable->vt->route_add (priv->platform, 0,
-				                       ipx_routes->index->entries[i_ipx_routes],
-				                       effective_metrics[i_ipx_routes]);
+				vtable->vt->batch_route_add (batch, 0,
+				                             ipx_routes->index->entries[i_ipx_routes],
+				                             effective_metrics[i_ipx_routes]);
 			}
 			g_array_unref (gateway_routes);
 		}
@@ -871,26 +968,44 @@ next:
 			if (   !cur_plat_route
 			    || route_dest_cmp_result != 0
 			    || !_route_equals_ignoring_ifindex (vtable, cur_plat_route, cur_ipx_route, *p_effective_metric)) {
+				AddedRoute added;
 
-				if (!vtable->vt->route_add (priv->platform, ifindex, cur_ipx_route, *p_effective_metric)) {
-					if (cur_ipx_route->rx.rt_source < NM_IP_CONFIG_SOURCE_USER) {
-						_LOGD (vtable->vt->addr_family,
-						       "ignore error adding IPv%c route to kernel: %s",
-						       vtable->vt->is_ip4 ? '4' : '6',
-						       vtable->vt->route_to_string (cur_ipx_route, NULL, 0));
-					} else {
-						/* Remember that there was a failure, but for now continue trying
-						 * to sync the remaining routes. */
-						success = FALSE;
-					}
-				}
+				added.batch_idx = vtable->vt->batch_route_add (batch, ifindex, cur_ipx_route, *p_effective_metric);
+				added.route = cur_ipx_route;
+				if (!added_routes)
+					added_routes = g_array_new (FALSE, FALSE, sizeof (AddedRoute));
+				g_array_append_val (added_routes, added);
 			}
 		}
 	}
 
+	nm_platform_batch_commit (batch);
+
+	for (i = 0; added_routes && i < added_routes->len; i++) {
+		const AddedRoute *added = &g_array_index (added_routes, AddedRoute, i);
+
+		if (nm_platform_batch_get_result (batch, added->batch_idx))
+			continue;
+
+		if (added->route->rx.rt_source < NM_IP_CONFIG_SOURCE_USER) {
+			_LOGD (vtable->vt->addr_family,
+			       "ignore error adding IPv%c route to kernel: %s",
+			       vtable->vt->is_ip4 ? '4' : '6',
+			       vtable->vt->route_to_string (added->route, NULL, 0));
+		} else {
+			/* Remember that there was a failure, but still report
+			 * the remaining routes. */
+			success = FALSE;
+		}
+	}
+
+	if (added_routes)
+		g_array_unref (added_routes);
+	nm_platform_batch_free (batch);
+
 	g_free (known_routes_idx);
 	g_free (plat_routes_idx);
-	g_array_unref (plat_routes);
+	nm_platform_snapshot_unref (plat_snapshot);
 
 	return success;
 }
@@ -1367,6 +1367,60 @@ ip6_route_get (NMPlatform *platform, int ifindex, struct in6_addr network, guint
 	return NULL;
 }
 
+static const NMPlatformIP4Route *
+ip4_route_get_lpm (NMPlatform *platform, int ifindex, in_addr_t host, gboolean without_gateway)
+{
+	NMFakePlatformPrivate *priv = NM_FAKE_PLATFORM_GET_PRIVATE (platform);
+	NMPlatformIP4Route *best = NULL;
+	int i;
+
+	for (i = 0; i < priv->ip4_routes->len; i++) {
+		NMPlatformIP4Route *route = &g_array_index (priv->ip4_routes, NMPlatformIP4Route, i);
+
+		if (ifindex > 0 && route->ifindex != ifindex)
+			continue;
+		if (without_gateway && route->gateway)
+			continue;
+		if (route->network != nm_utils_ip4_address_clear_host_address (host, route->plen))
+			continue;
+		if (   best
+		    && (   best->plen > route->plen
+		        || (best->plen == route->plen && best->metric <= route->metric)))
+			continue;
+		best = route;
+	}
+
+	return best;
+}
+
+static const NMPlatformIP6Route *
+ip6_route_get_lpm (NMPlatform *platform, int ifindex, const struct in6_addr *host, gboolean without_gateway)
+{
+	NMFakePlatformPrivate *priv = NM_FAKE_PLATFORM_GET_PRIVATE (platform);
+	NMPlatformIP6Route *best = NULL;
+	int i;
+
+	for (i = 0; i < priv->ip6_routes->len; i++) {
+		NMPlatformIP6Route *route = &g_array_index (priv->ip6_routes, NMPlatformIP6Route, i);
+		struct in6_addr network;
+
+		if (ifindex > 0 && route->ifindex != ifindex)
+			continue;
+		if (without_gateway && !IN6_IS_ADDR_UNSPECIFIED (&route->gateway))
+			continue;
+		nm_utils_ip6_address_clear_host_address (&network, host, route->plen);
+		if (!IN6_ARE_ADDR_EQUAL (&route->network, &network))
+			continue;
+		if (   best
+		    && (   best->plen > route->plen
+		        || (best->plen == route->plen && best->metric <= route->metric)))
+			continue;
+		best = route;
+	}
+
+	return best;
+}
+
 /******************************************************************/
 
 static void
@@ -1500,6 +1554,8 @@ nm_fake_platform_class_init (NMFakePlatformClass *klass)
 
 	platform_class->ip4_route_get = ip4_route_get;
 	platform_class->ip6_route_get = ip6_route_get;
+	platform_class->ip4_route_get_lpm = ip4_route_get_lpm;
+	platform_class->ip6_route_get_lpm = ip6_route_get_lpm;
 	platform_class->ip4_route_get_all = ip4_route_get_all;
 	platform_class->ip6_route_get_all = ip6_route_get_all;
 	platform_class->ip4_route_add = ip4_route_add;
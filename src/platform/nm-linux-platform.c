@@ -25,6 +25,7 @@
 #include <unistd.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
+#include <sys/stat.h>
 #include <fcntl.h>
 #include <dlfcn.h>
 #include <arpa/inet.h>
@@ -242,6 +243,7 @@ static void do_request_all_no_delayed_actions (NMPlatform *platform, DelayedActi
 static void cache_pre_hook (NMPCache *cache, const NMPObject *old, const NMPObject *new, NMPCacheOpsType ops_type, gpointer user_data);
 static void cache_prune_candidates_prune (NMPlatform *platform);
 static gboolean event_handler_read_netlink (NMPlatform *platform, gboolean wait_for_acks);
+static gboolean event_handler_read_netlink_sock (NMPlatform *platform, int sock_idx);
 static void _assert_netns_current (NMPlatform *platform);
 
 /*****************************************************************************/
@@ -2380,30 +2382,128 @@ _support_kernel_extended_ifa_flags_get (void)
  * NMPlatform types and functions
  ******************************************************************/
 
+/* The events are received on one socket per group of tables, so that an
+ * overrun of one socket only requires to re-dump the tables of that socket.
+ * Requests and dumps of a table are sent on the socket of its table, so
+ * that their responses stay ordered against the events. */
+typedef enum {
+	NL_SOCK_IDX_LINK,       /* links and addresses */
+	NL_SOCK_IDX_IP4_ROUTE,
+	NL_SOCK_IDX_IP6_ROUTE,
+	_NL_SOCK_IDX_NUM,
+} NlSockIdx;
+
 typedef struct {
 	guint32 seq_number;
+	NlSockIdx sock_idx;
 	WaitForNlResponseResult seq_result;
 	gint64 timeout_abs_ns;
 	WaitForNlResponseResult *out_seq_result;
 	gint *out_refresh_all_in_progess;
 } DelayedActionWaitForNlResponseData;
 
-typedef struct _NMLinuxPlatformPrivate NMLinuxPlatformPrivate;
+/* Number of datagrams fetched with one recvmmsg() call. */
+#define NL_RECV_RING_SLOTS      16
 
-struct _NMLinuxPlatformPrivate {
+/* Initial size of a slot. Dumps are usually packed into datagrams of at
+ * most that size, but single messages can be larger (e.g. RTM_NEWLINK of
+ * a device with many SR-IOV VFs). Then the slots grow. */
+#define NL_RECV_RING_SLOT_SIZE  32768
+
+typedef struct {
+	struct sockaddr_nl nla;
+	struct ucred creds;
+	union {
+		struct cmsghdr cmsg;
+		char buf[CMSG_SPACE (sizeof (struct ucred))];
+	} ctrl;
+	struct iovec iov;
+} NlRecvRingSlot;
+
+typedef struct {
+	/* number of received datagrams in @msgs, and the index of the
+	 * next one to hand out. */
+	guint n_filled;
+	guint idx;
+
+	/* @data holds the buffers of all slots, each @slot_size bytes. When a
+	 * datagram didn't fit, @slot_size_next is the size to use with the
+	 * next recvmmsg(). */
+	gsize slot_size;
+	gsize slot_size_next;
+	unsigned char *data;
+
+	struct mmsghdr msgs[NL_RECV_RING_SLOTS];
+	NlRecvRingSlot slots[NL_RECV_RING_SLOTS];
+} NlRecvRing;
+
+typedef struct {
 	struct nl_sock *nlh;
-	guint32 nlh_seq_next;
 #ifdef NM_MORE_LOGGING
-	guint32 nlh_seq_last_handled;
+	guint32 seq_last_handled;
 #endif
-	guint32 nlh_seq_last_seen;
-	NMPCache *cache;
+	guint32 seq_last_seen;
 	GIOChannel *event_channel;
 	guint event_id;
 
+	/* preallocated receive buffers, see _nl_recv_ring_next(). */
+	NlRecvRing *recv_ring;
+} NlSock;
+
+static const struct {
+	const char *name;
+	int groups[4];
+	DelayedActionType refresh_all;
+} nl_sock_infos[_NL_SOCK_IDX_NUM] = {
+	[NL_SOCK_IDX_LINK] = {
+		.name        = "link",
+		.groups      = { RTNLGRP_LINK, RTNLGRP_IPV4_IFADDR, RTNLGRP_IPV6_IFADDR, 0 },
+		.refresh_all =   DELAYED_ACTION_TYPE_REFRESH_ALL_LINKS
+		               | DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ADDRESSES
+		               | DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ADDRESSES,
+	},
+	[NL_SOCK_IDX_IP4_ROUTE] = {
+		.name        = "ip4-route",
+		.groups      = { RTNLGRP_IPV4_ROUTE, 0 },
+		.refresh_all = DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ROUTES,
+	},
+	[NL_SOCK_IDX_IP6_ROUTE] = {
+		.name        = "ip6-route",
+		.groups      = { RTNLGRP_IPV6_ROUTE, 0 },
+		.refresh_all = DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ROUTES,
+	},
+};
+
+static NlSockIdx
+_nl_sock_idx_from_nlmsg (struct nlmsghdr *hdr)
+{
+	if (NM_IN_SET (hdr->nlmsg_type, RTM_NEWROUTE, RTM_DELROUTE, RTM_GETROUTE)) {
+		/* both struct rtmsg of requests and struct rtgenmsg of dumps
+		 * start with the address family. */
+		if (   hdr->nlmsg_len >= NLMSG_LENGTH (sizeof (struct rtgenmsg))
+		    && ((struct rtgenmsg *) nlmsg_data (hdr))->rtgen_family == AF_INET6)
+			return NL_SOCK_IDX_IP6_ROUTE;
+		return NL_SOCK_IDX_IP4_ROUTE;
+	}
+	return NL_SOCK_IDX_LINK;
+}
+
+typedef struct _NMLinuxPlatformPrivate NMLinuxPlatformPrivate;
+
+struct _NMLinuxPlatformPrivate {
+	NlSock nl_socks[_NL_SOCK_IDX_NUM];
+
+	/* the sequence numbers are unique across all sockets. */
+	guint32 nlh_seq_next;
+	NMPCache *cache;
+
 	gboolean sysctl_get_warned;
 	GHashTable *sysctl_get_prev_values;
 
+	/* open file descriptors of per-interface sysctl directories
+	 * (like /proc/sys/net/ipv6/conf/eth0), see _sysctl_open(). */
+	GHashTable *sysctl_dirfds;
+
 	GUdevClient *udev_client;
 
 	struct {
@@ -2497,6 +2597,149 @@ _log_dbg_sysctl_set_impl (NMPlatform *platform, const char *path, const char *va
 		} \
 	} G_STMT_END
 
+/* At most this many directory fds are kept open. Activating a device
+ * touches the directories of one interface in a row, so a small cache
+ * suffices and we don't exhaust the file descriptors of the process on
+ * hosts with thousands of links. */
+#define SYSCTL_DIRFDS_MAX 32
+
+static const char *const sysctl_ifdir_prefixes[] = {
+	"/proc/sys/net/ipv4/conf/",
+	"/proc/sys/net/ipv4/neigh/",
+	"/proc/sys/net/ipv6/conf/",
+	"/proc/sys/net/ipv6/neigh/",
+};
+
+static void
+_sysctl_dirfds_clear (NMPlatform *platform)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	GHashTableIter iter;
+	gpointer fd;
+
+	if (!priv->sysctl_dirfds)
+		return;
+
+	g_hash_table_iter_init (&iter, priv->sysctl_dirfds);
+	while (g_hash_table_iter_next (&iter, NULL, &fd))
+		close (GPOINTER_TO_INT (fd));
+	g_hash_table_remove_all (priv->sysctl_dirfds);
+}
+
+static void
+_sysctl_dirfds_forget (NMPlatform *platform, const char *dirpath)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	gpointer fd;
+
+	if (   priv->sysctl_dirfds
+	    && g_hash_table_lookup_extended (priv->sysctl_dirfds, dirpath, NULL, &fd)) {
+		close (GPOINTER_TO_INT (fd));
+		g_hash_table_remove (priv->sysctl_dirfds, dirpath);
+	}
+}
+
+static void
+_sysctl_dirfds_forget_ifname (NMPlatform *platform, const char *ifname)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	char dirpath[NM_STRLEN ("/proc/sys/net/ipv6/neigh/") + IFNAMSIZ];
+	guint i;
+
+	if (   !priv->sysctl_dirfds
+	    || !ifname
+	    || !ifname[0])
+		return;
+
+	for (i = 0; i < G_N_ELEMENTS (sysctl_ifdir_prefixes); i++) {
+		nm_sprintf_buf (dirpath, "%s%s", sysctl_ifdir_prefixes[i], ifname);
+		_sysctl_dirfds_forget (platform, dirpath);
+	}
+}
+
+/* Opens the sysctl file @path with @flags.
+ *
+ * Files in a per-interface directory are opened with openat() relative
+ * to a cached fd of that directory, which saves the kernel from walking
+ * the whole path for each of the many settings that are touched while
+ * activating a device.
+ *
+ * A stale directory fd is harmless: kernel re-registers the directory when
+ * the link is renamed or recreated, and the old one fails with ENOENT.
+ * In that case, retry with the full path.
+ *
+ * Returns the fd, or -1 and sets errno. */
+static int
+_sysctl_open (NMPlatform *platform, const char *path, int flags)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	char dirpath[NM_STRLEN ("/proc/sys/net/ipv6/neigh/") + IFNAMSIZ];
+	const char *filename = NULL;
+	gpointer dir_fd_ptr;
+	int dir_fd, fd;
+	gsize l;
+	guint i;
+
+	flags |= O_CLOEXEC;
+
+	for (i = 0; i < G_N_ELEMENTS (sysctl_ifdir_prefixes); i++) {
+		l = strlen (sysctl_ifdir_prefixes[i]);
+		if (strncmp (path, sysctl_ifdir_prefixes[i], l) == 0) {
+			filename = strchr (&path[l], '/');
+			if (   filename
+			    && filename - &path[l] > 0
+			    && filename - &path[l] < IFNAMSIZ
+			    && filename[1]
+			    && !strchr (&filename[1], '/')) {
+				memcpy (dirpath, path, filename - path);
+				dirpath[filename - path] = '\0';
+				filename++;
+			} else
+				filename = NULL;
+			break;
+		}
+	}
+
+	if (!filename)
+		return open (path, flags);
+
+	if (!priv->sysctl_dirfds)
+		priv->sysctl_dirfds = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	if (g_hash_table_lookup_extended (priv->sysctl_dirfds, dirpath, NULL, &dir_fd_ptr))
+		dir_fd = GPOINTER_TO_INT (dir_fd_ptr);
+	else {
+		dir_fd = open (dirpath, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if (dir_fd < 0)
+			return open (path, flags);
+
+		if (g_hash_table_size (priv->sysctl_dirfds) >= SYSCTL_DIRFDS_MAX)
+			_sysctl_dirfds_clear (platform);
+		g_hash_table_insert (priv->sysctl_dirfds, g_strdup (dirpath), GINT_TO_POINTER (dir_fd));
+	}
+
+	fd = openat (dir_fd, filename, flags);
+	if (fd < 0 && errno == ENOENT) {
+		struct stat st;
+
+		/* either only the file is missing, or the cached directory is gone
+		 * (e.g. the interface was removed and maybe re-added). Only forget
+		 * the directory in the latter case. */
+		if (   fstat (dir_fd, &st) != 0
+		    || st.st_nlink == 0) {
+			_sysctl_dirfds_forget (platform, dirpath);
+			return open (path, flags);
+		}
+
+		fd = open (path, flags);
+		if (fd >= 0) {
+			/* the path now refers to another directory. */
+			_sysctl_dirfds_forget (platform, dirpath);
+		}
+	}
+	return fd;
+}
+
 static gboolean
 sysctl_set (NMPlatform *platform, const char *path, const char *value)
 {
@@ -2522,7 +2765,7 @@ sysctl_set (NMPlatform *platform, const char *path, const char *value)
 		return FALSE;
 	}
 
-	fd = open (path, O_WRONLY | O_TRUNC);
+	fd = _sysctl_open (platform, path, O_WRONLY | O_TRUNC);
 	if (fd == -1) {
 		errsv = errno;
 		if (errsv == ENOENT) {
@@ -2656,8 +2899,11 @@ static char *
 sysctl_get (NMPlatform *platform, const char *path)
 {
 	nm_auto_pop_netns NMPNetns *netns = NULL;
-	GError *error = NULL;
-	char *contents;
+	GString *str;
+	char *contents = NULL;
+	char buf[4096];
+	gssize n;
+	int fd, errsv;
 
 	/* Don't write outside known locations */
 	g_assert (g_str_has_prefix (path, "/proc/sys/")
@@ -2668,14 +2914,39 @@ sysctl_get (NMPlatform *platform, const char *path)
 	if (!nm_platform_netns_push (platform, &netns))
 		return NULL;
 
-	if (!g_file_get_contents (path, &contents, NULL, &error)) {
+	/* Unlike g_file_get_contents(), don't stat() the file. The size
+	 * of virtual files is meaningless anyway. */
+	fd = _sysctl_open (platform, path, O_RDONLY);
+	if (fd >= 0) {
+		str = g_string_sized_new (32);
+		errsv = 0;
+		while (TRUE) {
+			n = read (fd, buf, sizeof (buf));
+			if (n > 0)
+				g_string_append_len (str, buf, n);
+			else if (n == 0)
+				break;
+			else if ((errsv = errno) != EINTR)
+				break;
+			else
+				errsv = 0;
+		}
+		close (fd);
+		if (!errsv)
+			contents = g_string_free (str, FALSE);
+		else {
+			g_string_free (str, TRUE);
+			fd = -1;
+		}
+	} else
+		errsv = errno;
+
+	if (fd < 0) {
 		/* We assume FAILED means EOPNOTSUP */
-		if (   g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT)
-		    || g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_FAILED))
-			_LOGD ("error reading %s: %s", path, error->message);
+		if (NM_IN_SET (g_file_error_from_errno (errsv), G_FILE_ERROR_NOENT, G_FILE_ERROR_FAILED))
+			_LOGD ("error reading %s: %s", path, strerror (errsv));
 		else
-			_LOGE ("error reading %s: %s", path, error->message);
-		g_clear_error (&error);
+			_LOGE ("error reading %s: %s", path, strerror (errsv));
 		return NULL;
 	}
 
@@ -2930,28 +3201,37 @@ delayed_action_wait_for_nl_response_complete (NMPlatform *platform,
 	g_array_remove_index_fast (priv->delayed_action.list_wait_for_nl_response, idx);
 }
 
+/* Completes the pending requests sent on socket @sock_idx, or on all
+ * sockets if @sock_idx is -1. */
 static void
 delayed_action_wait_for_nl_response_complete_all (NMPlatform *platform,
+                                                  int sock_idx,
                                                   WaitForNlResponseResult fallback_result)
 {
 	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	guint idx;
 
 	if (NM_FLAGS_HAS (priv->delayed_action.flags, DELAYED_ACTION_TYPE_WAIT_FOR_NL_RESPONSE)) {
-		while (priv->delayed_action.list_wait_for_nl_response->len > 0) {
+		idx = priv->delayed_action.list_wait_for_nl_response->len;
+		while (idx > 0) {
 			const DelayedActionWaitForNlResponseData *data;
-			guint idx = priv->delayed_action.list_wait_for_nl_response->len - 1;
 			WaitForNlResponseResult r;
 
+			idx--;
 			data = &g_array_index (priv->delayed_action.list_wait_for_nl_response, DelayedActionWaitForNlResponseData, idx);
 
+			if (sock_idx >= 0 && data->sock_idx != (NlSockIdx) sock_idx)
+				continue;
+
 			/* prefer the result that we already have. */
 			r = data->seq_result ? : fallback_result;
 
+			/* this moves the last element to @idx, which was already visited. */
 			delayed_action_wait_for_nl_response_complete (platform, idx, r);
 		}
 	}
-	nm_assert (!NM_FLAGS_HAS (priv->delayed_action.flags, DELAYED_ACTION_TYPE_WAIT_FOR_NL_RESPONSE));
-	nm_assert (priv->delayed_action.list_wait_for_nl_response->len == 0);
+	nm_assert (sock_idx >= 0 || !NM_FLAGS_HAS (priv->delayed_action.flags, DELAYED_ACTION_TYPE_WAIT_FOR_NL_RESPONSE));
+	nm_assert (sock_idx >= 0 || priv->delayed_action.list_wait_for_nl_response->len == 0);
 }
 
 /*****************************************************************************/
@@ -3130,12 +3410,14 @@ delayed_action_schedule (NMPlatform *platform, DelayedActionType action_type, gp
 
 static void
 delayed_action_schedule_WAIT_FOR_NL_RESPONSE (NMPlatform *platform,
+                                              NlSockIdx sock_idx,
                                               guint32 seq_number,
                                               WaitForNlResponseResult *out_seq_result,
                                               gint *out_refresh_all_in_progess)
 {
 	DelayedActionWaitForNlResponseData data = {
 		.seq_number = seq_number,
+		.sock_idx = sock_idx,
 		.timeout_abs_ns = nm_utils_get_monotonic_timestamp_ns () + (200 * (NM_UTILS_NS_PER_SECOND / 1000)),
 		.out_seq_result = out_seq_result,
 		.out_refresh_all_in_progess = out_refresh_all_in_progess,
@@ -3160,6 +3442,29 @@ cache_prune_candidates_record_all (NMPlatform *platform, NMPObjectType obj_type)
 	       priv->prune_candidates ? g_hash_table_size (priv->prune_candidates) : 0);
 }
 
+static void
+cache_prune_candidates_record_addrroute_by_ifindex (NMPlatform *platform, int ifindex)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	static const NMPObjectType obj_types[] = {
+		NMP_OBJECT_TYPE_IP4_ADDRESS,
+		NMP_OBJECT_TYPE_IP6_ADDRESS,
+		NMP_OBJECT_TYPE_IP4_ROUTE,
+		NMP_OBJECT_TYPE_IP6_ROUTE,
+	};
+	guint i;
+
+	nm_assert (ifindex > 0);
+
+	for (i = 0; i < G_N_ELEMENTS (obj_types); i++) {
+		priv->prune_candidates = nmp_cache_lookup_all_to_hash (priv->cache,
+		                                                       nmp_cache_id_init_addrroute_visible_by_ifindex (NMP_CACHE_ID_STATIC, obj_types[i], ifindex),
+		                                                       priv->prune_candidates);
+	}
+	_LOGt ("cache-prune: record addresses and routes of ifindex %d (now %u candidates)", ifindex,
+	       priv->prune_candidates ? g_hash_table_size (priv->prune_candidates) : 0);
+}
+
 static void
 cache_prune_candidates_record_one (NMPlatform *platform, NMPObject *obj)
 {
@@ -3204,22 +3509,23 @@ cache_prune_candidates_prune (NMPlatform *platform)
 	gboolean was_visible;
 	NMPCacheOpsType cache_op;
 
-	if (!priv->prune_candidates)
-		return;
+	/* pruning a link records the addresses and routes on it as new
+	 * candidates. Repeat until nothing is left. */
+	while (priv->prune_candidates) {
+		prune_candidates = priv->prune_candidates;
+		priv->prune_candidates = NULL;
 
-	prune_candidates = priv->prune_candidates;
-	priv->prune_candidates = NULL;
+		g_hash_table_iter_init (&iter, prune_candidates);
+		while (g_hash_table_iter_next (&iter, (gpointer *)&obj, NULL)) {
+			nm_auto_nmpobj NMPObject *obj_cache = NULL;
 
-	g_hash_table_iter_init (&iter, prune_candidates);
-	while (g_hash_table_iter_next (&iter, (gpointer *)&obj, NULL)) {
-		nm_auto_nmpobj NMPObject *obj_cache = NULL;
+			_LOGt ("cache-prune: prune %s", nmp_object_to_string (obj, NMP_OBJECT_TO_STRING_ALL, NULL, 0));
+			cache_op = nmp_cache_remove (priv->cache, obj, TRUE, &obj_cache, &was_visible, cache_pre_hook, platform);
+			do_emit_signal (platform, obj_cache, cache_op, was_visible);
+		}
 
-		_LOGt ("cache-prune: prune %s", nmp_object_to_string (obj, NMP_OBJECT_TO_STRING_ALL, NULL, 0));
-		cache_op = nmp_cache_remove (priv->cache, obj, TRUE, &obj_cache, &was_visible, cache_pre_hook, platform);
-		do_emit_signal (platform, obj_cache, cache_op, was_visible);
+		g_hash_table_unref (prune_candidates);
 	}
-
-	g_hash_table_unref (prune_candidates);
 }
 
 static void
@@ -3279,7 +3585,6 @@ cache_pre_hook (NMPCache *cache, const NMPObject *old, const NMPObject *new, NMP
 		{
 			int ifindex = 0;
 
-			/* if we remove a link (from netlink), we must refresh the addresses and routes */
 			if (   ops_type == NMP_CACHE_OPS_REMOVED
 			    && old /* <-- nonsensical, make coverity happy */)
 				ifindex = old->link.ifindex;
@@ -3289,14 +3594,14 @@ cache_pre_hook (NMPCache *cache, const NMPObject *old, const NMPObject *new, NMP
 			         && new->_link.netlink.is_in_netlink != old->_link.netlink.is_in_netlink)
 				ifindex = new->link.ifindex;
 
-			if (ifindex > 0) {
-				delayed_action_schedule (platform,
-				                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ADDRESSES |
-				                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ADDRESSES |
-				                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ROUTES |
-				                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ROUTES,
-				                         NULL);
-			}
+			/* if we remove a link (from netlink), all addresses and routes on that
+			 * ifindex are gone too. Kernel does not notify us about all of them
+			 * (e.g. IPv4 routes), but there is no need to re-dump the complete
+			 * tables of every interface to find out. Only prune the objects of
+			 * this ifindex. If kernel meanwhile reused the ifindex, the new objects
+			 * are dropped from the candidates when their events arrive. */
+			if (ifindex > 0)
+				cache_prune_candidates_record_addrroute_by_ifindex (platform, ifindex);
 		}
 		{
 			int ifindex = -1;
@@ -3330,6 +3635,14 @@ cache_pre_hook (NMPCache *cache, const NMPObject *old, const NMPObject *new, NMP
 				}
 			}
 		}
+		{
+			/* the sysctl directories of a removed or renamed link are gone. */
+			if (   old
+			    && (   !new
+			        || !new->_link.netlink.is_in_netlink
+			        || strcmp (old->link.name, new->link.name) != 0))
+				_sysctl_dirfds_forget_ifname (platform, old->link.name);
+		}
 		{
 			/* if a link goes down, we must refresh routes */
 			if (   ops_type == NMP_CACHE_OPS_UPDATED
@@ -3501,6 +3814,7 @@ _nl_send_auto_with_seq (NMPlatform *platform,
                         gint *out_refresh_all_in_progess)
 {
 	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	NlSockIdx sock_idx;
 	guint32 seq;
 	int nle;
 
@@ -3509,11 +3823,12 @@ _nl_send_auto_with_seq (NMPlatform *platform,
 
 	nlmsg_hdr (nlmsg)->nlmsg_seq = seq;
 
-	nle = nl_send_auto (priv->nlh, nlmsg);
+	sock_idx = _nl_sock_idx_from_nlmsg (nlmsg_hdr (nlmsg));
+	nle = nl_send_auto (priv->nl_socks[sock_idx].nlh, nlmsg);
 
 	if (nle >= 0) {
 		nle = 0;
-		delayed_action_schedule_WAIT_FOR_NL_RESPONSE (platform, seq, out_seq_result, out_refresh_all_in_progess);
+		delayed_action_schedule_WAIT_FOR_NL_RESPONSE (platform, sock_idx, seq, out_seq_result, out_refresh_all_in_progess);
 	} else
 		_LOGD ("netlink: send: failed sending message: %s (%d)", nl_geterror (nle), nle);
 
@@ -3622,13 +3937,14 @@ do_request_one_type (NMPlatform *platform, NMPObjectType obj_type)
 }
 
 static void
-event_seq_check_refresh_all (NMPlatform *platform, guint32 seq_number)
+event_seq_check_refresh_all (NMPlatform *platform, NlSockIdx sock_idx, guint32 seq_number)
 {
 	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	NlSock *sock = &priv->nl_socks[sock_idx];
 	DelayedActionWaitForNlResponseData *data;
 	guint i;
 
-	if (NM_IN_SET (seq_number, 0, priv->nlh_seq_last_seen))
+	if (NM_IN_SET (seq_number, 0, sock->seq_last_seen))
 		return;
 
 	if (NM_FLAGS_HAS (priv->delayed_action.flags, DELAYED_ACTION_TYPE_WAIT_FOR_NL_RESPONSE)) {
@@ -3637,7 +3953,7 @@ event_seq_check_refresh_all (NMPlatform *platform, guint32 seq_number)
 		for (i = 0; i < priv->delayed_action.list_wait_for_nl_response->len; i++) {
 			data = &g_array_index (priv->delayed_action.list_wait_for_nl_response, DelayedActionWaitForNlResponseData, i);
 
-			if (data->seq_number == priv->nlh_seq_last_seen) {
+			if (data->seq_number == sock->seq_last_seen) {
 				if (data->out_refresh_all_in_progess) {
 					nm_assert (*data->out_refresh_all_in_progess > 0);
 					*data->out_refresh_all_in_progess -= 1;
@@ -3648,11 +3964,11 @@ event_seq_check_refresh_all (NMPlatform *platform, guint32 seq_number)
 		}
 	}
 
-	priv->nlh_seq_last_seen = seq_number;
+	sock->seq_last_seen = seq_number;
 }
 
 static void
-event_seq_check (NMPlatform *platform, guint32 seq_number, WaitForNlResponseResult seq_result)
+event_seq_check (NMPlatform *platform, NlSockIdx sock_idx, guint32 seq_number, WaitForNlResponseResult seq_result)
 {
 	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
 	DelayedActionWaitForNlResponseData *data;
@@ -3682,9 +3998,9 @@ event_seq_check (NMPlatform *platform, guint32 seq_number, WaitForNlResponseResu
 	}
 
 #ifdef NM_MORE_LOGGING
-	if (seq_number != priv->nlh_seq_last_handled)
+	if (seq_number != priv->nl_socks[sock_idx].seq_last_handled)
 		_LOGt ("netlink: recvmsg: unwaited sequence number %u", seq_number);
-	priv->nlh_seq_last_handled = seq_number;
+	priv->nl_socks[sock_idx].seq_last_handled = seq_number;
 #endif
 }
 
@@ -3699,6 +4015,7 @@ event_valid_msg (NMPlatform *platform, struct nl_msg *msg, gboolean handle_event
 	char buf_nlmsg_type[16];
 	gboolean id_only = FALSE;
 	gboolean was_visible;
+	int i;
 
 	msghdr = nlmsg_hdr (msg);
 
@@ -3727,6 +4044,17 @@ event_valid_msg (NMPlatform *platform, struct nl_msg *msg, gboolean handle_event
 	       msghdr->nlmsg_seq, nmp_object_to_string (obj,
 	           id_only ? NMP_OBJECT_TO_STRING_ID : NMP_OBJECT_TO_STRING_PUBLIC, NULL, 0));
 
+	if (msghdr->nlmsg_type == RTM_DELLINK) {
+		/* removing the link prunes its routes, but they are received on
+		 * other sockets. First handle the route events that kernel sent
+		 * before removing the link. When received later, they would keep
+		 * the dead routes in the cache. */
+		for (i = 0; i < _NL_SOCK_IDX_NUM; i++) {
+			if (i != NL_SOCK_IDX_LINK)
+				event_handler_read_netlink_sock (platform, i);
+		}
+	}
+
 	switch (msghdr->nlmsg_type) {
 
 	case RTM_NEWLINK:
@@ -3987,6 +4315,30 @@ do_add_addrroute (NMPlatform *platform, const NMPObject *obj_id, struct nl_msg *
 	return obj && seq_result == WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_OK;
 }
 
+static gboolean
+_delete_seq_result_is_success (const NMPObject *obj_id, WaitForNlResponseResult seq_result, const char **out_log_detail)
+{
+	const char *log_detail = "";
+	gboolean success = TRUE;
+
+	if (seq_result == WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_OK) {
+		/* ok */
+	} else if (NM_IN_SET (-((int) seq_result), ESRCH, ENOENT))
+		log_detail = ", meaning the object was already removed";
+	else if (   NM_IN_SET (-((int) seq_result), ENXIO)
+	         && NM_IN_SET (NMP_OBJECT_GET_TYPE (obj_id), NMP_OBJECT_TYPE_IP6_ADDRESS)) {
+		/* On RHEL7 kernel, deleting a non existing address fails with ENXIO */
+		log_detail = ", meaning the address was already removed";
+	} else if (   NM_IN_SET (-((int) seq_result), EADDRNOTAVAIL)
+	           && NM_IN_SET (NMP_OBJECT_GET_TYPE (obj_id), NMP_OBJECT_TYPE_IP4_ADDRESS, NMP_OBJECT_TYPE_IP6_ADDRESS))
+		log_detail = ", meaning the address was already removed";
+	else
+		success = FALSE;
+
+	NM_SET_OUT (out_log_detail, log_detail);
+	return success;
+}
+
 static gboolean
 do_delete_object (NMPlatform *platform, const NMPObject *obj_id, struct nl_msg *nlmsg)
 {
@@ -4012,19 +4364,7 @@ do_delete_object (NMPlatform *platform, const NMPObject *obj_id, struct nl_msg *
 
 	nm_assert (seq_result);
 
-	if (seq_result == WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_OK) {
-		/* ok */
-	} else if (NM_IN_SET (-((int) seq_result), ESRCH, ENOENT))
-		log_detail = ", meaning the object was already removed";
-	else if (   NM_IN_SET (-((int) seq_result), ENXIO)
-	         && NM_IN_SET (NMP_OBJECT_GET_TYPE (obj_id), NMP_OBJECT_TYPE_IP6_ADDRESS)) {
-		/* On RHEL7 kernel, deleting a non existing address fails with ENXIO */
-		log_detail = ", meaning the address was already removed";
-	} else if (   NM_IN_SET (-((int) seq_result), EADDRNOTAVAIL)
-	           && NM_IN_SET (NMP_OBJECT_GET_TYPE (obj_id), NMP_OBJECT_TYPE_IP4_ADDRESS, NMP_OBJECT_TYPE_IP6_ADDRESS))
-		log_detail = ", meaning the address was already removed";
-	else
-		success = FALSE;
+	success = _delete_seq_result_is_success (obj_id, seq_result, &log_detail);
 
 	_NMLOG (success ? LOGL_DEBUG : LOGL_ERR,
 	        "do-delete-%s[%s]: %s%s",
@@ -5847,6 +6187,348 @@ ip6_route_get (NMPlatform *platform, int ifindex, struct in6_addr network, guint
 	return NULL;
 }
 
+static const NMPlatformIP4Route *
+ip4_route_get_lpm (NMPlatform *platform, int ifindex, in_addr_t host, gboolean without_gateway)
+{
+	const NMPObject *obj;
+
+	obj = nmp_cache_lookup_route_lpm (NM_LINUX_PLATFORM_GET_PRIVATE (platform)->cache,
+	                                  NMP_OBJECT_TYPE_IP4_ROUTE, &host, ifindex, without_gateway);
+	return obj ? &obj->ip4_route : NULL;
+}
+
+static const NMPlatformIP6Route *
+ip6_route_get_lpm (NMPlatform *platform, int ifindex, const struct in6_addr *host, gboolean without_gateway)
+{
+	const NMPObject *obj;
+
+	obj = nmp_cache_lookup_route_lpm (NM_LINUX_PLATFORM_GET_PRIVATE (platform)->cache,
+	                                  NMP_OBJECT_TYPE_IP6_ROUTE, host, ifindex, without_gateway);
+	return obj ? &obj->ip6_route : NULL;
+}
+
+/******************************************************************/
+
+/* limit the number of requests that are in flight at the same time. Kernel
+ * handles the messages of one sendmsg() call in order and acknowledges each
+ * of them separately. */
+#define BATCH_MAX_MSGS          256
+#define BATCH_MAX_BUF_SIZE      (32 * 1024)
+
+static void
+_batch_op_stackinit_id (NMPObject *obj_id, const NMPlatformBatchOp *op)
+{
+	nmp_object_stackinit_id (obj_id, op->obj);
+	if (   NMP_OBJECT_GET_TYPE (obj_id) == NMP_OBJECT_TYPE_IP6_ROUTE
+	    && op->op_type == NM_PLATFORM_BATCH_OP_DELETE)
+		obj_id->ip6_route.metric = nm_utils_ip6_route_metric_normalize (obj_id->ip6_route.metric);
+}
+
+static struct nl_msg *
+_nl_msg_new_from_batch_op (const NMPlatformBatchOp *op)
+{
+	const NMPObject *obj = op->obj;
+	gboolean is_add = (op->op_type == NM_PLATFORM_BATCH_OP_ADD);
+
+	switch (NMP_OBJECT_GET_TYPE (obj)) {
+	case NMP_OBJECT_TYPE_IP4_ADDRESS:
+		if (is_add) {
+			return _nl_msg_new_address (RTM_NEWADDR,
+			                            NLM_F_CREATE | NLM_F_REPLACE,
+			                            AF_INET,
+			                            obj->ip4_address.ifindex,
+			                            &obj->ip4_address.address,
+			                            obj->ip4_address.plen,
+			                            &obj->ip4_address.peer_address,
+			                            obj->ip4_address.n_ifa_flags,
+			                            nm_utils_ip4_address_is_link_local (obj->ip4_address.address) ? RT_SCOPE_LINK : RT_SCOPE_UNIVERSE,
+			                            obj->ip4_address.lifetime,
+			                            obj->ip4_address.preferred,
+			                            obj->ip4_address.label);
+		}
+		return _nl_msg_new_address (RTM_DELADDR,
+		                            0,
+		                            AF_INET,
+		                            obj->ip4_address.ifindex,
+		                            &obj->ip4_address.address,
+		                            obj->ip4_address.plen,
+		                            &obj->ip4_address.peer_address,
+		                            0,
+		                            RT_SCOPE_NOWHERE,
+		                            NM_PLATFORM_LIFETIME_PERMANENT,
+		                            NM_PLATFORM_LIFETIME_PERMANENT,
+		                            NULL);
+	case NMP_OBJECT_TYPE_IP6_ADDRESS:
+		if (is_add) {
+			return _nl_msg_new_address (RTM_NEWADDR,
+			                            NLM_F_CREATE | NLM_F_REPLACE,
+			                            AF_INET6,
+			                            obj->ip6_address.ifindex,
+			                            &obj->ip6_address.address,
+			                            obj->ip6_address.plen,
+			                            &obj->ip6_address.peer_address,
+			                            obj->ip6_address.n_ifa_flags,
+			                            RT_SCOPE_UNIVERSE,
+			                            obj->ip6_address.lifetime,
+			                            obj->ip6_address.preferred,
+			                            NULL);
+		}
+		return _nl_msg_new_address (RTM_DELADDR,
+		                            0,
+		                            AF_INET6,
+		                            obj->ip6_address.ifindex,
+		                            &obj->ip6_address.address,
+		                            obj->ip6_address.plen,
+		                            NULL,
+		                            0,
+		                            RT_SCOPE_NOWHERE,
+		                            NM_PLATFORM_LIFETIME_PERMANENT,
+		                            NM_PLATFORM_LIFETIME_PERMANENT,
+		                            NULL);
+	case NMP_OBJECT_TYPE_IP4_ROUTE:
+		if (is_add) {
+			return _nl_msg_new_route (RTM_NEWROUTE,
+			                          NLM_F_CREATE | NLM_F_REPLACE,
+			                          AF_INET,
+			                          obj->ip4_route.ifindex,
+			                          obj->ip4_route.rt_source,
+			                          obj->ip4_route.gateway ? RT_SCOPE_UNIVERSE : RT_SCOPE_LINK,
+			                          &obj->ip4_route.network,
+			                          obj->ip4_route.plen,
+			                          &obj->ip4_route.gateway,
+			                          obj->ip4_route.metric,
+			                          obj->ip4_route.mss,
+			                          obj->ip4_route.pref_src ? &obj->ip4_route.pref_src : NULL);
+		}
+		return _nl_msg_new_route (RTM_DELROUTE,
+		                          0,
+		                          AF_INET,
+		                          obj->ip4_route.ifindex,
+		                          NM_IP_CONFIG_SOURCE_UNKNOWN,
+		                          RT_SCOPE_NOWHERE,
+		                          &obj->ip4_route.network,
+		                          obj->ip4_route.plen,
+		                          NULL,
+		                          obj->ip4_route.metric,
+		                          0,
+		                          NULL);
+	case NMP_OBJECT_TYPE_IP6_ROUTE:
+		if (is_add) {
+			return _nl_msg_new_route (RTM_NEWROUTE,
+			                          NLM_F_CREATE | NLM_F_REPLACE,
+			                          AF_INET6,
+			                          obj->ip6_route.ifindex,
+			                          obj->ip6_route.rt_source,
+			                          !IN6_IS_ADDR_UNSPECIFIED (&obj->ip6_route.gateway) ? RT_SCOPE_UNIVERSE : RT_SCOPE_LINK,
+			                          &obj->ip6_route.network,
+			                          obj->ip6_route.plen,
+			                          &obj->ip6_route.gateway,
+			                          obj->ip6_route.metric,
+			                          obj->ip6_route.mss,
+			                          NULL);
+		}
+		return _nl_msg_new_route (RTM_DELROUTE,
+		                          0,
+		                          AF_INET6,
+		                          obj->ip6_route.ifindex,
+		                          NM_IP_CONFIG_SOURCE_UNKNOWN,
+		                          RT_SCOPE_NOWHERE,
+		                          &obj->ip6_route.network,
+		                          obj->ip6_route.plen,
+		                          NULL,
+		                          nm_utils_ip6_route_metric_normalize (obj->ip6_route.metric),
+		                          0,
+		                          NULL);
+	default:
+		g_return_val_if_reached (NULL);
+	}
+}
+
+static void
+_batch_send_chunk (NMPlatform *platform,
+                   NMPlatformBatchOp *ops,
+                   WaitForNlResponseResult *seq_results,
+                   guint n_ops,
+                   guint *p_idx)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	gs_free guint8 *buf = NULL;
+	gs_free guint32 *seqs = NULL;
+	gs_free guint *idxs = NULL;
+	NlSockIdx sock_idx = NL_SOCK_IDX_LINK;
+	gsize buf_len = 0;
+	guint n_msgs = 0;
+	guint i;
+	int nle;
+
+	buf = g_malloc (BATCH_MAX_BUF_SIZE);
+	seqs = g_new (guint32, BATCH_MAX_MSGS);
+	idxs = g_new (guint, BATCH_MAX_MSGS);
+
+	for (i = *p_idx; i < n_ops && n_msgs < BATCH_MAX_MSGS; i++) {
+		nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
+		struct nlmsghdr *hdr;
+		gsize msg_len;
+		guint32 seq;
+
+		if (seq_results[i] != WAIT_FOR_NL_RESPONSE_RESULT_UNKNOWN) {
+			/* the operation is already completed without sending a request. */
+			continue;
+		}
+
+		nlmsg = _nl_msg_new_from_batch_op (&ops[i]);
+		if (!nlmsg) {
+			seq_results[i] = WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_UNKNOWN;
+			continue;
+		}
+
+		hdr = nlmsg_hdr (nlmsg);
+
+		if (n_msgs == 0)
+			sock_idx = _nl_sock_idx_from_nlmsg (hdr);
+		else if (sock_idx != _nl_sock_idx_from_nlmsg (hdr)) {
+			/* the request goes to another socket. Send it with the next chunk. */
+			break;
+		}
+
+		msg_len = NLMSG_ALIGN (hdr->nlmsg_len);
+		if (buf_len + msg_len > BATCH_MAX_BUF_SIZE) {
+			if (buf_len == 0) {
+				/* cannot happen for addresses and routes. */
+				seq_results[i] = WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_UNKNOWN;
+				continue;
+			}
+			/* the buffer is full. Send this message with the next chunk. */
+			break;
+		}
+
+		/* complete the message with a sequence number (ensuring it's not zero). */
+		seq = priv->nlh_seq_next++ ?: priv->nlh_seq_next++;
+		hdr->nlmsg_seq = seq;
+		nl_complete_msg (priv->nl_socks[sock_idx].nlh, nlmsg);
+
+		memcpy (&buf[buf_len], hdr, hdr->nlmsg_len);
+		memset (&buf[buf_len + hdr->nlmsg_len], 0, msg_len - hdr->nlmsg_len);
+		buf_len += msg_len;
+
+		seqs[n_msgs] = seq;
+		idxs[n_msgs] = i;
+		n_msgs++;
+	}
+	*p_idx = i;
+
+	if (n_msgs == 0)
+		return;
+
+	nle = nl_sendto (priv->nl_socks[sock_idx].nlh, buf, buf_len);
+	if (nle < 0) {
+		_LOGE ("batch: failure sending %u netlink requests \"%s\" (%d)",
+		       n_msgs, nl_geterror (nle), -nle);
+		for (i = 0; i < n_msgs; i++)
+			seq_results[idxs[i]] = WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_UNKNOWN;
+		return;
+	}
+
+	_LOGT ("batch: sent %u netlink requests (%zu bytes) on %s socket", n_msgs, buf_len, nl_sock_infos[sock_idx].name);
+
+	for (i = 0; i < n_msgs; i++)
+		delayed_action_schedule_WAIT_FOR_NL_RESPONSE (platform, sock_idx, seqs[i], &seq_results[idxs[i]], NULL);
+}
+
+static void
+batch_commit (NMPlatform *platform, NMPlatformBatchOp *ops, guint n_ops)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	gs_free WaitForNlResponseResult *seq_results = NULL;
+	DelayedActionType refetch_types = DELAYED_ACTION_TYPE_NONE;
+	gboolean refreshed_ip4_routes = FALSE;
+	gboolean refetched_ip4_routes = FALSE;
+	char s_buf[256];
+	NMPObject obj_id;
+	guint i;
+
+	seq_results = g_new0 (WaitForNlResponseResult, n_ops);
+
+	/* Deleting an IPv4 route with metric 0 might delete another route to the same
+	 * destination. Like ip4_route_delete(), only send such a request if the route
+	 * really exists. Refresh the cache only once for the entire batch. */
+	for (i = 0; i < n_ops; i++) {
+		if (   ops[i].op_type != NM_PLATFORM_BATCH_OP_DELETE
+		    || NMP_OBJECT_GET_TYPE (ops[i].obj) != NMP_OBJECT_TYPE_IP4_ROUTE
+		    || ops[i].obj->ip4_route.metric != 0)
+			continue;
+
+		if (!refreshed_ip4_routes) {
+			delayed_action_handle_all (platform, TRUE);
+			refreshed_ip4_routes = TRUE;
+		}
+
+		_batch_op_stackinit_id (&obj_id, &ops[i]);
+		if (nmp_cache_lookup_obj (priv->cache, &obj_id))
+			continue;
+
+		if (!refetched_ip4_routes) {
+			do_request_one_type (platform, NMP_OBJECT_TYPE_IP4_ROUTE);
+			refetched_ip4_routes = TRUE;
+			if (nmp_cache_lookup_obj (priv->cache, &obj_id))
+				continue;
+		}
+		seq_results[i] = WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_OK;
+	}
+
+	i = 0;
+	while (i < n_ops) {
+		event_handler_read_netlink (platform, FALSE);
+		_batch_send_chunk (platform, ops, seq_results, n_ops, &i);
+		delayed_action_handle_all (platform, FALSE);
+	}
+
+	/* In rare cases, an added object is not yet in the cache when we receive the
+	 * ACK, or a deleted object is still there. Refetch each affected object type
+	 * at most once (see do_add_addrroute() and do_delete_object()). */
+	for (i = 0; i < n_ops; i++) {
+		gboolean in_cache;
+
+		_batch_op_stackinit_id (&obj_id, &ops[i]);
+		in_cache = !!nmp_cache_lookup_obj (priv->cache, &obj_id);
+		if (in_cache != (ops[i].op_type == NM_PLATFORM_BATCH_OP_ADD))
+			refetch_types |= delayed_action_refresh_from_object_type (NMP_OBJECT_GET_TYPE (ops[i].obj));
+	}
+	if (refetch_types) {
+		do_request_all_no_delayed_actions (platform, refetch_types);
+		delayed_action_handle_all (platform, FALSE);
+	}
+
+	for (i = 0; i < n_ops; i++) {
+		const char *log_detail = "";
+		gboolean in_cache;
+		gboolean ack_ok;
+
+		nm_assert (seq_results[i]);
+
+		_batch_op_stackinit_id (&obj_id, &ops[i]);
+		in_cache = !!nmp_cache_lookup_obj (priv->cache, &obj_id);
+
+		if (ops[i].op_type == NM_PLATFORM_BATCH_OP_ADD) {
+			ack_ok = (seq_results[i] == WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_OK);
+			/* Adding is only successful, if kernel reported success *and* we have the
+			 * expected object in cache afterwards. */
+			ops[i].success = ack_ok && in_cache;
+		} else {
+			ack_ok = _delete_seq_result_is_success (&obj_id, seq_results[i], &log_detail);
+			ops[i].success = !in_cache;
+		}
+
+		_NMLOG (ack_ok ? LOGL_DEBUG : LOGL_ERR,
+		        "do-%s-%s[%s]: %s%s",
+		        ops[i].op_type == NM_PLATFORM_BATCH_OP_ADD ? "add" : "delete",
+		        NMP_OBJECT_GET_CLASS (&obj_id)->obj_type_name,
+		        nmp_object_to_string (&obj_id, NMP_OBJECT_TO_STRING_ID, NULL, 0),
+		        wait_for_nl_response_to_string (seq_results[i], s_buf, sizeof (s_buf)),
+		        log_detail);
+	}
+}
+
 /******************************************************************/
 
 #define EVENT_CONDITIONS      ((GIOCondition) (G_IO_IN | G_IO_PRI))
@@ -5864,59 +6546,157 @@ event_handler (GIOChannel *channel,
 
 /*****************************************************************************/
 
-/* copied from libnl3's recvmsgs() */
+static void
+_nl_recv_ring_slot_init (NlRecvRing *ring, guint i, unsigned char *buf, gsize len)
+{
+	NlRecvRingSlot *slot = &ring->slots[i];
+	struct msghdr *mhdr = &ring->msgs[i].msg_hdr;
+
+	slot->iov.iov_base = buf;
+	slot->iov.iov_len = len;
+
+	memset (mhdr, 0, sizeof (*mhdr));
+	mhdr->msg_name = &slot->nla;
+	mhdr->msg_namelen = sizeof (slot->nla);
+	mhdr->msg_iov = &slot->iov;
+	mhdr->msg_iovlen = 1;
+	mhdr->msg_control = slot->ctrl.buf;
+	mhdr->msg_controllen = sizeof (slot->ctrl.buf);
+	ring->msgs[i].msg_len = 0;
+}
+
+static int
+_nl_recv_ring_error (int errsv)
+{
+	if (errsv == EAGAIN || errsv == EWOULDBLOCK)
+		return -NLE_AGAIN;
+	if (errsv == ENOBUFS) {
+		/* we are very much interested in a overrun of the receive buffer.
+		 * Return our own error code to signal the overrun. */
+		return -_NLE_NM_NOBUFS;
+	}
+	return -nl_syserr2nlerr (errsv);
+}
+
+/* Returns the next datagram from the event socket @sock_idx.
+ *
+ * Instead of nl_recv(), which peeks and allocates a new buffer for every
+ * datagram, fetch up to %NL_RECV_RING_SLOTS datagrams with a single
+ * recvmmsg() into buffers that are allocated once per socket.
+ * During a burst of events this empties the kernel queue faster and
+ * makes overruns of the socket less likely.
+ *
+ * recvmmsg() cannot tell the size of a datagram before consuming it, so a
+ * datagram larger than a slot is truncated and lost. When that happens,
+ * it is reported as an overrun and the slots grow to fit the datagram,
+ * whose full length netlink reports with MSG_TRUNC. The resync then
+ * receives the large messages in full, still in batches.
+ *
+ * The returned @out_buf and @out_creds point into the ring and stay valid
+ * until the next call.
+ *
+ * Returns the length of the datagram or a negative libnl error code.
+ * An overrun of the receive buffer is signalled by -_NLE_NM_NOBUFS. */
+static int
+_nl_recv_ring_next (NMPlatform *platform,
+                    NlSockIdx sock_idx,
+                    struct sockaddr_nl *out_nla,
+                    const struct ucred **out_creds,
+                    unsigned char **out_buf)
+{
+	NlSock *sock = &NM_LINUX_PLATFORM_GET_PRIVATE (platform)->nl_socks[sock_idx];
+	NlRecvRing *ring;
+	NlRecvRingSlot *slot;
+	struct msghdr *mhdr;
+	struct cmsghdr *cmsg;
+	int r, errsv;
+	guint i;
+
+	ring = sock->recv_ring;
+	if (!ring) {
+		ring = g_new (NlRecvRing, 1);
+		ring->n_filled = 0;
+		ring->idx = 0;
+		ring->slot_size = 0;
+		ring->slot_size_next = NL_RECV_RING_SLOT_SIZE;
+		ring->data = NULL;
+		sock->recv_ring = ring;
+	}
+
+	if (ring->idx >= ring->n_filled) {
+		ring->n_filled = 0;
+		ring->idx = 0;
+
+		/* the previous datagrams are handed out, the slots can be resized. */
+		if (ring->slot_size != ring->slot_size_next) {
+			g_free (ring->data);
+			ring->slot_size = ring->slot_size_next;
+			ring->data = g_malloc (NL_RECV_RING_SLOTS * ring->slot_size);
+		}
+		for (i = 0; i < NL_RECV_RING_SLOTS; i++)
+			_nl_recv_ring_slot_init (ring, i, &ring->data[i * ring->slot_size], ring->slot_size);
+
+again:
+		r = recvmmsg (nl_socket_get_fd (sock->nlh), ring->msgs, NL_RECV_RING_SLOTS, MSG_TRUNC, NULL);
+		if (r < 0) {
+			errsv = errno;
+			if (errsv == EINTR)
+				goto again;
+			return _nl_recv_ring_error (errsv);
+		}
+		if (r == 0)
+			return -NLE_AGAIN;
+		ring->n_filled = r;
+	}
+
+	i = ring->idx++;
+	slot = &ring->slots[i];
+	mhdr = &ring->msgs[i].msg_hdr;
+
+	if (NM_FLAGS_HAS (mhdr->msg_flags, MSG_TRUNC)) {
+		gsize size = ring->slot_size;
+
+		/* the datagram was larger than its slot and the tail is lost. That
+		 * is no different from an overrun, we missed events. With MSG_TRUNC,
+		 * msg_len is the full length. Grow the slots for the next recvmmsg(),
+		 * the remaining datagrams of this one still point into them. */
+		while (size < ring->msgs[i].msg_len)
+			size *= 2;
+		ring->slot_size_next = MAX (ring->slot_size_next, size);
+		_LOGD ("netlink: recvmsg: message of %u bytes on %s socket truncated at %zu bytes, grow buffers to %zu bytes",
+		       ring->msgs[i].msg_len, nl_sock_infos[sock_idx].name, ring->slot_size, ring->slot_size_next);
+		return -_NLE_NM_NOBUFS;
+	}
+
+	*out_creds = NULL;
+	for (cmsg = CMSG_FIRSTHDR (mhdr); cmsg; cmsg = CMSG_NXTHDR (mhdr, cmsg)) {
+		if (   cmsg->cmsg_level == SOL_SOCKET
+		    && cmsg->cmsg_type == SCM_CREDENTIALS) {
+			memcpy (&slot->creds, CMSG_DATA (cmsg), sizeof (slot->creds));
+			*out_creds = &slot->creds;
+			break;
+		}
+	}
+
+	*out_nla = slot->nla;
+	*out_buf = slot->iov.iov_base;
+	return ring->msgs[i].msg_len;
+}
+
+/* Processes the datagrams from _nl_recv_ring_next(). The parsing of the
+ * messages follows libnl3's recvmsgs(). */
 static int
-event_handler_recvmsgs (NMPlatform *platform, gboolean handle_events)
+event_handler_recvmsgs (NMPlatform *platform, NlSockIdx sock_idx, gboolean handle_events)
 {
-	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
-	struct nl_sock *sk = priv->nlh;
 	int n, err = 0, multipart = 0, interrupted = 0;
 	struct nlmsghdr *hdr;
 	WaitForNlResponseResult seq_result;
-
-	/*
-	nla is passed on to not only to nl_recv() but may also be passed
-	to a function pointer provided by the caller which may or may not
-	initialize the variable. Thomas Graf.
-	*/
 	struct sockaddr_nl nla = {0};
-	nm_auto_free struct ucred *creds = NULL;
-	nm_auto_free unsigned char *buf = NULL;
+	const struct ucred *creds;
+	unsigned char *buf;
 
 continue_reading:
-	g_clear_pointer (&buf, free);
-	g_clear_pointer (&creds, free);
-	errno = 0;
-	n = nl_recv (sk, &nla, &buf, &creds);
-
-	if (n <= 0) {
-		/* workaround libnl3 <= 3.2.15 returning danling pointers in case nl_recv()
-		 * fails. Fixed by libnl3 69468517d0de1675d80f24661ff57a5dbac7275c. */
-		buf = NULL;
-		creds = NULL;
-	}
-
-	switch (n) {
-	case 0:
-		/* Work around a libnl bug fixed in 3.2.22 (375a6294) */
-		if (errno == EAGAIN) {
-			/* EAGAIN is equal to EWOULDBLOCK. If it would not be, we'd have to
-			 * workaround libnl3 mapping EWOULDBLOCK to -NLE_FAILURE. */
-			G_STATIC_ASSERT (EAGAIN == EWOULDBLOCK);
-			n = -NLE_AGAIN;
-		}
-		break;
-	case -NLE_NOMEM:
-		if (errno == ENOBUFS) {
-			/* we are very much interested in a overrun of the receive buffer.
-			 * nl_recv() maps all kinds of errors to NLE_NOMEM, so check also
-			 * for errno explicitly. And if so, hack our own return code to signal
-			 * the overrun. */
-			n = -_NLE_NM_NOBUFS;
-		}
-		break;
-	}
-
+	n = _nl_recv_ring_next (platform, sock_idx, &nla, &creds, &buf);
 	if (n <= 0)
 		return n;
 
@@ -6016,13 +6796,13 @@ continue_reading:
 		seq_number = nlmsg_hdr (msg)->nlmsg_seq;
 
 		/* check whether the seq number is different from before, and
-		 * whether the previous number (@nlh_seq_last_seen) is a pending
+		 * whether the previous number (@seq_last_seen of the socket) is a pending
 		 * refresh-all request. In that case, the pending request is thereby
 		 * completed.
 		 *
 		 * We must do that before processing the message with event_valid_msg(),
 		 * because we must track the completion of the pending request before that. */
-		event_seq_check_refresh_all (platform, seq_number);
+		event_seq_check_refresh_all (platform, sock_idx, seq_number);
 
 		if (process_valid_msg) {
 			/* Valid message (not checking for MULTIPART bit to
@@ -6034,7 +6814,7 @@ continue_reading:
 			seq_result = WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_OK;
 		}
 
-		event_seq_check (platform, seq_number, seq_result);
+		event_seq_check (platform, sock_idx, seq_number, seq_result);
 
 		if (abort_parsing)
 			goto stop;
@@ -6062,13 +6842,48 @@ out:
 
 /*****************************************************************************/
 
+/* Reads the events of socket @sock_idx until there are no more. */
+static gboolean
+event_handler_read_netlink_sock (NMPlatform *platform, int sock_idx)
+{
+	int nle;
+	gboolean any = FALSE;
+
+	while (TRUE) {
+
+		nle = event_handler_recvmsgs (platform, sock_idx, TRUE);
+
+		if (nle < 0)
+			switch (nle) {
+			case -NLE_AGAIN:
+				return any;
+			case -NLE_DUMP_INTR:
+				_LOGD ("netlink: read: uncritical failure to retrieve incoming events: %s (%d)", nl_geterror (nle), nle);
+				break;
+			case -_NLE_NM_NOBUFS:
+				_LOGI ("netlink: read: too many netlink events on %s socket. Need to resynchronize platform cache",
+				       nl_sock_infos[sock_idx].name);
+
+				/* only this socket lost events. Re-dump the tables of its groups. */
+				event_handler_recvmsgs (platform, sock_idx, FALSE);
+				delayed_action_wait_for_nl_response_complete_all (platform, sock_idx, WAIT_FOR_NL_RESPONSE_RESULT_FAILED_RESYNC);
+				delayed_action_schedule (platform, nl_sock_infos[sock_idx].refresh_all, NULL);
+				break;
+			default:
+				_LOGE ("netlink: read: failed to retrieve incoming events: %s (%d)", nl_geterror (nle), nle);
+				break;
+		}
+		any = TRUE;
+	}
+}
+
 static gboolean
 event_handler_read_netlink (NMPlatform *platform, gboolean wait_for_acks)
 {
 	nm_auto_pop_netns NMPNetns *netns = NULL;
 	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
-	int r, nle;
-	struct pollfd pfd;
+	int r;
+	struct pollfd pfds[_NL_SOCK_IDX_NUM];
 	gboolean any = FALSE;
 	gint64 now_ns;
 	int timeout_ms;
@@ -6083,34 +6898,9 @@ event_handler_read_netlink (NMPlatform *platform, gboolean wait_for_acks)
 
 	while (TRUE) {
 
-		while (TRUE) {
-
-			nle = event_handler_recvmsgs (platform, TRUE);
-
-			if (nle < 0)
-				switch (nle) {
-				case -NLE_AGAIN:
-					goto after_read;
-				case -NLE_DUMP_INTR:
-					_LOGD ("netlink: read: uncritical failure to retrieve incoming events: %s (%d)", nl_geterror (nle), nle);
-					break;
-				case -_NLE_NM_NOBUFS:
-					_LOGI ("netlink: read: too many netlink events. Need to resynchronize platform cache");
-					event_handler_recvmsgs (platform, FALSE);
-					delayed_action_wait_for_nl_response_complete_all (platform, WAIT_FOR_NL_RESPONSE_RESULT_FAILED_RESYNC);
-					delayed_action_schedule (platform,
-					                         DELAYED_ACTION_TYPE_REFRESH_ALL_LINKS |
-					                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ADDRESSES |
-					                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ADDRESSES |
-					                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ROUTES |
-					                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ROUTES,
-					                         NULL);
-					break;
-				default:
-					_LOGE ("netlink: read: failed to retrieve incoming events: %s (%d)", nl_geterror (nle), nle);
-					break;
-			}
-			any = TRUE;
+		for (i = 0; i < _NL_SOCK_IDX_NUM; i++) {
+			if (event_handler_read_netlink_sock (platform, i))
+				any = TRUE;
 		}
 
 after_read:
@@ -6152,10 +6942,12 @@ after_read:
 
 		timeout_ms = (data_next.timeout_abs_ns - now_ns) / (NM_UTILS_NS_PER_SECOND / 1000);
 
-		memset (&pfd, 0, sizeof (pfd));
-		pfd.fd = nl_socket_get_fd (priv->nlh);
-		pfd.events = POLLIN;
-		r = poll (&pfd, 1, MAX (1, timeout_ms));
+		memset (pfds, 0, sizeof (pfds));
+		for (i = 0; i < _NL_SOCK_IDX_NUM; i++) {
+			pfds[i].fd = nl_socket_get_fd (priv->nl_socks[i].nlh);
+			pfds[i].events = POLLIN;
+		}
+		r = poll (pfds, _NL_SOCK_IDX_NUM, MAX (1, timeout_ms));
 
 		if (r == 0) {
 			/* timeout and there is nothing to read. */
@@ -6166,7 +6958,7 @@ after_read:
 
 			if (errsv != EINTR) {
 				_LOGE ("netlink: read: poll failed with %s", strerror (errsv));
-				delayed_action_wait_for_nl_response_complete_all (platform, WAIT_FOR_NL_RESPONSE_RESULT_FAILED_POLL);
+				delayed_action_wait_for_nl_response_complete_all (platform, -1, WAIT_FOR_NL_RESPONSE_RESULT_FAILED_POLL);
 				return any;
 			}
 			/* Continue to read again, even if there might be nothing to read after EINTR. */
@@ -6322,6 +7114,7 @@ constructed (GObject *_object)
 	int channel_flags;
 	gboolean status;
 	int nle;
+	guint i;
 
 	nm_assert (!platform->_netns || platform->_netns == nmp_netns_get_current ());
 
@@ -6336,41 +7129,46 @@ constructed (GObject *_object)
 	                                   nmp_netns_get_current () == nmp_netns_get_initial () ? "/main" : "")),
 	       nmp_cache_use_udev_get (priv->cache) ? "use" : "no");
 
-	priv->nlh = nl_socket_alloc ();
-	g_assert (priv->nlh);
-
-	nle = nl_connect (priv->nlh, NETLINK_ROUTE);
-	g_assert (!nle);
-	nle = nl_socket_set_passcred (priv->nlh, 1);
-	g_assert (!nle);
-
-	/* No blocking for event socket, so that we can drain it safely. */
-	nle = nl_socket_set_nonblocking (priv->nlh);
-	g_assert (!nle);
-
-	/* use 8 MB for receive socket kernel queue. */
-	nle = nl_socket_set_buffer_size (priv->nlh, 8*1024*1024, 0);
-	g_assert (!nle);
-
-	nle = nl_socket_add_memberships (priv->nlh,
-	                                 RTNLGRP_LINK,
-	                                 RTNLGRP_IPV4_IFADDR, RTNLGRP_IPV6_IFADDR,
-	                                 RTNLGRP_IPV4_ROUTE,  RTNLGRP_IPV6_ROUTE,
-	                                 0);
-	g_assert (!nle);
-	_LOGD ("Netlink socket for events established: port=%u, fd=%d", nl_socket_get_local_port (priv->nlh), nl_socket_get_fd (priv->nlh));
-
-	priv->event_channel = g_io_channel_unix_new (nl_socket_get_fd (priv->nlh));
-	g_io_channel_set_encoding (priv->event_channel, NULL, NULL);
-	g_io_channel_set_close_on_unref (priv->event_channel, TRUE);
-
-	channel_flags = g_io_channel_get_flags (priv->event_channel);
-	status = g_io_channel_set_flags (priv->event_channel,
-	                                 channel_flags | G_IO_FLAG_NONBLOCK, NULL);
-	g_assert (status);
-	priv->event_id = g_io_add_watch (priv->event_channel,
-	                                (EVENT_CONDITIONS | ERROR_CONDITIONS | DISCONNECT_CONDITIONS),
-	                                 event_handler, platform);
+	for (i = 0; i < _NL_SOCK_IDX_NUM; i++) {
+		NlSock *sock = &priv->nl_socks[i];
+		guint j;
+
+		sock->nlh = nl_socket_alloc ();
+		g_assert (sock->nlh);
+
+		nle = nl_connect (sock->nlh, NETLINK_ROUTE);
+		g_assert (!nle);
+		nle = nl_socket_set_passcred (sock->nlh, 1);
+		g_assert (!nle);
+
+		/* No blocking for event socket, so that we can drain it safely. */
+		nle = nl_socket_set_nonblocking (sock->nlh);
+		g_assert (!nle);
+
+		/* use 8 MB for receive socket kernel queue. */
+		nle = nl_socket_set_buffer_size (sock->nlh, 8*1024*1024, 0);
+		g_assert (!nle);
+
+		for (j = 0; nl_sock_infos[i].groups[j]; j++) {
+			nle = nl_socket_add_membership (sock->nlh, nl_sock_infos[i].groups[j]);
+			g_assert (!nle);
+		}
+		_LOGD ("Netlink socket for %s events established: port=%u, fd=%d",
+		       nl_sock_infos[i].name,
+		       nl_socket_get_local_port (sock->nlh), nl_socket_get_fd (sock->nlh));
+
+		sock->event_channel = g_io_channel_unix_new (nl_socket_get_fd (sock->nlh));
+		g_io_channel_set_encoding (sock->event_channel, NULL, NULL);
+		g_io_channel_set_close_on_unref (sock->event_channel, TRUE);
+
+		channel_flags = g_io_channel_get_flags (sock->event_channel);
+		status = g_io_channel_set_flags (sock->event_channel,
+		                                 channel_flags | G_IO_FLAG_NONBLOCK, NULL);
+		g_assert (status);
+		sock->event_id = g_io_add_watch (sock->event_channel,
+		                                 (EVENT_CONDITIONS | ERROR_CONDITIONS | DISCONNECT_CONDITIONS),
+		                                 event_handler, platform);
+	}
 
 	/* complete construction of the GObject instance before populating the cache. */
 	G_OBJECT_CLASS (nm_linux_platform_parent_class)->constructed (_object);
@@ -6417,7 +7215,7 @@ dispose (GObject *object)
 
 	_LOGD ("dispose");
 
-	delayed_action_wait_for_nl_response_complete_all (platform, WAIT_FOR_NL_RESPONSE_RESULT_FAILED_DISPOSING);
+	delayed_action_wait_for_nl_response_complete_all (platform, -1, WAIT_FOR_NL_RESPONSE_RESULT_FAILED_DISPOSING);
 
 	priv->delayed_action.flags = DELAYED_ACTION_TYPE_NONE;
 	g_ptr_array_set_size (priv->delayed_action.list_master_connected, 0);
@@ -6437,6 +7235,7 @@ static void
 nm_linux_platform_finalize (GObject *object)
 {
 	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (object);
+	guint i;
 
 	nmp_cache_free (priv->cache);
 
@@ -6445,12 +7244,25 @@ nm_linux_platform_finalize (GObject *object)
 	g_array_unref (priv->delayed_action.list_wait_for_nl_response);
 
 	/* Free netlink resources */
-	g_source_remove (priv->event_id);
-	g_io_channel_unref (priv->event_channel);
-	nl_socket_free (priv->nlh);
+	for (i = 0; i < _NL_SOCK_IDX_NUM; i++) {
+		NlSock *sock = &priv->nl_socks[i];
+
+		g_source_remove (sock->event_id);
+		g_io_channel_unref (sock->event_channel);
+		nl_socket_free (sock->nlh);
+		if (sock->recv_ring) {
+			g_free (sock->recv_ring->data);
+			g_free (sock->recv_ring);
+		}
+	}
 
 	g_hash_table_unref (priv->wifi_data);
 
+	if (priv->sysctl_dirfds) {
+		_sysctl_dirfds_clear (NM_PLATFORM (object));
+		g_hash_table_unref (priv->sysctl_dirfds);
+	}
+
 	if (priv->sysctl_get_prev_values) {
 		sysctl_clear_cache_list = g_slist_remove (sysctl_clear_cache_list, object);
 		g_hash_table_destroy (priv->sysctl_get_prev_values);
@@ -6561,6 +7373,8 @@ nm_linux_platform_class_init (NMLinuxPlatformClass *klass)
 
 	platform_class->ip4_route_get = ip4_route_get;
 	platform_class->ip6_route_get = ip6_route_get;
+	platform_class->ip4_route_get_lpm = ip4_route_get_lpm;
+	platform_class->ip6_route_get_lpm = ip6_route_get_lpm;
 	platform_class->ip4_route_get_all = ip4_route_get_all;
 	platform_class->ip6_route_get_all = ip6_route_get_all;
 	platform_class->ip4_route_add = ip4_route_add;
@@ -6568,6 +7382,8 @@ nm_linux_platform_class_init (NMLinuxPlatformClass *klass)
 	platform_class->ip4_route_delete = ip4_route_delete;
 	platform_class->ip6_route_delete = ip6_route_delete;
 
+	platform_class->batch_commit = batch_commit;
+
 	platform_class->check_support_kernel_extended_ifa_flags = check_support_kernel_extended_ifa_flags;
 	platform_class->check_support_user_ipv6ll = check_support_user_ipv6ll;
 
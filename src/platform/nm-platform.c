@@ -95,6 +95,14 @@ enum {
 
 typedef struct {
 	gboolean register_singleton;
+
+	/* for addresses and routes, a counter per object type that is bumped
+	 * on every change signal of that type. */
+	guint64 generation[NMP_OBJECT_TYPE_MAX + 1];
+
+	/* the NMPlatformSnapshot instances of the current generation, per
+	 * object type. */
+	GHashTable *snapshots[NMP_OBJECT_TYPE_MAX + 1];
 } NMPlatformPrivate;
 
 /******************************************************************/
@@ -2715,62 +2723,88 @@ array_contains_ip6_address (const GArray *addresses, const NMPlatformIP6Address
  * @out_added_addresses: (out): (allow-none): if not %NULL, return a #GPtrArray
  *   with the addresses added. The pointers point into @known_addresses.
  *   It possibly does not contain all addresses from @known_address because
- *   some addresses might be expired.
+ *   some addresses might be expired or could not be added.
  *
  * A convenience function to synchronize addresses for a specific interface
  * with the least possible disturbance. It simply removes addresses that are
  * not listed and adds addresses that are.
  *
- * Returns: %TRUE on success.
+ * All changes are sent to the kernel at once. Thus, when adding an address
+ * fails, the addresses after it are still added.
+ *
+ * Returns: %TRUE on success, %FALSE if any address could not be added.
  */
 gboolean
 nm_platform_ip4_address_sync (NMPlatform *self, int ifindex, const GArray *known_addresses, GPtrArray **out_added_addresses)
 {
+	NMPlatformBatch *batch;
 	GArray *addresses;
 	NMPlatformIP4Address *address;
+	gs_unref_ptrarray GPtrArray *to_add = NULL;
 	gint32 now = nm_utils_get_monotonic_timestamp_s ();
+	gboolean success = TRUE;
+	guint first_add_idx;
 	int i;
 
 	_CHECK_SELF (self, klass, FALSE);
 
+	batch = nm_platform_batch_new (self);
+
 	/* Delete unknown addresses */
 	addresses = nm_platform_ip4_address_get_all (self, ifindex);
 	for (i = 0; i < addresses->len; i++) {
 		address = &g_array_index (addresses, NMPlatformIP4Address, i);
 
 		if (!array_contains_ip4_address (known_addresses, address, now))
-			nm_platform_ip4_address_delete (self, ifindex, address->address, address->plen, address->peer_address);
+			nm_platform_batch_delete (batch, NMP_OBJECT_TYPE_IP4_ADDRESS, (const NMPlatformObject *) address);
 	}
 	g_array_free (addresses, TRUE);
 
 	if (out_added_addresses)
 		*out_added_addresses = NULL;
 
-	if (!known_addresses)
-		return TRUE;
-
 	/* Add missing addresses */
-	for (i = 0; i < known_addresses->len; i++) {
+	first_add_idx = nm_platform_batch_get_len (batch);
+	for (i = 0; known_addresses && i < known_addresses->len; i++) {
 		const NMPlatformIP4Address *known_address = &g_array_index (known_addresses, NMPlatformIP4Address, i);
+		NMPlatformIP4Address a;
 		guint32 lifetime, preferred;
 
 		if (!nm_utils_lifetime_get (known_address->timestamp, known_address->lifetime, known_address->preferred,
 		                            now, &lifetime, &preferred))
 			continue;
 
-		if (!nm_platform_ip4_address_add (self, ifindex, known_address->address, known_address->plen,
-		                                  known_address->peer_address, lifetime, preferred,
-		                                  0, known_address->label))
-			return FALSE;
+		a = *known_address;
+		a.ifindex = ifindex;
+		a.timestamp = 0;
+		a.lifetime = lifetime;
+		a.preferred = preferred;
+		a.n_ifa_flags = 0;
+		nm_platform_batch_add (batch, NMP_OBJECT_TYPE_IP4_ADDRESS, (const NMPlatformObject *) &a);
+
+		if (!to_add)
+			to_add = g_ptr_array_new ();
+		g_ptr_array_add (to_add, (gpointer) known_address);
+	}
+
+	nm_platform_batch_commit (batch);
 
+	/* failures to delete addresses are ignored. Only the added addresses
+	 * determine the result. */
+	for (i = 0; to_add && i < to_add->len; i++) {
+		if (!nm_platform_batch_get_result (batch, first_add_idx + i)) {
+			success = FALSE;
+			continue;
+		}
 		if (out_added_addresses) {
 			if (!*out_added_addresses)
 				*out_added_addresses = g_ptr_array_new ();
-			g_ptr_array_add (*out_added_addresses, (gpointer) known_address);
+			g_ptr_array_add (*out_added_addresses, to_add->pdata[i]);
 		}
 	}
 
-	return TRUE;
+	nm_platform_batch_free (batch);
+	return success;
 }
 
 /**
@@ -2784,16 +2818,26 @@ nm_platform_ip4_address_sync (NMPlatform *self, int ifindex, const GArray *known
  * with the least possible disturbance. It simply removes addresses that are
  * not listed and adds addresses that are.
  *
- * Returns: %TRUE on success.
+ * All changes are sent to the kernel at once. Thus, when adding an address
+ * fails, the addresses after it are still added.
+ *
+ * Returns: %TRUE on success, %FALSE if any address could not be added.
  */
 gboolean
 nm_platform_ip6_address_sync (NMPlatform *self, int ifindex, const GArray *known_addresses, gboolean keep_link_local)
 {
+	NMPlatformBatch *batch;
 	GArray *addresses;
 	NMPlatformIP6Address *address;
 	gint32 now = nm_utils_get_monotonic_timestamp_s ();
+	gboolean success = TRUE;
+	guint first_add_idx, n_ops;
 	int i;
 
+	_CHECK_SELF (self, klass, FALSE);
+
+	batch = nm_platform_batch_new (self);
+
 	/* Delete unknown addresses */
 	addresses = nm_platform_ip6_address_get_all (self, ifindex);
 	for (i = 0; i < addresses->len; i++) {
@@ -2804,29 +2848,40 @@ nm_platform_ip6_address_sync (NMPlatform *self, int ifindex, const GArray *known
 			continue;
 
 		if (!array_contains_ip6_address (known_addresses, address, now))
-			nm_platform_ip6_address_delete (self, ifindex, address->address, address->plen);
+			nm_platform_batch_delete (batch, NMP_OBJECT_TYPE_IP6_ADDRESS, (const NMPlatformObject *) address);
 	}
 	g_array_free (addresses, TRUE);
 
-	if (!known_addresses)
-		return TRUE;
-
 	/* Add missing addresses */
-	for (i = 0; i < known_addresses->len; i++) {
+	first_add_idx = nm_platform_batch_get_len (batch);
+	for (i = 0; known_addresses && i < known_addresses->len; i++) {
 		const NMPlatformIP6Address *known_address = &g_array_index (known_addresses, NMPlatformIP6Address, i);
+		NMPlatformIP6Address a;
 		guint32 lifetime, preferred;
 
 		if (!nm_utils_lifetime_get (known_address->timestamp, known_address->lifetime, known_address->preferred,
 		                            now, &lifetime, &preferred))
 			continue;
 
-		if (!nm_platform_ip6_address_add (self, ifindex, known_address->address,
-		                                  known_address->plen, known_address->peer_address,
-		                                  lifetime, preferred, known_address->n_ifa_flags))
-			return FALSE;
+		a = *known_address;
+		a.ifindex = ifindex;
+		a.timestamp = 0;
+		a.lifetime = lifetime;
+		a.preferred = preferred;
+		nm_platform_batch_add (batch, NMP_OBJECT_TYPE_IP6_ADDRESS, (const NMPlatformObject *) &a);
 	}
 
-	return TRUE;
+	nm_platform_batch_commit (batch);
+
+	/* failures to delete addresses are ignored. */
+	n_ops = nm_platform_batch_get_len (batch);
+	for (i = first_add_idx; i < n_ops; i++) {
+		if (!nm_platform_batch_get_result (batch, i))
+			success = FALSE;
+	}
+
+	nm_platform_batch_free (batch);
+	return success;
 }
 
 gboolean
@@ -2860,6 +2915,224 @@ nm_platform_ip6_route_get_all (NMPlatform *self, int ifindex, NMPlatformGetRoute
 	return klass->ip6_route_get_all (self, ifindex, flags);
 }
 
+/******************************************************************/
+
+struct _NMPlatformSnapshot {
+	int ref_count;
+	NMPObjectType obj_type;
+	int ifindex;
+	NMPlatformGetRouteFlags flags;
+	guint64 generation;
+	GArray *array;
+};
+
+static guint
+_snapshot_hash (const NMPlatformSnapshot *snapshot)
+{
+	return ((guint) snapshot->ifindex) * 31u + ((guint) snapshot->flags);
+}
+
+static gboolean
+_snapshot_equal (const NMPlatformSnapshot *a, const NMPlatformSnapshot *b)
+{
+	return    a->ifindex == b->ifindex
+	       && a->flags == b->flags;
+}
+
+static void
+_snapshots_invalidate (NMPlatform *self, NMPObjectType obj_type)
+{
+	NMPlatformPrivate *priv = NM_PLATFORM_GET_PRIVATE (self);
+
+	priv->generation[obj_type]++;
+	if (priv->snapshots[obj_type])
+		g_hash_table_remove_all (priv->snapshots[obj_type]);
+}
+
+static NMPlatformSnapshot *
+_snapshot_get (NMPlatform *self, NMPObjectType obj_type, int ifindex, NMPlatformGetRouteFlags flags)
+{
+	NMPlatformClass *klass = NM_PLATFORM_GET_CLASS (self);
+	NMPlatformPrivate *priv = NM_PLATFORM_GET_PRIVATE (self);
+	GHashTable **p_snapshots = &priv->snapshots[obj_type];
+	NMPlatformSnapshot *snapshot;
+	NMPlatformSnapshot needle = {
+		.ifindex = ifindex,
+		.flags = flags,
+	};
+
+	if (*p_snapshots) {
+		snapshot = g_hash_table_lookup (*p_snapshots, &needle);
+		if (snapshot) {
+			nm_assert (snapshot->generation == priv->generation[obj_type]);
+			return nm_platform_snapshot_ref (snapshot);
+		}
+	} else {
+		*p_snapshots = g_hash_table_new_full ((GHashFunc) _snapshot_hash,
+		                                      (GEqualFunc) _snapshot_equal,
+		                                      (GDestroyNotify) nm_platform_snapshot_unref,
+		                                      NULL);
+	}
+
+	snapshot = g_slice_new (NMPlatformSnapshot);
+	snapshot->ref_count = 1;
+	snapshot->obj_type = obj_type;
+	snapshot->ifindex = ifindex;
+	snapshot->flags = flags;
+	snapshot->generation = priv->generation[obj_type];
+
+	switch (obj_type) {
+	case NMP_OBJECT_TYPE_IP4_ADDRESS:
+		snapshot->array = klass->ip4_address_get_all (self, ifindex);
+		break;
+	case NMP_OBJECT_TYPE_IP6_ADDRESS:
+		snapshot->array = klass->ip6_address_get_all (self, ifindex);
+		break;
+	case NMP_OBJECT_TYPE_IP4_ROUTE:
+		snapshot->array = klass->ip4_route_get_all (self, ifindex, flags);
+		break;
+	case NMP_OBJECT_TYPE_IP6_ROUTE:
+		snapshot->array = klass->ip6_route_get_all (self, ifindex, flags);
+		break;
+	default:
+		nm_assert_not_reached ();
+		snapshot->array = NULL;
+		break;
+	}
+
+	/* fetching the objects must not emit signals. */
+	nm_assert (snapshot->generation == priv->generation[obj_type]);
+
+	g_hash_table_add (*p_snapshots, nm_platform_snapshot_ref (snapshot));
+	return snapshot;
+}
+
+/**
+ * nm_platform_ip4_address_get_snapshot:
+ * @self: platform instance
+ * @ifindex: the interface
+ *
+ * Like nm_platform_ip4_address_get_all(), but returns an immutable
+ * snapshot. As long as no address changes, all callers share the same
+ * instance instead of copying the addresses each time.
+ *
+ * Returns: (transfer full): the snapshot. Release it with
+ *   nm_platform_snapshot_unref().
+ */
+NMPlatformSnapshot *
+nm_platform_ip4_address_get_snapshot (NMPlatform *self, int ifindex)
+{
+	_CHECK_SELF (self, klass, NULL);
+
+	g_return_val_if_fail (ifindex > 0, NULL);
+
+	return _snapshot_get (self, NMP_OBJECT_TYPE_IP4_ADDRESS, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_NONE);
+}
+
+NMPlatformSnapshot *
+nm_platform_ip6_address_get_snapshot (NMPlatform *self, int ifindex)
+{
+	_CHECK_SELF (self, klass, NULL);
+
+	g_return_val_if_fail (ifindex > 0, NULL);
+
+	return _snapshot_get (self, NMP_OBJECT_TYPE_IP6_ADDRESS, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_NONE);
+}
+
+NMPlatformSnapshot *
+nm_platform_ip4_route_get_snapshot (NMPlatform *self, int ifindex, NMPlatformGetRouteFlags flags)
+{
+	_CHECK_SELF (self, klass, NULL);
+
+	g_return_val_if_fail (ifindex >= 0, NULL);
+
+	return _snapshot_get (self, NMP_OBJECT_TYPE_IP4_ROUTE, ifindex, flags);
+}
+
+NMPlatformSnapshot *
+nm_platform_ip6_route_get_snapshot (NMPlatform *self, int ifindex, NMPlatformGetRouteFlags flags)
+{
+	_CHECK_SELF (self, klass, NULL);
+
+	g_return_val_if_fail (ifindex >= 0, NULL);
+
+	return _snapshot_get (self, NMP_OBJECT_TYPE_IP6_ROUTE, ifindex, flags);
+}
+
+NMPlatformSnapshot *
+nm_platform_snapshot_ref (NMPlatformSnapshot *snapshot)
+{
+	g_return_val_if_fail (snapshot, NULL);
+	g_return_val_if_fail (snapshot->ref_count > 0, NULL);
+
+	snapshot->ref_count++;
+	return snapshot;
+}
+
+void
+nm_platform_snapshot_unref (NMPlatformSnapshot *snapshot)
+{
+	g_return_if_fail (snapshot);
+	g_return_if_fail (snapshot->ref_count > 0);
+
+	if (--snapshot->ref_count == 0) {
+		if (snapshot->array)
+			g_array_unref (snapshot->array);
+		g_slice_free (NMPlatformSnapshot, snapshot);
+	}
+}
+
+/**
+ * nm_platform_snapshot_get_array:
+ * @snapshot: the snapshot
+ *
+ * Returns: (transfer none): the addresses or routes of the snapshot, in the
+ *   same format as returned by nm_platform_ip4_address_get_all() & co.
+ *   The array is shared and must not be modified.
+ */
+const GArray *
+nm_platform_snapshot_get_array (const NMPlatformSnapshot *snapshot)
+{
+	g_return_val_if_fail (snapshot, NULL);
+
+	return snapshot->array;
+}
+
+/**
+ * nm_platform_snapshot_get_generation:
+ * @snapshot: the snapshot
+ *
+ * Returns: the generation of the object type at the time the snapshot was
+ *   taken. Two snapshots of the same platform and object type with the same
+ *   generation are identical. See also nm_platform_get_generation().
+ */
+guint64
+nm_platform_snapshot_get_generation (const NMPlatformSnapshot *snapshot)
+{
+	g_return_val_if_fail (snapshot, 0);
+
+	return snapshot->generation;
+}
+
+/**
+ * nm_platform_get_generation:
+ * @self: platform instance
+ * @obj_type: the object type, one of the address or route types.
+ *
+ * Returns: a counter that increases whenever an object of @obj_type is
+ *   added, changed or removed. It is never zero.
+ */
+guint64
+nm_platform_get_generation (NMPlatform *self, NMPObjectType obj_type)
+{
+	_CHECK_SELF (self, klass, 0);
+
+	g_return_val_if_fail (NM_IN_SET (obj_type, NMP_OBJECT_TYPE_IP4_ADDRESS, NMP_OBJECT_TYPE_IP6_ADDRESS,
+	                                           NMP_OBJECT_TYPE_IP4_ROUTE, NMP_OBJECT_TYPE_IP6_ROUTE), 0);
+
+	return NM_PLATFORM_GET_PRIVATE (self)->generation[obj_type];
+}
+
 /**
  * nm_platform_ip4_route_add:
  * @self:
@@ -2986,6 +3259,241 @@ nm_platform_ip6_route_get (NMPlatform *self, int ifindex, struct in6_addr networ
 	return klass->ip6_route_get (self, ifindex, network, plen, metric);
 }
 
+/**
+ * nm_platform_ip4_route_get_lpm:
+ * @self: platform instance
+ * @ifindex: if positive, only consider routes on this interface
+ * @host: the destination address
+ * @without_gateway: if %TRUE, only consider direct routes
+ *
+ * Returns: the route with the longest prefix that covers @host.
+ *   If there are several, the one with the lowest metric.
+ */
+const NMPlatformIP4Route *
+nm_platform_ip4_route_get_lpm (NMPlatform *self, int ifindex, in_addr_t host, gboolean without_gateway)
+{
+	_CHECK_SELF (self, klass, NULL);
+
+	return klass->ip4_route_get_lpm (self, ifindex, host, without_gateway);
+}
+
+const NMPlatformIP6Route *
+nm_platform_ip6_route_get_lpm (NMPlatform *self, int ifindex, const struct in6_addr *host, gboolean without_gateway)
+{
+	_CHECK_SELF (self, klass, NULL);
+
+	g_return_val_if_fail (host, NULL);
+
+	return klass->ip6_route_get_lpm (self, ifindex, host, without_gateway);
+}
+
+/******************************************************************/
+
+struct _NMPlatformBatch {
+	NMPlatform *platform;
+	GArray *ops;
+	bool committed:1;
+};
+
+/**
+ * nm_platform_batch_new:
+ * @self: platform instance
+ *
+ * Creates a new batch for adding and deleting addresses and routes.
+ * The queued operations are only executed by nm_platform_batch_commit(),
+ * in the order in which they were queued. Platform implementations that
+ * support it send all requests at once and wait for the kernel's responses
+ * together, instead of doing one round trip per object.
+ *
+ * Returns: (transfer full): the new batch. Free with nm_platform_batch_free().
+ */
+NMPlatformBatch *
+nm_platform_batch_new (NMPlatform *self)
+{
+	NMPlatformBatch *batch;
+
+	_CHECK_SELF (self, klass, NULL);
+
+	batch = g_slice_new0 (NMPlatformBatch);
+	batch->platform = g_object_ref (self);
+	batch->ops = g_array_new (FALSE, FALSE, sizeof (NMPlatformBatchOp));
+	return batch;
+}
+
+void
+nm_platform_batch_free (NMPlatformBatch *batch)
+{
+	guint i;
+
+	if (!batch)
+		return;
+
+	for (i = 0; i < batch->ops->len; i++)
+		nmp_object_unref (g_array_index (batch->ops, NMPlatformBatchOp, i).obj);
+	g_array_unref (batch->ops);
+	g_object_unref (batch->platform);
+	g_slice_free (NMPlatformBatch, batch);
+}
+
+guint
+nm_platform_batch_get_len (const NMPlatformBatch *batch)
+{
+	g_return_val_if_fail (batch, 0);
+
+	return batch->ops->len;
+}
+
+static guint
+_batch_append (NMPlatformBatch *batch, NMPlatformBatchOpType op_type, NMPObjectType obj_type, const NMPlatformObject *obj)
+{
+	NMPlatformBatchOp op = { 0 };
+
+	g_return_val_if_fail (batch, G_MAXUINT);
+	g_return_val_if_fail (!batch->committed, G_MAXUINT);
+	g_return_val_if_fail (NM_IN_SET (obj_type, NMP_OBJECT_TYPE_IP4_ADDRESS,
+	                                           NMP_OBJECT_TYPE_IP6_ADDRESS,
+	                                           NMP_OBJECT_TYPE_IP4_ROUTE,
+	                                           NMP_OBJECT_TYPE_IP6_ROUTE), G_MAXUINT);
+	g_return_val_if_fail (obj && obj->ifindex > 0, G_MAXUINT);
+
+	op.obj = nmp_object_new (obj_type, obj);
+	op.op_type = op_type;
+	g_array_append_val (batch->ops, op);
+	return batch->ops->len - 1;
+}
+
+/**
+ * nm_platform_batch_add:
+ * @batch: the batch
+ * @obj_type: one of the address or route object types
+ * @obj: the address or route to add. For addresses, the lifetimes
+ *   are relative to the moment of the commit (as if @timestamp was zero).
+ *
+ * Returns: the index of the operation in @batch, for
+ *   nm_platform_batch_get_result().
+ */
+guint
+nm_platform_batch_add (NMPlatformBatch *batch, NMPObjectType obj_type, const NMPlatformObject *obj)
+{
+	return _batch_append (batch, NM_PLATFORM_BATCH_OP_ADD, obj_type, obj);
+}
+
+/**
+ * nm_platform_batch_delete:
+ * @batch: the batch
+ * @obj_type: one of the address or route object types
+ * @obj: the address or route to delete. Only the ID fields are relevant.
+ *
+ * Returns: the index of the operation in @batch, for
+ *   nm_platform_batch_get_result().
+ */
+guint
+nm_platform_batch_delete (NMPlatformBatch *batch, NMPObjectType obj_type, const NMPlatformObject *obj)
+{
+	return _batch_append (batch, NM_PLATFORM_BATCH_OP_DELETE, obj_type, obj);
+}
+
+static gboolean
+_batch_op_commit_one (NMPlatform *self, const NMPlatformBatchOp *op)
+{
+	const NMPObject *obj = op->obj;
+
+	switch (NMP_OBJECT_GET_TYPE (obj)) {
+	case NMP_OBJECT_TYPE_IP4_ADDRESS:
+		if (op->op_type == NM_PLATFORM_BATCH_OP_ADD) {
+			return nm_platform_ip4_address_add (self, obj->ip4_address.ifindex, obj->ip4_address.address,
+			                                    obj->ip4_address.plen, obj->ip4_address.peer_address,
+			                                    obj->ip4_address.lifetime, obj->ip4_address.preferred,
+			                                    obj->ip4_address.n_ifa_flags, obj->ip4_address.label);
+		}
+		return nm_platform_ip4_address_delete (self, obj->ip4_address.ifindex, obj->ip4_address.address,
+		                                       obj->ip4_address.plen, obj->ip4_address.peer_address);
+	case NMP_OBJECT_TYPE_IP6_ADDRESS:
+		if (op->op_type == NM_PLATFORM_BATCH_OP_ADD) {
+			return nm_platform_ip6_address_add (self, obj->ip6_address.ifindex, obj->ip6_address.address,
+			                                    obj->ip6_address.plen, obj->ip6_address.peer_address,
+			                                    obj->ip6_address.lifetime, obj->ip6_address.preferred,
+			                                    obj->ip6_address.n_ifa_flags);
+		}
+		return nm_platform_ip6_address_delete (self, obj->ip6_address.ifindex, obj->ip6_address.address,
+		                                       obj->ip6_address.plen);
+	case NMP_OBJECT_TYPE_IP4_ROUTE:
+		if (op->op_type == NM_PLATFORM_BATCH_OP_ADD)
+			return nm_platform_vtable_route_v4.route_add (self, 0, &obj->ipx_route, -1);
+		return nm_platform_vtable_route_v4.route_delete (self, 0, &obj->ipx_route);
+	case NMP_OBJECT_TYPE_IP6_ROUTE:
+		if (op->op_type == NM_PLATFORM_BATCH_OP_ADD)
+			return nm_platform_vtable_route_v6.route_add (self, 0, &obj->ipx_route, -1);
+		return nm_platform_vtable_route_v6.route_delete (self, 0, &obj->ipx_route);
+	default:
+		g_return_val_if_reached (FALSE);
+	}
+}
+
+/**
+ * nm_platform_batch_commit:
+ * @batch: the batch
+ *
+ * Executes all queued operations of @batch. A batch can only be
+ * committed once. The result of the individual operations can be
+ * retrieved with nm_platform_batch_get_result().
+ *
+ * Returns: %TRUE if all operations succeeded.
+ */
+gboolean
+nm_platform_batch_commit (NMPlatformBatch *batch)
+{
+	NMPlatform *self;
+	NMPlatformClass *klass;
+	NMPlatformBatchOp *ops;
+	gboolean success = TRUE;
+	guint i, n_ops;
+
+	g_return_val_if_fail (batch, FALSE);
+	g_return_val_if_fail (!batch->committed, FALSE);
+
+	batch->committed = TRUE;
+
+	n_ops = batch->ops->len;
+	if (n_ops == 0)
+		return TRUE;
+
+	self = batch->platform;
+	klass = NM_PLATFORM_GET_CLASS (self);
+	ops = &g_array_index (batch->ops, NMPlatformBatchOp, 0);
+
+	if (klass->batch_commit) {
+		if (_LOGD_ENABLED ()) {
+			for (i = 0; i < n_ops; i++) {
+				_LOGD ("batch: %s %s",
+				       ops[i].op_type == NM_PLATFORM_BATCH_OP_ADD ? "adding or updating" : "deleting",
+				       nmp_object_to_string (ops[i].obj, NMP_OBJECT_TO_STRING_PUBLIC, NULL, 0));
+			}
+		}
+		klass->batch_commit (self, ops, n_ops);
+	} else {
+		for (i = 0; i < n_ops; i++)
+			ops[i].success = _batch_op_commit_one (self, &ops[i]);
+	}
+
+	for (i = 0; i < n_ops; i++) {
+		if (!ops[i].success)
+			success = FALSE;
+	}
+	return success;
+}
+
+gboolean
+nm_platform_batch_get_result (const NMPlatformBatch *batch, guint idx)
+{
+	g_return_val_if_fail (batch, FALSE);
+	g_return_val_if_fail (batch->committed, FALSE);
+
+	if (idx >= batch->ops->len)
+		return FALSE;
+	return g_array_index (batch->ops, NMPlatformBatchOp, idx).success;
+}
+
 /******************************************************************/
 
 const char *
@@ -4054,24 +4562,28 @@ log_link (NMPlatform *self, NMPObjectType obj_type, int ifindex, NMPlatformLink
 static void
 log_ip4_address (NMPlatform *self, NMPObjectType obj_type, int ifindex, NMPlatformIP4Address *address, NMPlatformSignalChangeType change_type, gpointer user_data)
 {
+	_snapshots_invalidate (self, obj_type);
 	_LOGD ("signal: address 4 %7s: %s", nm_platform_signal_change_type_to_string (change_type), nm_platform_ip4_address_to_string (address, NULL, 0));
 }
 
 static void
 log_ip6_address (NMPlatform *self, NMPObjectType obj_type, int ifindex, NMPlatformIP6Address *address, NMPlatformSignalChangeType change_type, gpointer user_data)
 {
+	_snapshots_invalidate (self, obj_type);
 	_LOGD ("signal: address 6 %7s: %s", nm_platform_signal_change_type_to_string (change_type), nm_platform_ip6_address_to_string (address, NULL, 0));
 }
 
 static void
 log_ip4_route (NMPlatform *self, NMPObjectType obj_type, int ifindex, NMPlatformIP4Route *route, NMPlatformSignalChangeType change_type, gpointer user_data)
 {
+	_snapshots_invalidate (self, obj_type);
 	_LOGD ("signal: route   4 %7s: %s", nm_platform_signal_change_type_to_string (change_type), nm_platform_ip4_route_to_string (route, NULL, 0));
 }
 
 static void
 log_ip6_route (NMPlatform *self, NMPObjectType obj_type, int ifindex, NMPlatformIP6Route *route, NMPlatformSignalChangeType change_type, gpointer user_data)
 {
+	_snapshots_invalidate (self, obj_type);
 	_LOGD ("signal: route   6 %7s: %s", nm_platform_signal_change_type_to_string (change_type), nm_platform_ip6_route_to_string (route, NULL, 0));
 }
 
@@ -4155,6 +4667,50 @@ _vtr_v4_metric_normalize (guint32 metric)
 	return metric;
 }
 
+static guint
+_vtr_v4_batch_route_add (NMPlatformBatch *batch, int ifindex, const NMPlatformIPXRoute *route, gint64 metric)
+{
+	NMPlatformIP4Route r = route->r4;
+
+	if (ifindex > 0)
+		r.ifindex = ifindex;
+	if (metric >= 0)
+		r.metric = (guint32) metric;
+	return nm_platform_batch_add (batch, NMP_OBJECT_TYPE_IP4_ROUTE, (const NMPlatformObject *) &r);
+}
+
+static guint
+_vtr_v6_batch_route_add (NMPlatformBatch *batch, int ifindex, const NMPlatformIPXRoute *route, gint64 metric)
+{
+	NMPlatformIP6Route r = route->r6;
+
+	if (ifindex > 0)
+		r.ifindex = ifindex;
+	if (metric >= 0)
+		r.metric = (guint32) metric;
+	return nm_platform_batch_add (batch, NMP_OBJECT_TYPE_IP6_ROUTE, (const NMPlatformObject *) &r);
+}
+
+static guint
+_vtr_v4_batch_route_delete (NMPlatformBatch *batch, int ifindex, const NMPlatformIPXRoute *route)
+{
+	NMPlatformIP4Route r = route->r4;
+
+	if (ifindex > 0)
+		r.ifindex = ifindex;
+	return nm_platform_batch_delete (batch, NMP_OBJECT_TYPE_IP4_ROUTE, (const NMPlatformObject *) &r);
+}
+
+static guint
+_vtr_v6_batch_route_delete (NMPlatformBatch *batch, int ifindex, const NMPlatformIPXRoute *route)
+{
+	NMPlatformIP6Route r = route->r6;
+
+	if (ifindex > 0)
+		r.ifindex = ifindex;
+	return nm_platform_batch_delete (batch, NMP_OBJECT_TYPE_IP6_ROUTE, (const NMPlatformObject *) &r);
+}
+
 static gboolean
 _vtr_v4_route_delete_default (NMPlatform *self, int ifindex, guint32 metric)
 {
@@ -4176,9 +4732,12 @@ const NMPlatformVTableRoute nm_platform_vtable_route_v4 = {
 	.route_cmp                      = (int (*) (const NMPlatformIPXRoute *a, const NMPlatformIPXRoute *b)) nm_platform_ip4_route_cmp,
 	.route_to_string                = (const char *(*) (const NMPlatformIPXRoute *route, char *buf, gsize len)) nm_platform_ip4_route_to_string,
 	.route_get_all                  = nm_platform_ip4_route_get_all,
+	.route_get_snapshot             = nm_platform_ip4_route_get_snapshot,
 	.route_add                      = _vtr_v4_route_add,
 	.route_delete                   = _vtr_v4_route_delete,
 	.route_delete_default           = _vtr_v4_route_delete_default,
+	.batch_route_add                = _vtr_v4_batch_route_add,
+	.batch_route_delete             = _vtr_v4_batch_route_delete,
 	.metric_normalize               = _vtr_v4_metric_normalize,
 };
 
@@ -4189,9 +4748,12 @@ const NMPlatformVTableRoute nm_platform_vtable_route_v6 = {
 	.route_cmp                      = (int (*) (const NMPlatformIPXRoute *a, const NMPlatformIPXRoute *b)) nm_platform_ip6_route_cmp,
 	.route_to_string                = (const char *(*) (const NMPlatformIPXRoute *route, char *buf, gsize len)) nm_platform_ip6_route_to_string,
 	.route_get_all                  = nm_platform_ip6_route_get_all,
+	.route_get_snapshot             = nm_platform_ip6_route_get_snapshot,
 	.route_add                      = _vtr_v6_route_add,
 	.route_delete                   = _vtr_v6_route_delete,
 	.route_delete_default           = _vtr_v6_route_delete_default,
+	.batch_route_add                = _vtr_v6_batch_route_add,
+	.batch_route_delete             = _vtr_v6_batch_route_delete,
 	.metric_normalize               = nm_utils_ip6_route_metric_normalize,
 };
 
@@ -4240,13 +4802,24 @@ constructed (GObject *object)
 static void
 nm_platform_init (NMPlatform *object)
 {
+	NMPlatformPrivate *priv = NM_PLATFORM_GET_PRIVATE (object);
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (priv->generation); i++)
+		priv->generation[i] = 1;
 }
 
 static void
 finalize (GObject *object)
 {
 	NMPlatform *self = NM_PLATFORM (object);
+	NMPlatformPrivate *priv = NM_PLATFORM_GET_PRIVATE (self);
+	guint i;
 
+	for (i = 0; i < G_N_ELEMENTS (priv->snapshots); i++) {
+		if (priv->snapshots[i])
+			g_hash_table_unref (priv->snapshots[i]);
+	}
 	g_clear_object (&self->_netns);
 }
 
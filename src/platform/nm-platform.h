@@ -366,6 +366,30 @@ typedef union {
 #undef __NMPlatformObject_COMMON
 
 
+typedef enum { /*< skip >*/
+	NM_PLATFORM_BATCH_OP_ADD,
+	NM_PLATFORM_BATCH_OP_DELETE,
+} NMPlatformBatchOpType;
+
+/**
+ * NMPlatformBatchOp:
+ * @obj: the address or route to add or delete. For addresses,
+ *   @timestamp is ignored and @lifetime/@preferred are relative to *now*.
+ * @op_type: whether to add or delete @obj.
+ * @success: after committing the batch, whether the operation succeeded.
+ *   This has the same meaning as the return value of the corresponding
+ *   nm_platform_ip4_route_add() & co.
+ */
+typedef struct {
+	NMPObject *obj;
+	NMPlatformBatchOpType op_type;
+	bool success:1;
+} NMPlatformBatchOp;
+
+typedef struct _NMPlatformBatch NMPlatformBatch;
+
+typedef struct _NMPlatformSnapshot NMPlatformSnapshot;
+
 typedef struct {
 	gboolean is_ip4;
 	int addr_family;
@@ -373,9 +397,12 @@ typedef struct {
 	int (*route_cmp) (const NMPlatformIPXRoute *a, const NMPlatformIPXRoute *b);
 	const char *(*route_to_string) (const NMPlatformIPXRoute *route, char *buf, gsize len);
 	GArray *(*route_get_all) (NMPlatform *self, int ifindex, NMPlatformGetRouteFlags flags);
+	NMPlatformSnapshot *(*route_get_snapshot) (NMPlatform *self, int ifindex, NMPlatformGetRouteFlags flags);
 	gboolean (*route_add) (NMPlatform *self, int ifindex, const NMPlatformIPXRoute *route, gint64 metric);
 	gboolean (*route_delete) (NMPlatform *self, int ifindex, const NMPlatformIPXRoute *route);
 	gboolean (*route_delete_default) (NMPlatform *self, int ifindex, guint32 metric);
+	guint (*batch_route_add) (NMPlatformBatch *batch, int ifindex, const NMPlatformIPXRoute *route, gint64 metric);
+	guint (*batch_route_delete) (NMPlatformBatch *batch, int ifindex, const NMPlatformIPXRoute *route);
 	guint32 (*metric_normalize) (guint32 metric);
 } NMPlatformVTableRoute;
 
@@ -642,6 +669,11 @@ typedef struct {
 	gboolean (*ip6_route_delete) (NMPlatform *, int ifindex, struct in6_addr network, guint8 plen, guint32 metric);
 	const NMPlatformIP4Route *(*ip4_route_get) (NMPlatform *, int ifindex, in_addr_t network, guint8 plen, guint32 metric);
 	const NMPlatformIP6Route *(*ip6_route_get) (NMPlatform *, int ifindex, struct in6_addr network, guint8 plen, guint32 metric);
+	const NMPlatformIP4Route *(*ip4_route_get_lpm) (NMPlatform *, int ifindex, in_addr_t host, gboolean without_gateway);
+	const NMPlatformIP6Route *(*ip6_route_get_lpm) (NMPlatform *, int ifindex, const struct in6_addr *host, gboolean without_gateway);
+
+	/* optional. If unset, the operations of a batch are committed one by one. */
+	void (*batch_commit) (NMPlatform *, NMPlatformBatchOp *ops, guint n_ops);
 
 	gboolean (*check_support_kernel_extended_ifa_flags) (NMPlatform *);
 	gboolean (*check_support_user_ipv6ll) (NMPlatform *);
@@ -909,10 +941,30 @@ gboolean nm_platform_ip4_address_sync (NMPlatform *self, int ifindex, const GArr
 gboolean nm_platform_ip6_address_sync (NMPlatform *self, int ifindex, const GArray *known_addresses, gboolean keep_link_local);
 gboolean nm_platform_address_flush (NMPlatform *self, int ifindex);
 
+NMPlatformBatch *nm_platform_batch_new (NMPlatform *self);
+void nm_platform_batch_free (NMPlatformBatch *batch);
+guint nm_platform_batch_get_len (const NMPlatformBatch *batch);
+guint nm_platform_batch_add (NMPlatformBatch *batch, NMPObjectType obj_type, const NMPlatformObject *obj);
+guint nm_platform_batch_delete (NMPlatformBatch *batch, NMPObjectType obj_type, const NMPlatformObject *obj);
+gboolean nm_platform_batch_commit (NMPlatformBatch *batch);
+gboolean nm_platform_batch_get_result (const NMPlatformBatch *batch, guint idx);
+
 const NMPlatformIP4Route *nm_platform_ip4_route_get (NMPlatform *self, int ifindex, in_addr_t network, guint8 plen, guint32 metric);
 const NMPlatformIP6Route *nm_platform_ip6_route_get (NMPlatform *self, int ifindex, struct in6_addr network, guint8 plen, guint32 metric);
+const NMPlatformIP4Route *nm_platform_ip4_route_get_lpm (NMPlatform *self, int ifindex, in_addr_t host, gboolean without_gateway);
+const NMPlatformIP6Route *nm_platform_ip6_route_get_lpm (NMPlatform *self, int ifindex, const struct in6_addr *host, gboolean without_gateway);
 GArray *nm_platform_ip4_route_get_all (NMPlatform *self, int ifindex, NMPlatformGetRouteFlags flags);
 GArray *nm_platform_ip6_route_get_all (NMPlatform *self, int ifindex, NMPlatformGetRouteFlags flags);
+
+NMPlatformSnapshot *nm_platform_ip4_address_get_snapshot (NMPlatform *self, int ifindex);
+NMPlatformSnapshot *nm_platform_ip6_address_get_snapshot (NMPlatform *self, int ifindex);
+NMPlatformSnapshot *nm_platform_ip4_route_get_snapshot (NMPlatform *self, int ifindex, NMPlatformGetRouteFlags flags);
+NMPlatformSnapshot *nm_platform_ip6_route_get_snapshot (NMPlatform *self, int ifindex, NMPlatformGetRouteFlags flags);
+NMPlatformSnapshot *nm_platform_snapshot_ref (NMPlatformSnapshot *snapshot);
+void nm_platform_snapshot_unref (NMPlatformSnapshot *snapshot);
+const GArray *nm_platform_snapshot_get_array (const NMPlatformSnapshot *snapshot);
+guint64 nm_platform_snapshot_get_generation (const NMPlatformSnapshot *snapshot);
+guint64 nm_platform_get_generation (NMPlatform *self, NMPObjectType obj_type);
 gboolean nm_platform_ip4_route_add (NMPlatform *self, int ifindex, NMIPConfigSource source,
                                     in_addr_t network, guint8 plen, in_addr_t gateway,
                                     in_addr_t pref_src, guint32 metric, guint32 mss);
@@ -28,6 +28,7 @@
 
 #include "nm-core-utils.h"
 #include "nm-platform-utils.h"
+#include "nm-prefix-trie.h"
 
 /*********************************************************************************************/
 
@@ -67,6 +68,12 @@ struct _NMPCache {
 	GHashTable *idx_main;
 	NMMultiIndex *idx_multi;
 
+	/* prefix tries of all IPv4 and IPv6 routes for longest-prefix-match
+	 * lookups. They are only created on the first lookup and from then on
+	 * kept up to date together with the other indexes. */
+	NMPrefixTrie *idx_lpm_ip4;
+	NMPrefixTrie *idx_lpm_ip6;
+
 	gboolean use_udev;
 };
 
@@ -1579,6 +1586,128 @@ nmp_cache_lookup_all_to_hash (const NMPCache *cache,
 
 /******************************************************************/
 
+static NMPrefixTrie **
+_nmp_cache_lpm_get_trie (const NMPCache *cache, NMPObjectType obj_type)
+{
+	switch (obj_type) {
+	case NMP_OBJECT_TYPE_IP4_ROUTE:
+		return (NMPrefixTrie **) &cache->idx_lpm_ip4;
+	case NMP_OBJECT_TYPE_IP6_ROUTE:
+		return (NMPrefixTrie **) &cache->idx_lpm_ip6;
+	default:
+		return NULL;
+	}
+}
+
+static gconstpointer
+_nmp_cache_lpm_get_network (const NMPObject *obj)
+{
+	if (NMP_OBJECT_GET_TYPE (obj) == NMP_OBJECT_TYPE_IP4_ROUTE)
+		return &obj->ip4_route.network;
+	return &obj->ip6_route.network;
+}
+
+static void
+_nmp_cache_update_lpm (NMPCache *cache, NMPObject *obj, gboolean remove)
+{
+	NMPrefixTrie **p_trie;
+
+	p_trie = _nmp_cache_lpm_get_trie (cache, NMP_OBJECT_GET_TYPE (obj));
+	if (!p_trie || !*p_trie)
+		return;
+
+	/* the network and plen are part of the route's ID, so they never change
+	 * while the object is in the cache. */
+	if (remove) {
+		if (!nm_prefix_trie_remove (*p_trie, _nmp_cache_lpm_get_network (obj), obj->ip_route.plen, obj))
+			g_assert_not_reached ();
+	} else {
+		if (!nm_prefix_trie_add (*p_trie, _nmp_cache_lpm_get_network (obj), obj->ip_route.plen, obj))
+			g_assert_not_reached ();
+	}
+}
+
+typedef struct {
+	int ifindex;
+	gboolean without_gateway;
+	const NMPObject *result;
+} LookupRouteLpmData;
+
+static gboolean
+_lookup_route_lpm_cb (guint8 plen, void *const* values, guint len, gpointer user_data)
+{
+	LookupRouteLpmData *data = user_data;
+	guint i;
+
+	for (i = 0; i < len; i++) {
+		const NMPObject *obj = values[i];
+
+		if (!nmp_object_is_visible (obj))
+			continue;
+		if (data->ifindex > 0 && obj->object.ifindex != data->ifindex)
+			continue;
+		if (data->without_gateway) {
+			if (NMP_OBJECT_GET_TYPE (obj) == NMP_OBJECT_TYPE_IP4_ROUTE) {
+				if (obj->ip4_route.gateway)
+					continue;
+			} else {
+				if (!IN6_IS_ADDR_UNSPECIFIED (&obj->ip6_route.gateway))
+					continue;
+			}
+		}
+		if (data->result && data->result->ip_route.metric <= obj->ip_route.metric)
+			continue;
+		data->result = obj;
+	}
+	return !!data->result;
+}
+
+/**
+ * nmp_cache_lookup_route_lpm:
+ * @cache: the platform cache
+ * @obj_type: either %NMP_OBJECT_TYPE_IP4_ROUTE or %NMP_OBJECT_TYPE_IP6_ROUTE
+ * @addr: the in_addr_t or struct in6_addr to look up
+ * @ifindex: if positive, only consider routes on that interface
+ * @without_gateway: only consider routes without gateway (direct routes)
+ *
+ * Returns: the visible route with the longest prefix that contains @addr. Among
+ *   routes with the same prefix, the one with the lowest metric.
+ *   %NULL, if there is no such route.
+ */
+const NMPObject *
+nmp_cache_lookup_route_lpm (NMPCache *cache, NMPObjectType obj_type, gconstpointer addr, int ifindex, gboolean without_gateway)
+{
+	NMPrefixTrie **p_trie;
+	LookupRouteLpmData data = {
+		.ifindex = ifindex,
+		.without_gateway = without_gateway,
+	};
+
+	g_return_val_if_fail (cache, NULL);
+	g_return_val_if_fail (addr, NULL);
+
+	p_trie = _nmp_cache_lpm_get_trie (cache, obj_type);
+	g_return_val_if_fail (p_trie, NULL);
+
+	if (!*p_trie) {
+		const NMPlatformObject *const *objects;
+		guint i, len;
+
+		*p_trie = nm_prefix_trie_new (obj_type == NMP_OBJECT_TYPE_IP4_ROUTE ? AF_INET : AF_INET6);
+
+		objects = nmp_cache_lookup_multi (cache,
+		                                  nmp_cache_id_init_object_type (NMP_CACHE_ID_STATIC, obj_type, FALSE),
+		                                  &len);
+		for (i = 0; i < len; i++)
+			_nmp_cache_update_lpm (cache, NMP_OBJECT_UP_CAST (objects[i]), FALSE);
+	}
+
+	nm_prefix_trie_lookup_lpm (*p_trie, addr, G_MAXUINT8, _lookup_route_lpm_cb, &data);
+	return data.result;
+}
+
+/******************************************************************/
+
 static void
 _nmp_cache_update_cache (NMPCache *cache, NMPObject *obj, gboolean remove)
 {
@@ -1607,6 +1736,8 @@ _nmp_cache_update_cache (NMPCache *cache, NMPObject *obj, gboolean remove)
 				g_assert_not_reached ();
 		}
 	}
+
+	_nmp_cache_update_lpm (cache, obj, remove);
 }
 
 static void
@@ -2004,6 +2135,8 @@ nmp_cache_new (gboolean use_udev)
 	                                       (NMMultiIndexFuncEqual) nmp_cache_id_equal,
 	                                       (NMMultiIndexFuncClone) nmp_cache_id_clone,
 	                                       (NMMultiIndexFuncDestroy) nmp_cache_id_destroy);
+	cache->idx_lpm_ip4 = NULL;
+	cache->idx_lpm_ip6 = NULL;
 	cache->use_udev = !!use_udev;
 	return cache;
 }
@@ -2024,6 +2157,10 @@ nmp_cache_free (NMPCache *cache)
 		obj->is_cached = FALSE;
 	}
 
+	if (cache->idx_lpm_ip4)
+		nm_prefix_trie_free (cache->idx_lpm_ip4);
+	if (cache->idx_lpm_ip6)
+		nm_prefix_trie_free (cache->idx_lpm_ip6);
 	nm_multi_index_free (cache->idx_multi);
 	g_hash_table_unref (cache->idx_main);
 
@@ -2043,6 +2180,7 @@ ASSERT_nmp_cache_is_consistent (const NMPCache *cache)
 	const NMPCacheId *cache_id, *cache_id2;
 	const NMPlatformObject *const *objects;
 	const NMPObject *obj;
+	guint num_ip4_routes = 0, num_ip6_routes = 0;
 
 	g_assert (cache);
 
@@ -2060,7 +2198,19 @@ ASSERT_nmp_cache_is_consistent (const NMPCache *cache)
 				continue;
 			g_assert (nm_multi_index_contains (cache->idx_multi, &cache_id->base, &obj->object));
 		}
+
+		if (NMP_OBJECT_GET_TYPE (obj) == NMP_OBJECT_TYPE_IP4_ROUTE) {
+			num_ip4_routes++;
+			if (cache->idx_lpm_ip4)
+				g_assert (nm_prefix_trie_contains (cache->idx_lpm_ip4, &obj->ip4_route.network, obj->ip_route.plen, obj));
+		} else if (NMP_OBJECT_GET_TYPE (obj) == NMP_OBJECT_TYPE_IP6_ROUTE) {
+			num_ip6_routes++;
+			if (cache->idx_lpm_ip6)
+				g_assert (nm_prefix_trie_contains (cache->idx_lpm_ip6, &obj->ip6_route.network, obj->ip_route.plen, obj));
+		}
 	}
+	g_assert (!cache->idx_lpm_ip4 || nm_prefix_trie_get_num_values (cache->idx_lpm_ip4) == num_ip4_routes);
+	g_assert (!cache->idx_lpm_ip6 || nm_prefix_trie_get_num_values (cache->idx_lpm_ip6) == num_ip6_routes);
 
 	nm_multi_index_iter_init (&iter_multi, cache->idx_multi, NULL);
 	while (nm_multi_index_iter_next (&iter_multi,
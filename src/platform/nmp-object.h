@@ -418,6 +418,7 @@ const NMPObject *nmp_cache_lookup_obj (const NMPCache *cache, const NMPObject *o
 const NMPObject *nmp_cache_lookup_link (const NMPCache *cache, int ifindex);
 
 const NMPObject *nmp_cache_find_other_route_for_same_destination (const NMPCache *cache, const NMPObject *route);
+const NMPObject *nmp_cache_lookup_route_lpm (NMPCache *cache, NMPObjectType obj_type, gconstpointer addr, int ifindex, gboolean without_gateway);
 
 const NMPObject *nmp_cache_lookup_link_full (const NMPCache *cache,
                                              int ifindex,
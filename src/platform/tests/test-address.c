@@ -250,6 +250,54 @@ test_ip6_address_general_2 (void)
 
 /*****************************************************************************/
 
+static void
+test_ip4_address_sync_failure (void)
+{
+	const int ifindex = DEVICE_IFINDEX;
+	gs_unref_array GArray *known_addresses = NULL;
+	gs_unref_ptrarray GPtrArray *added = NULL;
+	NMPlatformIP4Address a = { 0 };
+
+	if (!nmtstp_is_root_test ()) {
+		/* the fake platform doesn't reject invalid addresses. */
+		g_test_skip ("Skip test with fake platform");
+		return;
+	}
+
+	g_assert (nm_platform_link_set_up (NM_PLATFORM_GET, ifindex, NULL));
+
+	known_addresses = g_array_new (FALSE, FALSE, sizeof (NMPlatformIP4Address));
+	a.plen = IP4_PLEN;
+	a.address = nmtst_inet4_from_string ("192.0.2.1");
+	a.peer_address = a.address;
+	g_array_append_val (known_addresses, a);
+	a.plen = 33;
+	a.address = nmtst_inet4_from_string ("192.0.2.5");
+	a.peer_address = a.address;
+	g_array_append_val (known_addresses, a);
+	a.plen = IP4_PLEN;
+	a.address = nmtst_inet4_from_string ("192.0.2.9");
+	a.peer_address = a.address;
+	g_array_append_val (known_addresses, a);
+
+	/* kernel rejects the invalid prefix length of the second address. The
+	 * sync fails, but the addresses before and after it are added. */
+	g_assert (!nm_platform_ip4_address_sync (NM_PLATFORM_GET, ifindex, known_addresses, &added));
+
+	g_assert (added);
+	g_assert_cmpint (added->len, ==, 2);
+	g_assert (added->pdata[0] == &g_array_index (known_addresses, NMPlatformIP4Address, 0));
+	g_assert (added->pdata[1] == &g_array_index (known_addresses, NMPlatformIP4Address, 2));
+
+	g_assert (nm_platform_ip4_address_get (NM_PLATFORM_GET, ifindex, nmtst_inet4_from_string ("192.0.2.1"), IP4_PLEN, nmtst_inet4_from_string ("192.0.2.1")));
+	g_assert (nm_platform_ip4_address_get (NM_PLATFORM_GET, ifindex, nmtst_inet4_from_string ("192.0.2.9"), IP4_PLEN, nmtst_inet4_from_string ("192.0.2.9")));
+
+	g_assert (nm_platform_ip4_address_sync (NM_PLATFORM_GET, ifindex, NULL, NULL));
+	g_assert (!nm_platform_ip4_address_get (NM_PLATFORM_GET, ifindex, nmtst_inet4_from_string ("192.0.2.1"), IP4_PLEN, nmtst_inet4_from_string ("192.0.2.1")));
+}
+
+/*****************************************************************************/
+
 static void
 test_ip4_address_peer (void)
 {
@@ -420,6 +468,8 @@ _nmtstp_setup_tests (void)
 	_g_test_add_func ("/address/ipv4/general-2", test_ip4_address_general_2);
 	_g_test_add_func ("/address/ipv6/general-2", test_ip6_address_general_2);
 
+	_g_test_add_func ("/address/ipv4/sync/failure", test_ip4_address_sync_failure);
+
 	_g_test_add_func ("/address/ipv4/peer", test_ip4_address_peer);
 	_g_test_add_func ("/address/ipv4/peer/zero", test_ip4_address_peer_zero);
 }
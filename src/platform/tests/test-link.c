@@ -2323,6 +2323,44 @@ test_netns_bind_to_path (gpointer fixture, gconstpointer test_data)
 
 /*****************************************************************************/
 
+static void
+test_sysctl_recreate_link (void)
+{
+	const char *IFACE_DUMMY0 = "nm-test-dummy0";
+	const char *path = "/proc/sys/net/ipv4/conf/nm-test-dummy0/arp_ignore";
+	gs_free char *val_default = NULL;
+	const char *val_new;
+	int ifindex;
+	guint i;
+
+	val_default = nm_platform_sysctl_get (NM_PLATFORM_GET, "/proc/sys/net/ipv4/conf/default/arp_ignore");
+	g_assert (val_default);
+	val_new = nm_streq (val_default, "2") ? "1" : "2";
+
+	/* the per-interface directory is cached between accesses. A link recreated
+	 * with the same name must get the values of the new link, not of the
+	 * stale directory. */
+	for (i = 0; i < 2; i++) {
+		gs_free char *val = NULL;
+
+		ifindex = nmtstp_link_dummy_add (NM_PLATFORM_GET, -1, IFACE_DUMMY0)->ifindex;
+
+		val = nm_platform_sysctl_get (NM_PLATFORM_GET, path);
+		g_assert_cmpstr (val, ==, val_default);
+
+		g_assert (nm_platform_sysctl_set (NM_PLATFORM_GET, path, val_new));
+		g_clear_pointer (&val, g_free);
+		val = nm_platform_sysctl_get (NM_PLATFORM_GET, path);
+		g_assert_cmpstr (val, ==, val_new);
+
+		nmtstp_link_del (NM_PLATFORM_GET, -1, ifindex, IFACE_DUMMY0);
+	}
+
+	g_assert (!nm_platform_sysctl_get (NM_PLATFORM_GET, path));
+}
+
+/*****************************************************************************/
+
 void
 _nmtstp_init_tests (int *argc, char ***argv)
 {
@@ -2370,6 +2408,8 @@ _nmtstp_setup_tests (void)
 		g_test_add_func ("/link/nl-bugs/spurious-newlink", test_nl_bugs_spuroius_newlink);
 		g_test_add_func ("/link/nl-bugs/spurious-dellink", test_nl_bugs_spuroius_dellink);
 
+		g_test_add_func ("/link/sysctl/recreate-link", test_sysctl_recreate_link);
+
 		g_test_add_vtable ("/general/netns/general", 0, NULL, _test_netns_setup, test_netns_general, _test_netns_teardown);
 		g_test_add_vtable ("/general/netns/set-netns", 0, NULL, _test_netns_setup, test_netns_set_netns, _test_netns_teardown);
 		g_test_add_vtable ("/general/netns/push", 0, NULL, _test_netns_setup, test_netns_push, _test_netns_teardown);
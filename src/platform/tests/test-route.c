@@ -305,6 +305,205 @@ test_ip6_route (void)
 
 /*****************************************************************************/
 
+static void
+test_ip4_route_batch (void)
+{
+	int ifindex = nm_platform_link_get_ifindex (NM_PLATFORM_GET, DEVICE_NAME);
+	SignalData *route_added = add_signal (NM_PLATFORM_SIGNAL_IP4_ROUTE_CHANGED, NM_PLATFORM_SIGNAL_ADDED, ip4_route_callback);
+	SignalData *route_removed = add_signal (NM_PLATFORM_SIGNAL_IP4_ROUTE_CHANGED, NM_PLATFORM_SIGNAL_REMOVED, ip4_route_callback);
+	NMPlatformBatch *batch;
+	NMPlatformIP4Route rts[3];
+	guint idx[4];
+	int metric = 22988;
+	guint i;
+
+	memset (rts, 0, sizeof (rts));
+	for (i = 0; i < G_N_ELEMENTS (rts); i++) {
+		rts[i].ifindex = ifindex;
+		rts[i].rt_source = NM_IP_CONFIG_SOURCE_USER;
+		rts[i].metric = metric;
+	}
+	rts[0].network = nmtst_inet4_from_string ("198.51.100.1");
+	rts[0].plen = 32;
+	rts[1].network = nmtst_inet4_from_string ("192.0.3.0");
+	rts[1].plen = 24;
+	rts[1].gateway = rts[0].network;
+	rts[2].network = nmtst_inet4_from_string ("192.0.4.0");
+	rts[2].plen = 24;
+	rts[2].gateway = rts[0].network;
+
+	/* the operations are executed in order, so the gateway routes can
+	 * be added in the same batch as the route to the gateway. */
+	batch = nm_platform_batch_new (NM_PLATFORM_GET);
+	for (i = 0; i < G_N_ELEMENTS (rts); i++)
+		idx[i] = nm_platform_batch_add (batch, NMP_OBJECT_TYPE_IP4_ROUTE, (const NMPlatformObject *) &rts[i]);
+	g_assert_cmpint (nm_platform_batch_get_len (batch), ==, 3);
+	g_assert (nm_platform_batch_commit (batch));
+	for (i = 0; i < G_N_ELEMENTS (rts); i++)
+		g_assert (nm_platform_batch_get_result (batch, idx[i]));
+	nm_platform_batch_free (batch);
+	accept_signals (route_added, 3, 3);
+
+	for (i = 0; i < G_N_ELEMENTS (rts); i++)
+		nmtstp_assert_ip4_route_exists (NULL, TRUE, DEVICE_NAME, rts[i].network, rts[i].plen, metric);
+
+	/* delete the routes again in reverse order. Deleting a non-existing route
+	 * with metric 0 succeeds without touching the other routes. */
+	batch = nm_platform_batch_new (NM_PLATFORM_GET);
+	rts[1].metric = 0;
+	idx[3] = nm_platform_batch_delete (batch, NMP_OBJECT_TYPE_IP4_ROUTE, (const NMPlatformObject *) &rts[1]);
+	rts[1].metric = metric;
+	for (i = G_N_ELEMENTS (rts); i > 0; i--)
+		idx[i - 1] = nm_platform_batch_delete (batch, NMP_OBJECT_TYPE_IP4_ROUTE, (const NMPlatformObject *) &rts[i - 1]);
+	g_assert (nm_platform_batch_commit (batch));
+	for (i = 0; i < G_N_ELEMENTS (idx); i++)
+		g_assert (nm_platform_batch_get_result (batch, idx[i]));
+	nm_platform_batch_free (batch);
+	accept_signals (route_removed, 3, 3);
+
+	for (i = 0; i < G_N_ELEMENTS (rts); i++)
+		nmtstp_assert_ip4_route_exists (NULL, FALSE, DEVICE_NAME, rts[i].network, rts[i].plen, metric);
+
+	free_signal (route_added);
+	free_signal (route_removed);
+}
+
+static void
+test_ip4_route_snapshot (void)
+{
+	int ifindex = nm_platform_link_get_ifindex (NM_PLATFORM_GET, DEVICE_NAME);
+	in_addr_t network = nmtst_inet4_from_string ("198.51.100.0");
+	NMPlatformSnapshot *snapshot1, *snapshot2;
+	const GArray *routes;
+	guint64 generation;
+	int metric = 22990;
+	guint i;
+	gboolean found;
+
+	snapshot1 = nm_platform_ip4_route_get_snapshot (NM_PLATFORM_GET, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_NONE);
+	g_assert (snapshot1);
+	generation = nm_platform_snapshot_get_generation (snapshot1);
+	g_assert_cmpint (generation, ==, nm_platform_get_generation (NM_PLATFORM_GET, NMP_OBJECT_TYPE_IP4_ROUTE));
+
+	/* without changes, the same snapshot is shared. */
+	snapshot2 = nm_platform_ip4_route_get_snapshot (NM_PLATFORM_GET, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_NONE);
+	g_assert (snapshot1 == snapshot2);
+	nm_platform_snapshot_unref (snapshot2);
+
+	g_assert (nm_platform_ip4_route_add (NM_PLATFORM_GET, ifindex, NM_IP_CONFIG_SOURCE_USER, network, 24, INADDR_ANY, 0, metric, 0));
+	g_assert_cmpint (nm_platform_get_generation (NM_PLATFORM_GET, NMP_OBJECT_TYPE_IP4_ROUTE), >, generation);
+
+	snapshot2 = nm_platform_ip4_route_get_snapshot (NM_PLATFORM_GET, ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_NONE);
+	g_assert (snapshot1 != snapshot2);
+	g_assert_cmpint (nm_platform_snapshot_get_generation (snapshot2), >, generation);
+
+	/* the old snapshot is unchanged. */
+	routes = nm_platform_snapshot_get_array (snapshot1);
+	for (i = 0; i < routes->len; i++)
+		g_assert (g_array_index (routes, NMPlatformIP4Route, i).metric != metric);
+
+	routes = nm_platform_snapshot_get_array (snapshot2);
+	found = FALSE;
+	for (i = 0; i < routes->len; i++) {
+		const NMPlatformIP4Route *r = &g_array_index (routes, NMPlatformIP4Route, i);
+
+		if (r->network == network && r->plen == 24 && r->metric == metric)
+			found = TRUE;
+	}
+	g_assert (found);
+
+	nm_platform_snapshot_unref (snapshot1);
+	nm_platform_snapshot_unref (snapshot2);
+
+	g_assert (nm_platform_ip4_route_delete (NM_PLATFORM_GET, ifindex, network, 24, metric));
+}
+
+static void
+test_ip4_route_lpm (void)
+{
+	int ifindex = nm_platform_link_get_ifindex (NM_PLATFORM_GET, DEVICE_NAME);
+	in_addr_t net24 = nmtst_inet4_from_string ("198.51.100.0");
+	in_addr_t net25 = nmtst_inet4_from_string ("198.51.100.128");
+	in_addr_t gateway = nmtst_inet4_from_string ("198.51.100.1");
+	const NMPlatformIP4Route *r;
+	int metric = 22989;
+
+	g_assert (!nm_platform_ip4_route_get_lpm (NM_PLATFORM_GET, ifindex, nmtst_inet4_from_string ("198.51.100.200"), FALSE));
+
+	g_assert (nm_platform_ip4_route_add (NM_PLATFORM_GET, ifindex, NM_IP_CONFIG_SOURCE_USER, net24, 24, INADDR_ANY, 0, metric + 1, 0));
+	g_assert (nm_platform_ip4_route_add (NM_PLATFORM_GET, ifindex, NM_IP_CONFIG_SOURCE_USER, net24, 24, INADDR_ANY, 0, metric, 0));
+	g_assert (nm_platform_ip4_route_add (NM_PLATFORM_GET, ifindex, NM_IP_CONFIG_SOURCE_USER, net25, 25, gateway, 0, metric, 0));
+
+	/* the longest prefix wins, ... */
+	r = nm_platform_ip4_route_get_lpm (NM_PLATFORM_GET, ifindex, nmtst_inet4_from_string ("198.51.100.200"), FALSE);
+	g_assert (r);
+	g_assert_cmpint (r->network, ==, net25);
+	g_assert_cmpint (r->plen, ==, 25);
+
+	/* ... unless only direct routes are requested. Then the lowest metric
+	 * of the next shorter prefix. */
+	r = nm_platform_ip4_route_get_lpm (NM_PLATFORM_GET, ifindex, nmtst_inet4_from_string ("198.51.100.200"), TRUE);
+	g_assert (r);
+	g_assert_cmpint (r->network, ==, net24);
+	g_assert_cmpint (r->plen, ==, 24);
+	g_assert_cmpint (r->metric, ==, metric);
+
+	r = nm_platform_ip4_route_get_lpm (NM_PLATFORM_GET, ifindex, nmtst_inet4_from_string ("198.51.100.5"), FALSE);
+	g_assert (r);
+	g_assert_cmpint (r->plen, ==, 24);
+	g_assert_cmpint (r->metric, ==, metric);
+
+	g_assert (!nm_platform_ip4_route_get_lpm (NM_PLATFORM_GET, ifindex, nmtst_inet4_from_string ("198.51.101.5"), FALSE));
+
+	g_assert (nm_platform_ip4_route_delete (NM_PLATFORM_GET, ifindex, net25, 25, metric));
+	r = nm_platform_ip4_route_get_lpm (NM_PLATFORM_GET, ifindex, nmtst_inet4_from_string ("198.51.100.200"), FALSE);
+	g_assert (r);
+	g_assert_cmpint (r->plen, ==, 24);
+	g_assert_cmpint (r->metric, ==, metric);
+
+	g_assert (nm_platform_ip4_route_delete (NM_PLATFORM_GET, ifindex, net24, 24, metric));
+	r = nm_platform_ip4_route_get_lpm (NM_PLATFORM_GET, ifindex, nmtst_inet4_from_string ("198.51.100.200"), FALSE);
+	g_assert (r);
+	g_assert_cmpint (r->metric, ==, metric + 1);
+
+	g_assert (nm_platform_ip4_route_delete (NM_PLATFORM_GET, ifindex, net24, 24, metric + 1));
+	g_assert (!nm_platform_ip4_route_get_lpm (NM_PLATFORM_GET, ifindex, nmtst_inet4_from_string ("198.51.100.200"), FALSE));
+}
+
+/*****************************************************************************/
+
+static void
+test_ip4_route_link_removed (void)
+{
+	const char *dummy_name = "nm-test-dummy1";
+	int ifindex = nm_platform_link_get_ifindex (NM_PLATFORM_GET, DEVICE_NAME);
+	int dummy_ifindex;
+	in_addr_t network = nmtst_inet4_from_string ("198.51.100.0");
+	int metric = 22989;
+	GArray *routes;
+
+	dummy_ifindex = nmtstp_link_dummy_add (NM_PLATFORM_GET, -1, dummy_name)->ifindex;
+	nmtstp_link_set_updown (NM_PLATFORM_GET, -1, dummy_ifindex, TRUE);
+
+	g_assert (nm_platform_ip4_route_add (NM_PLATFORM_GET, ifindex, NM_IP_CONFIG_SOURCE_USER, network, 24, INADDR_ANY, 0, metric, 0));
+	g_assert (nm_platform_ip4_route_add (NM_PLATFORM_GET, dummy_ifindex, NM_IP_CONFIG_SOURCE_USER, network, 24, INADDR_ANY, 0, metric, 0));
+	g_assert (nm_platform_ip4_route_get (NM_PLATFORM_GET, dummy_ifindex, network, 24, metric));
+
+	/* removing the link drops its routes from the cache, but leaves
+	 * the routes of other links alone. */
+	nmtstp_link_del (NM_PLATFORM_GET, -1, dummy_ifindex, dummy_name);
+	nm_platform_process_events (NM_PLATFORM_GET);
+
+	routes = nm_platform_ip4_route_get_all (NM_PLATFORM_GET, dummy_ifindex, NM_PLATFORM_GET_ROUTE_FLAGS_WITH_DEFAULT | NM_PLATFORM_GET_ROUTE_FLAGS_WITH_NON_DEFAULT);
+	g_assert_cmpint (routes->len, ==, 0);
+	g_array_unref (routes);
+
+	g_assert (nm_platform_ip4_route_get (NM_PLATFORM_GET, ifindex, network, 24, metric));
+	g_assert (nm_platform_ip4_route_delete (NM_PLATFORM_GET, ifindex, network, 24, metric));
+}
+
+/*****************************************************************************/
+
 static void
 test_ip4_zero_gateway (void)
 {
@@ -350,6 +549,10 @@ _nmtstp_setup_tests (void)
 	g_test_add_func ("/route/ip4", test_ip4_route);
 	g_test_add_func ("/route/ip6", test_ip6_route);
 	g_test_add_func ("/route/ip4_metric0", test_ip4_route_metric0);
+	g_test_add_func ("/route/ip4_batch", test_ip4_route_batch);
+	g_test_add_func ("/route/ip4_lpm", test_ip4_route_lpm);
+	g_test_add_func ("/route/ip4_snapshot", test_ip4_route_snapshot);
+	g_test_add_func ("/route/ip4_link_removed", test_ip4_route_link_removed);
 
 	if (nmtstp_is_root_test ())
 		g_test_add_func ("/route/ip4_zero_gateway", test_ip4_zero_gateway);
@@ -24,6 +24,9 @@
 #include "nm-settings-connection.h"
 
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "nm-common-macros.h"
 #include "nm-dbus-interface.h"
@@ -118,6 +121,12 @@ typedef struct {
 	 */
 	NMConnection *agent_secrets;
 
+	/* The reply to GetSettings(), without secrets. Built on demand and
+	 * dropped whenever the connection, the timestamp or the seen BSSIDs
+	 * change, so that clients polling all profiles don't cause them to
+	 * be serialized over and over again. */
+	GVariant *settings_dbus;
+
 	guint64 timestamp;   /* Up-to-date timestamp of connection use */
 	gboolean timestamp_set;
 	GHashTable *seen_bssids; /* Up-to-date BSSIDs that's been seen for the connection */
@@ -139,6 +148,18 @@ _emit_updated (NMSettingsConnection *self, gboolean by_user)
 	g_signal_emit (self, signals[UPDATED_INTERNAL], 0, by_user);
 }
 
+static void
+_settings_dbus_clear (NMSettingsConnection *self)
+{
+	g_clear_pointer (&NM_SETTINGS_CONNECTION_GET_PRIVATE (self)->settings_dbus, g_variant_unref);
+}
+
+static void
+settings_dbus_changed_cb (NMSettingsConnection *self, gpointer unused)
+{
+	_settings_dbus_clear (self);
+}
+
 /*******************************************************************/
 
 gboolean
@@ -691,42 +712,381 @@ nm_settings_connection_delete (NMSettingsConnection *self,
 	}
 }
 
+/*************************************************************/
+
+/* The timestamps and seen-bssids databases are kept in memory. They are
+ * loaded once from their keyfile, and changes are appended to a log file
+ * next to it ("<file>.log"), one "<uuid>=<value>" record per line, or
+ * "<uuid>" alone for a removal. Appends are batched and fsync()ed from a
+ * timeout; once the log grows larger than the table, the keyfile is
+ * rewritten from memory and the log deleted. */
+
+#define STATE_DB_FLUSH_DELAY_MSEC  1000
+#define STATE_DB_COMPACT_MIN       200
+
+typedef enum {
+	STATE_DB_TIMESTAMPS,
+	STATE_DB_SEEN_BSSIDS,
+	_STATE_DB_NUM,
+} StateDBType;
+
+typedef struct _NMSettingsStateDB {
+	const char *filename;
+	const char *log_filename;
+	const char *group;
+
+	/* uuid => value, as the raw keyfile value. */
+	GHashTable *entries;
+
+	/* log records not yet written to disk. */
+	GString *pending;
+	guint pending_records;
+
+	/* number of records in the log file on disk. */
+	guint log_records;
+
+	/* the log file might end with a partial record, so that appending
+	 * to it is unsafe. The next flush rewrites the keyfile instead. */
+	gboolean dirty;
+
+	guint flush_id;
+} StateDB;
+
+static StateDB state_dbs[_STATE_DB_NUM] = {
+	[STATE_DB_TIMESTAMPS] = {
+		.filename     = SETTINGS_TIMESTAMPS_FILE,
+		.log_filename = SETTINGS_TIMESTAMPS_FILE ".log",
+		.group        = "timestamps",
+	},
+	[STATE_DB_SEEN_BSSIDS] = {
+		.filename     = SETTINGS_SEEN_BSSIDS_FILE,
+		.log_filename = SETTINGS_SEEN_BSSIDS_FILE ".log",
+		.group        = "seen-bssids",
+	},
+};
+
 static void
-remove_entry_from_db (NMSettingsConnection *self, const char* db_name)
+_state_db_replay_log (StateDB *db)
 {
-	GKeyFile *key_file;
-	const char *db_file;
+	gs_free char *contents = NULL;
+	gs_free_error GError *error = NULL;
+	char *line, *eol, *eq;
 
-	if (strcmp (db_name, "timestamps") == 0)
-		db_file = SETTINGS_TIMESTAMPS_FILE;
-	else if (strcmp (db_name, "seen-bssids") == 0)
-		db_file = SETTINGS_SEEN_BSSIDS_FILE;
-	else
+	if (!g_file_get_contents (db->log_filename, &contents, NULL, &error)) {
+		if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT)) {
+			nm_log_warn (LOGD_SETTINGS, "error reading %s log '%s': %s",
+			             db->group, db->log_filename, error->message);
+		}
 		return;
+	}
 
-	key_file = g_key_file_new ();
-	if (g_key_file_load_from_file (key_file, db_file, G_KEY_FILE_KEEP_COMMENTS, NULL)) {
-		const char *connection_uuid;
-		char *data;
-		gsize len;
-		GError *error = NULL;
-
-		connection_uuid = nm_settings_connection_get_uuid (self);
-
-		g_key_file_remove_key (key_file, db_name, connection_uuid, NULL);
-		data = g_key_file_to_data (key_file, &len, &error);
-		if (data) {
-			g_file_set_contents (db_file, data, len, &error);
-			g_free (data);
+	for (line = contents; (eol = strchr (line, '\n')); line = eol + 1) {
+		*eol = '\0';
+		if (!line[0])
+			continue;
+		eq = strchr (line, '=');
+		if (eq) {
+			*eq = '\0';
+			g_hash_table_insert (db->entries, g_strdup (line), g_strdup (&eq[1]));
+		} else
+			g_hash_table_remove (db->entries, line);
+		db->log_records++;
+	}
+
+	if (line[0]) {
+		/* A trailing record without newline was interrupted while being
+		 * written. Ignore it, and cut it off so that the next record is
+		 * not appended to it. */
+		nm_log_warn (LOGD_SETTINGS, "ignoring partial record at the end of %s log '%s'",
+		             db->group, db->log_filename);
+		if (truncate (db->log_filename, line - contents) != 0) {
+			nm_log_warn (LOGD_SETTINGS, "error truncating %s log '%s': %s",
+			             db->group, db->log_filename, g_strerror (errno));
+			db->dirty = TRUE;
 		}
-		if (error) {
-			_LOGW ("error writing %s file '%s': %s", db_name, db_file, error->message);
-			g_error_free (error);
+	}
+}
+
+static void
+_state_db_load (StateDB *db)
+{
+	GKeyFile *key_file;
+	gs_free_error GError *error = NULL;
+
+	nm_assert (!db->entries);
+
+	db->entries = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	db->pending = g_string_new (NULL);
+
+	key_file = g_key_file_new ();
+	if (g_key_file_load_from_file (key_file, db->filename, G_KEY_FILE_KEEP_COMMENTS, &error)) {
+		gs_strfreev char **keys = NULL;
+		guint i;
+
+		keys = g_key_file_get_keys (key_file, db->group, NULL, NULL);
+		for (i = 0; keys && keys[i]; i++) {
+			char *value;
+
+			value = g_key_file_get_value (key_file, db->group, keys[i], NULL);
+			if (value)
+				g_hash_table_insert (db->entries, g_strdup (keys[i]), value);
 		}
+	} else if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT)) {
+		nm_log_warn (LOGD_SETTINGS, "error parsing %s file '%s': %s",
+		             db->group, db->filename, error->message);
 	}
 	g_key_file_free (key_file);
+
+	_state_db_replay_log (db);
+}
+
+static StateDB *
+_state_db_get (StateDBType type)
+{
+	StateDB *db;
+
+	nm_assert (type < _STATE_DB_NUM);
+
+	db = &state_dbs[type];
+	if (G_UNLIKELY (!db->entries))
+		_state_db_load (db);
+	return db;
 }
 
+static gboolean
+_state_db_compact (StateDB *db)
+{
+	GKeyFile *key_file;
+	GHashTableIter iter;
+	const char *uuid, *value;
+	gs_free char *data = NULL;
+	gs_free_error GError *error = NULL;
+	gsize len;
+
+	key_file = g_key_file_new ();
+	g_hash_table_iter_init (&iter, db->entries);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &uuid, (gpointer *) &value))
+		g_key_file_set_value (key_file, db->group, uuid, value);
+	data = g_key_file_to_data (key_file, &len, NULL);
+	g_key_file_free (key_file);
+
+	if (!g_file_set_contents (db->filename, data, len, &error)) {
+		nm_log_warn (LOGD_SETTINGS, "error writing %s file '%s': %s",
+		             db->group, db->filename, error->message);
+		return FALSE;
+	}
+
+	/* The records of the log are older than the keyfile now. Replaying
+	 * them on the next start would revert newer values, so the log must
+	 * go. */
+	if (   unlink (db->log_filename) != 0
+	    && errno != ENOENT
+	    && truncate (db->log_filename, 0) != 0) {
+		nm_log_warn (LOGD_SETTINGS, "error removing %s log '%s': %s",
+		             db->group, db->log_filename, g_strerror (errno));
+		db->dirty = TRUE;
+		return TRUE;
+	}
+	db->log_records = 0;
+	db->dirty = FALSE;
+	return TRUE;
+}
+
+static gboolean
+_state_db_append (StateDB *db)
+{
+	const char *buf = db->pending->str;
+	gsize len = db->pending->len;
+	int fd, errsv;
+
+	nm_assert (!db->dirty);
+
+	fd = open (db->log_filename, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+	if (fd < 0) {
+		errsv = errno;
+		goto fail;
+	}
+
+	while (len > 0) {
+		ssize_t n;
+
+		n = write (fd, buf, len);
+		if (n < 0) {
+			errsv = errno;
+			if (errsv == EINTR)
+				continue;
+			close (fd);
+			db->dirty = TRUE;
+			goto fail;
+		}
+		buf += n;
+		len -= n;
+	}
+
+	if (fsync (fd) != 0) {
+		errsv = errno;
+		close (fd);
+		db->dirty = TRUE;
+		goto fail;
+	}
+	close (fd);
+
+	db->log_records += db->pending_records;
+	return TRUE;
+
+fail:
+	nm_log_warn (LOGD_SETTINGS, "error writing %s log '%s': %s",
+	             db->group, db->log_filename, g_strerror (errsv));
+	return FALSE;
+}
+
+static void
+_state_db_flush (StateDB *db)
+{
+	gboolean success;
+
+	nm_clear_g_source (&db->flush_id);
+
+	if (!db->pending_records && !db->dirty)
+		return;
+
+	if (   !db->dirty
+	    && db->log_records + db->pending_records <= MAX (STATE_DB_COMPACT_MIN, g_hash_table_size (db->entries)))
+		success = _state_db_append (db);
+	else {
+		success = _state_db_compact (db);
+		if (!success && !db->dirty)
+			success = _state_db_append (db);
+	}
+
+	/* On failure, keep the records pending for the next flush. After a
+	 * failed append, the log might end with a partial record. Then the
+	 * next flush rewrites the keyfile. */
+	if (!success)
+		return;
+
+	g_string_truncate (db->pending, 0);
+	db->pending_records = 0;
+}
+
+static gboolean
+_state_db_flush_cb (gpointer user_data)
+{
+	StateDB *db = user_data;
+
+	db->flush_id = 0;
+	_state_db_flush (db);
+	return G_SOURCE_REMOVE;
+}
+
+static const char *
+_state_db_lookup (StateDB *db, const char *uuid)
+{
+	return uuid ? g_hash_table_lookup (db->entries, uuid) : NULL;
+}
+
+/* Sets or, with a %NULL @value, removes the entry for @uuid and schedules
+ * writing the change to disk. */
+static void
+_state_db_set (StateDB *db, const char *uuid, const char *value)
+{
+	const char *old;
+
+	if (!uuid)
+		return;
+
+	nm_assert (strchr (uuid, '\n') == NULL && strchr (uuid, '=') == NULL);
+	nm_assert (!value || strchr (value, '\n') == NULL);
+
+	old = g_hash_table_lookup (db->entries, uuid);
+	if (!value) {
+		if (!old)
+			return;
+		g_hash_table_remove (db->entries, uuid);
+		g_string_append_printf (db->pending, "%s\n", uuid);
+	} else {
+		if (g_strcmp0 (old, value) == 0)
+			return;
+		g_hash_table_insert (db->entries, g_strdup (uuid), g_strdup (value));
+		g_string_append_printf (db->pending, "%s=%s\n", uuid, value);
+	}
+	db->pending_records++;
+
+	if (!db->flush_id)
+		db->flush_id = g_timeout_add (STATE_DB_FLUSH_DELAY_MSEC, _state_db_flush_cb, db);
+}
+
+/* exposed for testing. These operate on a database at @filename instead of
+ * the timestamps or seen-bssids files. */
+
+NMSettingsStateDB *
+_nm_settings_state_db_new (const char *filename, const char *group)
+{
+	StateDB *db;
+
+	db = g_slice_new0 (StateDB);
+	db->filename = g_strdup (filename);
+	db->log_filename = g_strdup_printf ("%s.log", filename);
+	db->group = g_strdup (group);
+	_state_db_load (db);
+	return db;
+}
+
+void
+_nm_settings_state_db_free (NMSettingsStateDB *db)
+{
+	nm_clear_g_source (&db->flush_id);
+	g_hash_table_unref (db->entries);
+	g_string_free (db->pending, TRUE);
+	g_free ((char *) db->filename);
+	g_free ((char *) db->log_filename);
+	g_free ((char *) db->group);
+	g_slice_free (StateDB, db);
+}
+
+const char *
+_nm_settings_state_db_lookup (NMSettingsStateDB *db, const char *uuid)
+{
+	return _state_db_lookup (db, uuid);
+}
+
+void
+_nm_settings_state_db_set (NMSettingsStateDB *db, const char *uuid, const char *value)
+{
+	_state_db_set (db, uuid, value);
+}
+
+void
+_nm_settings_state_db_flush (NMSettingsStateDB *db)
+{
+	_state_db_flush (db);
+}
+
+guint
+_nm_settings_state_db_get_log_records (NMSettingsStateDB *db)
+{
+	return db->log_records;
+}
+
+/**
+ * nm_settings_connection_flush_state:
+ *
+ * Writes pending changes to the timestamps and seen-bssids databases
+ * to disk. Called on shutdown.
+ **/
+void
+nm_settings_connection_flush_state (void)
+{
+	guint i;
+
+	for (i = 0; i < _STATE_DB_NUM; i++) {
+		if (state_dbs[i].entries)
+			_state_db_flush (&state_dbs[i]);
+	}
+}
+
+/*************************************************************/
+
 static void
 do_delete (NMSettingsConnection *self,
            NMSettingsConnectionDeleteFunc callback,
@@ -746,11 +1106,11 @@ do_delete (NMSettingsConnection *self,
 	                                 for_agents);
 	g_object_unref (for_agents);
 
-	/* Remove timestamp from timestamps database file */
-	remove_entry_from_db (self, "timestamps");
-
-	/* Remove connection from seen-bssids database file */
-	remove_entry_from_db (self, "seen-bssids");
+	/* Remove timestamp and seen-bssids from the state databases */
+	_state_db_set (_state_db_get (STATE_DB_TIMESTAMPS),
+	               nm_settings_connection_get_uuid (self), NULL);
+	_state_db_set (_state_db_get (STATE_DB_SEEN_BSSIDS),
+	               nm_settings_connection_get_uuid (self), NULL);
 
 	nm_settings_connection_signal_remove (self);
 
@@ -1454,6 +1814,56 @@ check_writable (NMConnection *self, GError **error)
 	return TRUE;
 }
 
+static GVariant *
+_get_settings_dbus (NMSettingsConnection *self)
+{
+	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
+	NMConnection *dupl_con;
+	NMSettingConnection *s_con;
+	NMSettingWireless *s_wifi;
+	guint64 timestamp = 0;
+	char **bssids;
+
+	if (priv->settings_dbus)
+		return priv->settings_dbus;
+
+	dupl_con = nm_simple_connection_new_clone (NM_CONNECTION (self));
+	g_assert (dupl_con);
+
+	/* Timestamp is not updated in connection's 'timestamp' property,
+	 * because it would force updating the connection and in turn
+	 * writing to /etc periodically, which we want to avoid. Rather real
+	 * timestamps are kept track of in a private variable. So, substitute
+	 * timestamp property with the real one here before returning the settings.
+	 */
+	nm_settings_connection_get_timestamp (self, &timestamp);
+	if (timestamp) {
+		s_con = nm_connection_get_setting_connection (NM_CONNECTION (dupl_con));
+		g_assert (s_con);
+		g_object_set (s_con, NM_SETTING_CONNECTION_TIMESTAMP, timestamp, NULL);
+	}
+	/* Seen BSSIDs are not updated in 802-11-wireless 'seen-bssids' property
+	 * from the same reason as timestamp. Thus we put it here to GetSettings()
+	 * return settings too.
+	 */
+	bssids = nm_settings_connection_get_seen_bssids (self);
+	s_wifi = nm_connection_get_setting_wireless (NM_CONNECTION (dupl_con));
+	if (bssids && bssids[0] && s_wifi)
+		g_object_set (s_wifi, NM_SETTING_WIRELESS_SEEN_BSSIDS, bssids, NULL);
+	g_free (bssids);
+
+	/* Secrets should *never* be returned by the GetSettings method, they
+	 * get returned by the GetSecrets method which can be better
+	 * protected against leakage of secrets to unprivileged callers.
+	 */
+	priv->settings_dbus = nm_connection_to_dbus (NM_CONNECTION (dupl_con), NM_CONNECTION_SERIALIZE_NO_SECRETS);
+	g_assert (priv->settings_dbus);
+	g_variant_ref_sink (priv->settings_dbus);
+	g_object_unref (dupl_con);
+
+	return priv->settings_dbus;
+}
+
 static void
 get_settings_auth_cb (NMSettingsConnection *self, 
                       GDBusMethodInvocation *context,
@@ -1464,47 +1874,9 @@ get_settings_auth_cb (NMSettingsConnection *self,
 	if (error)
 		g_dbus_method_invocation_return_gerror (context, error);
 	else {
-		GVariant *settings;
-		NMConnection *dupl_con;
-		NMSettingConnection *s_con;
-		NMSettingWireless *s_wifi;
-		guint64 timestamp = 0;
-		char **bssids;
-
-		dupl_con = nm_simple_connection_new_clone (NM_CONNECTION (self));
-		g_assert (dupl_con);
-
-		/* Timestamp is not updated in connection's 'timestamp' property,
-		 * because it would force updating the connection and in turn
-		 * writing to /etc periodically, which we want to avoid. Rather real
-		 * timestamps are kept track of in a private variable. So, substitute
-		 * timestamp property with the real one here before returning the settings.
-		 */
-		nm_settings_connection_get_timestamp (self, &timestamp);
-		if (timestamp) {
-			s_con = nm_connection_get_setting_connection (NM_CONNECTION (dupl_con));
-			g_assert (s_con);
-			g_object_set (s_con, NM_SETTING_CONNECTION_TIMESTAMP, timestamp, NULL);
-		}
-		/* Seen BSSIDs are not updated in 802-11-wireless 'seen-bssids' property
-		 * from the same reason as timestamp. Thus we put it here to GetSettings()
-		 * return settings too.
-		 */
-		bssids = nm_settings_connection_get_seen_bssids (self);
-		s_wifi = nm_connection_get_setting_wireless (NM_CONNECTION (dupl_con));
-		if (bssids && bssids[0] && s_wifi)
-			g_object_set (s_wifi, NM_SETTING_WIRELESS_SEEN_BSSIDS, bssids, NULL);
-		g_free (bssids);
-
-		/* Secrets should *never* be returned by the GetSettings method, they
-		 * get returned by the GetSecrets method which can be better
-		 * protected against leakage of secrets to unprivileged callers.
-		 */
-		settings = nm_connection_to_dbus (NM_CONNECTION (dupl_con), NM_CONNECTION_SERIALIZE_NO_SECRETS);
-		g_assert (settings);
 		g_dbus_method_invocation_return_value (context,
-		                                       g_variant_new ("(@a{sa{sv}})", settings));
-		g_object_unref (dupl_con);
+		                                       g_variant_new ("(@a{sa{sv}})",
+		                                                      _get_settings_dbus (self)));
 	}
 }
 
@@ -2151,6 +2523,22 @@ nm_settings_connection_set_flags_all (NMSettingsConnection *self, NMSettingsConn
 
 /*************************************************************/
 
+/* incremented whenever the timestamp of any connection changes. */
+static guint timestamps_serial;
+
+/**
+ * nm_settings_connection_get_timestamps_serial:
+ *
+ * Returns: a counter that changes whenever the timestamp of any
+ * connection changes. Users that cache connections sorted by
+ * timestamp use it to know when to sort again.
+ **/
+guint
+nm_settings_connection_get_timestamps_serial (void)
+{
+	return timestamps_serial;
+}
+
 /**
  * nm_settings_connection_get_timestamp:
  * @self: the #NMSettingsConnection
@@ -2187,44 +2575,26 @@ nm_settings_connection_update_timestamp (NMSettingsConnection *self,
                                          gboolean flush_to_disk)
 {
 	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
-	const char *connection_uuid;
-	GKeyFile *timestamps_file;
-	char *data, *tmp;
-	gsize len;
-	GError *error = NULL;
+	char buf[30];
 
 	g_return_if_fail (NM_IS_SETTINGS_CONNECTION (self));
 
 	/* Update timestamp in private storage */
+	if (   !priv->timestamp_set
+	    || priv->timestamp != timestamp)
+		timestamps_serial++;
 	priv->timestamp = timestamp;
 	priv->timestamp_set = TRUE;
+	_settings_dbus_clear (self);
 
 	if (flush_to_disk == FALSE)
 		return;
 
-	/* Save timestamp to timestamps database file */
-	timestamps_file = g_key_file_new ();
-	if (!g_key_file_load_from_file (timestamps_file, SETTINGS_TIMESTAMPS_FILE, G_KEY_FILE_KEEP_COMMENTS, &error)) {
-		if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
-			_LOGW ("error parsing timestamps file '%s': %s", SETTINGS_TIMESTAMPS_FILE, error->message);
-		g_clear_error (&error);
-	}
-
-	connection_uuid = nm_settings_connection_get_uuid (self);
-	tmp = g_strdup_printf ("%" G_GUINT64_FORMAT, timestamp);
-	g_key_file_set_value (timestamps_file, "timestamps", connection_uuid, tmp);
-	g_free (tmp);
-
-	data = g_key_file_to_data (timestamps_file, &len, &error);
-	if (data) {
-		g_file_set_contents (SETTINGS_TIMESTAMPS_FILE, data, len, &error);
-		g_free (data);
-	}
-	if (error) {
-		_LOGW ("error saving timestamp to file '%s': %s", SETTINGS_TIMESTAMPS_FILE, error->message);
-		g_error_free (error);
-	}
-	g_key_file_free (timestamps_file);
+	/* Save timestamp to timestamps database */
+	g_snprintf (buf, sizeof (buf), "%" G_GUINT64_FORMAT, timestamp);
+	_state_db_set (_state_db_get (STATE_DB_TIMESTAMPS),
+	               nm_settings_connection_get_uuid (self),
+	               buf);
 }
 
 /**
@@ -2238,33 +2608,27 @@ void
 nm_settings_connection_read_and_fill_timestamp (NMSettingsConnection *self)
 {
 	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
-	const char *connection_uuid;
-	guint64 timestamp = 0;
-	GKeyFile *timestamps_file;
-	GError *err = NULL;
-	char *tmp_str;
+	const char *tmp_str;
+	guint64 timestamp;
 
 	g_return_if_fail (NM_IS_SETTINGS_CONNECTION (self));
 
-	/* Get timestamp from database file */
-	timestamps_file = g_key_file_new ();
-	g_key_file_load_from_file (timestamps_file, SETTINGS_TIMESTAMPS_FILE, G_KEY_FILE_KEEP_COMMENTS, NULL);
-	connection_uuid = nm_settings_connection_get_uuid (self);
-	tmp_str = g_key_file_get_value (timestamps_file, "timestamps", connection_uuid, &err);
-	if (tmp_str) {
-		timestamp = g_ascii_strtoull (tmp_str, NULL, 10);
-		g_free (tmp_str);
+	/* Get timestamp from database */
+	tmp_str = _state_db_lookup (_state_db_get (STATE_DB_TIMESTAMPS),
+	                            nm_settings_connection_get_uuid (self));
+	if (!tmp_str) {
+		_LOGD ("no timestamp in database");
+		return;
 	}
 
 	/* Update connection's timestamp */
-	if (!err) {
-		priv->timestamp = timestamp;
-		priv->timestamp_set = TRUE;
-	} else {
-		_LOGD ("failed to read connection timestamp: %s", err->message);
-		g_clear_error (&err);
-	}
-	g_key_file_free (timestamps_file);
+	timestamp = g_ascii_strtoull (tmp_str, NULL, 10);
+	if (   !priv->timestamp_set
+	    || priv->timestamp != timestamp)
+		timestamps_serial++;
+	priv->timestamp = timestamp;
+	priv->timestamp_set = TRUE;
+	_settings_dbus_clear (self);
 }
 
 /**
@@ -2327,14 +2691,9 @@ nm_settings_connection_add_seen_bssid (NMSettingsConnection *self,
                                        const char *seen_bssid)
 {
 	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
-	const char *connection_uuid;
-	GKeyFile *seen_bssids_file;
-	char *data, *bssid_str;
-	const char **list;
-	gsize len;
-	GError *error = NULL;
+	GString *str;
+	char *bssid_str;
 	GHashTableIter iter;
-	guint n;
 
 	g_return_if_fail (seen_bssid != NULL);
 
@@ -2344,41 +2703,22 @@ nm_settings_connection_add_seen_bssid (NMSettingsConnection *self,
 	/* Add the new BSSID; let the hash take ownership of the allocated BSSID string */
 	bssid_str = g_strdup (seen_bssid);
 	g_hash_table_insert (priv->seen_bssids, bssid_str, bssid_str);
+	_settings_dbus_clear (self);
 
-	/* Build up a list of all the BSSIDs in string form */
-	n = 0;
-	list = g_malloc0 (g_hash_table_size (priv->seen_bssids) * sizeof (char *));
+	/* Build up the list of all BSSIDs the way GKeyFile stores a
+	 * ','-separated string list */
+	str = g_string_new (NULL);
 	g_hash_table_iter_init (&iter, priv->seen_bssids);
-	while (g_hash_table_iter_next (&iter, NULL, (gpointer) &bssid_str))
-		list[n++] = bssid_str;
-
-	/* Save BSSID to seen-bssids file */
-	seen_bssids_file = g_key_file_new ();
-	g_key_file_set_list_separator (seen_bssids_file, ',');
-	if (!g_key_file_load_from_file (seen_bssids_file, SETTINGS_SEEN_BSSIDS_FILE, G_KEY_FILE_KEEP_COMMENTS, &error)) {
-		if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT)) {
-			_LOGW ("error parsing seen-bssids file '%s': %s",
-			       SETTINGS_SEEN_BSSIDS_FILE, error->message);
-		}
-		g_clear_error (&error);
-	}
-
-	connection_uuid = nm_settings_connection_get_uuid (self);
-	g_key_file_set_string_list (seen_bssids_file, "seen-bssids", connection_uuid, list, n);
-	g_free (list);
-
-	data = g_key_file_to_data (seen_bssids_file, &len, &error);
-	if (data) {
-		g_file_set_contents (SETTINGS_SEEN_BSSIDS_FILE, data, len, &error);
-		g_free (data);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer) &bssid_str)) {
+		g_string_append (str, bssid_str);
+		g_string_append_c (str, ',');
 	}
-	g_key_file_free (seen_bssids_file);
 
-	if (error) {
-		_LOGW ("error saving seen-bssids to file '%s': %s",
-		       SETTINGS_SEEN_BSSIDS_FILE, error->message);
-		g_error_free (error);
-	}
+	/* Save BSSIDs to seen-bssids database */
+	_state_db_set (_state_db_get (STATE_DB_SEEN_BSSIDS),
+	               nm_settings_connection_get_uuid (self),
+	               str->str);
+	g_string_free (str, TRUE);
 }
 
 /**
@@ -2392,27 +2732,27 @@ void
 nm_settings_connection_read_and_fill_seen_bssids (NMSettingsConnection *self)
 {
 	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
-	const char *connection_uuid;
-	GKeyFile *seen_bssids_file;
-	char **tmp_strv = NULL;
+	const char *value;
 	gsize i, len = 0;
 	NMSettingWireless *s_wifi;
 
-	/* Get seen BSSIDs from database file */
-	seen_bssids_file = g_key_file_new ();
-	g_key_file_set_list_separator (seen_bssids_file, ',');
-	if (g_key_file_load_from_file (seen_bssids_file, SETTINGS_SEEN_BSSIDS_FILE, G_KEY_FILE_KEEP_COMMENTS, NULL)) {
-		connection_uuid = nm_settings_connection_get_uuid (self);
-		tmp_strv = g_key_file_get_string_list (seen_bssids_file, "seen-bssids", connection_uuid, &len, NULL);
-	}
-	g_key_file_free (seen_bssids_file);
+	/* Get seen BSSIDs from database */
+	value = _state_db_lookup (_state_db_get (STATE_DB_SEEN_BSSIDS),
+	                          nm_settings_connection_get_uuid (self));
 
 	/* Update connection's seen-bssids */
-	if (tmp_strv) {
+	if (value) {
+		gs_strfreev char **tmp_strv = NULL;
+
 		g_hash_table_remove_all (priv->seen_bssids);
-		for (i = 0; i < len; i++)
-			g_hash_table_insert (priv->seen_bssids, tmp_strv[i], tmp_strv[i]);
-		g_free (tmp_strv);
+		tmp_strv = g_strsplit (value, ",", -1);
+		for (i = 0; tmp_strv[i]; i++) {
+			if (tmp_strv[i][0]) {
+				char *bssid_dup = g_strdup (tmp_strv[i]);
+
+				g_hash_table_insert (priv->seen_bssids, bssid_dup, bssid_dup);
+			}
+		}
 	} else {
 		/* If this connection didn't have an entry in the seen-bssids database,
 		 * maybe this is the first time we've read it in, so populate the
@@ -2429,6 +2769,7 @@ nm_settings_connection_read_and_fill_seen_bssids (NMSettingsConnection *self)
 			}
 		}
 	}
+	_settings_dbus_clear (self);
 }
 
 #define AUTOCONNECT_RETRIES_DEFAULT 4
@@ -2628,6 +2969,7 @@ nm_settings_connection_init (NMSettingsConnection *self)
 
 	g_signal_connect (self, NM_CONNECTION_SECRETS_CLEARED, G_CALLBACK (secrets_cleared_cb), NULL);
 	g_signal_connect (self, NM_CONNECTION_CHANGED, G_CALLBACK (connection_changed_cb), NULL);
+	g_signal_connect (self, NM_CONNECTION_CHANGED, G_CALLBACK (settings_dbus_changed_cb), NULL);
 }
 
 static void
@@ -2664,8 +3006,10 @@ dispose (GObject *object)
 	 */
 	g_signal_handlers_disconnect_by_func (self, G_CALLBACK (secrets_cleared_cb), NULL);
 	g_signal_handlers_disconnect_by_func (self, G_CALLBACK (connection_changed_cb), NULL);
+	g_signal_handlers_disconnect_by_func (self, G_CALLBACK (settings_dbus_changed_cb), NULL);
 
 	nm_connection_clear_secrets (NM_CONNECTION (self));
+	_settings_dbus_clear (self);
 	g_clear_object (&priv->system_secrets);
 	g_clear_object (&priv->agent_secrets);
 
@@ -184,6 +184,8 @@ NMSettingsConnectionFlags nm_settings_connection_get_flags (NMSettingsConnection
 NMSettingsConnectionFlags nm_settings_connection_set_flags (NMSettingsConnection *self, NMSettingsConnectionFlags flags, gboolean set);
 NMSettingsConnectionFlags nm_settings_connection_set_flags_all (NMSettingsConnection *self, NMSettingsConnectionFlags flags);
 
+guint nm_settings_connection_get_timestamps_serial (void);
+
 gboolean nm_settings_connection_get_timestamp (NMSettingsConnection *self,
                                                guint64 *out_timestamp);
 
@@ -203,6 +205,8 @@ void nm_settings_connection_add_seen_bssid (NMSettingsConnection *self,
 
 void nm_settings_connection_read_and_fill_seen_bssids (NMSettingsConnection *self);
 
+void nm_settings_connection_flush_state (void);
+
 int nm_settings_connection_get_autoconnect_retries (NMSettingsConnection *self);
 void nm_settings_connection_set_autoconnect_retries (NMSettingsConnection *self,
                                                      int retries);
@@ -230,6 +234,16 @@ const char *nm_settings_connection_get_filename (NMSettingsConnection *self);
 const char *nm_settings_connection_get_id   (NMSettingsConnection *connection);
 const char *nm_settings_connection_get_uuid (NMSettingsConnection *connection);
 
+/* exposed for testing */
+typedef struct _NMSettingsStateDB NMSettingsStateDB;
+
+NMSettingsStateDB *_nm_settings_state_db_new (const char *filename, const char *group);
+void               _nm_settings_state_db_free (NMSettingsStateDB *db);
+const char        *_nm_settings_state_db_lookup (NMSettingsStateDB *db, const char *uuid);
+void               _nm_settings_state_db_set (NMSettingsStateDB *db, const char *uuid, const char *value);
+void               _nm_settings_state_db_flush (NMSettingsStateDB *db);
+guint              _nm_settings_state_db_get_log_records (NMSettingsStateDB *db);
+
 G_END_DECLS
 
 #endif /* __NETWORKMANAGER_SETTINGS_CONNECTION_H__ */
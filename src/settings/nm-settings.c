@@ -57,6 +57,7 @@
 #include "nm-setting-adsl.h"
 #include "nm-setting-wireless.h"
 #include "nm-setting-wireless-security.h"
+#include "nm-setting-infiniband.h"
 #include "nm-setting-proxy.h"
 #include "nm-setting-bond.h"
 #include "nm-utils.h"
@@ -150,7 +151,16 @@ typedef struct {
 	GSList *plugins;
 	gboolean connections_loaded;
 	GHashTable *connections;
+	GHashTable *connections_by_uuid;
+	GHashTable *connection_uuids;
+	guint connections_by_uuid_shadowed;
 	NMSettingsConnection **connections_cached_list;
+	GPtrArray *connections_sorted;
+	guint connections_sorted_timestamps_serial;
+	GHashTable *candidate_keys;
+	GHashTable *candidates_by_ifname;
+	GHashTable *candidates_by_hwaddr;
+	GPtrArray *candidates_unlocked;
 	GSList *unmanaged_specs;
 	GSList *unrecognized_specs;
 
@@ -312,22 +322,79 @@ impl_settings_list_connections (NMSettings *self,
 NMSettingsConnection *
 nm_settings_get_connection_by_uuid (NMSettings *self, const char *uuid)
 {
-	NMSettingsPrivate *priv;
-	NMSettingsConnection *candidate;
-	GHashTableIter iter;
-
 	g_return_val_if_fail (NM_IS_SETTINGS (self), NULL);
 	g_return_val_if_fail (uuid != NULL, NULL);
 
-	priv = NM_SETTINGS_GET_PRIVATE (self);
+	return g_hash_table_lookup (NM_SETTINGS_GET_PRIVATE (self)->connections_by_uuid, uuid);
+}
 
-	g_hash_table_iter_init (&iter, priv->connections);
-	while (g_hash_table_iter_next (&iter, NULL, (gpointer) &candidate)) {
-		if (g_strcmp0 (uuid, nm_settings_connection_get_uuid (candidate)) == 0)
-			return candidate;
+/* After the connection indexed for @uuid went away, index another one with
+ * the same UUID, if any. */
+static void
+_uuid_index_reindex (NMSettings *self, const char *uuid)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	GHashTableIter iter;
+	gpointer connection, connection_uuid;
+
+	g_hash_table_iter_init (&iter, priv->connection_uuids);
+	while (g_hash_table_iter_next (&iter, &connection, &connection_uuid)) {
+		if (g_strcmp0 (connection_uuid, uuid) == 0) {
+			g_hash_table_insert (priv->connections_by_uuid, g_strdup (uuid), connection);
+			priv->connections_by_uuid_shadowed--;
+			return;
+		}
 	}
+}
 
-	return NULL;
+/* Keeps @connections_by_uuid in sync with the UUID of @connection, which
+ * can change when the connection gets updated. @connection_uuids remembers
+ * the UUID each connection was indexed with. With @remove, the connection
+ * is dropped from the index. */
+static void
+_uuid_index_update (NMSettings *self, NMSettingsConnection *connection, gboolean remove)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	const char *old_uuid;
+	const char *uuid = NULL;
+	gs_free char *reindex_uuid = NULL;
+
+	old_uuid = g_hash_table_lookup (priv->connection_uuids, connection);
+	if (!remove) {
+		uuid = nm_settings_connection_get_uuid (connection);
+		if (old_uuid && g_strcmp0 (old_uuid, uuid) == 0)
+			return;
+	}
+
+	if (old_uuid) {
+		if (g_hash_table_lookup (priv->connections_by_uuid, old_uuid) == connection) {
+			g_hash_table_remove (priv->connections_by_uuid, old_uuid);
+			if (priv->connections_by_uuid_shadowed)
+				reindex_uuid = g_strdup (old_uuid);
+		} else {
+			nm_assert (priv->connections_by_uuid_shadowed > 0);
+			priv->connections_by_uuid_shadowed--;
+		}
+		g_hash_table_remove (priv->connection_uuids, connection);
+
+		if (reindex_uuid)
+			_uuid_index_reindex (self, reindex_uuid);
+	}
+
+	if (remove)
+		return;
+
+	g_hash_table_insert (priv->connection_uuids, connection, g_strdup (uuid));
+
+	/* Duplicate UUIDs are rejected when claiming a connection. Should an
+	 * update still produce one, the connection indexed first wins and the
+	 * other one takes its place when it goes away. */
+	if (uuid) {
+		if (!g_hash_table_contains (priv->connections_by_uuid, uuid))
+			g_hash_table_insert (priv->connections_by_uuid, g_strdup (uuid), connection);
+		else
+			priv->connections_by_uuid_shadowed++;
+	}
 }
 
 static void
@@ -398,6 +465,15 @@ connection_sort (gconstpointer pa, gconstpointer pb)
 	if (can_ac_a != can_ac_b)
 		return can_ac_a ? -1 : 1;
 
+	if (can_ac_a) {
+		gint prio_a, prio_b;
+
+		prio_a = nm_setting_connection_get_autoconnect_priority (con_a);
+		prio_b = nm_setting_connection_get_autoconnect_priority (con_b);
+		if (prio_a != prio_b)
+			return prio_a > prio_b ? -1 : 1;
+	}
+
 	nm_settings_connection_get_timestamp (NM_SETTINGS_CONNECTION (pa), &ts_a);
 	nm_settings_connection_get_timestamp (NM_SETTINGS_CONNECTION (pb), &ts_b);
 	if (ts_a > ts_b)
@@ -454,26 +530,344 @@ nm_settings_get_connections (NMSettings *self, guint *out_len)
 	return v;
 }
 
+/* The sorted lists are kept up to date as connections are added, updated
+ * and removed. Connections are inserted after the ones that compare equal,
+ * so the order is stable. */
+static void
+_connections_sorted_insert (GPtrArray *sorted, NMSettingsConnection *connection)
+{
+	guint lo = 0, hi = sorted->len, mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (connection_sort (sorted->pdata[mid], connection) <= 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	g_ptr_array_insert (sorted, lo, connection);
+}
+
+/* A stable insertion sort. It is about linear for lists that are mostly
+ * sorted already. */
+static void
+_connections_sort (GPtrArray *list)
+{
+	gpointer connection;
+	guint i, j;
+
+	for (i = 1; i < list->len; i++) {
+		connection = list->pdata[i];
+		for (j = i; j > 0 && connection_sort (list->pdata[j - 1], connection) > 0; j--)
+			list->pdata[j] = list->pdata[j - 1];
+		list->pdata[j] = connection;
+	}
+}
+
+/* Timestamps change without notifying NMSettings. Then only a few
+ * connections are out of place. */
+static void
+_connections_sorted_ensure (NMSettings *self)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+
+	if (priv->connections_sorted_timestamps_serial == nm_settings_connection_get_timestamps_serial ())
+		return;
+
+	_connections_sort (priv->connections_sorted);
+	_connections_sort (priv->candidates_unlocked);
+	priv->connections_sorted_timestamps_serial = nm_settings_connection_get_timestamps_serial ();
+}
+
 /* Returns a list of NMSettingsConnections.
  * The list is sorted in the order suitable for auto-connecting, i.e.
- * first go connections with autoconnect=yes and most recent timestamp.
+ * first go connections with autoconnect=yes, by descending
+ * autoconnect-priority and most recent timestamp.
  * Caller must free the list with g_slist_free().
  */
 GSList *
 nm_settings_get_connections_sorted (NMSettings *self)
 {
-	GHashTableIter iter;
-	gpointer data = NULL;
+	NMSettingsPrivate *priv;
 	GSList *list = NULL;
+	guint len;
 
 	g_return_val_if_fail (NM_IS_SETTINGS (self), NULL);
 
-	g_hash_table_iter_init (&iter, NM_SETTINGS_GET_PRIVATE (self)->connections);
-	while (g_hash_table_iter_next (&iter, NULL, &data))
-		list = g_slist_insert_sorted (list, data, connection_sort);
+	priv = NM_SETTINGS_GET_PRIVATE (self);
+
+	_connections_sorted_ensure (self);
+
+	len = priv->connections_sorted->len;
+	while (len > 0)
+		list = g_slist_prepend (list, priv->connections_sorted->pdata[--len]);
 	return list;
 }
 
+/*****************************************************************************/
+
+/* The interface name and MAC address a connection is locked to. The device
+ * code rejects connections locked to another device in
+ * check_connection_compatible(), but only after looking up the settings of
+ * the connection one by one.
+ *
+ * Instead, connections locked to an interface name are indexed by that name,
+ * and connections only locked to a MAC address by the address. The others
+ * are kept in @candidates_unlocked, sorted like @connections_sorted. That
+ * way, a device only visits the connections that could be its own. */
+typedef struct {
+	char *ifname;
+	char *hwaddr;
+} CandidateKeys;
+
+static void
+_candidate_keys_free (gpointer data)
+{
+	CandidateKeys *keys = data;
+
+	g_free (keys->ifname);
+	g_free (keys->hwaddr);
+	g_slice_free (CandidateKeys, keys);
+}
+
+static void
+_candidate_index_remove (NMSettings *self, NMSettingsConnection *connection)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	const CandidateKeys *keys;
+	GHashTable *index;
+	const char *key;
+	GPtrArray *list;
+
+	keys = g_hash_table_lookup (priv->candidate_keys, connection);
+	if (!keys)
+		return;
+
+	if (keys->ifname || keys->hwaddr) {
+		if (keys->ifname) {
+			index = priv->candidates_by_ifname;
+			key = keys->ifname;
+		} else {
+			index = priv->candidates_by_hwaddr;
+			key = keys->hwaddr;
+		}
+		list = g_hash_table_lookup (index, key);
+		nm_assert (list);
+		g_ptr_array_remove (list, connection);
+		if (!list->len)
+			g_hash_table_remove (index, key);
+	} else
+		g_ptr_array_remove (priv->candidates_unlocked, connection);
+
+	g_hash_table_remove (priv->candidate_keys, connection);
+}
+
+static void
+_candidate_index_update (NMSettings *self, NMSettingsConnection *connection)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	NMConnection *c = NM_CONNECTION (connection);
+	const char *ifname;
+	const char *hwaddr = NULL;
+	CandidateKeys *keys;
+	GHashTable *index;
+	const char *key;
+	GPtrArray *list;
+
+	_candidate_index_remove (self, connection);
+
+	ifname = nm_connection_get_interface_name (c);
+
+	/* only consider the MAC address for types where it refers to the device
+	 * itself, and not for example to the parent of a VLAN. */
+	if (nm_connection_is_type (c, NM_SETTING_WIRED_SETTING_NAME)) {
+		NMSettingWired *s_wired = nm_connection_get_setting_wired (c);
+		const char *const*subchans;
+
+		if (s_wired) {
+			/* if the s390 subchannels match, the MAC address is not checked. */
+			subchans = nm_setting_wired_get_s390_subchannels (s_wired);
+			if (!subchans || !subchans[0])
+				hwaddr = nm_setting_wired_get_mac_address (s_wired);
+		}
+	} else if (nm_connection_is_type (c, NM_SETTING_WIRELESS_SETTING_NAME)) {
+		NMSettingWireless *s_wireless = nm_connection_get_setting_wireless (c);
+
+		if (s_wireless)
+			hwaddr = nm_setting_wireless_get_mac_address (s_wireless);
+	} else if (nm_connection_is_type (c, NM_SETTING_INFINIBAND_SETTING_NAME)) {
+		NMSettingInfiniband *s_infiniband = nm_connection_get_setting_infiniband (c);
+
+		if (s_infiniband)
+			hwaddr = nm_setting_infiniband_get_mac_address (s_infiniband);
+	}
+
+	keys = g_slice_new (CandidateKeys);
+	keys->ifname = g_strdup (ifname);
+	keys->hwaddr = hwaddr ? nm_utils_hwaddr_canonical (hwaddr, -1) : NULL;
+	g_hash_table_insert (priv->candidate_keys, connection, keys);
+
+	if (!keys->ifname && !keys->hwaddr) {
+		_connections_sorted_insert (priv->candidates_unlocked, connection);
+		return;
+	}
+
+	if (keys->ifname) {
+		index = priv->candidates_by_ifname;
+		key = keys->ifname;
+	} else {
+		index = priv->candidates_by_hwaddr;
+		key = keys->hwaddr;
+	}
+	list = g_hash_table_lookup (index, key);
+	if (!list) {
+		list = g_ptr_array_new ();
+		g_hash_table_insert (index, g_strdup (key), list);
+	}
+	g_ptr_array_add (list, connection);
+}
+
+/**
+ * nm_settings_is_candidate_connection:
+ * @self: the #NMSettings
+ * @connection: the #NMSettingsConnection
+ * @ifname: (allow-none): the interface name of the device
+ * @hwaddr: (allow-none): the permanent MAC address of the device
+ *
+ * Cheap pre-check whether @connection could be compatible with a device
+ * named @ifname with MAC address @hwaddr. Connections that are locked to
+ * another interface name or MAC address are rejected. Passing %NULL for
+ * either skips that part of the check.
+ *
+ * Returns: %FALSE if @connection is certainly not compatible with the
+ *   device. %TRUE means the full compatibility check is still necessary.
+ */
+gboolean
+nm_settings_is_candidate_connection (NMSettings *self,
+                                     NMSettingsConnection *connection,
+                                     const char *ifname,
+                                     const char *hwaddr)
+{
+	const CandidateKeys *keys;
+
+	g_return_val_if_fail (NM_IS_SETTINGS (self), TRUE);
+
+	keys = g_hash_table_lookup (NM_SETTINGS_GET_PRIVATE (self)->candidate_keys, connection);
+	if (!keys)
+		return TRUE;
+
+	if (   ifname
+	    && keys->ifname
+	    && strcmp (ifname, keys->ifname) != 0)
+		return FALSE;
+
+	if (   hwaddr
+	    && keys->hwaddr
+	    && !nm_utils_hwaddr_matches (hwaddr, -1, keys->hwaddr, -1))
+		return FALSE;
+
+	return TRUE;
+}
+
+/* Adds the connections indexed under @key, or with a %NULL @key all
+ * connections of @index. */
+static void
+_candidate_index_collect (GHashTable *index, const char *key, GPtrArray *dst)
+{
+	GHashTableIter iter;
+	GPtrArray *list;
+	guint i;
+
+	if (key) {
+		list = g_hash_table_lookup (index, key);
+		for (i = 0; list && i < list->len; i++)
+			g_ptr_array_add (dst, list->pdata[i]);
+		return;
+	}
+
+	g_hash_table_iter_init (&iter, index);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &list)) {
+		for (i = 0; i < list->len; i++)
+			g_ptr_array_add (dst, list->pdata[i]);
+	}
+}
+
+/**
+ * nm_settings_get_candidate_connections:
+ * @self: the #NMSettings
+ * @ifname: (allow-none): the interface name of the device
+ * @hwaddr: (allow-none): the permanent MAC address of the device
+ * @out_len: (out): (allow-none): returns the number of returned
+ *   connections.
+ *
+ * Returns the connections for which nm_settings_is_candidate_connection()
+ * holds, in the order of nm_settings_get_connections_sorted(). Only the
+ * connections locked to @ifname or @hwaddr and the ones not locked to any
+ * device are visited.
+ *
+ * Returns: (transfer-container): a %NULL terminated array of
+ *   #NMSettingsConnections. Free it with g_free().
+ */
+NMSettingsConnection **
+nm_settings_get_candidate_connections (NMSettings *self,
+                                       const char *ifname,
+                                       const char *hwaddr,
+                                       guint *out_len)
+{
+	NMSettingsPrivate *priv;
+	gs_free char *hwaddr_canonical = NULL;
+	GPtrArray *locked, *unlocked, *result;
+	guint i, j;
+
+	g_return_val_if_fail (NM_IS_SETTINGS (self), NULL);
+
+	priv = NM_SETTINGS_GET_PRIVATE (self);
+
+	_connections_sorted_ensure (self);
+
+	/* without @ifname or @hwaddr, that part of the check is skipped and
+	 * all connections locked that way are candidates. */
+	locked = g_ptr_array_new ();
+	_candidate_index_collect (priv->candidates_by_ifname, ifname, locked);
+	if (hwaddr) {
+		hwaddr_canonical = nm_utils_hwaddr_canonical (hwaddr, -1);
+		if (hwaddr_canonical)
+			_candidate_index_collect (priv->candidates_by_hwaddr, hwaddr_canonical, locked);
+	} else
+		_candidate_index_collect (priv->candidates_by_hwaddr, NULL, locked);
+
+	/* connections locked to the interface name might still be locked to
+	 * another MAC address. */
+	for (i = 0; i < locked->len; ) {
+		if (nm_settings_is_candidate_connection (self, locked->pdata[i], ifname, hwaddr))
+			i++;
+		else
+			g_ptr_array_remove_index (locked, i);
+	}
+	_connections_sort (locked);
+
+	/* merge with the unlocked connections, which are sorted already. */
+	unlocked = priv->candidates_unlocked;
+	result = g_ptr_array_sized_new (locked->len + unlocked->len + 1);
+	i = 0;
+	j = 0;
+	while (i < locked->len || j < unlocked->len) {
+		if (   j >= unlocked->len
+		    || (   i < locked->len
+		        && connection_sort (locked->pdata[i], unlocked->pdata[j]) <= 0))
+			g_ptr_array_add (result, locked->pdata[i++]);
+		else
+			g_ptr_array_add (result, unlocked->pdata[j++]);
+	}
+	g_ptr_array_unref (locked);
+
+	NM_SET_OUT (out_len, result->len);
+	g_ptr_array_add (result, NULL);
+	return (NMSettingsConnection **) g_ptr_array_free (result, FALSE);
+}
+
+/*****************************************************************************/
+
 NMSettingsConnection *
 nm_settings_get_connection_by_path (NMSettings *self, const char *path)
 {
@@ -934,6 +1328,12 @@ next:
 static void
 connection_updated (NMSettingsConnection *connection, gboolean by_user, gpointer user_data)
 {
+	/* the autoconnect properties might have changed. */
+	g_ptr_array_remove (NM_SETTINGS_GET_PRIVATE (user_data)->connections_sorted, connection);
+	_connections_sorted_insert (NM_SETTINGS_GET_PRIVATE (user_data)->connections_sorted, connection);
+	_candidate_index_update (NM_SETTINGS (user_data), connection);
+	_uuid_index_update (NM_SETTINGS (user_data), connection, FALSE);
+
 	g_signal_emit (NM_SETTINGS (user_data),
 	               signals[CONNECTION_UPDATED],
 	               0,
@@ -978,7 +1378,10 @@ connection_removed (NMSettingsConnection *connection, gpointer user_data)
 
 	/* Forget about the connection internally */
 	g_hash_table_remove (priv->connections, (gpointer) cpath);
+	_candidate_index_remove (self, connection);
+	_uuid_index_update (self, connection, TRUE);
 	g_clear_pointer (&priv->connections_cached_list, g_free);
+	g_ptr_array_remove (priv->connections_sorted, connection);
 
 	/* Notify D-Bus */
 	g_signal_emit (self, signals[CONNECTION_REMOVED], 0, connection);
@@ -1050,20 +1453,15 @@ claim_connection (NMSettings *self, NMSettingsConnection *connection)
 {
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
 	GError *error = NULL;
-	GHashTableIter iter;
-	gpointer data;
 	const char *path;
 	NMSettingsConnection *existing;
 
 	g_return_if_fail (NM_IS_SETTINGS_CONNECTION (connection));
 	g_return_if_fail (nm_connection_get_path (NM_CONNECTION (connection)) == NULL);
 
-	g_hash_table_iter_init (&iter, priv->connections);
-	while (g_hash_table_iter_next (&iter, NULL, &data)) {
-		/* prevent duplicates */
-		if (data == connection)
-			return;
-	}
+	/* prevent duplicates */
+	if (g_hash_table_contains (priv->connection_uuids, connection))
+		return;
 
 	if (!nm_connection_normalize (NM_CONNECTION (connection), NULL, NULL, &error)) {
 		_LOGW ("plugin provided invalid connection: %s", error->message);
@@ -1123,6 +1521,9 @@ claim_connection (NMSettings *self, NMSettingsConnection *connection)
 	                     (gpointer) nm_connection_get_path (NM_CONNECTION (connection)),
 	                     g_object_ref (connection));
 	g_clear_pointer (&priv->connections_cached_list, g_free);
+	_connections_sorted_insert (priv->connections_sorted, connection);
+	_candidate_index_update (self, connection);
+	_uuid_index_update (self, connection, FALSE);
 
 	nm_utils_log_connection_diff (NM_CONNECTION (connection), NULL, LOGL_DEBUG, LOGD_CORE, "new connection", "++ ");
 
@@ -1162,20 +1563,16 @@ nm_settings_add_connection (NMSettings *self,
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
 	GSList *iter;
 	NMSettingsConnection *added = NULL;
-	GHashTableIter citer;
-	NMConnection *candidate = NULL;
+	const char *uuid;
 
 	/* Make sure a connection with this UUID doesn't already exist */
-	g_hash_table_iter_init (&citer, priv->connections);
-	while (g_hash_table_iter_next (&citer, NULL, (gpointer *) &candidate)) {
-		if (g_strcmp0 (nm_connection_get_uuid (connection),
-		               nm_connection_get_uuid (candidate)) == 0) {
-			g_set_error_literal (error,
-			                     NM_SETTINGS_ERROR,
-			                     NM_SETTINGS_ERROR_UUID_EXISTS,
-			                     "A connection with this UUID already exists.");
-			return NULL;
-		}
+	uuid = nm_connection_get_uuid (connection);
+	if (uuid && nm_settings_get_connection_by_uuid (self, uuid)) {
+		g_set_error_literal (error,
+		                     NM_SETTINGS_ERROR,
+		                     NM_SETTINGS_ERROR_UUID_EXISTS,
+		                     "A connection with this UUID already exists.");
+		return NULL;
 	}
 
 	/* 1) plugin writes the NMConnection to disk
@@ -2349,6 +2746,13 @@ nm_settings_init (NMSettings *self)
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
 
 	priv->connections = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_object_unref);
+	priv->connections_by_uuid = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	priv->connection_uuids = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
+	priv->connections_sorted = g_ptr_array_new ();
+	priv->candidate_keys = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, _candidate_keys_free);
+	priv->candidates_by_ifname = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
+	priv->candidates_by_hwaddr = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
+	priv->candidates_unlocked = g_ptr_array_new ();
 
 	/* Hold a reference to the agent manager so it stays alive; the only
 	 * other holders are NMSettingsConnection objects which are often
@@ -2407,7 +2811,14 @@ finalize (GObject *object)
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
 
 	g_hash_table_destroy (priv->connections);
+	g_hash_table_destroy (priv->connections_by_uuid);
+	g_hash_table_destroy (priv->connection_uuids);
+	g_hash_table_destroy (priv->candidate_keys);
+	g_hash_table_destroy (priv->candidates_by_ifname);
+	g_hash_table_destroy (priv->candidates_by_hwaddr);
+	g_ptr_array_unref (priv->candidates_unlocked);
 	g_clear_pointer (&priv->connections_cached_list, g_free);
+	g_ptr_array_unref (priv->connections_sorted);
 
 	g_slist_free_full (priv->unmanaged_specs, g_free);
 	g_slist_free_full (priv->unrecognized_specs, g_free);
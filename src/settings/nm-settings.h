@@ -116,6 +116,15 @@ NMSettingsConnection *nm_settings_add_connection (NMSettings *settings,
                                                   NMConnection *connection,
                                                   gboolean save_to_disk,
                                                   GError **error);
+gboolean nm_settings_is_candidate_connection (NMSettings *self,
+                                              NMSettingsConnection *connection,
+                                              const char *ifname,
+                                              const char *hwaddr);
+NMSettingsConnection **nm_settings_get_candidate_connections (NMSettings *self,
+                                                              const char *ifname,
+                                                              const char *hwaddr,
+                                                              guint *out_len);
+
 NMSettingsConnection *nm_settings_get_connection_by_path (NMSettings *settings,
                                                           const char *path);
 
@@ -28,6 +28,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 
@@ -457,6 +458,46 @@ _paths_from_connections (GHashTable *connections)
 	return paths;
 }
 
+static void
+_read_ahead_file (const char *path)
+{
+	char buf[4096];
+	int fd;
+
+	if (!path)
+		return;
+
+	fd = open (path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return;
+	while (nm_utils_fd_read_loop (fd, buf, sizeof (buf), FALSE) > 0)
+		;
+	close (fd);
+}
+
+static void
+_read_ahead_cb (gpointer data, gpointer user_data)
+{
+	const char *path = data;
+	char *extra;
+
+	/* runs on a worker thread. Only pulls the files into the page cache;
+	 * parsing them might access the platform and stays on the main thread. */
+	_read_ahead_file (path);
+
+	extra = utils_get_keys_path (path);
+	_read_ahead_file (extra);
+	g_free (extra);
+
+	extra = utils_get_route_path (path);
+	_read_ahead_file (extra);
+	g_free (extra);
+
+	extra = utils_get_route6_path (path);
+	_read_ahead_file (extra);
+	g_free (extra);
+}
+
 static int
 _sort_paths (const char **f1, const char **f2, GHashTable *paths)
 {
@@ -524,6 +565,10 @@ read_connections (SettingsPluginIfcfg *plugin)
 	g_ptr_array_sort_with_data (filenames, (GCompareDataFunc) _sort_paths, paths);
 	g_hash_table_destroy (paths);
 
+	/* With many files on slow storage, most time is spent waiting for I/O.
+	 * Read the files in parallel before parsing them in order. */
+	nm_utils_parallel_for_each (filenames->pdata, filenames->len, _read_ahead_cb, NULL);
+
 	for (i = 0; i < filenames->len; i++) {
 		connection = update_connection (plugin, NULL, filenames->pdata[i], NULL, FALSE, alive_connections, NULL);
 		if (connection)
@@ -38,6 +38,72 @@
 
 #include "nm-core-internal.h"
 
+/* Lines are indexed by the key they set, that is by everything before the
+ * first '='. Only the first line for each key is indexed, as that is the
+ * one svGetValueFull() returns. */
+
+static void
+_line_index_add (shvarFile *s, GList *link)
+{
+	const char *line = link->data;
+	const char *eq;
+	char *key;
+
+	eq = strchr (line, '=');
+	if (!eq)
+		return;
+
+	key = g_strndup (line, eq - line);
+	if (g_hash_table_contains (s->lineIndex, key)) {
+		g_free (key);
+		return;
+	}
+	g_hash_table_insert (s->lineIndex, key, link);
+}
+
+static void
+_line_append (shvarFile *s, char *line)
+{
+	GList *link;
+
+	link = g_list_alloc ();
+	link->data = line;
+	link->prev = s->lineListLast;
+	if (s->lineListLast)
+		s->lineListLast->next = link;
+	else
+		s->lineList = link;
+	s->lineListLast = link;
+
+	_line_index_add (s, link);
+}
+
+static void
+_line_remove (shvarFile *s, GList *link, const char *key)
+{
+	GList *iter;
+	gsize len;
+
+	nm_assert (g_hash_table_lookup (s->lineIndex, key) == link);
+
+	g_hash_table_remove (s->lineIndex, key);
+
+	/* a later line for the same key takes the place of the removed one. */
+	len = strlen (key);
+	for (iter = link->next; iter; iter = iter->next) {
+		const char *line = iter->data;
+
+		if (!strncmp (key, line, len) && line[len] == '=') {
+			g_hash_table_insert (s->lineIndex, g_strdup (key), iter);
+			break;
+		}
+	}
+
+	if (s->lineListLast == link)
+		s->lineListLast = link->prev;
+	s->lineList = g_list_delete_link (s->lineList, link);
+}
+
 /* Open the file <name>, returning a shvarFile on success and NULL on failure.
  * Add a wrinkle to let the caller specify whether or not to create the file
  * (actually, return a structure anyway) if it doesn't exist.
@@ -50,6 +116,7 @@ svOpenFileInternal (const char *name, gboolean create, GError **error)
 	int errsv = 0;
 
 	s = g_slice_new0 (shvarFile);
+	s->lineIndex = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 
 	s->fd = -1;
 	if (create)
@@ -91,7 +158,7 @@ svOpenFileInternal (const char *name, gboolean create, GError **error)
 
 		/* we'd use g_strsplit() here, but we want a list, not an array */
 		for (p = arena; (q = strchr (p, '\n')) != NULL; p = q + 1)
-			s->lineList = g_list_append (s->lineList, g_strndup (p, q - p));
+			_line_append (s, g_strndup (p, q - p));
 		g_free (arena);
 
 		/* closefd is set if we opened the file read-only, so go ahead and
@@ -112,6 +179,7 @@ svOpenFileInternal (const char *name, gboolean create, GError **error)
 	if (s->fd != -1)
 		close (s->fd);
 	g_free (s->fileName);
+	g_hash_table_destroy (s->lineIndex);
 	g_slice_free (shvarFile, s);
 
 	g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errsv),
@@ -269,26 +337,23 @@ svGetValue (shvarFile *s, const char *key, gboolean verbatim)
 char *
 svGetValueFull (shvarFile *s, const char *key, gboolean verbatim)
 {
-	char *value = NULL;
-	char *line;
-	guint len;
+	char *value;
+	const char *line;
 
 	g_return_val_if_fail (s != NULL, NULL);
 	g_return_val_if_fail (key != NULL, NULL);
+	nm_assert (!strchr (key, '='));
 
-	len = strlen (key);
+	s->current = g_hash_table_lookup (s->lineIndex, key);
+	if (!s->current)
+		return NULL;
 
-	for (s->current = s->lineList; s->current; s->current = s->current->next) {
-		line = s->current->data;
-		if (!strncmp (key, line, len) && line[len] == '=') {
-			/* Strip trailing spaces before unescaping to preserve spaces quoted whitespace */
-			value = g_strchomp (g_strdup (line + len + 1));
-			if (!verbatim)
-				svUnescape (value);
-			break;
-		}
-	}
+	line = s->current->data;
 
+	/* Strip trailing spaces before unescaping to preserve spaces quoted whitespace */
+	value = g_strchomp (g_strdup (line + strlen (key) + 1));
+	if (!verbatim)
+		svUnescape (value);
 	return value;
 }
 
@@ -410,9 +475,9 @@ svSetValueFull (shvarFile *s, const char *key, const char *value, gboolean verba
 		/* delete value */
 		if (oldval) {
 			/* delete line */
-			s->lineList = g_list_remove_link (s->lineList, s->current);
 			g_free (s->current->data);
-			g_list_free_1 (s->current);
+			_line_remove (s, s->current, key);
+			s->current = NULL;
 			s->modified = TRUE;
 		}
 		return;
@@ -421,7 +486,7 @@ svSetValueFull (shvarFile *s, const char *key, const char *value, gboolean verba
 	keyValue = g_strdup_printf ("%s=%s", key, newval);
 	if (!oldval) {
 		/* append line */
-		s->lineList = g_list_append (s->lineList, keyValue);
+		_line_append (s, keyValue);
 		s->modified = TRUE;
 		return;
 	}
@@ -432,7 +497,7 @@ svSetValueFull (shvarFile *s, const char *key, const char *value, gboolean verba
 			g_free (s->current->data);
 			s->current->data = keyValue;
 		} else
-			s->lineList = g_list_append (s->lineList, keyValue);
+			_line_append (s, keyValue);
 		s->modified = TRUE;
 	} else
 		g_free (keyValue);
@@ -511,6 +576,7 @@ svCloseFile (shvarFile *s)
 		close (s->fd);
 
 	g_free (s->fileName);
+	g_hash_table_destroy (s->lineIndex);
 	g_list_free_full (s->lineList, g_free); /* implicitly frees s->current */
 	g_slice_free (shvarFile, s);
 }
@@ -38,6 +38,10 @@ struct _shvarFile {
 	GList     *lineList;    /* read-only */
 	GList     *current;     /* set implicitly or explicitly, points to element of lineList */
 	gboolean   modified;    /* ignore */
+
+	/* private */
+	GList     *lineListLast;
+	GHashTable *lineIndex;  /* key::first element of lineList setting the key */
 };
 
 
@@ -8701,6 +8701,61 @@ test_svUnescape (void)
 	g_rand_free (r);
 }
 
+static void
+test_sv_file_index (void)
+{
+	gs_free char *testfile = g_build_filename (TEST_SCRATCH_DIR, "network-scripts", "ifcfg-test-sv-index", NULL);
+	gs_free char *contents = NULL;
+	shvarFile *f;
+	GError *error = NULL;
+	char *val;
+
+	g_file_set_contents (testfile,
+	                     "# comment\n"
+	                     "KEY=a\n"
+	                     "#KEY=commented\n"
+	                     "OTHER=1\n"
+	                     "KEY=b\n",
+	                     -1, &error);
+	g_assert_no_error (error);
+
+	f = svOpenFile (testfile, &error);
+	g_assert_no_error (error);
+	g_assert (f);
+
+	/* the first line for a key wins */
+	val = svGetValue (f, "KEY", FALSE);
+	g_assert_cmpstr (val, ==, "a");
+	g_free (val);
+	val = svGetValue (f, "#KEY", FALSE);
+	g_assert_cmpstr (val, ==, "commented");
+	g_free (val);
+	g_assert (!svGetValue (f, "KE", FALSE));
+
+	/* after removing it, the next one takes its place */
+	svSetValue (f, "KEY", NULL, FALSE);
+	val = svGetValue (f, "KEY", FALSE);
+	g_assert_cmpstr (val, ==, "b");
+	g_free (val);
+
+	svSetValue (f, "OTHER", "2", FALSE);
+	svSetValue (f, "NEW", "x", FALSE);
+
+	g_assert (svWriteFile (f, 0644, &error));
+	g_assert_no_error (error);
+	svCloseFile (f);
+
+	g_file_get_contents (testfile, &contents, NULL, &error);
+	g_assert_no_error (error);
+	g_assert_cmpstr (contents, ==,
+	                 "# comment\n"
+	                 "#KEY=commented\n"
+	                 "OTHER=2\n"
+	                 "KEY=b\n"
+	                 "NEW=x\n");
+	unlink (testfile);
+}
+
 static void
 test_read_vlan_trailing_spaces (void)
 {
@@ -8765,6 +8820,7 @@ int main (int argc, char **argv)
 	nmtst_init_assert_logging (&argc, &argv, "INFO", "DEFAULT");
 
 	g_test_add_func (TPATH "svUnescape", test_svUnescape);
+	g_test_add_func (TPATH "svFileIndex", test_sv_file_index);
 	g_test_add_func (TPATH "vlan-trailing-spaces", test_read_vlan_trailing_spaces);
 
 	g_test_add_func (TPATH "unmanaged", test_read_unmanaged);
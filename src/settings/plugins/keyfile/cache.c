@@ -0,0 +1,305 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager system settings service - keyfile plugin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "cache.h"
+
+#include <string.h>
+#include <time.h>
+
+#include "nm-core-internal.h"
+#include "NetworkManagerUtils.h"
+
+/* The cache is a single serialized GVariant, which is mapped into memory
+ * on load:
+ *
+ *   (u    format version
+ *    s    version of NetworkManager that wrote the cache
+ *    a(s  path of the keyfile
+ *      t  st_dev
+ *      t  st_ino
+ *      t  st_size
+ *      x  st_mtime in nanoseconds
+ *      x  st_ctime in nanoseconds
+ *      a{sa{sv}}))  the normalized connection
+ *
+ * An entry is only used if the file's stat() data matches exactly. As
+ * chmod() and chown() change the ctime, the permission checks of the
+ * reader don't need to be repeated for a cache hit.
+ */
+
+#define CACHE_FORMAT_VERSION 1
+#define CACHE_ENTRY_TYPE     "(stttxxa{sa{sv}})"
+#define CACHE_TYPE           "(usa" CACHE_ENTRY_TYPE ")"
+
+/* files modified more recently are not cached: a second modification
+ * within the timestamp granularity of the file system could go
+ * unnoticed otherwise. */
+#define CACHE_RACY_NSEC      (2 * NM_UTILS_NS_PER_SECOND)
+
+struct _NMKeyfileCache {
+	char *filename;
+
+	/* path::GVariant of the entries in the loaded cache */
+	GHashTable *entries;
+
+	/* the entries for the cache to write on commit */
+	GVariantBuilder builder;
+	guint n_added;
+	gboolean dirty;
+};
+
+#define _ts_nsec(ts) ((gint64) (ts).tv_sec * NM_UTILS_NS_PER_SECOND + (ts).tv_nsec)
+
+static void
+_load (NMKeyfileCache *cache)
+{
+	GMappedFile *mapped;
+	gs_unref_variant GVariant *data = NULL;
+	gs_unref_variant GVariant *array = NULL;
+	gs_free_error GError *error = NULL;
+	const char *nm_version;
+	guint32 version;
+	GVariantIter iter;
+	GVariant *entry;
+
+	mapped = g_mapped_file_new (cache->filename, FALSE, &error);
+	if (!mapped) {
+		if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+			nm_log_dbg (LOGD_SETTINGS, "keyfile: cannot open cache '%s': %s", cache->filename, error->message);
+		return;
+	}
+
+	if (!g_mapped_file_get_length (mapped)) {
+		g_mapped_file_unref (mapped);
+		return;
+	}
+
+	data = g_variant_new_from_data (G_VARIANT_TYPE (CACHE_TYPE),
+	                                g_mapped_file_get_contents (mapped),
+	                                g_mapped_file_get_length (mapped),
+	                                FALSE,
+	                                (GDestroyNotify) g_mapped_file_unref,
+	                                mapped);
+	g_variant_ref_sink (data);
+
+	g_variant_get (data, "(u&s@a" CACHE_ENTRY_TYPE ")", &version, &nm_version, &array);
+	if (   version != CACHE_FORMAT_VERSION
+	    || strcmp (nm_version, VERSION) != 0) {
+		nm_log_dbg (LOGD_SETTINGS, "keyfile: ignore cache '%s' of version %u/%s", cache->filename, version, nm_version);
+		return;
+	}
+
+	g_variant_iter_init (&iter, array);
+	while ((entry = g_variant_iter_next_value (&iter))) {
+		const char *path;
+
+		g_variant_get_child (entry, 0, "&s", &path);
+		g_hash_table_insert (cache->entries, (gpointer) path, entry);
+	}
+}
+
+/**
+ * nm_keyfile_plugin_cache_new:
+ * @filename: the cache file
+ *
+ * Loads the cache from @filename. A missing or unusable cache results
+ * in an empty one.
+ *
+ * Returns: the cache. Free with nm_keyfile_plugin_cache_free().
+ */
+NMKeyfileCache *
+nm_keyfile_plugin_cache_new (const char *filename)
+{
+	NMKeyfileCache *cache;
+
+	g_return_val_if_fail (filename, NULL);
+
+	cache = g_slice_new0 (NMKeyfileCache);
+	cache->filename = g_strdup (filename);
+	cache->entries = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify) g_variant_unref);
+	g_variant_builder_init (&cache->builder, G_VARIANT_TYPE ("a" CACHE_ENTRY_TYPE));
+
+	_load (cache);
+	return cache;
+}
+
+void
+nm_keyfile_plugin_cache_free (NMKeyfileCache *cache)
+{
+	g_return_if_fail (cache);
+
+	g_variant_builder_clear (&cache->builder);
+	g_hash_table_destroy (cache->entries);
+	g_free (cache->filename);
+	g_slice_free (NMKeyfileCache, cache);
+}
+
+static GVariant *
+_lookup_entry (NMKeyfileCache *cache, const char *path, const struct stat *st)
+{
+	GVariant *entry;
+	guint64 dev, ino, size;
+	gint64 mtime, ctime;
+
+	entry = g_hash_table_lookup (cache->entries, path);
+	if (!entry)
+		return NULL;
+
+	g_variant_get (entry, "(&stttxx@a{sa{sv}})", NULL, &dev, &ino, &size, &mtime, &ctime, NULL);
+	if (   dev != (guint64) st->st_dev
+	    || ino != (guint64) st->st_ino
+	    || size != (guint64) st->st_size
+	    || mtime != _ts_nsec (st->st_mtim)
+	    || ctime != _ts_nsec (st->st_ctim))
+		return NULL;
+	return entry;
+}
+
+/**
+ * nm_keyfile_plugin_cache_lookup:
+ * @cache: the cache
+ * @path: the keyfile
+ * @st: the result of stat() on @path
+ *
+ * Can be called from any thread, as long as nm_keyfile_plugin_cache_add()
+ * is not called at the same time.
+ *
+ * Returns: (transfer full): the connection cached for @path or %NULL if
+ *   there is none, or it was cached for a different version of the file.
+ */
+NMConnection *
+nm_keyfile_plugin_cache_lookup (NMKeyfileCache *cache,
+                                const char *path,
+                                const struct stat *st)
+{
+	GVariant *entry;
+	gs_unref_variant GVariant *dict = NULL;
+	gs_free_error GError *error = NULL;
+	NMConnection *connection;
+
+	g_return_val_if_fail (cache, NULL);
+	g_return_val_if_fail (path, NULL);
+	g_return_val_if_fail (st, NULL);
+
+	entry = _lookup_entry (cache, path, st);
+	if (!entry)
+		return NULL;
+
+	dict = g_variant_get_child_value (entry, 6);
+	connection = nm_simple_connection_new_from_dbus (dict, &error);
+	if (!connection) {
+		nm_log_dbg (LOGD_SETTINGS, "keyfile: invalid cache entry for '%s': %s", path, error->message);
+		return NULL;
+	}
+	return connection;
+}
+
+/**
+ * nm_keyfile_plugin_cache_add:
+ * @cache: the cache
+ * @path: the keyfile
+ * @st: the result of stat() on @path before reading it
+ * @connection: the connection read from @path
+ *
+ * Adds @connection to the cache that nm_keyfile_plugin_cache_commit()
+ * writes. Only files added here end up in the written cache.
+ */
+void
+nm_keyfile_plugin_cache_add (NMKeyfileCache *cache,
+                             const char *path,
+                             const struct stat *st,
+                             NMConnection *connection)
+{
+	GVariant *entry;
+	struct timespec now;
+
+	g_return_if_fail (cache);
+	g_return_if_fail (path);
+	g_return_if_fail (st);
+	g_return_if_fail (NM_IS_CONNECTION (connection));
+
+	entry = _lookup_entry (cache, path, st);
+	if (entry) {
+		/* unchanged. Reuse the serialized connection. */
+		g_variant_builder_add_value (&cache->builder, entry);
+		cache->n_added++;
+		return;
+	}
+
+	cache->dirty = TRUE;
+
+	clock_gettime (CLOCK_REALTIME, &now);
+	if (_ts_nsec (now) - _ts_nsec (st->st_mtim) < CACHE_RACY_NSEC)
+		return;
+
+	g_variant_builder_add (&cache->builder, "(stttxx@a{sa{sv}})",
+	                       path,
+	                       (guint64) st->st_dev,
+	                       (guint64) st->st_ino,
+	                       (guint64) st->st_size,
+	                       _ts_nsec (st->st_mtim),
+	                       _ts_nsec (st->st_ctim),
+	                       nm_connection_to_dbus (connection, NM_CONNECTION_SERIALIZE_ALL));
+	cache->n_added++;
+}
+
+/**
+ * nm_keyfile_plugin_cache_commit:
+ * @cache: the cache
+ * @error: error in case of failure
+ *
+ * Writes the entries added with nm_keyfile_plugin_cache_add(), unless
+ * they match the loaded cache.
+ *
+ * Returns: %TRUE on success
+ */
+gboolean
+nm_keyfile_plugin_cache_commit (NMKeyfileCache *cache, GError **error)
+{
+	gs_unref_variant GVariant *data = NULL;
+	mode_t saved_umask;
+	gboolean success;
+
+	g_return_val_if_fail (cache, FALSE);
+
+	if (   !cache->dirty
+	    && cache->n_added == g_hash_table_size (cache->entries))
+		return TRUE;
+
+	data = g_variant_new ("(usa" CACHE_ENTRY_TYPE ")",
+	                      (guint32) CACHE_FORMAT_VERSION,
+	                      VERSION,
+	                      &cache->builder);
+	g_variant_ref_sink (data);
+	g_variant_builder_init (&cache->builder, G_VARIANT_TYPE ("a" CACHE_ENTRY_TYPE));
+	cache->n_added = 0;
+	cache->dirty = FALSE;
+
+	/* the cache contains secrets */
+	saved_umask = umask (S_IRWXG | S_IRWXO);
+	success = g_file_set_contents (cache->filename,
+	                               g_variant_get_data (data),
+	                               g_variant_get_size (data),
+	                               error);
+	umask (saved_umask);
+	return success;
+}
@@ -0,0 +1,46 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager system settings service - keyfile plugin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+#ifndef _KEYFILE_PLUGIN_CACHE_H
+#define _KEYFILE_PLUGIN_CACHE_H
+
+#include <sys/stat.h>
+
+#include <nm-connection.h>
+
+#include "nm-default.h"
+
+typedef struct _NMKeyfileCache NMKeyfileCache;
+
+NMKeyfileCache *nm_keyfile_plugin_cache_new (const char *filename);
+void            nm_keyfile_plugin_cache_free (NMKeyfileCache *cache);
+
+NMConnection *nm_keyfile_plugin_cache_lookup (NMKeyfileCache *cache,
+                                              const char *path,
+                                              const struct stat *st);
+
+void nm_keyfile_plugin_cache_add (NMKeyfileCache *cache,
+                                  const char *path,
+                                  const struct stat *st,
+                                  NMConnection *connection);
+
+gboolean nm_keyfile_plugin_cache_commit (NMKeyfileCache *cache, GError **error);
+
+#endif /* _KEYFILE_PLUGIN_CACHE_H */
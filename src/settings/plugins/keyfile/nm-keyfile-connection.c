@@ -36,37 +36,13 @@
 
 G_DEFINE_TYPE (NMKeyfileConnection, nm_keyfile_connection, NM_TYPE_SETTINGS_CONNECTION)
 
-NMKeyfileConnection *
-nm_keyfile_connection_new (NMConnection *source,
-                           const char *full_path,
-                           GError **error)
+static NMKeyfileConnection *
+_keyfile_connection_new (NMConnection *tmp,
+                         const char *full_path,
+                         gboolean update_unsaved,
+                         GError **error)
 {
 	GObject *object;
-	NMConnection *tmp;
-	const char *uuid;
-	gboolean update_unsaved = TRUE;
-
-	g_assert (source || full_path);
-
-	/* If we're given a connection already, prefer that instead of re-reading */
-	if (source)
-		tmp = g_object_ref (source);
-	else {
-		tmp = nm_keyfile_plugin_connection_from_file (full_path, error);
-		if (!tmp)
-			return NULL;
-
-		uuid = nm_connection_get_uuid (NM_CONNECTION (tmp));
-		if (!uuid) {
-			g_set_error (error, NM_SETTINGS_ERROR, NM_SETTINGS_ERROR_INVALID_CONNECTION,
-			             "Connection in file %s had no UUID", full_path);
-			g_object_unref (tmp);
-			return NULL;
-		}
-
-		/* If we just read the connection from disk, it's clearly not Unsaved */
-		update_unsaved = FALSE;
-	}
 
 	object = (GObject *) g_object_new (NM_TYPE_KEYFILE_CONNECTION,
 	                                   NM_SETTINGS_CONNECTION_FILENAME, full_path,
@@ -82,10 +58,62 @@ nm_keyfile_connection_new (NMConnection *source,
 		object = NULL;
 	}
 
-	g_object_unref (tmp);
 	return (NMKeyfileConnection *) object;
 }
 
+/**
+ * nm_keyfile_connection_new_read:
+ * @read_connection: the connection as returned by
+ *   nm_keyfile_plugin_connection_from_file() for @full_path
+ * @full_path: the file @read_connection was read from
+ * @error: error in case of failure
+ *
+ * Like nm_keyfile_connection_new() without @source, for a file that
+ * was already read, for example by a worker thread.
+ *
+ * Returns: the new connection or %NULL on failure.
+ */
+NMKeyfileConnection *
+nm_keyfile_connection_new_read (NMConnection *read_connection,
+                                const char *full_path,
+                                GError **error)
+{
+	g_return_val_if_fail (NM_IS_CONNECTION (read_connection), NULL);
+	g_return_val_if_fail (full_path, NULL);
+
+	if (!nm_connection_get_uuid (read_connection)) {
+		g_set_error (error, NM_SETTINGS_ERROR, NM_SETTINGS_ERROR_INVALID_CONNECTION,
+		             "Connection in file %s had no UUID", full_path);
+		return NULL;
+	}
+
+	/* If we just read the connection from disk, it's clearly not Unsaved */
+	return _keyfile_connection_new (read_connection, full_path, FALSE, error);
+}
+
+NMKeyfileConnection *
+nm_keyfile_connection_new (NMConnection *source,
+                           const char *full_path,
+                           GError **error)
+{
+	NMKeyfileConnection *connection;
+	NMConnection *tmp;
+
+	g_assert (source || full_path);
+
+	/* If we're given a connection already, prefer that instead of re-reading */
+	if (source)
+		return _keyfile_connection_new (source, full_path, TRUE, error);
+
+	tmp = nm_keyfile_plugin_connection_from_file (full_path, error);
+	if (!tmp)
+		return NULL;
+
+	connection = nm_keyfile_connection_new_read (tmp, full_path, error);
+	g_object_unref (tmp);
+	return connection;
+}
+
 static void
 commit_changes (NMSettingsConnection *connection,
                 NMSettingsConnectionCommitReason commit_reason,
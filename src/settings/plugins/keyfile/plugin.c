@@ -34,13 +34,18 @@
 #include "nm-utils.h"
 #include "nm-config.h"
 #include "nm-core-internal.h"
+#include "NetworkManagerUtils.h"
 
 #include "plugin.h"
 #include "nm-settings-plugin.h"
 #include "nm-keyfile-connection.h"
+#include "cache.h"
+#include "reader.h"
 #include "writer.h"
 #include "utils.h"
 
+#define KEYFILE_CACHE_FILE NMSTATEDIR "/keyfile-cache"
+
 static void settings_plugin_interface_init (NMSettingsPluginInterface *plugin_iface);
 
 G_DEFINE_TYPE_EXTENDED (SettingsPluginKeyfile, settings_plugin_keyfile, G_TYPE_OBJECT, 0,
@@ -52,6 +57,9 @@ G_DEFINE_TYPE_EXTENDED (SettingsPluginKeyfile, settings_plugin_keyfile, G_TYPE_O
 typedef struct {
 	GHashTable *connections;  /* uuid::connection */
 
+	/* path::ReadResult of the files read ahead by read_connections() */
+	GHashTable *read_results;
+
 	gboolean initialized;
 	GFileMonitor *monitor;
 	gulong monitor_id;
@@ -105,6 +113,65 @@ find_by_path (SettingsPluginKeyfile *self, const char *path)
 	return NULL;
 }
 
+typedef struct {
+	const char *path;
+	struct stat st;
+	gboolean has_stat;
+	NMConnection *connection;
+	GError *error;
+} ReadResult;
+
+static void
+_read_result_free (gpointer data)
+{
+	ReadResult *result = data;
+
+	g_clear_object (&result->connection);
+	g_clear_error (&result->error);
+	g_slice_free (ReadResult, result);
+}
+
+static void
+_read_file_cb (gpointer data, gpointer user_data)
+{
+	ReadResult *result = data;
+	NMKeyfileCache *cache = user_data;
+
+	/* runs on a worker thread. Reading, normalizing and verifying the
+	 * connection doesn't touch the plugin or any other shared state,
+	 * as long as all setting types are already registered. */
+	if (stat (result->path, &result->st) == 0) {
+		result->has_stat = TRUE;
+		result->connection = nm_keyfile_plugin_cache_lookup (cache, result->path, &result->st);
+		if (result->connection)
+			return;
+	}
+
+	result->connection = nm_keyfile_plugin_connection_from_file (result->path, &result->error);
+}
+
+static NMKeyfileConnection *
+_connection_new (SettingsPluginKeyfile *self,
+                 NMConnection *source,
+                 const char *full_path,
+                 GError **error)
+{
+	SettingsPluginKeyfilePrivate *priv = SETTINGS_PLUGIN_KEYFILE_GET_PRIVATE (self);
+	ReadResult *result;
+
+	if (   !source
+	    && priv->read_results
+	    && (result = g_hash_table_lookup (priv->read_results, full_path))) {
+		if (!result->connection) {
+			g_propagate_error (error, g_error_copy (result->error));
+			return NULL;
+		}
+		return nm_keyfile_connection_new_read (result->connection, full_path, error);
+	}
+
+	return nm_keyfile_connection_new (source, full_path, error);
+}
+
 /* update_connection:
  * @self: the plugin instance
  * @source: if %NULL, this re-reads the connection from @full_path
@@ -157,7 +224,7 @@ update_connection (SettingsPluginKeyfile *self,
 	if (full_path)
 		nm_log_dbg (LOGD_SETTINGS, "keyfile: loading from file \"%s\"...", full_path);
 
-	connection_new = nm_keyfile_connection_new (source, full_path, &local);
+	connection_new = _connection_new (self, source, full_path, &local);
 	if (!connection_new) {
 		/* Error; remove the connection */
 		if (source)
@@ -399,6 +466,8 @@ read_connections (NMSettingsPlugin *config)
 	GPtrArray *dead_connections = NULL;
 	guint i;
 	GPtrArray *filenames;
+	GPtrArray *results;
+	NMKeyfileCache *cache;
 	GHashTable *paths;
 
 	dir = g_dir_open (nm_keyfile_plugin_get_path (), 0, &error);
@@ -430,11 +499,44 @@ read_connections (NMSettingsPlugin *config)
 	g_ptr_array_sort_with_data (filenames, (GCompareDataFunc) _sort_paths, paths);
 	g_hash_table_destroy (paths);
 
+	/* Parsing the files is the expensive part. Read them on worker threads
+	 * up front, then create the connections in the order from above.
+	 * Files that didn't change since the last time are taken from the
+	 * cache instead of parsing them again. */
+	cache = nm_keyfile_plugin_cache_new (KEYFILE_CACHE_FILE);
+	results = g_ptr_array_new_full (filenames->len, _read_result_free);
+	priv->read_results = g_hash_table_new (g_str_hash, g_str_equal);
+	for (i = 0; i < filenames->len; i++) {
+		ReadResult *result = g_slice_new0 (ReadResult);
+
+		result->path = filenames->pdata[i];
+		g_ptr_array_add (results, result);
+		g_hash_table_insert (priv->read_results, (gpointer) result->path, result);
+	}
+	_nm_setting_ensure_all_registered ();
+	nm_utils_parallel_for_each (results->pdata, results->len, _read_file_cb, cache);
+
 	for (i = 0; i < filenames->len; i++) {
 		connection = update_connection (self, NULL, filenames->pdata[i], NULL, FALSE, alive_connections, NULL);
 		if (connection)
 			g_hash_table_add (alive_connections, connection);
 	}
+	g_clear_pointer (&priv->read_results, g_hash_table_destroy);
+
+	for (i = 0; i < results->len; i++) {
+		ReadResult *result = results->pdata[i];
+
+		if (result->connection && result->has_stat)
+			nm_keyfile_plugin_cache_add (cache, result->path, &result->st, result->connection);
+	}
+	if (!nm_keyfile_plugin_cache_commit (cache, &error)) {
+		nm_log_warn (LOGD_SETTINGS, "keyfile: cannot write cache '%s': %s",
+		             KEYFILE_CACHE_FILE, error->message);
+		g_clear_error (&error);
+	}
+	nm_keyfile_plugin_cache_free (cache);
+
+	g_ptr_array_free (results, TRUE);
 	g_ptr_array_free (filenames, TRUE);
 
 	g_hash_table_iter_init (&iter, priv->connections);
@@ -30,6 +30,7 @@
 
 #include "nm-core-internal.h"
 
+#include "cache.h"
 #include "reader.h"
 #include "writer.h"
 #include "utils.h"
@@ -2966,6 +2967,48 @@ _escape_filename (const char *filename, gboolean would_be_ignored)
 		g_error ("Escaping filename \"%s\" yielded \"%s\", but this is ignored", filename, esc);
 }
 
+static void
+test_cache (void)
+{
+	gs_free char *cache_file = g_build_filename (TEST_SCRATCH_DIR, "keyfile-cache", NULL);
+	const char *path = TEST_KEYFILES_DIR"/Test_minimal_1";
+	gs_unref_object NMConnection *connection = NULL;
+	gs_unref_object NMConnection *cached = NULL;
+	NMKeyfileCache *cache;
+	struct stat st;
+	GError *error = NULL;
+
+	unlink (cache_file);
+
+	connection = keyfile_read_connection_from_file (path);
+
+	/* a file that was modified long ago */
+	memset (&st, 0, sizeof (st));
+	st.st_ino = 42;
+	st.st_size = 100;
+	st.st_mtim.tv_sec = 1000;
+	st.st_ctim.tv_sec = 1000;
+
+	cache = nm_keyfile_plugin_cache_new (cache_file);
+	g_assert (!nm_keyfile_plugin_cache_lookup (cache, path, &st));
+	nm_keyfile_plugin_cache_add (cache, path, &st, connection);
+	g_assert (nm_keyfile_plugin_cache_commit (cache, &error));
+	g_assert_no_error (error);
+	nm_keyfile_plugin_cache_free (cache);
+
+	cache = nm_keyfile_plugin_cache_new (cache_file);
+	cached = nm_keyfile_plugin_cache_lookup (cache, path, &st);
+	g_assert (cached);
+	nmtst_assert_connection_equals (connection, FALSE, cached, FALSE);
+
+	/* a modified file is not taken from the cache */
+	st.st_mtim.tv_nsec = 1;
+	g_assert (!nm_keyfile_plugin_cache_lookup (cache, path, &st));
+	nm_keyfile_plugin_cache_free (cache);
+
+	unlink (cache_file);
+}
+
 static void
 test_nm_keyfile_plugin_utils_escape_filename (void)
 {
@@ -3066,6 +3109,8 @@ int main (int argc, char **argv)
 
 	g_test_add_func ("/keyfile/test_nm_keyfile_plugin_utils_escape_filename", test_nm_keyfile_plugin_utils_escape_filename);
 
+	g_test_add_func ("/keyfile/test_cache", test_cache);
+
 	return g_test_run ();
 }
 
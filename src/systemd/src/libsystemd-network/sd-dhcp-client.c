@@ -48,6 +48,13 @@
 #define RESTART_AFTER_NAK_MIN_USEC (1 * USEC_PER_SEC)
 #define RESTART_AFTER_NAK_MAX_USEC (30 * USEC_PER_MINUTE)
 
+#if 0 /* NM_IGNORED */
+#else /* NM_IGNORED */
+/* Let sd-event coalesce the T1/T2/expiry timers of all clients into
+ * shared wakeups, instead of waking up for each lease separately. */
+#define LEASE_TIMER_ACCURACY_USEC (1 * USEC_PER_SEC)
+#endif /* NM_IGNORED */
+
 struct sd_dhcp_client {
         unsigned n_ref;
 
@@ -1414,7 +1421,11 @@ static int client_set_lease_timeouts(sd_dhcp_client *client) {
         /* arm lifetime timeout */
         r = sd_event_add_time(client->event, &client->timeout_expire,
                               clock_boottime_or_monotonic(),
+#if 0 /* NM_IGNORED */
                               lifetime_timeout, 10 * USEC_PER_MSEC,
+#else /* NM_IGNORED */
+                              lifetime_timeout, LEASE_TIMER_ACCURACY_USEC,
+#endif /* NM_IGNORED */
                               client_timeout_expire, client);
         if (r < 0)
                 return r;
@@ -1440,7 +1451,11 @@ static int client_set_lease_timeouts(sd_dhcp_client *client) {
                               &client->timeout_t2,
                               clock_boottime_or_monotonic(),
                               t2_timeout,
+#if 0 /* NM_IGNORED */
                               10 * USEC_PER_MSEC,
+#else /* NM_IGNORED */
+                              LEASE_TIMER_ACCURACY_USEC,
+#endif /* NM_IGNORED */
                               client_timeout_t2, client);
         if (r < 0)
                 return r;
@@ -1465,7 +1480,11 @@ static int client_set_lease_timeouts(sd_dhcp_client *client) {
         r = sd_event_add_time(client->event,
                               &client->timeout_t1,
                               clock_boottime_or_monotonic(),
+#if 0 /* NM_IGNORED */
                               t1_timeout, 10 * USEC_PER_MSEC,
+#else /* NM_IGNORED */
+                              t1_timeout, LEASE_TIMER_ACCURACY_USEC,
+#endif /* NM_IGNORED */
                               client_timeout_t1, client);
         if (r < 0)
                 return r;
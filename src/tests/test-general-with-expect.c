@@ -26,9 +26,11 @@
 #include <netinet/ether.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/socket.h>
 
 #include "NetworkManagerUtils.h"
 #include "nm-multi-index.h"
+#include "nm-prefix-trie.h"
 
 #include "nm-test-utils-core.h"
 
@@ -850,6 +852,155 @@ test_nm_multi_index (void)
 	}
 	_mi_test_run (50, 3);
 	_mi_test_run (50, 18);
+	_mi_test_run (500, 2);
+}
+
+/*******************************************/
+
+typedef struct {
+	guint8 addr[16];
+	guint8 plen;
+	gboolean added;
+} NMPrefixTrieTestValue;
+
+static gboolean
+_pt_prefix_matches (const guint8 *a, const guint8 *b, guint8 plen)
+{
+	guint i;
+
+	for (i = 0; i < plen; i++) {
+		guint bit = 0x80 >> (i % 8);
+
+		if ((a[i / 8] & bit) != (b[i / 8] & bit))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static void
+_pt_random_addr (GRand *rand, guint8 *addr, guint addr_len)
+{
+	guint i;
+
+	/* use only few distinct leading bits, so that prefixes overlap a lot. */
+	for (i = 0; i < addr_len; i++)
+		addr[i] = g_rand_int (rand);
+	addr[0] &= 0x83;
+	addr[1] &= 0xF0;
+}
+
+typedef struct {
+	guint8 plen;
+	guint len;
+} NMPrefixTrieLookupData;
+
+static gboolean
+_pt_lookup_cb (guint8 plen, void *const* values, guint len, gpointer user_data)
+{
+	NMPrefixTrieLookupData *data = user_data;
+
+	g_assert (values);
+	g_assert (len > 0);
+	g_assert (values[len] == NULL);
+
+	data->plen = plen;
+	data->len = len;
+	return TRUE;
+}
+
+static void
+_pt_assert_lookup (const NMPrefixTrie *trie, const NMPrefixTrieTestValue *array, guint num_values, guint addr_len, const guint8 *addr)
+{
+	NMPrefixTrieLookupData data = { 0 };
+	int best_plen = -1;
+	guint best_len = 0;
+	guint i;
+
+	for (i = 0; i < num_values; i++) {
+		if (!array[i].added)
+			continue;
+		if (!_pt_prefix_matches (array[i].addr, addr, array[i].plen))
+			continue;
+		if (array[i].plen > best_plen) {
+			best_plen = array[i].plen;
+			best_len = 0;
+		}
+		if (array[i].plen == best_plen)
+			best_len++;
+	}
+
+	if (!nm_prefix_trie_lookup_lpm (trie, addr, addr_len * 8, _pt_lookup_cb, &data)) {
+		g_assert_cmpint (best_plen, ==, -1);
+		return;
+	}
+	g_assert_cmpint (data.plen, ==, best_plen);
+	g_assert_cmpint (data.len, ==, best_len);
+}
+
+static void
+_pt_test_run (int addr_family, guint num_values)
+{
+	NMPrefixTrie *trie = nm_prefix_trie_new (addr_family);
+	gs_free NMPrefixTrieTestValue *array = g_new0 (NMPrefixTrieTestValue, num_values);
+	GRand *rand = nmtst_get_rand ();
+	guint addr_len = addr_family == AF_INET ? 4 : 16;
+	guint8 addr[16];
+	guint i, j, num_added = 0;
+
+	for (i = 0; i < num_values; i++) {
+		_pt_random_addr (rand, array[i].addr, addr_len);
+		array[i].plen = g_rand_int_range (rand, 0, addr_len * 8 + 1);
+
+		/* some values share the same prefix. */
+		if (i > 0 && g_rand_int_range (rand, 0, 5) == 0) {
+			j = g_rand_int_range (rand, 0, i);
+			memcpy (array[i].addr, array[j].addr, addr_len);
+			array[i].plen = array[j].plen;
+		}
+	}
+
+	for (i = 0; i < 10 * num_values; i++) {
+		NMPrefixTrieTestValue *v = &array[g_rand_int_range (rand, 0, num_values)];
+		gpointer ptr_value = GUINT_TO_POINTER ((v - array) + 1);
+
+		if (g_rand_boolean (rand)) {
+			g_assert (nm_prefix_trie_add (trie, v->addr, v->plen, ptr_value) == !v->added);
+			if (!v->added)
+				num_added++;
+			v->added = TRUE;
+		} else {
+			g_assert (nm_prefix_trie_remove (trie, v->addr, v->plen, ptr_value) == v->added);
+			if (v->added)
+				num_added--;
+			v->added = FALSE;
+		}
+		g_assert (nm_prefix_trie_contains (trie, v->addr, v->plen, ptr_value) == v->added);
+		g_assert_cmpint (nm_prefix_trie_get_num_values (trie), ==, num_added);
+
+		_pt_random_addr (rand, addr, addr_len);
+		_pt_assert_lookup (trie, array, num_values, addr_len, addr);
+		_pt_assert_lookup (trie, array, num_values, addr_len, v->addr);
+	}
+
+	for (i = 0; i < num_values; i++) {
+		if (array[i].added)
+			g_assert (nm_prefix_trie_remove (trie, array[i].addr, array[i].plen, GUINT_TO_POINTER (i + 1)));
+	}
+	g_assert_cmpint (nm_prefix_trie_get_num_values (trie), ==, 0);
+	_pt_random_addr (rand, addr, addr_len);
+	_pt_assert_lookup (trie, array, 0, addr_len, addr);
+
+	nm_prefix_trie_free (trie);
+}
+
+static void
+test_nm_prefix_trie (void)
+{
+	_pt_test_run (AF_INET, 1);
+	_pt_test_run (AF_INET, 10);
+	_pt_test_run (AF_INET, 200);
+	_pt_test_run (AF_INET6, 10);
+	_pt_test_run (AF_INET6, 200);
 }
 
 /*******************************************/
@@ -909,6 +1060,7 @@ main (int argc, char **argv)
 	g_test_add_func ("/general/nm_utils_array_remove_at_indexes", test_nm_utils_array_remove_at_indexes);
 	g_test_add_func ("/general/nm_ethernet_address_is_valid", test_nm_ethernet_address_is_valid);
 	g_test_add_func ("/general/nm_multi_index", test_nm_multi_index);
+	g_test_add_func ("/general/nm_prefix_trie", test_nm_prefix_trie);
 	g_test_add_func ("/general/nm_utils_new_vlan_name", test_nm_utils_new_vlan_name);
 
 	return g_test_run ();
@@ -20,11 +20,14 @@
 
 #include "nm-default.h"
 
+#include <stdio.h>
 #include <string.h>
 #include <errno.h>
+#include <unistd.h>
 
 #include "NetworkManagerUtils.h"
 #include "nm-core-internal.h"
+#include "settings/nm-settings-connection.h"
 
 #include "nm-test-utils-core.h"
 
@@ -1481,6 +1484,260 @@ test_reverse_dns_ip6 (void)
 
 /*****************************************************************************/
 
+static void
+_parallel_for_each_cb (gpointer item, gpointer user_data)
+{
+	gint *counter = user_data;
+
+	g_atomic_int_inc ((gint *) item);
+	g_atomic_int_inc (counter);
+}
+
+static void
+test_parallel_for_each (void)
+{
+	gint values[100] = { 0 };
+	gpointer items[G_N_ELEMENTS (values)];
+	gint counter;
+	guint len, i;
+
+	for (i = 0; i < G_N_ELEMENTS (values); i++)
+		items[i] = &values[i];
+
+	/* below and above the threshold for using threads */
+	for (len = 0; len <= G_N_ELEMENTS (values); len += 25) {
+		memset (values, 0, sizeof (values));
+		counter = 0;
+
+		nm_utils_parallel_for_each (items, len, _parallel_for_each_cb, &counter);
+
+		g_assert_cmpint (counter, ==, len);
+		for (i = 0; i < G_N_ELEMENTS (values); i++)
+			g_assert_cmpint (values[i], ==, i < len ? 1 : 0);
+	}
+}
+
+/*****************************************************************************/
+
+static void
+test_logging_recorder (void)
+{
+	gs_strfreev char **lines = NULL;
+	GError *error = NULL;
+	guint i;
+
+	g_assert (!nm_logging_recorder_setup ("CORE,NOSUCHDOMAIN", &error));
+	g_assert_error (error, NM_MANAGER_ERROR, NM_MANAGER_ERROR_UNKNOWN_LOG_DOMAIN);
+	g_clear_error (&error);
+
+	g_assert (nm_logging_recorder_setup ("WIFI, DHCP4", &error));
+	g_assert_no_error (error);
+	g_assert (nm_logging_enabled (LOGL_TRACE, LOGD_WIFI));
+
+	nm_log_trace (LOGD_WIFI, "recorded %d", 0);
+	for (i = 1; i <= 200; i++)
+		nm_log_trace (LOGD_DHCP4, "recorded %u", i);
+	nm_log_trace (LOGD_WIFI, "recorded %d", 201);
+	nm_log_trace (LOGD_DHCP6, "not recorded");
+
+	/* the DHCP4 ring wrapped around, but the WIFI one didn't. */
+	lines = nm_logging_recorder_dump ();
+	g_assert_cmpint (g_strv_length (lines), ==, 2 + 128);
+	g_assert (g_str_has_suffix (lines[0], "] WIFI: recorded 0"));
+	g_assert (g_str_has_suffix (lines[1], "] DHCP4: recorded 73"));
+	g_assert (g_str_has_suffix (lines[128], "] DHCP4: recorded 200"));
+	g_assert (g_str_has_suffix (lines[129], "] WIFI: recorded 201"));
+	g_clear_pointer (&lines, g_strfreev);
+
+	g_assert (nm_logging_recorder_setup (NULL, &error));
+	g_assert_no_error (error);
+	lines = nm_logging_recorder_dump ();
+	g_assert (lines && !lines[0]);
+}
+
+/*****************************************************************************/
+
+#define RING_TEST_PRODUCERS 4
+#define RING_TEST_MESSAGES  5000
+
+static gpointer
+_async_ring_producer (gpointer user_data)
+{
+	NMLogAsyncRing *ring = ((gpointer *) user_data)[0];
+	guint id = GPOINTER_TO_UINT (((gpointer *) user_data)[1]);
+	guint i;
+	char msg[64];
+
+	for (i = 0; i < RING_TEST_MESSAGES; ) {
+		nm_sprintf_buf (msg, "%u %u", id, i);
+		if (_nm_logging_async_ring_push (ring, msg))
+			i++;
+		else
+			g_thread_yield ();
+	}
+	return NULL;
+}
+
+/* messages 0 to 7 fill the ring, later every fifth doesn't fit a slot. */
+static const char *
+_ring_test_msg (char *buf, gsize len, const char *long_msg, guint i)
+{
+	if (i >= 8 && i % 5 == 0)
+		return long_msg;
+	g_snprintf (buf, len, "%u", i);
+	return buf;
+}
+
+static void
+test_logging_async_ring (void)
+{
+	NMLogAsyncRing *ring;
+	gpointer data[RING_TEST_PRODUCERS][2];
+	GThread *threads[RING_TEST_PRODUCERS];
+	guint next[RING_TEST_PRODUCERS] = { 0 };
+	gs_free char *long_msg = g_strnfill (1000, 'x');
+	char buf[32];
+	char *msg;
+	guint i, n;
+
+	ring = _nm_logging_async_ring_new (8);
+
+	/* fill the ring; further messages are dropped and counted. */
+	g_assert (!_nm_logging_async_ring_pop (ring));
+	for (i = 0; i < 8; i++)
+		g_assert (_nm_logging_async_ring_push (ring, _ring_test_msg (buf, sizeof (buf), long_msg, i)));
+	g_assert (!_nm_logging_async_ring_push (ring, "dropped"));
+	g_assert (!_nm_logging_async_ring_push (ring, "dropped"));
+	g_assert_cmpint (_nm_logging_async_ring_take_dropped (ring), ==, 2);
+	g_assert_cmpint (_nm_logging_async_ring_take_dropped (ring), ==, 0);
+
+	/* wrap around several times, keeping the ring full. */
+	for (i = 8; i < 50 + 8; i++) {
+		msg = _nm_logging_async_ring_pop (ring);
+		g_assert_cmpstr (msg, ==, _ring_test_msg (buf, sizeof (buf), long_msg, i - 8));
+		g_free (msg);
+		if (i >= 50)
+			continue;
+		g_assert (_nm_logging_async_ring_push (ring, _ring_test_msg (buf, sizeof (buf), long_msg, i)));
+		g_assert (!_nm_logging_async_ring_push (ring, "dropped"));
+	}
+	g_assert (!_nm_logging_async_ring_pop (ring));
+	g_assert_cmpint (_nm_logging_async_ring_take_dropped (ring), ==, 50 - 8);
+
+	/* multiple producers and one consumer. Each message must arrive once
+	 * and in the order of its producer. */
+	for (i = 0; i < RING_TEST_PRODUCERS; i++) {
+		data[i][0] = ring;
+		data[i][1] = GUINT_TO_POINTER (i);
+		threads[i] = g_thread_new ("producer", _async_ring_producer, data[i]);
+	}
+	for (n = 0; n < RING_TEST_PRODUCERS * RING_TEST_MESSAGES; ) {
+		guint id, seq;
+
+		msg = _nm_logging_async_ring_pop (ring);
+		if (!msg) {
+			g_thread_yield ();
+			continue;
+		}
+		g_assert (sscanf (msg, "%u %u", &id, &seq) == 2);
+		g_assert_cmpint (id, <, RING_TEST_PRODUCERS);
+		g_assert_cmpint (seq, ==, next[id]);
+		next[id]++;
+		n++;
+		g_free (msg);
+	}
+	for (i = 0; i < RING_TEST_PRODUCERS; i++) {
+		g_thread_join (threads[i]);
+		g_assert_cmpint (next[i], ==, RING_TEST_MESSAGES);
+	}
+	g_assert (!_nm_logging_async_ring_pop (ring));
+
+	_nm_logging_async_ring_free (ring);
+}
+
+/*****************************************************************************/
+
+static void
+test_settings_state_db (void)
+{
+	gs_free char *dir = NULL;
+	gs_free char *filename = NULL;
+	gs_free char *log_filename = NULL;
+	NMSettingsStateDB *db;
+	char value[20];
+	FILE *f;
+	guint i;
+
+	dir = g_dir_make_tmp ("nm-test-state-db-XXXXXX", NULL);
+	g_assert (dir);
+	filename = g_build_filename (dir, "timestamps", NULL);
+	log_filename = g_strdup_printf ("%s.log", filename);
+
+	/* changes are appended to the log. */
+	db = _nm_settings_state_db_new (filename, "timestamps");
+	_nm_settings_state_db_set (db, "a", "1");
+	_nm_settings_state_db_set (db, "b", "2");
+	_nm_settings_state_db_flush (db);
+	g_assert_cmpint (_nm_settings_state_db_get_log_records (db), ==, 2);
+	g_assert (!g_file_test (filename, G_FILE_TEST_EXISTS));
+	_nm_settings_state_db_free (db);
+
+	/* and replayed on load. */
+	db = _nm_settings_state_db_new (filename, "timestamps");
+	g_assert_cmpint (_nm_settings_state_db_get_log_records (db), ==, 2);
+	g_assert_cmpstr (_nm_settings_state_db_lookup (db, "a"), ==, "1");
+	g_assert_cmpstr (_nm_settings_state_db_lookup (db, "b"), ==, "2");
+	_nm_settings_state_db_set (db, "a", "3");
+	_nm_settings_state_db_set (db, "b", NULL);
+	_nm_settings_state_db_flush (db);
+	g_assert_cmpint (_nm_settings_state_db_get_log_records (db), ==, 4);
+	_nm_settings_state_db_free (db);
+
+	/* a partial record at the end of the log is ignored and cut off,
+	 * so that the next record is not appended to it. */
+	f = fopen (log_filename, "a");
+	g_assert (f);
+	g_assert (fputs ("c=4", f) >= 0);
+	g_assert (fclose (f) == 0);
+
+	db = _nm_settings_state_db_new (filename, "timestamps");
+	g_assert_cmpint (_nm_settings_state_db_get_log_records (db), ==, 4);
+	g_assert_cmpstr (_nm_settings_state_db_lookup (db, "a"), ==, "3");
+	g_assert (!_nm_settings_state_db_lookup (db, "b"));
+	g_assert (!_nm_settings_state_db_lookup (db, "c"));
+	_nm_settings_state_db_set (db, "d", "5");
+	_nm_settings_state_db_flush (db);
+	_nm_settings_state_db_free (db);
+
+	db = _nm_settings_state_db_new (filename, "timestamps");
+	g_assert_cmpint (_nm_settings_state_db_get_log_records (db), ==, 5);
+	g_assert (!_nm_settings_state_db_lookup (db, "c"));
+	g_assert_cmpstr (_nm_settings_state_db_lookup (db, "d"), ==, "5");
+
+	/* a log larger than the table is compacted into the keyfile. */
+	for (i = 0; i < 250; i++) {
+		nm_sprintf_buf (value, "%u", 1000 + i);
+		_nm_settings_state_db_set (db, "a", value);
+	}
+	_nm_settings_state_db_flush (db);
+	g_assert_cmpint (_nm_settings_state_db_get_log_records (db), ==, 0);
+	g_assert (g_file_test (filename, G_FILE_TEST_EXISTS));
+	g_assert (!g_file_test (log_filename, G_FILE_TEST_EXISTS));
+	_nm_settings_state_db_free (db);
+
+	db = _nm_settings_state_db_new (filename, "timestamps");
+	g_assert_cmpint (_nm_settings_state_db_get_log_records (db), ==, 0);
+	g_assert_cmpstr (_nm_settings_state_db_lookup (db, "a"), ==, "1249");
+	g_assert (!_nm_settings_state_db_lookup (db, "b"));
+	g_assert_cmpstr (_nm_settings_state_db_lookup (db, "d"), ==, "5");
+	_nm_settings_state_db_free (db);
+
+	g_assert (unlink (filename) == 0);
+	g_assert (rmdir (dir) == 0);
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE ();
 
 int
@@ -1518,6 +1775,11 @@ main (int argc, char **argv)
 	g_test_add_func ("/general/reverse_dns/ip4", test_reverse_dns_ip4);
 	g_test_add_func ("/general/reverse_dns/ip6", test_reverse_dns_ip6);
 
+	g_test_add_func ("/general/parallel_for_each", test_parallel_for_each);
+	g_test_add_func ("/general/logging/recorder", test_logging_recorder);
+	g_test_add_func ("/general/logging/async_ring", test_logging_async_ring);
+	g_test_add_func ("/general/settings/state_db", test_settings_state_db);
+
 	return g_test_run ();
 }
 
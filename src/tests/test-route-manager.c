@@ -873,6 +873,91 @@ test_ip4_full_sync (test_fixture *fixture, gconstpointer user_data)
 
 /*****************************************************************************/
 
+/* Appends the routes to every other /24 subnet of 10.0.0.0/16, starting
+ * with 10.0.@first.0/24. */
+static void
+_fill_ip4_routes (GArray *routes, int ifindex, guint first, guint n)
+{
+	NMPlatformIP4Route route = { 0 };
+	guint i;
+
+	route.ifindex = ifindex;
+	route.rt_source = nmp_utils_ip_config_source_round_trip_rtprot (NM_IP_CONFIG_SOURCE_USER);
+	route.plen = 24;
+	route.gateway = INADDR_ANY;
+	route.metric = 20;
+
+	for (i = 0; i < n; i++) {
+		route.network = htonl (0x0a000000 /* 10.0.0.0 */ + ((first + 2 * i) << 8));
+		g_array_append_val (routes, route);
+	}
+}
+
+static void
+_assert_ip4_subnets (int ifindex, guint first, guint n, guint32 metric, gboolean has)
+{
+	guint i;
+
+	for (i = 0; i < n; i++) {
+		in_addr_t network = htonl (0x0a000000 /* 10.0.0.0 */ + ((first + 2 * i) << 8));
+
+		g_assert (!!nm_platform_ip4_route_get (NM_PLATFORM_GET, ifindex, network, 24, metric) == !!has);
+	}
+}
+
+static void
+test_ip4_sync_merge (test_fixture *fixture, gconstpointer user_data)
+{
+	gs_unref_array GArray *routes0 = g_array_new (FALSE, FALSE, sizeof (NMPlatformIP4Route));
+	gs_unref_array GArray *routes1 = g_array_new (FALSE, FALSE, sizeof (NMPlatformIP4Route));
+	NMPlatformIP4Route route;
+
+	/* the routes of both devices alternate in the index of route-manager,
+	 * so that the added routes are merged between the kept ones. */
+	_fill_ip4_routes (routes1, fixture->ifindex1, 0, 20);
+	g_assert (nm_route_manager_ip4_route_sync (nm_route_manager_get (), fixture->ifindex1, routes1, TRUE, TRUE));
+
+	_fill_ip4_routes (routes0, fixture->ifindex0, 1, 10);
+	g_assert (nm_route_manager_ip4_route_sync (nm_route_manager_get (), fixture->ifindex0, routes0, TRUE, FALSE));
+
+	_assert_ip4_subnets (fixture->ifindex1, 0, 20, 20, TRUE);
+	_assert_ip4_subnets (fixture->ifindex0, 1, 10, 20, TRUE);
+
+	/* remove 10.0.{1,3,..,9}.0/24 and add 10.0.{21,23,..,29}.0/24. */
+	g_array_set_size (routes0, 0);
+	_fill_ip4_routes (routes0, fixture->ifindex0, 11, 10);
+	g_assert (nm_route_manager_ip4_route_sync (nm_route_manager_get (), fixture->ifindex0, routes0, TRUE, FALSE));
+
+	_assert_ip4_subnets (fixture->ifindex1, 0, 20, 20, TRUE);
+	_assert_ip4_subnets (fixture->ifindex0, 1, 5, 20, FALSE);
+	_assert_ip4_subnets (fixture->ifindex0, 11, 10, 20, TRUE);
+
+	/* a route that conflicts with one of device1 is ordered after the
+	 * route that route-manager already has, and gets a bumped metric. */
+	route = g_array_index (routes1, NMPlatformIP4Route, 2);
+	route.ifindex = fixture->ifindex0;
+	g_array_append_val (routes0, route);
+	g_assert (nm_route_manager_ip4_route_sync (nm_route_manager_get (), fixture->ifindex0, routes0, TRUE, FALSE));
+
+	_assert_ip4_subnets (fixture->ifindex1, 0, 20, 20, TRUE);
+	_assert_ip4_subnets (fixture->ifindex0, 4, 1, 21, TRUE);
+	_assert_ip4_subnets (fixture->ifindex0, 4, 1, 20, FALSE);
+	_assert_ip4_subnets (fixture->ifindex0, 11, 10, 20, TRUE);
+
+	/* removing it again leaves the route of device1 alone. */
+	g_array_set_size (routes0, routes0->len - 1);
+	g_assert (nm_route_manager_ip4_route_sync (nm_route_manager_get (), fixture->ifindex0, routes0, TRUE, FALSE));
+
+	_assert_ip4_subnets (fixture->ifindex1, 0, 20, 20, TRUE);
+	_assert_ip4_subnets (fixture->ifindex0, 4, 1, 21, FALSE);
+	_assert_ip4_subnets (fixture->ifindex0, 11, 10, 20, TRUE);
+
+	nm_route_manager_route_flush (nm_route_manager_get (), fixture->ifindex0);
+	nm_route_manager_route_flush (nm_route_manager_get (), fixture->ifindex1);
+}
+
+/*****************************************************************************/
+
 static void
 fixture_setup (test_fixture *fixture, gconstpointer user_data)
 {
@@ -925,4 +1010,6 @@ _nmtstp_setup_tests (void)
 	g_test_add ("/route-manager/ip6", test_fixture, NULL, fixture_setup, test_ip6, fixture_teardown);
 
 	g_test_add ("/route-manager/ip4-full-sync", test_fixture, NULL, fixture_setup, test_ip4_full_sync, fixture_teardown);
+
+	g_test_add ("/route-manager/ip4-sync-merge", test_fixture, NULL, fixture_setup, test_ip4_sync_merge, fixture_teardown);
 }
@@ -110,6 +110,12 @@ class ExportedObj(dbus.service.Object):
             raise UnknownPropertyException()
         return props[propname]
 
+    def get_managed_ifaces(self):
+        ifaces = {}
+        for dbus_iface in self.__dbus_ifaces:
+            ifaces[dbus_iface] = self.__dbus_ifaces[dbus_iface].get_props_func()
+        return ifaces
+
     def _dbus_property_notify(self, dbus_iface, propname):
         prop = self._dbus_property_get(dbus_iface, propname)
         self.__dbus_interface_get(dbus_iface).prop_changed_func(self, { propname: prop })
@@ -1057,6 +1063,7 @@ class InvalidHostnameException(dbus.DBusException):
 class Settings(dbus.service.Object):
     def __init__(self, bus, object_path):
         dbus.service.Object.__init__(self, bus, object_path)
+        self.path = object_path
         self.connections = {}
         self.bus = bus
         self.counter = 1
@@ -1206,6 +1213,27 @@ class AgentManager(dbus.service.Object):
                 continue
         return secrets
 
+###################################################################
+IFACE_OBJECT_MANAGER = 'org.freedesktop.DBus.ObjectManager'
+
+class ObjectManager(dbus.service.Object):
+    def __init__(self, bus, object_path):
+        dbus.service.Object.__init__(self, bus, object_path)
+
+    @dbus.service.method(dbus_interface=IFACE_OBJECT_MANAGER, in_signature='', out_signature='a{oa{sa{sv}}}')
+    def GetManagedObjects(self):
+        objs = [ manager ] + manager.devices + manager.active_connections
+        for d in manager.devices:
+            objs = objs + getattr(d, 'aps', []) + getattr(d, 'nsps', [])
+
+        managed = {}
+        for o in objs:
+            managed[o.path] = o.get_managed_ifaces()
+        managed[settings.path] = { IFACE_SETTINGS: settings.props }
+        for c in settings.connections.values():
+            managed[c.path] = { IFACE_CONNECTION: c.props }
+        return managed
+
 ###################################################################
 
 def stdin_cb(io, condition):
@@ -1221,10 +1249,11 @@ def main():
 
     bus = dbus.SessionBus()
 
-    global manager, settings, agent_manager
+    global manager, settings, agent_manager, object_manager
     manager = NetworkManager(bus, "/org/freedesktop/NetworkManager")
     settings = Settings(bus, "/org/freedesktop/NetworkManager/Settings")
     agent_manager = AgentManager(bus, "/org/freedesktop/NetworkManager/AgentManager")
+    object_manager = ObjectManager(bus, "/org/freedesktop")
 
     if not bus.request_name("org.freedesktop.NetworkManager"):
         sys.exit(1)